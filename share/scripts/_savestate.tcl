@@ -11,7 +11,16 @@ proc savestate_common {} {
 	}
 }
 
-proc savestate {{name ""}} {
+proc savestate {args} {
+	set options [list]
+	if {[lindex $args 0] eq "-binary"} {
+		lappend options "-binary"
+		set args [lrange $args 1 end]
+	}
+	if {[llength $args] > 1} {
+		error "wrong # args: should be \"savestate ?-binary? ?name?\""
+	}
+	set name [lindex $args 0]
 	savestate_common
 	file mkdir $directory
 	if {[catch {::openmsx::internal_screenshot -raw -doublesize $png}]} {
@@ -19,7 +28,7 @@ proc savestate {{name ""}} {
 		catch {file delete -- $png}
 	}
 	set currentID [machine]
-	store_machine $currentID $fullname
+	store_machine {*}$options $currentID $fullname
 	return $fullname
 }
 
@@ -94,12 +103,14 @@ proc savestate_list_tab {args} {
 
 # savestate
 set_help_text savestate \
-{savestate [<name>]
+{savestate [-binary] [<name>]
 
 Create a snapshot of the current emulated MSX machine.
 
 Optionally you can specify a name for the savestate. If you omit this the default name 'quicksave' will be taken.
 
+With the -binary option the savestate is stored in a binary format instead of in XML. Binary savestates are much faster to load, but can only be loaded on a platform with the same endianness and word size. 'loadstate' handles both formats.
+
 See also 'loadstate', 'list_savestates', 'delete_savestate'.
 }
 set_tabcompletion_proc savestate [namespace code savestate_tab]
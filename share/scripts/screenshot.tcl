@@ -42,13 +42,14 @@ screenshot -raw -size 320    320x240 raw screenshot (of MSX screen only)
 screenshot -raw -size auto   raw screenshot (of MSX screen only), with size determined by screen mode
 screenshot -raw              raw screenshot (of MSX screen only), default -size (auto)
 screenshot -with-osd         Include OSD elements in the screenshot
+screenshot -compression <n>  PNG compression level 0-9: lower is faster, higher gives smaller files (default 6)
 screenshot -no-sprites       Don't include sprites in the screenshot
 screenshot -guess-name       Guess the name of the running software and use it as prefix
 }
 
 set_tabcompletion_proc screenshot [namespace code screenshot_tab]
 proc screenshot_tab {args} {
-	list "-prefix" "-raw" "-size" "-with-osd" "-no-sprites" "-guess-name"
+	list "-prefix" "-raw" "-size" "-with-osd" "-compression" "-no-sprites" "-guess-name"
 }
 
 namespace export screenshot
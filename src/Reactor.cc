@@ -33,6 +33,7 @@
 #include "RomInfo.hh"
 #include "StateChangeDistributor.hh"
 #include "SymbolManager.hh"
+#include "TclArgParser.hh"
 #include "TclCallbackMessages.hh"
 #include "TclObject.hh"
 #include "UserSettings.hh"
@@ -528,6 +529,19 @@ void Reactor::switchMachine(const std::string& machine)
 	deleteBoard(oldBoard);
 }
 
+// Load a savestate, either in XML or in binary format, into the given board.
+static void loadMachineState(zstring_view filename, MSXMotherBoard& board)
+{
+	if (BinarySaveState::isBinary(filename)) {
+		auto contents = BinarySaveState::load(filename);
+		auto in = contents.createArchive();
+		in.serialize("machine", board);
+	} else {
+		XmlInputArchive in(filename);
+		in.serialize("machine", board);
+	}
+}
+
 void Reactor::switchMachineFromSetup(zstring_view filename)
 {
 	if (!display) {
@@ -547,8 +561,7 @@ void Reactor::switchMachineFromSetup(zstring_view filename)
 	auto newBoard = createEmptyMotherBoard();
 
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("machine", *newBoard);
+		loadMachineState(filename, *newBoard);
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load setup, bad file format: ",
 				       e.getMessage());
@@ -1034,15 +1047,29 @@ StoreMachineCommand::StoreMachineCommand(
 
 void StoreMachineCommand::execute(std::span<const TclObject> tokens, TclObject& result)
 {
-	checkNumArgs(tokens, 3, Prefix{1}, "id filename");
-	const auto& machineID = tokens[1].getString();
-	const auto& filename = tokens[2].getString();
+	checkNumArgs(tokens, AtLeast{3}, "?-binary? id filename");
+	bool binary = false;
+	std::array info = {flagArg("-binary", binary)};
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (arguments.size() != 2) throw SyntaxError();
+	const auto& machineID = arguments[0].getString();
+	const auto& filename = arguments[1].getString();
 
 	const auto& board = *reactor.getMachine(machineID);
 
-	XmlOutputArchive out(filename);
-	out.serialize("machine", board);
-	out.close();
+	if (binary) {
+		MemOutputArchive out;
+		out.serialize("machine", board);
+		try {
+			BinarySaveState::save(filename, std::move(out));
+		} catch (MSXException& e) {
+			throw CommandException("Cannot save state: ", e.getMessage());
+		}
+	} else {
+		XmlOutputArchive out(filename);
+		out.serialize("machine", board);
+		out.close();
+	}
 	result = filename;
 }
 
@@ -1050,13 +1077,25 @@ std::string StoreMachineCommand::help(std::span<const TclObject> /*tokens*/) con
 {
 	return
 		"store_machine machineID <filename>  Save state of machine \"machineID\" to indicated file\n"
+		"store_machine -binary machineID <filename>\n"
+		"                                    Idem, but use the (much faster to load) binary format\n"
+		"\n"
+		"XML savestates can be loaded in newer openMSX versions and on other platforms, binary\n"
+		"savestates only in newer openMSX versions on a platform with the same endianness and\n"
+		"word size. 'restore_machine' detects the format automatically.\n"
 		"\n"
 		"This is a low-level command, the 'savestate' script is easier to use.";
 }
 
 void StoreMachineCommand::tabCompletion(std::vector<std::string>& tokens) const
 {
-	completeString(tokens, reactor.getMachineIDs());
+	if (tokens.size() == 2) {
+		auto options = to_vector(reactor.getMachineIDs());
+		options.emplace_back("-binary");
+		completeString(tokens, options);
+	} else {
+		completeString(tokens, reactor.getMachineIDs());
+	}
 }
 
 
@@ -1078,8 +1117,7 @@ void RestoreMachineCommand::execute(std::span<const TclObject> tokens,
 	const auto filename = FileOperations::expandTilde(std::string(tokens[1].getString()));
 
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("machine", *newBoard);
+		loadMachineState(filename, *newBoard);
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load state, bad file format: ",
 		                       e.getMessage());
@@ -19,6 +19,7 @@
 #include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "Timer.hh"
+#include "Version.hh"
 #include "XMLException.hh"
 #include "serialize.hh"
 #include "serialize_meta.hh"
@@ -26,7 +27,9 @@
 #include "format.hh"
 #include "narrow.hh"
 #include "one_of.hh"
+#include "xxhash.hh"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
@@ -41,6 +44,16 @@ using namespace std::literals;
 // Time between two snapshots (in seconds)
 static constexpr double SNAPSHOT_PERIOD = 1.0;
 
+// Snapshots are compressed progressively: the most recent ones stay
+// uncompressed (fast to go back to), older ones are compressed with LZ4 and
+// the oldest ones are recompressed with the slower LZ4 HC mode. Ages are
+// expressed in number of snapshot periods.
+static constexpr unsigned COMPRESS_FAST_AGE = 10;
+static constexpr unsigned COMPRESS_HIGH_AGE = 60;
+// Max amount of (uncompressed) data that gets recompressed with LZ4 HC per
+// snapshot. This spreads the work over time (e.g. after loading a replay).
+static constexpr size_t COMPRESS_HIGH_BUDGET = 256 * 1024;
+
 // Max number of snapshots in a replay file
 static constexpr unsigned MAX_NOF_SNAPSHOTS = 10;
 
@@ -65,6 +78,8 @@ struct Replay
 	Reactor& reactor;
 
 	ReverseManager::Events* events;
+	ReverseManager::StateHashes* stateHashes;
+	std::string* hashBuild;
 	std::vector<Reactor::Board> motherBoards;
 	EmuTime currentTime = EmuTime::dummy();
 	// this is the amount of times the reverse goto command was used, which
@@ -97,9 +112,25 @@ struct Replay
 		if (ar.versionAtLeast(version, 4)) {
 			ar.serialize("reRecordCount", reRecordCount);
 		}
+
+		if (ar.versionAtLeast(version, 5)) {
+			ar.serialize("stateHashes", *stateHashes,
+			             "hashBuild",   *hashBuild);
+		}
 	}
 };
-SERIALIZE_CLASS_VERSION(Replay, 4);
+SERIALIZE_CLASS_VERSION(Replay, 5);
+
+
+// struct StateHash
+
+template<typename Archive>
+void ReverseManager::StateHash::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.serialize("time",       time,
+	             "memoryHash", memoryHash,
+	             "fullHash",   fullHash);
+}
 
 
 // struct ReverseHistory
@@ -108,6 +139,9 @@ void ReverseManager::ReverseHistory::swap(ReverseHistory& other) noexcept
 {
 	std::swap(chunks, other.chunks);
 	std::swap(events, other.events);
+	std::swap(stateHashes, other.stateHashes);
+	std::swap(hashBuild, other.hashBuild);
+	std::swap(firstMismatch, other.firstMismatch);
 }
 
 void ReverseManager::ReverseHistory::clear()
@@ -115,6 +149,9 @@ void ReverseManager::ReverseHistory::clear()
 	// clear() and free storage capacity
 	Chunks().swap(chunks);
 	Events().swap(events);
+	StateHashes().swap(stateHashes);
+	hashBuild.clear();
+	firstMismatch.reset();
 }
 
 
@@ -123,6 +160,7 @@ void ReverseManager::ReverseHistory::clear()
 ReverseManager::ReverseManager(MSXMotherBoard& motherBoard_)
 	: syncNewSnapshot(motherBoard_.getScheduler())
 	, syncInputEvent (motherBoard_.getScheduler())
+	, syncVerifyHash (motherBoard_.getScheduler())
 	, motherBoard(motherBoard_)
 	, eventDistributor(motherBoard.getReactor().getEventDistributor())
 	, reverseCmd(motherBoard.getCommandController())
@@ -164,6 +202,7 @@ void ReverseManager::stop()
 		motherBoard.getStateChangeDistributor().unregisterRecorder(*this);
 		syncNewSnapshot.removeSyncPoint(); // don't schedule new snapshot takings
 		syncInputEvent .removeSyncPoint(); // stop any pending replay actions
+		syncVerifyHash .removeSyncPoint();
 		history.clear();
 		replayIndex = 0;
 		collecting = false;
@@ -614,6 +653,8 @@ void ReverseManager::saveReplay(
 	try {
 		XmlOutputArchive out(filename);
 		replay.events = &history.events;
+		replay.stateHashes = &history.stateHashes;
+		replay.hashBuild = &history.hashBuild;
 		out.serialize("replay", replay);
 		out.close();
 	} catch (MSXException&) {
@@ -670,6 +711,10 @@ void ReverseManager::loadReplay(
 	Replay replay(reactor);
 	Events events;
 	replay.events = &events;
+	StateHashes stateHashes;
+	replay.stateHashes = &stateHashes;
+	std::string hashBuild;
+	replay.hashBuild = &hashBuild;
 	try {
 		XmlInputArchive in(filename);
 		in.serialize("replay", replay);
@@ -711,6 +756,8 @@ void ReverseManager::loadReplay(
 
 	// Restore event log
 	swap(newHistory.events, events);
+	swap(newHistory.stateHashes, stateHashes);
+	swap(newHistory.hashBuild, hashBuild);
 	auto& newEvents = newHistory.events;
 
 	// Restore snapshots
@@ -745,6 +792,57 @@ void ReverseManager::loadReplay(
 	result = tmpStrCat("Loaded replay from ", filename);
 }
 
+// Replay the history (typically a loaded replay) and compare the machine state
+// with the recorded state hashes (see execVerifyHash()). Each interval between
+// two snapshots is replayed starting from the earlier snapshot, so this only
+// needs a single (fast-forward) pass to find the first diverging interval.
+// Note: going to a different time replaces the MSXMotherBoard (and thus also
+// the ReverseManager), that's why this is a static method.
+void ReverseManager::verify(MSXMotherBoard& board, TclObject& result)
+{
+	auto& reactor = board.getReactor();
+	if (&board != reactor.getMotherBoard()) {
+		throw CommandException("Can only verify the active machine.");
+	}
+	auto& hist = board.getReverseManager().history;
+	const auto& hashes = hist.stateHashes;
+	if (hashes.empty()) {
+		throw CommandException("No state hashes recorded, nothing to verify.");
+	}
+
+	// Go to the last recorded hash before each snapshot and finally to the
+	// last recorded hash.
+	std::vector<EmuTime> targets;
+	for (const auto& [idx, chunk] : std::views::drop(hist.chunks, 1)) {
+		auto it = std::ranges::lower_bound(hashes, chunk.time, {}, &StateHash::time);
+		if (it != begin(hashes)) targets.push_back(std::prev(it)->time);
+	}
+	targets.push_back(hashes.back().time);
+	auto numHashes = hashes.size();
+	auto startTime = begin(hist.chunks)->second.time;
+	hist.firstMismatch.reset();
+
+	auto getManager = [&]() -> ReverseManager& {
+		return reactor.getMotherBoard()->getReverseManager();
+	};
+	getManager().goTo(startTime, true);
+	for (auto target : targets) {
+		if (getManager().history.firstMismatch) break;
+		getManager().goTo(target, true);
+	}
+
+	auto& manager = getManager();
+	if (auto mismatch = manager.history.firstMismatch) {
+		const auto& newHashes = manager.history.stateHashes;
+		auto it = std::ranges::lower_bound(newHashes, *mismatch, {}, &StateHash::time);
+		auto lastGood = (it != begin(newHashes)) ? std::prev(it)->time : startTime;
+		result = tmpStrCat("Replay diverges between ", lastGood.toDouble(),
+		                   " and ", mismatch->toDouble(), " seconds.");
+	} else {
+		result = tmpStrCat("All ", numHashes, " recorded states match.");
+	}
+}
+
 void ReverseManager::transferHistory(ReverseHistory& oldHistory,
                                      unsigned oldEventCount)
 {
@@ -767,6 +865,7 @@ void ReverseManager::transferHistory(ReverseHistory& oldHistory,
 	// replay log contains at least the EndLogEvent
 	assert(replayIndex < history.events.size());
 	replayNextEvent();
+	scheduleVerifyHash();
 }
 
 void ReverseManager::execNewSnapshot()
@@ -870,6 +969,96 @@ void ReverseManager::takeSnapshot(EmuTime time)
 	newChunk.time = time;
 	newChunk.savestate = std::move(out).releaseBuffer();
 	newChunk.eventCount = replayIndex;
+
+	if (!isReplaying()) {
+		// While replaying, the recorded hashes are verified instead.
+		auto& hashes = history.stateHashes;
+		while (!hashes.empty() && (hashes.back().time >= time)) {
+			hashes.pop_back();
+		}
+		if (hashes.empty()) {
+			history.hashBuild = Version::full();
+		} else if (history.hashBuild != Version::full()) {
+			history.hashBuild.clear(); // continued recording of an older replay
+		}
+		hashes.push_back(calcStateHash(time));
+	}
+
+	compressOldSnapshots(seqNum);
+}
+
+void ReverseManager::compressOldSnapshots(unsigned seqNum)
+{
+	size_t budget = COMPRESS_HIGH_BUDGET;
+	for (auto& [idx, chunk] : history.chunks) {
+		if ((idx + COMPRESS_FAST_AGE) > seqNum) break; // all remaining chunks are more recent
+		bool high = ((idx + COMPRESS_HIGH_AGE) <= seqNum);
+		for (auto& block : chunk.deltaBlocks) {
+			if (high && budget) {
+				budget -= std::min(budget, block->compress(DeltaBlock::Compression::HIGH));
+			} else {
+				block->compress(DeltaBlock::Compression::FAST);
+			}
+		}
+	}
+}
+
+// Calculates two hashes of the machine state:
+// - 'memoryHash' only covers the large memory blocks (RAM, VRAM, SRAM, ...).
+//   These don't depend on the openMSX version, so this hash can be compared
+//   between builds.
+// - 'fullHash' additionally covers the rest of the serialized state (CPU
+//   registers, device registers, ...). The layout of that data may change
+//   between openMSX versions, so it's only compared when the replay was
+//   recorded with the same build (see 'hashBuild'). The strings in that
+//   state (e.g. the paths of the config files and of the inserted media) are
+//   left out, so the same replay matches on another machine or install
+//   location.
+// Cost: this serializes the whole machine, but (in a stand-alone archive) the
+// large memory blocks are only referenced, not copied. So this is about the
+// same work as taking a reverse snapshot (which happens at the same moment)
+// plus one xxhash pass over all memory. With the default 1s snapshot interval
+// that's negligible compared to the emulation itself.
+ReverseManager::StateHash ReverseManager::calcStateHash(EmuTime time) const
+{
+	MemOutputArchive out(MemOutputArchive::ForHash{});
+	out.serialize("machine", motherBoard);
+
+	StateHash result{.time = time};
+	for (auto blob : out.getLargeBlobs()) {
+		result.memoryHash = (result.memoryHash ^ xxhash_impl<false>(blob.data(), blob.size())) * PRIME32_1;
+	}
+	auto stream = std::move(out).releaseBuffer();
+	result.fullHash = (result.memoryHash ^ xxhash_impl<false>(stream.data(), stream.size())) * PRIME32_1;
+	return result;
+}
+
+void ReverseManager::scheduleVerifyHash()
+{
+	syncVerifyHash.removeSyncPoint();
+	if (!isReplaying() || history.firstMismatch) return;
+
+	// Note: the hashes must be calculated at the exact same EmuTime.
+	const auto& hashes = history.stateHashes;
+	auto it = std::ranges::upper_bound(hashes, getCurrentTime(), {}, &StateHash::time);
+	if (it != end(hashes)) {
+		syncVerifyHash.setSyncPoint(it->time);
+	}
+}
+
+void ReverseManager::execVerifyHash(EmuTime time)
+{
+	const auto& hashes = history.stateHashes;
+	auto it = std::ranges::lower_bound(hashes, time, {}, &StateHash::time);
+	if ((it != end(hashes)) && (it->time == time)) {
+		auto current = calcStateHash(time);
+		bool sameBuild = history.hashBuild == Version::full();
+		if ((current.memoryHash != it->memoryHash) ||
+		    (sameBuild && (current.fullHash != it->fullHash))) {
+			history.firstMismatch = time;
+		}
+	}
+	scheduleVerifyHash();
 }
 
 void ReverseManager::replayNextEvent()
@@ -899,6 +1088,11 @@ void ReverseManager::stopReplay(EmuTime time) noexcept
 			return p.second.time > time;
 		});
 		history.chunks.erase(it, end(history.chunks));
+		// and the same for the state hashes
+		auto& hashes = history.stateHashes;
+		hashes.erase(std::ranges::upper_bound(hashes, time, {}, &StateHash::time),
+		             end(hashes));
+		syncVerifyHash.removeSyncPoint();
 		// this also means someone is changing history, record that
 		reRecordCount++;
 	}
@@ -959,6 +1153,7 @@ void ReverseManager::ReverseCmd::execute(std::span<const TclObject> tokens, TclO
 		"goto",       [&]{ manager.goTo(tokens); },
 		"savereplay", [&]{ manager.saveReplay(interp, tokens, result); },
 		"loadreplay", [&]{ manager.loadReplay(interp, tokens, result); },
+		"verify",     [&]{ verify(manager.motherBoard, result); },
 		"viewonlymode", [&]{
 			auto& distributor = manager.motherBoard.getStateChangeDistributor();
 			switch (tokens.size()) {
@@ -987,7 +1182,8 @@ std::string ReverseManager::ReverseCmd::help(std::span<const TclObject> /*tokens
 	       "viewonlymode <bool> switch viewonly mode on or off\n"
 	       "truncatereplay      stop replaying and remove all 'future' data\n"
 	       "savereplay [<name>] save the first snapshot and all replay data as a 'replay' (with optional name)\n"
-	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] <name>   load a replay (snapshot and replay data) with given name and start replaying\n";
+	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] <name>   load a replay (snapshot and replay data) with given name and start replaying\n"
+	       "verify              replay and compare with the state hashes recorded in the replay, reports the first interval where the emulation diverges\n";
 }
 
 void ReverseManager::ReverseCmd::tabCompletion(std::vector<std::string>& tokens) const
@@ -997,7 +1193,7 @@ void ReverseManager::ReverseCmd::tabCompletion(std::vector<std::string>& tokens)
 		static constexpr std::array subCommands = {
 			"start"sv, "stop"sv, "status"sv, "goback"sv, "goto"sv,
 			"savereplay"sv, "loadreplay"sv, "viewonlymode"sv,
-			"truncatereplay"sv,
+			"truncatereplay"sv, "verify"sv,
 		};
 		completeString(tokens, subCommands);
 	} else if ((tokens.size() == 3) || (tokens[1] == "loadreplay")) {
@@ -15,6 +15,7 @@
 #include <deque>
 #include <map>
 #include <memory>
+#include <optional>
 #include <ranges>
 #include <span>
 #include <string_view>
@@ -88,6 +89,17 @@ private:
 	using Chunks = std::map<unsigned, ReverseChunk>;
 	using Events = std::deque<StateChange>;
 
+	// Hash of the machine state at a certain moment, see calcStateHash().
+	struct StateHash {
+		EmuTime time = EmuTime::zero();
+		uint32_t memoryHash = 0; // only the large memory blocks
+		uint32_t fullHash = 0;   // the complete state (including CPU registers)
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+	};
+	using StateHashes = std::vector<StateHash>; // sorted on time
+
 	struct ReverseHistory {
 		void swap(ReverseHistory& other) noexcept;
 		void clear();
@@ -95,6 +107,13 @@ private:
 
 		Chunks chunks;
 		Events events;
+		StateHashes stateHashes;
+		// The openMSX version that calculated the hashes, empty if
+		// that's a mix of versions.
+		std::string hashBuild;
+		// Time of the first recorded state hash that didn't match
+		// while replaying (see 'reverse verify').
+		std::optional<EmuTime> firstMismatch;
 		LastDeltaBlocks lastDeltaBlocks;
 	};
 
@@ -108,6 +127,7 @@ private:
 	                std::span<const TclObject> tokens, TclObject& result);
 	void loadReplay(Interpreter& interp,
 	                std::span<const TclObject> tokens, TclObject& result);
+	static void verify(MSXMotherBoard& board, TclObject& result);
 
 	void signalStopReplay(EmuTime time);
 	[[nodiscard]] EmuTime getEndTime(const ReverseHistory& history) const;
@@ -118,6 +138,9 @@ private:
 	                     unsigned oldEventCount);
 	void transferState(MSXMotherBoard& newBoard);
 	void takeSnapshot(EmuTime time);
+	void compressOldSnapshots(unsigned seqNum);
+	[[nodiscard]] StateHash calcStateHash(EmuTime time) const;
+	void scheduleVerifyHash();
 	void schedule(EmuTime time);
 	void replayNextEvent();
 	template<unsigned N> void dropOldSnapshots(unsigned count);
@@ -139,9 +162,18 @@ private:
 			rm.execInputEvent();
 		}
 	} syncInputEvent;
+	struct SyncVerifyHash final : Schedulable {
+		friend class ReverseManager;
+		explicit SyncVerifyHash(Scheduler& s) : Schedulable(s) {}
+		void executeUntil(EmuTime time) override {
+			auto& rm = OUTER(ReverseManager, syncVerifyHash);
+			rm.execVerifyHash(time);
+		}
+	} syncVerifyHash;
 
 	void execNewSnapshot();
 	void execInputEvent();
+	void execVerifyHash(EmuTime time);
 	[[nodiscard]] EmuTime getCurrentTime() const { return syncNewSnapshot.getCurrentTime(); }
 
 	// EventListener
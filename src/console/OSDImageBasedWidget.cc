@@ -96,7 +96,8 @@ void OSDImageBasedWidget::setRGBA(std::span<const uint32_t, 4> newRGBA)
 	if (std::ranges::equal(rgba, newRGBA)) {
 		return; // not changed
 	}
-	invalidateLocal();
+	// Only the image depends on the color, not e.g. the font of OSDText.
+	OSDImageBasedWidget::invalidateLocal();
 	copy_to_range(newRGBA, rgba);
 }
 
@@ -4,8 +4,8 @@
 #include "Display.hh"
 #include "FileContext.hh"
 #include "FileOperations.hh"
+#include "GLGlyphAtlas.hh"
 #include "GLImage.hh"
-#include "TTFFont.hh"
 #include "TclObject.hh"
 
 #include "StringOp.hh"
@@ -129,7 +129,7 @@ void OSDText::getProperty(std::string_view propName, TclObject& result) const
 
 void OSDText::invalidateLocal()
 {
-	font = TTFFont(); // clear font
+	atlas.reset(); // clear font
 	OSDImageBasedWidget::invalidateLocal();
 }
 
@@ -161,10 +161,10 @@ std::unique_ptr<GLImage> OSDText::create(OutputSurface& output)
 		return std::make_unique<GLImage>(ivec2(), 0);
 	}
 	int scale = getScaleFactor(output);
-	if (font.empty()) {
+	if (!atlas) {
 		try {
-			font = TTFFont(systemFileContext().resolve(fontFile),
-			               size * scale, fontFaceIndex);
+			atlas = GLGlyphAtlas::get(systemFileContext().resolve(fontFile),
+			                          size * scale, fontFaceIndex);
 		} catch (MSXException& e) {
 			throw MSXException("Couldn't open font: ", e.getMessage());
 		}
@@ -188,18 +188,13 @@ std::unique_ptr<GLImage> OSDText::create(OutputSurface& output)
 		} else {
 			UNREACHABLE;
 		}
-		// An alternative is to pass vector<string> to TTFFont::render().
-		// That way we can avoid join() (in the wrap functions)
-		// followed by // StringOp::split() (in TTFFont::render()).
-		SDLSurfacePtr surface(font.render(wrappedText,
-		                                  narrow_cast<uint8_t>(textRgba >> 24),
-		                                  narrow_cast<uint8_t>(textRgba >> 16),
-		                                  narrow_cast<uint8_t>(textRgba >>  8)));
-		if (surface) {
-			return std::make_unique<GLImage>(std::move(surface));
-		} else {
-			return std::make_unique<GLImage>(ivec2(), 0);
-		}
+		// The text is drawn from the glyph atlas, so (unlike rendering
+		// the whole text with SDL_ttf) this is cheap, also when the text
+		// changes every frame.
+		return std::make_unique<GLImage>(atlas, wrappedText,
+		                                 narrow_cast<uint8_t>(textRgba >> 24),
+		                                 narrow_cast<uint8_t>(textRgba >> 16),
+		                                 narrow_cast<uint8_t>(textRgba >>  8));
 	} catch (MSXException& e) {
 		throw MSXException("Couldn't render text: ", e.getMessage());
 	}
@@ -281,12 +276,11 @@ size_t OSDText::split(const std::string& line, unsigned maxWidth,
                       bool removeTrailingSpaces) const
 {
 	if (line.empty()) {
-		// empty line always fits (explicitly handle this because
-		// SDL_TTF can't handle empty strings)
+		// empty line always fits
 		return 0;
 	}
 
-	if (unsigned width = font.getSize(line).x; width <= maxWidth) {
+	if (auto width = unsigned(atlas->getWidth(line)); width <= maxWidth) {
 		// whole line fits
 		return line.size();
 	}
@@ -310,7 +304,7 @@ size_t OSDText::split(const std::string& line, unsigned maxWidth,
 		if (removeTrailingSpaces) {
 			StringOp::trimRight(curStr, ' ');
 		}
-		unsigned width2 = font.getSize(curStr).x;
+		auto width2 = unsigned(atlas->getWidth(curStr));
 		if (width2 <= maxWidth) {
 			// still fits, try to enlarge
 			size_t next = findSplitPoint(line, cur, max);
@@ -2,7 +2,6 @@
 #define OSDTEXT_HH
 
 #include "OSDImageBasedWidget.hh"
-#include "TTFFont.hh"
 
 #include "stl.hh"
 
@@ -12,6 +11,8 @@
 
 namespace openmsx {
 
+class GLGlyphAtlas;
+
 class OSDText final : public OSDImageBasedWidget
 {
 private:
@@ -56,7 +57,7 @@ private:
 
 	std::string text;
 	std::string fontFile;
-	TTFFont font;
+	std::shared_ptr<GLGlyphAtlas> atlas; // glyphs of the font (at the current size)
 	int size = 12;
 	int fontFaceIndex = 0;
 	WrapMode wrapMode = NONE;
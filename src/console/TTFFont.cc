@@ -262,6 +262,36 @@ int TTFFont::getWidth() const
 	return advance;
 }
 
+SDLSurfacePtr TTFFont::renderGlyph(char32_t c) const
+{
+	SDL_Color white = { 255, 255, 255, 255 };
+	return SDLSurfacePtr(TTF_RenderGlyph32_Blended(
+		static_cast<TTF_Font*>(font), c, white));
+}
+
+TTFFont::GlyphMetrics TTFFont::getGlyphMetrics(char32_t c) const
+{
+	GlyphMetrics result;
+	if (TTF_GlyphMetrics32(static_cast<TTF_Font*>(font), c,
+	                       &result.minX, nullptr /*maxx*/,
+	                       nullptr /*miny*/, nullptr /*maxy*/,
+	                       &result.advance)) {
+		// error? (e.g. glyph not in the font)
+		return {0, 0};
+	}
+	return result;
+}
+
+int TTFFont::getKerning(char32_t prev, char32_t c) const
+{
+	return TTF_GetFontKerningSizeGlyphs32(static_cast<TTF_Font*>(font), prev, c);
+}
+
+int TTFFont::getLineHeight() const
+{
+	return TTF_FontHeight(static_cast<TTF_Font*>(font));
+}
+
 gl::ivec2 TTFFont::getSize(zstring_view text) const
 {
 	int width, height;
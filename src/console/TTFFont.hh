@@ -75,6 +75,30 @@ public:
 	 */
 	[[nodiscard]] gl::ivec2 getSize(zstring_view text) const;
 
+	/** Render a single glyph to a new SDL_Surface, in white. The alpha
+	  * channel holds the coverage, so the glyph can be drawn in any color.
+	  * The result is getLineHeight() pixels high, and it's placed like
+	  * render() would place a text consisting of only this character.
+	  * Returns a null surface if there's nothing to render (e.g. a glyph
+	  * with zero width).
+	  */
+	[[nodiscard]] SDLSurfacePtr renderGlyph(char32_t c) const;
+
+	struct GlyphMetrics {
+		int minX;    // left edge, relative to the pen position
+		int advance; // distance to the pen position of the next glyph
+	};
+	/** Return the (horizontal) metrics of a single glyph. */
+	[[nodiscard]] GlyphMetrics getGlyphMetrics(char32_t c) const;
+
+	/** Return the kerning adjustment between two successive glyphs. */
+	[[nodiscard]] int getKerning(char32_t prev, char32_t c) const;
+
+	/** Return the height of a rendered line of text. Unlike getHeight()
+	  * this doesn't include the spacing between lines.
+	  */
+	[[nodiscard]] int getLineHeight() const;
+
 private:
 	void* font = nullptr;  // TTF_Font*
 };
@@ -14,6 +14,7 @@
 #include "ImGuiSymbols.hh"
 #include "ImGuiUtils.hh"
 #include "ImGuiVdpRegs.hh"
+#include "ImGuiVramAccess.hh"
 #include "ImGuiWatchExpr.hh"
 
 #include "Debuggable.hh"
@@ -281,6 +282,7 @@ void ImGuiDebugger::showMenu(MSXMotherBoard* motherBoard)
 		}
 		ImGui::MenuItem("Raster beam viewer", nullptr, &manager.rasterViewer->show);
 		ImGui::MenuItem("VDP register viewer", nullptr, &manager.vdpRegs->show);
+		ImGui::MenuItem("VRAM access statistics", nullptr, &manager.vramAccess->show);
 		ImGui::MenuItem("Palette editor", nullptr, &manager.palette->window.open);
 		ImGui::Separator();
 		im::Menu("Add hex editor", [&]{
@@ -28,6 +28,7 @@
 #include "ImGuiTrainer.hh"
 #include "ImGuiUtils.hh"
 #include "ImGuiVdpRegs.hh"
+#include "ImGuiVramAccess.hh"
 #include "ImGuiWatchExpr.hh"
 #include "ImGuiWaveViewer.hh"
 
@@ -174,6 +175,7 @@ ImGuiManager::ImGuiManager(Reactor& reactor_)
 	watchExpr = std::make_unique<ImGuiWatchExpr>(*this);
 	traceViewer = std::make_unique<ImGuiTraceViewer>(*this);
 	vdpRegs = std::make_unique<ImGuiVdpRegs>(*this);
+	vramAccess = std::make_unique<ImGuiVramAccess>(*this);
 	palette = std::make_unique<ImGuiPalette>(*this);
 	plotterViewer = std::make_unique<ImGuiPlotterViewer>(*this);
 	rasterViewer = std::make_unique<ImGuiRasterViewer>(*this, *traceViewer);
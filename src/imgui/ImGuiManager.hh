@@ -56,6 +56,7 @@ class ImGuiTools;
 class ImGuiTraceViewer;
 class ImGuiTrainer;
 class ImGuiVdpRegs;
+class ImGuiVramAccess;
 class ImGuiWatchExpr;
 class ImGuiWaveViewer;
 class RomInfo;
@@ -160,6 +161,7 @@ public:
 	std::unique_ptr<ImGuiWatchExpr> watchExpr;
 	std::unique_ptr<ImGuiTraceViewer> traceViewer;
 	std::unique_ptr<ImGuiVdpRegs> vdpRegs;
+	std::unique_ptr<ImGuiVramAccess> vramAccess;
 	std::unique_ptr<ImGuiPalette> palette;
 	std::unique_ptr<ImGuiPlotterViewer> plotterViewer;
 	std::unique_ptr<ImGuiRasterViewer> rasterViewer;
@@ -0,0 +1,191 @@
+#include "ImGuiVramAccess.hh"
+
+#include "ImGuiCpp.hh"
+#include "ImGuiManager.hh"
+#include "ImGuiPlot.hh"
+#include "ImGuiUtils.hh"
+
+#include "MSXMotherBoard.hh"
+#include "VDP.hh"
+#include "VDPVRAM.hh"
+#include "VRAMAccessStats.hh"
+
+#include "MemBuffer.hh"
+#include "narrow.hh"
+#include "xrange.hh"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace openmsx {
+
+using namespace std::literals;
+using Access = VRAMAccessStats::Access;
+
+static constexpr std::array<const char*, VRAMAccessStats::NUM_ACCESS> accessLabels = {
+	"CPU read", "CPU write", "Command read", "Command write"
+};
+
+void ImGuiVramAccess::save(ImGuiTextBuffer& buf)
+{
+	savePersistent(buf, *this, persistentElements);
+}
+
+void ImGuiVramAccess::loadLine(std::string_view name, zstring_view value)
+{
+	loadOnePersistent(name, value, *this, persistentElements);
+}
+
+void ImGuiVramAccess::paint(MSXMotherBoard* motherBoard)
+{
+	if (!show || !motherBoard) return;
+
+	ImGui::SetNextWindowSize(gl::vec2{36, 44} * ImGui::GetFontSize(), ImGuiCond_FirstUseEver);
+	im::Window("VRAM access statistics", &show, [&]{
+		auto* vdp = dynamic_cast<VDP*>(motherBoard->findDevice("VDP")); // TODO name based OK?
+		if (!vdp) return;
+		auto& vram = vdp->getVRAM();
+
+		bool enabled = vram.getAccessStats() != nullptr;
+		if (ImGui::Checkbox("Collect statistics", &enabled)) {
+			vram.setAccessStatsEnabled(enabled);
+		}
+		simpleToolTip("Count the VRAM accesses of the CPU and of the command engine. "
+		              "This slows down the emulation a bit. The same statistics are "
+		              "available via the 'vram_stats' Tcl command.");
+		auto* stats = vram.getAccessStats();
+		if (!stats) return;
+
+		ImGui::Separator();
+		paintFrameCounts(*stats);
+		ImGui::Separator();
+		paintHeatmap(*stats);
+	});
+}
+
+void ImGuiVramAccess::paintFrameCounts(const VRAMAccessStats& stats)
+{
+	const auto& history = stats.getHistory();
+	if (history.empty()) {
+		ImGui::TextUnformatted("Waiting for the first frame to finish ..."sv);
+		return;
+	}
+	const auto& last = history[history.size() - 1];
+
+	ImGui::TextUnformatted("Last frame:"sv);
+	im::Table("##counts", 2, ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingFixedFit, [&]{
+		auto row = [](const char* label, uint32_t value) {
+			if (ImGui::TableNextColumn()) ImGui::TextUnformatted(label);
+			if (ImGui::TableNextColumn()) ImGui::Text("%8u", value);
+		};
+		for (auto i : xrange(VRAMAccessStats::NUM_ACCESS)) {
+			row(accessLabels[i], last.counts[i]);
+		}
+		row("Total", last.total());
+		row("Access slots", last.slots);
+	});
+	ImGui::Text("Slot utilization: %5.1f%%", double(100.0f * last.utilization()));
+	simpleToolTip("Fraction of the VRAM access slots (outside of the slots reserved "
+	              "for the display) that was used by the CPU or the command engine.");
+
+	std::array<float, VRAMAccessStats::HISTORY> utilization;
+	auto num = history.size();
+	for (auto i : xrange(num)) {
+		utilization[i] = history[i].utilization();
+	}
+	ImGui::TextUnformatted("Utilization of the last frames:"sv);
+	auto size = gl::vec2{ImGui::GetContentRegionAvail().x, 4.0f * ImGui::GetFrameHeight()};
+	plotLines(std::span{utilization}.first(num), 0.0f, 1.0f, size);
+}
+
+void ImGuiVramAccess::paintHeatmap(VRAMAccessStats& stats)
+{
+	ImGui::Text("Heatmap, accumulated over %u frames", stats.getHeatmapFrames());
+	ImGui::SameLine();
+	if (ImGui::Button("Clear")) {
+		stats.clearHeatmap();
+	}
+	ImGui::SetNextItemWidth(ImGui::GetFontSize() * 9.0f);
+	ImGui::Combo("Accesses", &heatmapSource, "All\000CPU read\000CPU write\000Command read\000Command write\000");
+	simpleToolTip("With 'All', command engine accesses are shown in red, CPU accesses in green.");
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(ImGui::GetFontSize() * 4.0f);
+	ImGui::Combo("Zoom", &heatmapZoom, "1x\0002x\0003x\0004x\000");
+
+	auto get = [&](Access a) { return stats.getHeatmap(a); };
+	auto cpuRd = get(Access::CPU_READ);
+	auto cpuWr = get(Access::CPU_WRITE);
+	auto cmdRd = get(Access::CMD_READ);
+	auto cmdWr = get(Access::CMD_WRITE);
+	auto vramSize = cpuRd.size();
+
+	// Count per address, for the selected type(s).
+	auto cpuCount = [&](size_t addr) -> uint64_t {
+		switch (heatmapSource) {
+		case 0: return uint64_t(cpuRd[addr]) + cpuWr[addr];
+		case 1: return cpuRd[addr];
+		case 2: return cpuWr[addr];
+		default: return 0;
+		}
+	};
+	auto cmdCount = [&](size_t addr) -> uint64_t {
+		switch (heatmapSource) {
+		case 0: return uint64_t(cmdRd[addr]) + cmdWr[addr];
+		case 3: return cmdRd[addr];
+		case 4: return cmdWr[addr];
+		default: return 0;
+		}
+	};
+	uint64_t maxCount = 0;
+	for (auto addr : xrange(vramSize)) {
+		maxCount = std::max({maxCount, cpuCount(addr), cmdCount(addr)});
+	}
+	// Logarithmic scale, otherwise a few hot spots hide everything else.
+	float scale = 255.0f / std::log1p(float(std::max(maxCount, uint64_t(1))));
+	auto intensity = [&](uint64_t count) {
+		return count ? std::max(64u, unsigned(std::log1p(float(count)) * scale)) : 0u;
+	};
+
+	// One pixel per address, 256 addresses per line.
+	static constexpr int WIDTH = 256;
+	auto height = narrow<int>(vramSize / WIDTH);
+	MemBuffer<uint32_t> pixels(vramSize);
+	for (auto addr : xrange(vramSize)) {
+		auto cpu = intensity(cpuCount(addr));
+		auto cmd = intensity(cmdCount(addr));
+		uint32_t rgb = (heatmapSource == 0)
+			? ((cmd << 0) | (cpu << 8))        // red / green
+			: (cpu | cmd) * 0x010101;          // only one of both is non-zero
+		pixels[addr] = 0xff000000 | rgb;
+	}
+	if (!heatmapTex) {
+		heatmapTex.emplace(false, false); // no interpolation, no wrapping
+	}
+	heatmapTex->bind();
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, WIDTH, height, 0,
+	             GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	auto zoom = float(heatmapZoom + 1);
+	auto size = gl::vec2(float(WIDTH), float(height)) * zoom;
+	im::Child("##heatmap", {0.0f, 0.0f}, 0, ImGuiWindowFlags_HorizontalScrollbar, [&]{
+		gl::vec2 scrnPos = ImGui::GetCursorScreenPos();
+		ImGui::Image(heatmapTex->getImGui(), size);
+		if (ImGui::IsItemHovered()) {
+			auto [x, y] = trunc((gl::vec2(ImGui::GetIO().MousePos) - scrnPos) / zoom);
+			if ((0 <= x) && (x < WIDTH) && (0 <= y) && (y < height)) {
+				auto addr = size_t(y * WIDTH + x);
+				im::Tooltip([&]{
+					ImGui::StrCat("Address: 0x", hex_string<5>(addr));
+					for (auto i : xrange(VRAMAccessStats::NUM_ACCESS)) {
+						ImGui::Text("%s: %u", accessLabels[i], stats.getHeatmap(Access(i))[addr]);
+					}
+				});
+			}
+		}
+	});
+}
+
+} // namespace openmsx
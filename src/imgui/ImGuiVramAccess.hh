@@ -0,0 +1,45 @@
+#ifndef IMGUI_VRAM_ACCESS_HH
+#define IMGUI_VRAM_ACCESS_HH
+
+#include "ImGuiPart.hh"
+
+#include "GLUtil.hh"
+
+#include <optional>
+
+namespace openmsx {
+
+class VRAMAccessStats;
+
+class ImGuiVramAccess final : public ImGuiPart
+{
+public:
+	using ImGuiPart::ImGuiPart;
+
+	[[nodiscard]] zstring_view iniName() const override { return "vram access"; }
+	void save(ImGuiTextBuffer& buf) override;
+	void loadLine(std::string_view name, zstring_view value) override;
+	void paint(MSXMotherBoard* motherBoard) override;
+
+private:
+	void paintFrameCounts(const VRAMAccessStats& stats);
+	void paintHeatmap(VRAMAccessStats& stats);
+
+public:
+	bool show = false;
+
+private:
+	std::optional<gl::Texture> heatmapTex;
+	int heatmapSource = 0; // 0 = all, otherwise 1 + VRAMAccessStats::Access
+	int heatmapZoom = 1; // 0->1x, 1->2x, ..., 3->4x
+
+	static constexpr auto persistentElements = std::tuple{
+		PersistentElement   {"show",   &ImGuiVramAccess::show},
+		PersistentElementMax{"source", &ImGuiVramAccess::heatmapSource, 5},
+		PersistentElementMax{"zoom",   &ImGuiVramAccess::heatmapZoom, 4},
+	};
+};
+
+} // namespace openmsx
+
+#endif
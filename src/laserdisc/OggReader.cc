@@ -3,6 +3,7 @@
 #include "yuv2rgb.hh"
 
 #include "CliComm.hh"
+#include "FileOperations.hh"
 #include "MSXException.hh"
 
 #include "MemoryOps.hh"
@@ -13,10 +14,13 @@
 #include "xrange.hh"
 
 #include <algorithm>
+#include <cassert>
 #include <cctype> // for isspace
 #include <cstdlib> // for atoi
+#include <fstream>
 #include <memory>
 #include <ranges>
+#include <sstream>
 
 // TODO
 // - Improve error handling
@@ -48,6 +52,170 @@ Frame::~Frame()
 }
 
 
+static constexpr std::string_view INDEX_HEADER = "openMSX ogg seek index 1";
+
+OggSeekIndex::OggSeekIndex(size_t fileSize_, time_t fileTime_, size_t totalFrames_,
+                           std::vector<Entry> entries_)
+	: fileSize(fileSize_), fileTime(fileTime_), totalFrames(totalFrames_)
+	, entries(std::move(entries_))
+{
+	assert(!entries.empty());
+}
+
+// Parse a line of the index file, it must contain exactly the given numbers.
+template<typename... Ts>
+[[nodiscard]] static bool parseLine(const std::string& line, Ts&... values)
+{
+	std::istringstream in(line);
+	return (in >> ... >> values) && (in >> std::ws).eof();
+}
+
+std::optional<OggSeekIndex> OggSeekIndex::load(
+	const std::string& filename, size_t fileSize, time_t fileTime)
+{
+	if (!FileOperations::isRegularFile(filename)) return {};
+	std::string text;
+	try {
+		File file(filename);
+		text.resize(file.getSize());
+		file.read(std::span{text});
+	} catch (MSXException&) {
+		return {};
+	}
+	// save() ends every line with a newline, without it the file is
+	// truncated (the last entry might be incomplete).
+	if (!text.ends_with('\n')) return {};
+
+	std::istringstream in(text);
+	std::string line;
+	if (!std::getline(in, line) || (line != INDEX_HEADER)) return {};
+
+	size_t size, frames;
+	time_t time;
+	if (!std::getline(in, line) || !parseLine(line, size, time, frames)) return {};
+	if ((size != fileSize) || (time != fileTime)) return {}; // stale
+
+	std::vector<Entry> entries;
+	while (std::getline(in, line)) {
+		Entry e;
+		if (!parseLine(line, e.offset, e.frame, e.sample)) return {}; // corrupt
+		if (!entries.empty()) {
+			const auto& last = entries.back();
+			if ((e.offset < last.offset) || (e.frame < last.frame) ||
+			    (e.sample < last.sample)) {
+				return {}; // corrupt
+			}
+		}
+		entries.push_back(e);
+	}
+	if (entries.empty()) return {};
+	return OggSeekIndex(size, time, frames, std::move(entries));
+}
+
+void OggSeekIndex::save(const std::string& filename) const
+{
+	std::ofstream file;
+	FileOperations::openOfStream(file, filename);
+	if (!file.is_open()) {
+		return;
+	}
+	file << INDEX_HEADER << '\n'
+	     << fileSize << ' ' << fileTime << ' ' << totalFrames << '\n';
+	for (const auto& e : entries) {
+		file << e.offset << ' ' << e.frame << ' ' << e.sample << '\n';
+	}
+}
+
+const OggSeekIndex::Entry& OggSeekIndex::find(size_t frame, size_t sample) const
+{
+	auto it = std::min(std::ranges::upper_bound(entries, frame, {}, &Entry::frame),
+	                   std::ranges::upper_bound(entries, sample, {}, &Entry::sample));
+	return (it == begin(entries)) ? *it : *(it - 1);
+}
+
+
+OggIndexBuilder::OggIndexBuilder(
+		const std::string& filename, time_t fileTime_,
+		int videoSerial_, int audioSerial_, int granuleShift_)
+	: file(filename)
+	, fileSize(file.getSize())
+	, fileTime(fileTime_)
+	, videoSerial(videoSerial_)
+	, audioSerial(audioSerial_)
+	, granuleShift(granuleShift_)
+{
+	ogg_sync_init(&sync);
+	// keyframe 1 and sample 0 are at the start of the file
+	entries.push_back({.offset = 0, .frame = 1, .sample = 0});
+}
+
+OggIndexBuilder::~OggIndexBuilder()
+{
+	ogg_sync_clear(&sync);
+}
+
+bool OggIndexBuilder::scan()
+{
+	static constexpr size_t CHUNK = 64 * 1024;
+	static constexpr int CHUNKS_PER_SCAN = 16;
+
+	repeat(CHUNKS_PER_SCAN, [&] {
+		ogg_page page;
+		long ret;
+		while ((ret = ogg_sync_pageseek(&sync, &page)) != 0) {
+			if (ret > 0) {
+				addPage(page, pageOffset);
+				pageOffset += ret;
+			} else {
+				pageOffset += -ret; // skipped garbage
+			}
+		}
+		if (readOffset == fileSize) return;
+
+		auto chunk = std::min(CHUNK, fileSize - readOffset);
+		char* buffer = ogg_sync_buffer(&sync, long(chunk));
+		file.read(std::span{buffer, chunk});
+		readOffset += chunk;
+		ogg_sync_wrote(&sync, long(chunk));
+	});
+	return readOffset == fileSize;
+}
+
+void OggIndexBuilder::addPage(const ogg_page& page, size_t offset)
+{
+	auto granule = ogg_page_granulepos(&page);
+	if (granule < 0) return; // no packet ends on this page
+
+	int serial = ogg_page_serialno(&page);
+	if (serial == audioSerial) {
+		prevAudioSample = lastAudioSample;
+		lastAudioSample = size_t(granule);
+	} else if (serial == videoSerial) {
+		size_t key = size_t(granule) >> granuleShift;
+		size_t intra = size_t(granule) & ((1uz << granuleShift) - 1);
+		totalFrames = std::max(totalFrames, key + intra);
+
+		if (key > lastKey) {
+			// The last packet on the previous video page belongs to
+			// an older keyframe, so this keyframe starts on or after
+			// that page. Vorbis can't decode the first packet after
+			// a seek, so go back one audio page more than needed.
+			entries.push_back({.offset = lastVideoOffset,
+			                   .frame = key,
+			                   .sample = lastVideoSample});
+			lastKey = key;
+		}
+		lastVideoOffset = offset;
+		lastVideoSample = prevAudioSample;
+	}
+}
+
+OggSeekIndex OggIndexBuilder::getResult()
+{
+	return {fileSize, fileTime, totalFrames, std::move(entries)};
+}
+
+
 OggReader::OggReader(const std::string& filename, CliComm& cli_)
 	: cli(cli_)
 	, file(filename)
@@ -192,6 +360,23 @@ OggReader::OggReader(const std::string& filename, CliComm& cli_)
 	th_setup_free(tsi);
 	th_info_clear(&ti);
 	th_comment_clear(&tc);
+
+	indexFilename = filename + ".idx";
+	auto fileTime = file.getModificationDate();
+	seekIndex = OggSeekIndex::load(indexFilename, fileSize, fileTime);
+	if (seekIndex) {
+		totalFrames = seekIndex->getTotalFrames();
+	} else {
+		try {
+			indexBuilder = std::make_unique<OggIndexBuilder>(
+				filename, fileTime, videoSerial, audioSerial, granuleShift);
+		} catch (MSXException&) {
+			// ignore, seeking falls back to bisection
+		}
+	}
+	printWarnings();
+
+	worker = std::thread([this] { decodeAhead(); });
 }
 
 void OggReader::cleanup()
@@ -218,9 +403,90 @@ void OggReader::cleanup()
 
 OggReader::~OggReader()
 {
+	{
+		std::scoped_lock lock(mutex);
+		stopWorker = true;
+	}
+	cond.notify_one();
+	worker.join();
+
 	cleanup();
 }
 
+OggReader::Lock::Lock(OggReader& reader_)
+	: reader(reader_)
+{
+	++reader.waiting;
+	lock = std::unique_lock(reader.mutex);
+	--reader.waiting;
+}
+
+OggReader::Lock::~Lock()
+{
+	reader.printWarnings();
+	lock.unlock();
+	reader.cond.notify_one();
+}
+
+void OggReader::printWarnings()
+{
+	for (const auto& w : warnings) {
+		cli.printWarning(w);
+	}
+	warnings.clear();
+}
+
+bool OggReader::needDecodeAhead() const
+{
+	return !endOfStream &&
+	       frameList.size() < FRAMES_AHEAD &&
+	       audioList.size() < AUDIO_AHEAD;
+}
+
+void OggReader::decodeAhead()
+{
+	std::unique_lock lock(mutex);
+	while (true) {
+		cond.wait(lock, [&] {
+			return stopWorker ||
+			       ((waiting == 0) && (needDecodeAhead() || indexBuilder));
+		});
+		if (stopWorker) return;
+
+		if (needDecodeAhead()) {
+			// Decode one packet at a time, so that the emulation
+			// thread never has to wait long for the lock.
+			try {
+				if (!nextPacket()) {
+					endOfStream = true;
+				}
+			} catch (MSXException& e) {
+				warning("Error reading laserdisc video: ", e.getMessage());
+				endOfStream = true;
+			}
+		} else {
+			// Nothing to decode, meanwhile work on the seek index.
+			// That doesn't touch any shared state, so unlock.
+			lock.unlock();
+			std::optional<OggSeekIndex> result;
+			try {
+				if (indexBuilder->scan()) {
+					result = indexBuilder->getResult();
+					result->save(indexFilename);
+				}
+			} catch (MSXException&) {
+				// ignore, seeking falls back to bisection
+				indexBuilder.reset();
+			}
+			lock.lock();
+			if (result) {
+				seekIndex = std::move(result);
+				indexBuilder.reset();
+			}
+		}
+	}
+}
+
 /** Vorbis only records the ogg position (in no. of samples) once per ogg
  * page. After seeking we have already decoded some audio before we encounter
  * the exact position we are at. Fixup the positions and discard any unwanted
@@ -236,7 +502,7 @@ void OggReader::vorbisFoundPosition()
 
 	// last is now the first vorbis audio decoded
 	if (last > currentSample) {
-		cli.printWarning("missing part of audio stream");
+		warning("missing part of audio stream");
 	}
 
 	currentSample = std::max(currentSample, vorbisPos);
@@ -393,7 +659,7 @@ void OggReader::readVorbis(ogg_packet* packet)
 			vorbisFoundPosition();
 		} else {
 			if (vorbisPos != size_t(packet->granulepos)) {
-				cli.printWarning(
+				warning(
 					"vorbis audio out of sync, expected ",
 					vorbisPos, ", got ", packet->granulepos);
 				vorbisPos = packet->granulepos;
@@ -514,25 +780,25 @@ void OggReader::readTheora(ogg_packet* packet)
 	switch (rc) {
 	case TH_DUPFRAME:
 		if (frameList.empty()) {
-			cli.printWarning("Theora error: dup frame encountered "
+			warning("Theora error: dup frame encountered "
 					 "without preceding frame");
 		} else {
 			frameList.back()->length++;
 		}
 		break;
 	case TH_EIMPL:
-		cli.printWarning("Theora error: not capable of reading this");
+		warning("Theora error: not capable of reading this");
 		break;
 	case TH_EFAULT:
-		cli.printWarning("Theora error: API not used correctly");
+		warning("Theora error: API not used correctly");
 		break;
 	case TH_EBADPACKET:
-		cli.printWarning("Theora error: bad packet");
+		warning("Theora error: bad packet");
 		break;
 	case 0:
 		break;
 	default:
-		cli.printWarning("Theora error: unknown error ", rc);
+		warning("Theora error: unknown error ", rc);
 		break;
 	}
 
@@ -572,7 +838,7 @@ void OggReader::readTheora(ogg_packet* packet)
 	Frame* last = frameList.empty() ? nullptr : frameList.back().get();
 	if (last && (last->no != size_t(-1))) {
 		if (frameno != one_of(size_t(-1), last->no + last->length)) {
-			cli.printWarning("Theora frame sequence wrong");
+			warning("Theora frame sequence wrong");
 		} else {
 			frameno = last->no + last->length;
 		}
@@ -597,14 +863,26 @@ void OggReader::readTheora(ogg_packet* packet)
 
 void OggReader::getFrameNo(RawFrame& rawFrame, size_t frameno)
 {
-	Frame* frame;
+	const Frame* frame = [&] {
+		Lock lock(*this);
+		return findFrame(frameno);
+	}();
+	// Only the emulation thread removes frames from 'frameList', so
+	// this can be done without holding the lock.
+	if (frame) {
+		yuv2rgb::convert(frame->buffer, rawFrame);
+	}
+}
+
+const Frame* OggReader::findFrame(size_t frameno)
+{
 	while (true) {
 		// If there are no frames or the frames we have read
 		// does not include a proper frame number, just read
 		// more data
 		if (frameList.empty() || (frameList[0]->no == size_t(-1))) {
 			if (!nextPacket()) {
-				return;
+				return nullptr;
 			}
 			continue;
 		}
@@ -618,42 +896,38 @@ void OggReader::getFrameNo(RawFrame& rawFrame, size_t frameno)
 
 		if (!frameList.empty() && frameList[0]->no > frameno) {
 			// we're missing frames!
-			frame = frameList[0].get();
-			cli.printWarning(
+			const Frame* frame = frameList[0].get();
+			warning(
 					"Cannot find frame ", frameno, " using ",
 			        frame->no, " instead");
-			break;
+			return frame;
 		}
 
 		if ((frameList.size() >= 2) &&
 		    ((frameno >= frameList[0]->no) &&
 		     (frameno <  frameList[1]->no))) {
-			frame = frameList[0].get();
-			break;
+			return frameList[0].get();
 		}
 
 		if ((frameList.size() >= 3) &&
 		    ((frameno >= frameList[1]->no) &&
 		     (frameno <  frameList[2]->no))) {
-			frame = frameList[1].get();
-			break;
+			return frameList[1].get();
 		}
 
 		// Sanity check, should not happen
 		if (frameList.size() > (2uz << granuleShift)) {
 			// We've got more than twice as many frames
 			// as the maximum distance between key frames.
-			cli.printWarning("Cannot find frame ", frameno);
-			return;
+			warning("Cannot find frame ", frameno);
+			return nullptr;
 		}
 
 		// ..add read some new ones
 		if (!nextPacket()) {
-			return;
+			return nullptr;
 		}
 	}
-
-	yuv2rgb::convert(frame->buffer, rawFrame);
 }
 
 void OggReader::recycleAudio(std::unique_ptr<AudioFragment> audio)
@@ -664,6 +938,10 @@ void OggReader::recycleAudio(std::unique_ptr<AudioFragment> audio)
 
 const AudioFragment* OggReader::getAudio(size_t sample)
 {
+	// The returned fragment stays valid after unlocking, only the
+	// emulation thread removes fragments from 'audioList'.
+	Lock lock(*this);
+
 	// Read while position is unknown
 	while (audioList.empty() ||
 	       audioList.front()->position == AudioFragment::UNKNOWN_POS) {
@@ -736,14 +1014,14 @@ bool OggReader::nextPacket()
 		int serial = ogg_page_serialno(&page);
 		if (serial == audioSerial) {
 			if (ogg_stream_pagein(&vorbisStream, &page)) {
-				cli.printWarning("Failed to submit vorbis page");
+				warning("Failed to submit vorbis page");
 			}
 		} else if (serial == videoSerial) {
 			if (ogg_stream_pagein(&theoraStream, &page)) {
-				cli.printWarning("Failed to submit theora page");
+				warning("Failed to submit theora page");
 			}
 		} else if (serial != skeletonSerial) {
-			cli.printWarning("Unexpected stream with serial ",
+			warning("Unexpected stream with serial ",
 			                 serial, " in ogg file");
 		}
 	}
@@ -774,7 +1052,7 @@ bool OggReader::nextPage(ogg_page* page)
 		fileOffset += chunk;
 
 		if (ogg_sync_wrote(&sync, long(chunk)) == -1) {
-			cli.printWarning("Internal error: ogg_sync_wrote failed");
+			warning("Internal error: ogg_sync_wrote failed");
 		}
 	}
 
@@ -847,6 +1125,14 @@ size_t OggReader::findOffset(size_t frame, size_t sample)
 	// we assume that only data will be added to it and the ogg streams
 	// are exactly as before
 	fileSize = file.getSize();
+
+	if (seekIndex && (seekIndex->getFileSize() == fileSize)) {
+		totalFrames = seekIndex->getTotalFrames();
+		const auto& entry = seekIndex->find(frame, sample);
+		keyFrame = entry.frame;
+		return entry.offset;
+	}
+
 	auto offset = fileSize - 1;
 
 	while (offset > 0) {
@@ -919,6 +1205,8 @@ size_t OggReader::findOffset(size_t frame, size_t sample)
 
 bool OggReader::seek(size_t frame, size_t samples)
 {
+	Lock lock(*this);
+
 	// Remove all queued frames
 	recycleFrameList.insert(end(recycleFrameList),
 		std::move_iterator(begin(frameList)),
@@ -944,6 +1232,7 @@ bool OggReader::seek(size_t frame, size_t samples)
 	currentSample = samples;
 
 	vorbis_synthesis_restart(&vd);
+	endOfStream = false;
 
 	return true;
 }
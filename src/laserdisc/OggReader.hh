@@ -5,16 +5,23 @@
 
 #include "circular_buffer.hh"
 #include "narrow.hh"
+#include "strCat.hh"
 
 #include <ogg/ogg.h>
 #include <theora/theoradec.h>
 #include <vorbis/codec.h>
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <ctime>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace openmsx {
@@ -45,6 +52,92 @@ struct Frame
 	int length;
 };
 
+/** Maps theora keyframes to file offsets, so that a seek can start reading
+  * (almost) at the right spot, instead of bisecting the ogg file. Building
+  * it requires a scan of the whole file, so it's cached in a file next to
+  * the video.
+  */
+class OggSeekIndex
+{
+public:
+	struct Entry {
+		size_t offset; // start of an ogg page
+		size_t frame;  // keyframe that is completely contained after 'offset'
+		size_t sample; // audio from this sample on is contained after 'offset'
+	};
+
+	OggSeekIndex(size_t fileSize, time_t fileTime, size_t totalFrames,
+	             std::vector<Entry> entries);
+
+	/** Returns std::nullopt if there's no (valid) index for this version
+	  * (size and modification time) of the video file.
+	  */
+	[[nodiscard]] static std::optional<OggSeekIndex> load(
+		const std::string& filename, size_t fileSize, time_t fileTime);
+	/** Errors are ignored, e.g. the directory might be read-only. */
+	void save(const std::string& filename) const;
+
+	/** Find the last entry from which both the keyframe for the given
+	  * frame and the given audio sample can be decoded.
+	  */
+	[[nodiscard]] const Entry& find(size_t frame, size_t sample) const;
+	[[nodiscard]] size_t getFileSize() const { return fileSize; }
+	[[nodiscard]] size_t getTotalFrames() const { return totalFrames; }
+
+private:
+	size_t fileSize;
+	time_t fileTime;
+	size_t totalFrames;
+	std::vector<Entry> entries; // sorted on offset, frame and sample
+};
+
+/** Builds an OggSeekIndex by reading through the ogg file (in parts, so it
+  * can be done in between other work). Only the ogg page headers are
+  * looked at, nothing is decoded.
+  */
+class OggIndexBuilder
+{
+public:
+	OggIndexBuilder(const std::string& filename, time_t fileTime,
+	                int videoSerial, int audioSerial, int granuleShift);
+	OggIndexBuilder(const OggIndexBuilder&) = delete;
+	OggIndexBuilder(OggIndexBuilder&&) = delete;
+	OggIndexBuilder& operator=(const OggIndexBuilder&) = delete;
+	OggIndexBuilder& operator=(OggIndexBuilder&&) = delete;
+	~OggIndexBuilder();
+
+	/** Scan the next part of the file, returns true when done. */
+	bool scan();
+	[[nodiscard]] OggSeekIndex getResult();
+
+private:
+	void addPage(const ogg_page& page, size_t offset);
+
+private:
+	File file;
+	ogg_sync_state sync;
+	size_t fileSize;
+	time_t fileTime;
+	size_t readOffset{0};
+	size_t pageOffset{0};
+	int videoSerial;
+	int audioSerial;
+	int granuleShift;
+
+	size_t totalFrames{0};
+	size_t lastKey{1};
+	size_t lastVideoOffset{0};
+	size_t lastVideoSample{0};
+	size_t lastAudioSample{0};
+	size_t prevAudioSample{0};
+	std::vector<OggSeekIndex::Entry> entries;
+};
+
+/** Decodes a theora/vorbis ogg file. A background thread decodes a bounded
+  * number of frames and audio fragments ahead of what was last requested,
+  * so that (normally) getFrameNo() and getAudio() don't have to wait for
+  * the decoder.
+  */
 class OggReader
 {
 public:
@@ -79,6 +172,33 @@ private:
 	void recycleAudio(std::unique_ptr<AudioFragment> audio);
 	void vorbisFoundPosition();
 	size_t frameNo(const ogg_packet* packet) const;
+	const Frame* findFrame(size_t frameno);
+
+	template<typename... Args>
+	void warning(Args&& ...args) {
+		// Might be called from the worker thread, so print later.
+		warnings.push_back(strCat(std::forward<Args>(args)...));
+	}
+	void printWarnings();
+
+	void decodeAhead();
+	[[nodiscard]] bool needDecodeAhead() const;
+
+	/** Lock for the emulation thread. The worker backs off while the
+	  * emulation thread is waiting for it.
+	  */
+	class Lock {
+	public:
+		explicit Lock(OggReader& reader);
+		Lock(const Lock&) = delete;
+		Lock(Lock&&) = delete;
+		Lock& operator=(const Lock&) = delete;
+		Lock& operator=(Lock&&) = delete;
+		~Lock();
+	private:
+		OggReader& reader;
+		std::unique_lock<std::mutex> lock;
+	};
 
 	size_t findOffset(size_t frame, size_t sample);
 	size_t bisection(size_t frame, size_t sample,
@@ -134,6 +254,23 @@ private:
 		size_t frame;
 	};
 	std::vector<ChapterFrame> chapters; // sorted on chapter
+
+	// Seek index, either loaded or being built by the worker
+	std::string indexFilename;
+	std::optional<OggSeekIndex> seekIndex;
+	std::unique_ptr<OggIndexBuilder> indexBuilder; // only used by the worker
+
+	// Decode-ahead worker. The ogg/decoder state and the frame and audio
+	// lists above are protected by 'mutex'.
+	static constexpr size_t FRAMES_AHEAD = 16;
+	static constexpr size_t AUDIO_AHEAD = 64; // fragments, includes 1s history
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::atomic<int> waiting{0}; // number of Locks waiting for 'mutex'
+	bool stopWorker{false};
+	bool endOfStream{false};
+	std::vector<std::string> warnings;
+	std::thread worker;
 };
 
 } // namespace openmsx
@@ -3,261 +3,28 @@
 #include "RawFrame.hh"
 
 #include "Math.hh"
+#include "simd.hh"
 #include "xrange.hh"
 
 #include <array>
 #include <bit>
 #include <cassert>
-#include <concepts>
 #include <cstdint>
-#ifdef __SSE2__
-#include <emmintrin.h>
+#ifdef __ARM_NEON
+#include <arm_neon.h>
 #endif
 
 namespace openmsx::yuv2rgb {
 
 using Pixel = uint32_t;
 
-#ifdef __SSE2__
-
-/*
- * This implementation of yuv420 to rgb is based upon the corresponding routine
- * from Mono. See this blog entry:
- *	http://blog.sublimeintervention.com/archive/2008/Mar-21.html
- * Source code:
- *	http://anonsvn.mono-project.com/viewvc/trunk/moon/src/yuv-converter.cpp?revision=136072
- * This code is GPL2 (only)
- *
- * Copyright 2008 Novell, Inc. (http://www.novell.com)
- *
- * There are other implementations:
- *  - ffmpeg
- *  - mythtv
- *  - pcsx2
- * I have not done a comparison of these implementations.
- */
-
 /* R = 1.164 * (Y - 16) + 1.596 * (V - 128)
  * G = 1.164 * (Y - 16) - 0.813 * (V - 128) - 0.391 * (U - 128)
  * B = 1.164 * (Y - 16)                     + 2.018 * (U - 128)
- *   OR
- * R = 1.164 * Y + 1.596 * V             - 222.921
- * G = 1.164 * Y - 0.813 * V - 0.391 * U + 135.576
- * B = 1.164 * Y             + 2.018 * U - 276.836
+ *
+ * All implementations below (plain C++ and SIMD) use exactly the same fixed
+ * point calculation, so they give identical results.
  */
-static inline void yuv2rgb_sse2(
-	const uint8_t* u_ , const uint8_t* v_,
-	const uint8_t* y0_, const uint8_t* y1_,
-	Pixel* out0_, Pixel* out1_)
-{
-	// This routine calculates 32x2 RGBA pixels. Each output pixel uses a
-	// unique corresponding input Y value, but a group of 2x2 ouput pixels
-	// shares the same U and V input value.
-	const auto* u    = std::bit_cast<const __m128i*>(u_);
-	const auto* v    = std::bit_cast<const __m128i*>(v_);
-	const auto* y0   = std::bit_cast<const __m128i*>(y0_);
-	const auto* y1   = std::bit_cast<const __m128i*>(y1_);
-	      auto* out0 = std::bit_cast<      __m128i*>(out0_);
-	      auto* out1 = std::bit_cast<      __m128i*>(out1_);
-
-	// constants
-	const __m128i ZERO    = _mm_setzero_si128();
-	const __m128i ALPHA   = _mm_set1_epi16(    -1); // 0xFFFF
-	const __m128i RED_V   = _mm_set1_epi16(   102); // 102/64 =  1.59
-	const __m128i GREEN_U = _mm_set1_epi16(   -25); // -25/64 = -0.39
-	const __m128i GREEN_V = _mm_set1_epi16(   -52); // -52/64 = -0.81
-	const __m128i BLUE_U  = _mm_set1_epi16(   129); // 129/64 =  2.02
-	const __m128i COEF_Y  = _mm_set1_epi16(    74); //  74/64 =  1.16
-	const __m128i CNST_R  = _mm_set1_epi16(  -223); // -222.921
-	const __m128i CNST_G  = _mm_set1_epi16(   136); //  135.576
-	const __m128i CNST_B  = _mm_set1_epi16(  -277); // -276.836
-	const __m128i Y_MASK  = _mm_set1_epi16(0x00FF);
-
-	// left
-	__m128i u0f  = _mm_loadu_si128(u);
-	__m128i v0f  = _mm_loadu_si128(v);
-	__m128i u07  = _mm_unpacklo_epi8(u0f, ZERO);
-	__m128i v07  = _mm_unpacklo_epi8(v0f, ZERO);
-	__m128i mr07 = _mm_srai_epi16(_mm_mullo_epi16(v07, RED_V), 6);
-	__m128i sg07 = _mm_mullo_epi16(v07, GREEN_V);
-	__m128i tg07 = _mm_mullo_epi16(u07, GREEN_U);
-	__m128i mg07 = _mm_srai_epi16(_mm_adds_epi16(sg07, tg07), 6);
-	__m128i mb07 = _mm_srli_epi16(_mm_mullo_epi16(u07, BLUE_U), 6); // logical shift
-	__m128i dr07 = _mm_adds_epi16(mr07, CNST_R);
-	__m128i dg07 = _mm_adds_epi16(mg07, CNST_G);
-	__m128i db07 = _mm_adds_epi16(mb07, CNST_B);
-
-	// block top,left
-	__m128i y00_0f    = _mm_loadu_si128(y0 + 0);
-	__m128i y00_even  = _mm_and_si128(y00_0f, Y_MASK);
-	__m128i y00_odd   = _mm_srli_epi16(y00_0f, 8);
-	__m128i dy00_even = _mm_srai_epi16(_mm_mullo_epi16(y00_even, COEF_Y), 6);
-	__m128i dy00_odd  = _mm_srai_epi16(_mm_mullo_epi16(y00_odd,  COEF_Y), 6);
-	__m128i r00_even  = _mm_adds_epi16(dr07, dy00_even);
-	__m128i g00_even  = _mm_adds_epi16(dg07, dy00_even);
-	__m128i b00_even  = _mm_adds_epi16(db07, dy00_even);
-	__m128i r00_odd   = _mm_adds_epi16(dr07, dy00_odd);
-	__m128i g00_odd   = _mm_adds_epi16(dg07, dy00_odd);
-	__m128i b00_odd   = _mm_adds_epi16(db07, dy00_odd);
-	__m128i r00_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(r00_even, r00_even),
-	                                      _mm_packus_epi16(r00_odd,  r00_odd));
-	__m128i g00_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(g00_even, g00_even),
-	                                      _mm_packus_epi16(g00_odd,  g00_odd));
-	__m128i b00_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(b00_even, b00_even),
-	                                      _mm_packus_epi16(b00_odd,  b00_odd));
-	__m128i rb00_07   = _mm_unpacklo_epi8(r00_0f, b00_0f);
-	__m128i rb00_8f   = _mm_unpackhi_epi8(r00_0f, b00_0f);
-	__m128i ga00_07   = _mm_unpacklo_epi8(g00_0f, ALPHA);
-	__m128i ga00_8f   = _mm_unpackhi_epi8(g00_0f, ALPHA);
-	__m128i rgba00_03 = _mm_unpacklo_epi8(rb00_07, ga00_07);
-	__m128i rgba00_47 = _mm_unpackhi_epi8(rb00_07, ga00_07);
-	__m128i rgba00_8b = _mm_unpacklo_epi8(rb00_8f, ga00_8f);
-	__m128i rgba00_cf = _mm_unpackhi_epi8(rb00_8f, ga00_8f);
-	_mm_storeu_si128(out0 + 0, rgba00_03);
-	_mm_storeu_si128(out0 + 1, rgba00_47);
-	_mm_storeu_si128(out0 + 2, rgba00_8b);
-	_mm_storeu_si128(out0 + 3, rgba00_cf);
-
-	// block bottom,left
-	__m128i y10_0f    = _mm_loadu_si128(y1 + 0);
-	__m128i y10_even  = _mm_and_si128(y10_0f, Y_MASK);
-	__m128i y10_odd   = _mm_srli_epi16(y10_0f, 8);
-	__m128i dy10_even = _mm_srai_epi16(_mm_mullo_epi16(y10_even, COEF_Y), 6);
-	__m128i dy10_odd  = _mm_srai_epi16(_mm_mullo_epi16(y10_odd,  COEF_Y), 6);
-	__m128i r10_even  = _mm_adds_epi16(dr07, dy10_even);
-	__m128i g10_even  = _mm_adds_epi16(dg07, dy10_even);
-	__m128i b10_even  = _mm_adds_epi16(db07, dy10_even);
-	__m128i r10_odd   = _mm_adds_epi16(dr07, dy10_odd);
-	__m128i g10_odd   = _mm_adds_epi16(dg07, dy10_odd);
-	__m128i b10_odd   = _mm_adds_epi16(db07, dy10_odd);
-	__m128i r10_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(r10_even, r10_even),
-	                                      _mm_packus_epi16(r10_odd,  r10_odd));
-	__m128i g10_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(g10_even, g10_even),
-	                                      _mm_packus_epi16(g10_odd,  g10_odd));
-	__m128i b10_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(b10_even, b10_even),
-	                                      _mm_packus_epi16(b10_odd,  b10_odd));
-	__m128i rb10_07   = _mm_unpacklo_epi8(r10_0f, b10_0f);
-	__m128i rb10_8f   = _mm_unpackhi_epi8(r10_0f, b10_0f);
-	__m128i ga10_07   = _mm_unpacklo_epi8(g10_0f, ALPHA);
-	__m128i ga10_8f   = _mm_unpackhi_epi8(g10_0f, ALPHA);
-	__m128i rgba10_03 = _mm_unpacklo_epi8(rb10_07, ga10_07);
-	__m128i rgba10_47 = _mm_unpackhi_epi8(rb10_07, ga10_07);
-	__m128i rgba10_8b = _mm_unpacklo_epi8(rb10_8f, ga10_8f);
-	__m128i rgba10_cf = _mm_unpackhi_epi8(rb10_8f, ga10_8f);
-	_mm_storeu_si128(out1 + 0, rgba10_03);
-	_mm_storeu_si128(out1 + 1, rgba10_47);
-	_mm_storeu_si128(out1 + 2, rgba10_8b);
-	_mm_storeu_si128(out1 + 3, rgba10_cf);
-
-	// right
-	__m128i u8f  = _mm_unpackhi_epi8(u0f, ZERO);
-	__m128i v8f  = _mm_unpackhi_epi8(v0f, ZERO);
-	__m128i mr8f = _mm_srai_epi16(_mm_mullo_epi16(v8f, RED_V), 6);
-	__m128i sg8f = _mm_mullo_epi16(v8f, GREEN_V);
-	__m128i tg8f = _mm_mullo_epi16(u8f, GREEN_U);
-	__m128i mg8f = _mm_srai_epi16(_mm_adds_epi16(sg8f, tg8f), 6);
-	__m128i mb8f = _mm_srli_epi16(_mm_mullo_epi16(u8f, BLUE_U), 6); // logical shift
-	__m128i dr8f = _mm_adds_epi16(mr8f, CNST_R);
-	__m128i dg8f = _mm_adds_epi16(mg8f, CNST_G);
-	__m128i db8f = _mm_adds_epi16(mb8f, CNST_B);
-
-	// block top,right
-	__m128i y01_0f    = _mm_loadu_si128(y0 + 1);
-	__m128i y01_even  = _mm_and_si128(y01_0f, Y_MASK);
-	__m128i y01_odd   = _mm_srli_epi16(y01_0f, 8);
-	__m128i dy01_even = _mm_srai_epi16(_mm_mullo_epi16(y01_even, COEF_Y), 6);
-	__m128i dy01_odd  = _mm_srai_epi16(_mm_mullo_epi16(y01_odd,  COEF_Y), 6);
-	__m128i r01_even  = _mm_adds_epi16(dr8f, dy01_even);
-	__m128i g01_even  = _mm_adds_epi16(dg8f, dy01_even);
-	__m128i b01_even  = _mm_adds_epi16(db8f, dy01_even);
-	__m128i r01_odd   = _mm_adds_epi16(dr8f, dy01_odd);
-	__m128i g01_odd   = _mm_adds_epi16(dg8f, dy01_odd);
-	__m128i b01_odd   = _mm_adds_epi16(db8f, dy01_odd);
-	__m128i r01_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(r01_even, r01_even),
-	                                      _mm_packus_epi16(r01_odd,  r01_odd));
-	__m128i g01_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(g01_even, g01_even),
-	                                      _mm_packus_epi16(g01_odd,  g01_odd));
-	__m128i b01_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(b01_even, b01_even),
-	                                      _mm_packus_epi16(b01_odd,  b01_odd));
-	__m128i rb01_07   = _mm_unpacklo_epi8(r01_0f, b01_0f);
-	__m128i rb01_8f   = _mm_unpackhi_epi8(r01_0f, b01_0f);
-	__m128i ga01_07   = _mm_unpacklo_epi8(g01_0f, ALPHA);
-	__m128i ga01_8f   = _mm_unpackhi_epi8(g01_0f, ALPHA);
-	__m128i rgba01_03 = _mm_unpacklo_epi8(rb01_07, ga01_07);
-	__m128i rgba01_47 = _mm_unpackhi_epi8(rb01_07, ga01_07);
-	__m128i rgba01_8b = _mm_unpacklo_epi8(rb01_8f, ga01_8f);
-	__m128i rgba01_cf = _mm_unpackhi_epi8(rb01_8f, ga01_8f);
-	_mm_storeu_si128(out0 + 4, rgba01_03);
-	_mm_storeu_si128(out0 + 5, rgba01_47);
-	_mm_storeu_si128(out0 + 6, rgba01_8b);
-	_mm_storeu_si128(out0 + 7, rgba01_cf);
-
-	// block bottom,right
-	__m128i y11_0f    = _mm_loadu_si128(y1 + 1);
-	__m128i y11_even  = _mm_and_si128(y11_0f, Y_MASK);
-	__m128i y11_odd   = _mm_srli_epi16(y11_0f, 8);
-	__m128i dy11_even = _mm_srai_epi16(_mm_mullo_epi16(y11_even, COEF_Y), 6);
-	__m128i dy11_odd  = _mm_srai_epi16(_mm_mullo_epi16(y11_odd,  COEF_Y), 6);
-	__m128i r11_even  = _mm_adds_epi16(dr8f, dy11_even);
-	__m128i g11_even  = _mm_adds_epi16(dg8f, dy11_even);
-	__m128i b11_even  = _mm_adds_epi16(db8f, dy11_even);
-	__m128i r11_odd   = _mm_adds_epi16(dr8f, dy11_odd);
-	__m128i g11_odd   = _mm_adds_epi16(dg8f, dy11_odd);
-	__m128i b11_odd   = _mm_adds_epi16(db8f, dy11_odd);
-	__m128i r11_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(r11_even, r11_even),
-	                                      _mm_packus_epi16(r11_odd,  r11_odd));
-	__m128i g11_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(g11_even, g11_even),
-	                                      _mm_packus_epi16(g11_odd,  g11_odd));
-	__m128i b11_0f    = _mm_unpackhi_epi8(_mm_packus_epi16(b11_even, b11_even),
-	                                      _mm_packus_epi16(b11_odd,  b11_odd));
-	__m128i rb11_07   = _mm_unpacklo_epi8(r11_0f, b11_0f);
-	__m128i rb11_8f   = _mm_unpackhi_epi8(r11_0f, b11_0f);
-	__m128i ga11_07   = _mm_unpacklo_epi8(g11_0f, ALPHA);
-	__m128i ga11_8f   = _mm_unpackhi_epi8(g11_0f, ALPHA);
-	__m128i rgba11_03 = _mm_unpacklo_epi8(rb11_07, ga11_07);
-	__m128i rgba11_47 = _mm_unpackhi_epi8(rb11_07, ga11_07);
-	__m128i rgba11_8b = _mm_unpacklo_epi8(rb11_8f, ga11_8f);
-	__m128i rgba11_cf = _mm_unpackhi_epi8(rb11_8f, ga11_8f);
-	_mm_storeu_si128(out1 + 4, rgba11_03);
-	_mm_storeu_si128(out1 + 5, rgba11_47);
-	_mm_storeu_si128(out1 + 6, rgba11_8b);
-	_mm_storeu_si128(out1 + 7, rgba11_cf);
-}
-
-static inline void convertHelperSSE2(
-	const th_ycbcr_buffer& buffer, RawFrame& output)
-{
-	const int    width      = buffer[0].width;
-	const size_t y_stride   = buffer[0].stride;
-	const size_t uv_stride2 = buffer[1].stride / 2;
-
-	assert((width % 32) == 0);
-	assert((buffer[0].height % 2) == 0);
-
-	for (int y = 0; y < buffer[0].height; y += 2) {
-		const uint8_t* pY1 = buffer[0].data + (y + 0) * y_stride;
-		const uint8_t* pY2 = buffer[0].data + (y + 1) * y_stride;
-		const uint8_t* pCb = buffer[1].data + (y + 0) * uv_stride2;
-		const uint8_t* pCr = buffer[2].data + (y + 0) * uv_stride2;
-		auto out0 = output.getLineDirect(y + 0);
-		auto out1 = output.getLineDirect(y + 1);
-
-		for (int x = 0; x < width; x += 32) {
-			// convert a block of (32 x 2) pixels
-			yuv2rgb_sse2(pCb, pCr, pY1, pY2, &out0[x], &out1[x]);
-			pCb += 16;
-			pCr += 16;
-			pY1 += 32;
-			pY2 += 32;
-		}
-
-		output.setLineWidth(y + 0, width);
-		output.setLineWidth(y + 1, width);
-	}
-}
-
-#endif // __SSE2__
-
 static constexpr int PREC = 15;
 static constexpr int COEF_Y  = int(1.164 * (1 << PREC) + 0.5); // prefer to use lrint() to round
 static constexpr int COEF_RV = int(1.596 * (1 << PREC) + 0.5); // but that's not (yet) constexpr
@@ -265,6 +32,14 @@ static constexpr int COEF_GU = int(0.391 * (1 << PREC) + 0.5); // in current ver
 static constexpr int COEF_GV = int(0.813 * (1 << PREC) + 0.5);
 static constexpr int COEF_BU = int(2.018 * (1 << PREC) + 0.5);
 
+// The same calculation written as 'coef * value + offset'.
+static constexpr int OFFS_Y = (PREC / 2) - 16 * COEF_Y;
+static constexpr int OFFS_R = -128 * COEF_RV;
+static constexpr int OFFS_G =  128 * (COEF_GU + COEF_GV);
+static constexpr int OFFS_B = -128 * COEF_BU;
+
+static constexpr Pixel ALPHA = 0xFF000000;
+
 struct Coefs {
 	std::array<int, 256> gu;
 	std::array<int, 256> gv;
@@ -292,43 +67,260 @@ struct Coefs {
 	uint8_t r = Math::clipIntToByte((y + ruv) >> PREC);
 	uint8_t g = Math::clipIntToByte((y + guv) >> PREC);
 	uint8_t b = Math::clipIntToByte((y + buv) >> PREC);
-	return (r << 0) | (g << 8) | (b << 16);
+	return (r << 0) | (g << 8) | (b << 16) | ALPHA;
+}
+
+// Convert a block of 2x2 pixels (which share the same U and V value).
+static inline void convert2x2(
+	uint8_t u, uint8_t v, const uint8_t* pY0, const uint8_t* pY1,
+	Pixel* out0, Pixel* out1)
+{
+	static constexpr Coefs coefs = getCoefs();
+
+	int ruv = coefs.rv[v];
+	int guv = coefs.gu[u] + coefs.gv[v];
+	int buv = coefs.bu[u];
+
+	out0[0] = calc(coefs.y[pY0[0]], ruv, guv, buv);
+	out0[1] = calc(coefs.y[pY0[1]], ruv, guv, buv);
+	out1[0] = calc(coefs.y[pY1[0]], ruv, guv, buv);
+	out1[1] = calc(coefs.y[pY1[1]], ruv, guv, buv);
+}
+
+#ifdef SIMD_AVX2
+
+// AVX2 version: 32-bit multiplications, so the calculation maps 1-on-1.
+// (Helpers are separate functions, lambdas don't inherit SIMD_TARGET.)
+[[nodiscard]] static inline SIMD_TARGET("avx2") __m256i load8AVX2(const uint8_t* p)
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64(std::bit_cast<const __m128i*>(p)));
+}
+
+[[nodiscard]] static inline SIMD_TARGET("avx2") __m256i mulAddAVX2(__m256i x, int c, int offset)
+{
+	return _mm256_add_epi32(_mm256_mullo_epi32(x, _mm256_set1_epi32(c)), _mm256_set1_epi32(offset));
+}
+
+[[nodiscard]] static inline SIMD_TARGET("avx2") __m256i clipAVX2(__m256i y, __m256i c)
+{
+	__m256i t = _mm256_srai_epi32(_mm256_add_epi32(y, c), PREC);
+	return _mm256_min_epi32(_mm256_max_epi32(t, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+}
+
+// Convert 8 pixels, 'r', 'g' and 'b' hold the (already duplicated) chroma
+// contribution for each pixel.
+static inline SIMD_TARGET("avx2") void convert8AVX2(
+	const uint8_t* pY, __m256i r, __m256i g, __m256i b, Pixel* out)
+{
+	__m256i y = mulAddAVX2(load8AVX2(pY), COEF_Y, OFFS_Y);
+	__m256i p = _mm256_or_si256(
+		_mm256_or_si256(clipAVX2(y, r), _mm256_slli_epi32(clipAVX2(y, g), 8)),
+		_mm256_or_si256(_mm256_slli_epi32(clipAVX2(y, b), 16), _mm256_set1_epi32(int(ALPHA))));
+	_mm256_storeu_si256(std::bit_cast<__m256i*>(out), p);
+}
+
+// Convert the pixels in the range [0, width & ~15) of two lines.
+static SIMD_TARGET("avx2") void convertLinesAVX2(
+	const uint8_t* pU, const uint8_t* pV, const uint8_t* pY0, const uint8_t* pY1,
+	Pixel* out0, Pixel* out1, int width)
+{
+	const __m256i DUP_LO = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	const __m256i DUP_HI = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+	for (int x = 0; (x + 16) <= width; x += 16) {
+		// chroma contribution for 8 horizontal pairs of pixels
+		__m256i u = load8AVX2(pU + x / 2);
+		__m256i v = load8AVX2(pV + x / 2);
+		__m256i r = mulAddAVX2(v, COEF_RV, OFFS_R);
+		__m256i g = mulAddAVX2(v, -COEF_GV, OFFS_G);
+		g = _mm256_sub_epi32(g, _mm256_mullo_epi32(u, _mm256_set1_epi32(COEF_GU)));
+		__m256i b = mulAddAVX2(u, COEF_BU, OFFS_B);
+
+		// each value is shared by 2 horizontally adjacent pixels
+		for (auto i : xrange(2)) {
+			__m256i dup = i ? DUP_HI : DUP_LO;
+			__m256i rr = _mm256_permutevar8x32_epi32(r, dup);
+			__m256i gg = _mm256_permutevar8x32_epi32(g, dup);
+			__m256i bb = _mm256_permutevar8x32_epi32(b, dup);
+			convert8AVX2(pY0 + x + 8 * i, rr, gg, bb, out0 + x + 8 * i);
+			convert8AVX2(pY1 + x + 8 * i, rr, gg, bb, out1 + x + 8 * i);
+		}
+	}
+}
+
+#endif
+
+#if defined(__SSE2__)
+
+// SSE2 version: there's no 32-bit multiplication, so calculate the 32-bit
+// products from the low and high halves of 16x16-bit unsigned products.
+static inline void convert16x2(
+	const uint8_t* pU, const uint8_t* pV, const uint8_t* pY0, const uint8_t* pY1,
+	Pixel* out0, Pixel* out1)
+{
+	struct Vec { __m128i v[2]; }; // 8 x 32-bit
+	struct Vec4 { __m128i v[4]; }; // 16 x 32-bit
+
+	const __m128i ZERO = _mm_setzero_si128();
+	auto load8 = [&](const uint8_t* p) {
+		return _mm_unpacklo_epi8(_mm_loadl_epi64(std::bit_cast<const __m128i*>(p)), ZERO);
+	};
+	auto mul = [](__m128i x, int c) { // 'x' and 'c' must be unsigned 16-bit
+		__m128i k = _mm_set1_epi16(int16_t(c));
+		__m128i lo = _mm_mullo_epi16(x, k);
+		__m128i hi = _mm_mulhi_epu16(x, k);
+		return Vec{{_mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi)}};
+	};
+	auto add = [](const Vec& x, const Vec& y) {
+		return Vec{{_mm_add_epi32(x.v[0], y.v[0]), _mm_add_epi32(x.v[1], y.v[1])}};
+	};
+	auto cnst = [](int c) {
+		return Vec{{_mm_set1_epi32(c), _mm_set1_epi32(c)}};
+	};
+
+	// chroma contribution for 8 horizontal pairs of pixels
+	__m128i u = load8(pU);
+	__m128i v = load8(pV);
+	Vec r = add(mul(v, COEF_RV), cnst(OFFS_R));
+	Vec gt = add(mul(u, COEF_GU), mul(v, COEF_GV));
+	Vec g = {{_mm_sub_epi32(_mm_set1_epi32(OFFS_G), gt.v[0]),
+	          _mm_sub_epi32(_mm_set1_epi32(OFFS_G), gt.v[1])}};
+	static_assert((0x10000 <= COEF_BU) && (COEF_BU < 0x20000));
+	Vec u16 = {{_mm_slli_epi32(_mm_unpacklo_epi16(u, ZERO), 16),
+	            _mm_slli_epi32(_mm_unpackhi_epi16(u, ZERO), 16)}};
+	Vec b = add(add(u16, mul(u, COEF_BU - 0x10000)), cnst(OFFS_B));
+
+	// each value is shared by 2 horizontally adjacent pixels
+	auto dup = [](const Vec& x) {
+		return Vec4{{
+			_mm_unpacklo_epi32(x.v[0], x.v[0]), _mm_unpackhi_epi32(x.v[0], x.v[0]),
+			_mm_unpacklo_epi32(x.v[1], x.v[1]), _mm_unpackhi_epi32(x.v[1], x.v[1])}};
+	};
+	auto rr = dup(r);
+	auto gg = dup(g);
+	auto bb = dup(b);
+
+	auto row = [&](const uint8_t* pY, Pixel* out) {
+		__m128i y_0f = _mm_loadu_si128(std::bit_cast<const __m128i*>(pY));
+		Vec y07 = add(mul(_mm_unpacklo_epi8(y_0f, ZERO), COEF_Y), cnst(OFFS_Y));
+		Vec y8f = add(mul(_mm_unpackhi_epi8(y_0f, ZERO), COEF_Y), cnst(OFFS_Y));
+		Vec4 yy = {{y07.v[0], y07.v[1], y8f.v[0], y8f.v[1]}};
+		// calculate 16 values, saturate to [0..255]
+		auto clip = [&](const Vec4& c) {
+			auto t = [&](int i) { return _mm_srai_epi32(_mm_add_epi32(yy.v[i], c.v[i]), PREC); };
+			return _mm_packus_epi16(_mm_packs_epi32(t(0), t(1)),
+			                        _mm_packs_epi32(t(2), t(3)));
+		};
+		__m128i r_0f = clip(rr);
+		__m128i g_0f = clip(gg);
+		__m128i b_0f = clip(bb);
+		__m128i a_0f = _mm_set1_epi8(-1);
+		__m128i rg_07 = _mm_unpacklo_epi8(r_0f, g_0f);
+		__m128i rg_8f = _mm_unpackhi_epi8(r_0f, g_0f);
+		__m128i ba_07 = _mm_unpacklo_epi8(b_0f, a_0f);
+		__m128i ba_8f = _mm_unpackhi_epi8(b_0f, a_0f);
+		auto* o = std::bit_cast<__m128i*>(out);
+		_mm_storeu_si128(o + 0, _mm_unpacklo_epi16(rg_07, ba_07));
+		_mm_storeu_si128(o + 1, _mm_unpackhi_epi16(rg_07, ba_07));
+		_mm_storeu_si128(o + 2, _mm_unpacklo_epi16(rg_8f, ba_8f));
+		_mm_storeu_si128(o + 3, _mm_unpackhi_epi16(rg_8f, ba_8f));
+	};
+	row(pY0, out0);
+	row(pY1, out1);
+}
+
+#elif defined(__ARM_NEON)
+
+// NEON version, same structure as the AVX2 version but 4 x 32-bit wide.
+static inline void convert16x2(
+	const uint8_t* pU, const uint8_t* pV, const uint8_t* pY0, const uint8_t* pY1,
+	Pixel* out0, Pixel* out1)
+{
+	struct Vec { int32x4_t v[2]; }; // 8 x 32-bit
+	struct Vec4 { int32x4_t v[4]; }; // 16 x 32-bit
+
+	auto widen = [](uint8x8_t x) {
+		uint16x8_t w = vmovl_u8(x);
+		return Vec{{vreinterpretq_s32_u32(vmovl_u16(vget_low_u16 (w))),
+		            vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(w)))}};
+	};
+	auto mulAdd = [](const Vec& x, int c, int offset) {
+		return Vec{{vmlaq_n_s32(vdupq_n_s32(offset), x.v[0], c),
+		            vmlaq_n_s32(vdupq_n_s32(offset), x.v[1], c)}};
+	};
+
+	// chroma contribution for 8 horizontal pairs of pixels
+	Vec u = widen(vld1_u8(pU));
+	Vec v = widen(vld1_u8(pV));
+	Vec r = mulAdd(v, COEF_RV, OFFS_R);
+	Vec g = mulAdd(v, -COEF_GV, OFFS_G);
+	g = {{vmlaq_n_s32(g.v[0], u.v[0], -COEF_GU), vmlaq_n_s32(g.v[1], u.v[1], -COEF_GU)}};
+	Vec b = mulAdd(u, COEF_BU, OFFS_B);
+
+	// each value is shared by 2 horizontally adjacent pixels
+	auto dup = [](const Vec& x) {
+		int32x4x2_t lo = vzipq_s32(x.v[0], x.v[0]);
+		int32x4x2_t hi = vzipq_s32(x.v[1], x.v[1]);
+		return Vec4{{lo.val[0], lo.val[1], hi.val[0], hi.val[1]}};
+	};
+	auto rr = dup(r);
+	auto gg = dup(g);
+	auto bb = dup(b);
+
+	auto clip = [](int32x4_t y, int32x4_t c) {
+		int32x4_t t = vshrq_n_s32(vaddq_s32(y, c), PREC);
+		return vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(t, vdupq_n_s32(0)), vdupq_n_s32(255)));
+	};
+	auto row = [&](const uint8_t* pY, Pixel* out) {
+		uint8x16_t y_0f = vld1q_u8(pY);
+		Vec y07 = mulAdd(widen(vget_low_u8 (y_0f)), COEF_Y, OFFS_Y);
+		Vec y8f = mulAdd(widen(vget_high_u8(y_0f)), COEF_Y, OFFS_Y);
+		Vec4 yy = {{y07.v[0], y07.v[1], y8f.v[0], y8f.v[1]}};
+		for (auto i : xrange(4)) {
+			uint32x4_t p = vorrq_u32(
+				vorrq_u32(clip(yy.v[i], rr.v[i]), vshlq_n_u32(clip(yy.v[i], gg.v[i]), 8)),
+				vorrq_u32(vshlq_n_u32(clip(yy.v[i], bb.v[i]), 16), vdupq_n_u32(ALPHA)));
+			vst1q_u32(out + 4 * i, p);
+		}
+	};
+	row(pY0, out0);
+	row(pY1, out1);
 }
 
-static void convertHelper(const th_ycbcr_buffer& buffer, RawFrame& output)
+#endif
+
+void convert(const th_ycbcr_buffer& buffer, RawFrame& output)
 {
 	assert(buffer[1].width  * 2 == buffer[0].width);
 	assert(buffer[1].height * 2 == buffer[0].height);
 
-	static constexpr Coefs coefs = getCoefs();
-
 	const int    width      = buffer[0].width;
 	const size_t y_stride   = buffer[0].stride;
 	const size_t uv_stride2 = buffer[1].stride / 2;
 
 	for (int y = 0; y < buffer[0].height; y += 2) {
-		const uint8_t* pY  = buffer[0].data + y * y_stride;
-		const uint8_t* pCb = buffer[1].data + y * uv_stride2;
-		const uint8_t* pCr = buffer[2].data + y * uv_stride2;
+		const uint8_t* pY0 = buffer[0].data + (y + 0) * y_stride;
+		const uint8_t* pY1 = buffer[0].data + (y + 1) * y_stride;
+		const uint8_t* pCb = buffer[1].data + (y + 0) * uv_stride2;
+		const uint8_t* pCr = buffer[2].data + (y + 0) * uv_stride2;
 		auto out0 = output.getLineDirect(y + 0);
 		auto out1 = output.getLineDirect(y + 1);
 
-		for (int x = 0; x < width; x += 2, pY += 2, ++pCr, ++pCb) {
-			int ruv = coefs.rv[*pCr];
-			int guv = coefs.gu[*pCb] + coefs.gv[*pCr];
-			int buv = coefs.bu[*pCb];
-
-			int Y00 = coefs.y[pY[0]];
-			out0[x + 0] = calc(Y00, ruv, guv, buv);
-
-			int Y01 = coefs.y[pY[1]];
-			out0[x + 1] = calc(Y01, ruv, guv, buv);
-
-			int Y10 = coefs.y[pY[y_stride + 0]];
-			out1[x + 0] = calc(Y10, ruv, guv, buv);
-
-			int Y11 = coefs.y[pY[y_stride + 1]];
-			out1[x + 1] = calc(Y11, ruv, guv, buv);
+		int x = 0;
+#ifdef SIMD_AVX2
+		if (SIMD::hasAVX2()) {
+			convertLinesAVX2(pCb, pCr, pY0, pY1, out0.data(), out1.data(), width);
+			x = width & ~15;
+		}
+#endif
+#if defined(__SSE2__) || defined(__ARM_NEON)
+		for (/**/; (x + 16) <= width; x += 16) {
+			convert16x2(&pCb[x / 2], &pCr[x / 2], &pY0[x], &pY1[x],
+			            &out0[x], &out1[x]);
+		}
+#endif
+		for (/**/; x < width; x += 2) {
+			convert2x2(pCb[x / 2], pCr[x / 2], &pY0[x], &pY1[x],
+			           &out0[x], &out1[x]);
 		}
 
 		output.setLineWidth(y + 0, width);
@@ -336,13 +328,4 @@ static void convertHelper(const th_ycbcr_buffer& buffer, RawFrame& output)
 	}
 }
 
-void convert(const th_ycbcr_buffer& input, RawFrame& output)
-{
-#ifdef __SSE2__
-		convertHelperSSE2(input, output);
-		return;
-#endif
-		convertHelper(input, output);
-}
-
 } // namespace openmsx::yuv2rgb
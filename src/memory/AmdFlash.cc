@@ -123,7 +123,7 @@ AmdFlash::AmdFlash(const std::string& name, const ValidatedChip& validatedChip,
 		if (sector.writeAddress != -1) { // don't use isWritable() here
 			sector.readAddress = &(*ram)[sector.writeAddress];
 			if (!loaded) {
-				auto ramBlock = ram->getWriteBackdoor().subspan(sector.writeAddress, sector.size);
+				auto ramBlock = ram->getWriteBackdoor(sector.writeAddress, sector.size);
 				if (offset >= romSize) {
 					// completely past end of rom
 					std::ranges::fill(ramBlock, 0xFF);
@@ -40,6 +40,9 @@ public:
 	[[nodiscard]] std::span<uint8_t> getWriteBackdoor() {
 		return ram.getWriteBackdoor();
 	}
+	[[nodiscard]] std::span<uint8_t> getWriteBackdoor(size_t addr, size_t len) {
+		return ram.getWriteBackdoor(addr, len);
+	}
 
 	[[nodiscard]] size_t size() const {
 		return ram.size();
@@ -10,9 +10,17 @@ void TrackedRam::serialize(Archive& ar, unsigned /*version*/)
 	// Note: This is the exact same serialization format as the Ram class.
 	//  This allows to change from Ram to TrackedRam without having to
 	//  increase the class serialization version (of the user).
-	bool diff = writeSinceLastReverseSnapshot || !ar.isReverseSnapshot();
-	ar.serialize_blob("ram", std::span{ram}, diff);
-	if (ar.isReverseSnapshot()) writeSinceLastReverseSnapshot = false;
+	if constexpr (Archive::IS_LOADER) {
+		ar.serialize_blob("ram", std::span{ram});
+		writeSinceLastReverseSnapshot = true;
+	} else if (ar.isReverseSnapshot()) {
+		if (writeSinceLastReverseSnapshot) dirtyPages.markAll();
+		ar.serialize_blob("ram", std::span{ram}, dirtyPages);
+		dirtyPages.clear();
+		writeSinceLastReverseSnapshot = false;
+	} else {
+		ar.serialize_blob("ram", std::span{ram});
+	}
 }
 INSTANTIATE_SERIALIZE_METHODS(TrackedRam);
 
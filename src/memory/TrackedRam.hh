@@ -3,21 +3,30 @@
 
 #include "Ram.hh"
 
+#include "DirtyPages.hh"
+
 #include <cstdint>
 
 namespace openmsx {
 
 // Ram with dirty tracking
+//
+// Writes are tracked per page (see DirtyPages), so that a reverse snapshot
+// only has to compare the pages that actually changed. Writes via the
+// debugger or via the write-backdoor (without range) mark the whole ram as
+// dirty.
 class TrackedRam
 {
 public:
 	// Most methods simply delegate to the internal 'ram' object.
 	TrackedRam(const DeviceConfig& config, const std::string& name,
 	           static_string_view description, size_t size)
-		: ram(config, name, description, size, &writeSinceLastReverseSnapshot) {}
+		: ram(config, name, description, size, &writeSinceLastReverseSnapshot)
+		, dirtyPages(size) {}
 
 	TrackedRam(const XMLElement& xml, size_t size)
-		: ram(xml, size) {}
+		: ram(xml, size)
+		, dirtyPages(size) {}
 
 	[[nodiscard]] size_t size() const {
 		return ram.size();
@@ -41,7 +50,7 @@ public:
 
 	// Only allow write/clear via an explicit method.
 	void write(size_t addr, uint8_t value) {
-		writeSinceLastReverseSnapshot = true;
+		dirtyPages.mark(addr);
 		ram[addr] = value;
 	}
 
@@ -58,13 +67,19 @@ public:
 		writeSinceLastReverseSnapshot = true;
 		return {ram.data(), size()};
 	}
+	// Similar, but only (marks and) returns the given subrange.
+	[[nodiscard]] std::span<uint8_t> getWriteBackdoor(size_t addr, size_t len) {
+		dirtyPages.markRange(addr, len);
+		return std::span{ram.data(), size()}.subspan(addr, len);
+	}
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
 private:
 	Ram ram;
-	bool writeSinceLastReverseSnapshot = true;
+	DirtyPages dirtyPages;
+	bool writeSinceLastReverseSnapshot = true; // all pages dirty
 };
 
 } // namespace openmsx
@@ -1,6 +1,8 @@
 #include "serialize.hh"
 
+#include "File.hh"
 #include "FileOperations.hh"
+#include "MSXException.hh"
 #include "Version.hh"
 #include "XMLElement.hh"
 #include "XMLException.hh"
@@ -108,6 +110,7 @@ template class InputArchiveBase<XmlInputArchive>;
 
 void MemOutputArchive::save(std::string_view s)
 {
+	if (forHash) return;
 	auto size = s.size();
 	auto buf = buffer.allocate(sizeof(size) + size);
 	memcpy(buf.data(), &size, sizeof(size));
@@ -116,10 +119,16 @@ void MemOutputArchive::save(std::string_view s)
 
 ////
 
+void MemInputArchive::throwTruncated()
+{
+	throw MSXException("Unexpected end of savestate data.");
+}
+
 void MemInputArchive::load(std::string& s)
 {
 	size_t length;
 	load(length);
+	checkAvailable(length);
 	s.resize_and_overwrite(length, [&](char* dst, size_t /*n*/) {
 		//assert(length == n); <-- not true with gcc-12 (bug)
 		if (length) {
@@ -133,6 +142,7 @@ std::string_view MemInputArchive::loadStr()
 {
 	size_t length;
 	load(length);
+	checkAvailable(length);
 	const uint8_t* p = buffer.getCurrentPos();
 	buffer.skip(length);
 	return {std::bit_cast<const char*>(p), length};
@@ -146,26 +156,74 @@ std::string_view MemInputArchive::loadStr()
 // semi-arbitrary. I only made it >= 52 so that the (incompressible) RP5C01
 // registers won't be compressed.
 static constexpr size_t SMALL_SIZE = 64;
+// In a stand-alone archive, blobs of at least this size are stored outside the
+// stream. Changing this value requires a new binary savestate format version.
+static constexpr size_t LARGE_BLOB_SIZE = 16 * 1024;
+
 void MemOutputArchive::serialize_blob(const char* /*tag*/, std::span<const uint8_t> data,
                                       bool diff)
 {
-	// Delta-compress in-memory blobs, see DeltaBlock.hh for more details.
-	if (data.size() > SMALL_SIZE) {
-		auto deltaBlockIdx = unsigned(deltaBlocks.size());
+	if (!deltaBlocks) {
+		// stand-alone archive, store size (allows a check while loading)
+		save(data.size());
+		if (data.size() >= LARGE_BLOB_SIZE) {
+			save(largeBlobsSize);
+			largeBlobs.push_back(data);
+			largeBlobsSize += (data.size() + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+		} else {
+			auto buf = buffer.allocate(data.size());
+			copy_to_range(data, buf);
+		}
+	} else if (data.size() > SMALL_SIZE) {
+		// Delta-compress in-memory blobs, see DeltaBlock.hh for more details.
+		auto deltaBlockIdx = unsigned(deltaBlocks->size());
 		save(deltaBlockIdx); // see comment below in MemInputArchive
-		deltaBlocks.push_back(diff
-			? lastDeltaBlocks.createNew(data.data(), data)
-			: lastDeltaBlocks.createNullDiff(data.data(), data));
+		deltaBlocks->push_back(diff
+			? lastDeltaBlocks->createNew(data.data(), data)
+			: lastDeltaBlocks->createNullDiff(data.data(), data));
 	} else {
 		auto buf = buffer.allocate(data.size());
 		copy_to_range(data, buf);
 	}
 }
 
+void MemOutputArchive::serialize_blob(const char* tag, std::span<const uint8_t> data,
+                                      const DirtyPages& dirty)
+{
+	if (deltaBlocks && (data.size() > SMALL_SIZE)) {
+		auto deltaBlockIdx = unsigned(deltaBlocks->size());
+		save(deltaBlockIdx);
+		deltaBlocks->push_back(dirty.any()
+			? lastDeltaBlocks->createNew(data.data(), data, &dirty)
+			: lastDeltaBlocks->createNullDiff(data.data(), data));
+	} else {
+		serialize_blob(tag, data);
+	}
+}
+
 void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> data,
                                      bool /*diff*/)
 {
-	if (data.size() > SMALL_SIZE) {
+	if (standAlone) {
+		size_t size; load(size);
+		if (size != data.size()) {
+			throw MSXException(
+				"Length of blob different from expected value (",
+				size, " instead of ", data.size(), ')');
+		}
+		if (size >= LARGE_BLOB_SIZE) {
+			size_t offset; load(offset);
+			if ((offset > largeBlobs.size()) ||
+			    (size > (largeBlobs.size() - offset))) {
+				throw MSXException("Invalid blob offset in binary savestate.");
+			}
+			copy_to_range(largeBlobs.subspan(offset, size), data);
+		} else {
+			checkAvailable(size);
+			copy_to_range(std::span{buffer.getCurrentPos(), size}, data);
+			buffer.skip(size);
+		}
+	} else if (data.size() > SMALL_SIZE) {
 		// Usually blobs are saved in the same order as they are loaded
 		// (via the serialize_blob() methods in respectively
 		// MemOutputArchive and MemInputArchive). In that case keeping
@@ -177,6 +235,7 @@ void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> dat
 		unsigned deltaBlockIdx; load(deltaBlockIdx);
 		deltaBlocks[deltaBlockIdx]->apply(data);
 	} else {
+		checkAvailable(data.size());
 		copy_to_range(std::span{buffer.getCurrentPos(), data.size()}, data);
 		buffer.skip(data.size());
 	}
@@ -184,6 +243,154 @@ void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> dat
 
 ////
 
+namespace BinarySaveState {
+
+// File layout:
+//   Header
+//   BlobSection
+//   zlib compressed stand-alone MemOutputArchive stream
+//   padding up to 'BlobSection::offset' (a multiple of BLOB_ALIGNMENT)
+//   the large blobs, uncompressed, each padded to a multiple of BLOB_ALIGNMENT
+struct Header {
+	std::array<char, 8> magic;
+	uint32_t formatVersion;
+	uint32_t endianTag; // detect files written on a different platform
+	uint32_t wordSize;  // idem
+	uint32_t reserved;
+	uint64_t uncompressedSize;
+	uint64_t compressedSize;
+};
+struct BlobSection {
+	uint64_t offset; // from the start of the file
+	uint64_t size;
+};
+static constexpr std::array<char, 8> MAGIC = {'o', 'M', 'S', 'X', 'b', 'i', 'n', '\x1a'};
+// Versions 1 and 2 were only written by development builds (with a different
+// layout and enums stored as integers), those can't be loaded.
+static constexpr uint32_t FORMAT_VERSION = 3;
+static constexpr size_t BLOB_ALIGNMENT = MemOutputArchive::BLOB_ALIGNMENT;
+static constexpr uint32_t ENDIAN_TAG = 0x01020304;
+
+bool isBinary(zstring_view filename)
+{
+	try {
+		File file(filename, "rb"); // don't transparently uncompress
+		if (file.getSize() < sizeof(Header)) return false;
+		Header header;
+		file.read(std::span{&header, 1});
+		return header.magic == MAGIC;
+	} catch (MSXException&) {
+		return false;
+	}
+}
+
+void save(zstring_view filename, MemOutputArchive&& archive)
+{
+	auto largeBlobs = archive.getLargeBlobs();
+	auto data = std::move(archive).releaseBuffer();
+
+	auto dstLen = compressBound(uLong(data.size()));
+	MemBuffer<uint8_t> buf(dstLen);
+	// Favor speed over size, these files are meant to be fast.
+	if (compress2(buf.data(), &dstLen,
+	              std::bit_cast<const Bytef*>(data.data()), uLong(data.size()),
+	              Z_BEST_SPEED) != Z_OK) {
+		throw MSXException("Error while compressing savestate.");
+	}
+
+	Header header;
+	header.magic = MAGIC;
+	header.formatVersion = FORMAT_VERSION;
+	header.endianTag = ENDIAN_TAG;
+	header.wordSize = sizeof(size_t);
+	header.reserved = 0;
+	header.uncompressedSize = data.size();
+	header.compressedSize = dstLen;
+
+	auto alignUp = [](size_t s) { return (s + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1); };
+	BlobSection section;
+	auto streamEnd = sizeof(Header) + sizeof(BlobSection) + dstLen;
+	section.offset = alignUp(streamEnd);
+	section.size = 0;
+	for (const auto& blob : largeBlobs) section.size += alignUp(blob.size());
+
+	static constexpr std::array<uint8_t, BLOB_ALIGNMENT> zeros = {};
+	File file(filename, File::OpenMode::TRUNCATE);
+	file.write(std::span{&header, 1});
+	file.write(std::span{&section, 1});
+	file.write(std::span{buf.data(), dstLen});
+	file.write(std::span{zeros}.first(section.offset - streamEnd));
+	for (const auto& blob : largeBlobs) {
+		file.write(blob);
+		file.write(std::span{zeros}.first(alignUp(blob.size()) - blob.size()));
+	}
+}
+
+Contents load(zstring_view filename)
+{
+	File file(filename, "rb");
+	auto mmap = file.mmap<const uint8_t>();
+	std::span<const uint8_t> fileData{mmap.data(), mmap.size()};
+
+	auto read = [&](auto& t) {
+		if (fileData.size() < sizeof(t)) {
+			throw MSXException("Binary savestate is truncated or corrupt.");
+		}
+		memcpy(&t, fileData.data(), sizeof(t));
+		fileData = fileData.subspan(sizeof(t));
+	};
+
+	if (fileData.size() < sizeof(Header)) {
+		throw MSXException("Not a binary savestate: ", filename);
+	}
+	Header header;
+	read(header);
+	if (header.magic != MAGIC) {
+		throw MSXException("Not a binary savestate: ", filename);
+	}
+	if (header.formatVersion > FORMAT_VERSION) {
+		throw MSXException(
+			"your openMSX installation is too old (binary savestate "
+			"has format version ", header.formatVersion, ").");
+	}
+	if (header.formatVersion < FORMAT_VERSION) {
+		throw MSXException(
+			"Unsupported binary savestate format version ",
+			header.formatVersion, '.');
+	}
+	if ((header.endianTag != ENDIAN_TAG) || (header.wordSize != sizeof(size_t))) {
+		throw MSXException(
+			"Binary savestate was created on an incompatible platform, "
+			"use an XML savestate instead.");
+	}
+
+	BlobSection section;
+	read(section);
+	auto streamBegin = mmap.size() - fileData.size();
+	if ((section.offset < streamBegin) || (section.offset > mmap.size()) ||
+	    (section.size != (mmap.size() - section.offset)) ||
+	    (header.compressedSize > (section.offset - streamBegin))) {
+		throw MSXException("Binary savestate is truncated or corrupt.");
+	}
+
+	Contents result;
+	result.largeBlobs = std::span{mmap.data() + section.offset, section.size};
+
+	result.stream = MemBuffer<uint8_t>(header.uncompressedSize);
+	auto dstLen = uLongf(header.uncompressedSize);
+	if ((uncompress(result.stream.data(), &dstLen,
+	                fileData.data(), uLong(header.compressedSize)) != Z_OK) ||
+	    (dstLen != header.uncompressedSize)) {
+		throw MSXException("Error while decompressing binary savestate.");
+	}
+	result.file = std::move(mmap);
+	return result;
+}
+
+} // namespace BinarySaveState
+
+////
+
 XmlOutputArchive::XmlOutputArchive(zstring_view filename_)
 	: filename(filename_)
 	, writer(*this)
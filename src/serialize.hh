@@ -6,6 +6,7 @@
 #include "XMLOutputStream.hh"
 #include "serialize_core.hh"
 
+#include "MappedFile.hh"
 #include "MemBuffer.hh"
 #include "StringOp.hh"
 #include "hash_map.hh"
@@ -31,6 +32,7 @@ namespace openmsx {
 
 class LastDeltaBlocks;
 class DeltaBlock;
+class DirtyPages;
 
 // TODO move somewhere in utils once we use this more often
 struct HashPair {
@@ -54,11 +56,16 @@ template<typename T> struct SerializeClassVersion;
 // ATM these backing streams implemented:
 //   - Mem
 //      Stores stream in memory. Is meant to be very compact and very fast.
-//      It does not support versioning (it's not possible to load this stream
-//      in a newer version of openMSX). It is also not platform independent
-//      (e.g. integers are stored using native platform endianess).
+//      It is not platform independent (e.g. integers are stored using native
+//      platform endianess).
 //      The main use case for this archive format is regular in memory
-//      snapshots, for example to support replay/rewind.
+//      snapshots, for example to support replay/rewind. Those don't support
+//      versioning (it's not possible to load this stream in a newer version
+//      of openMSX).
+//      A 'stand-alone' Mem archive does store version information and
+//      doesn't use DeltaBlocks. Small blobs are stored inline, large blobs
+//      are collected separately. This is used for binary savestate files
+//      (see BinarySaveState below).
 //   - XML
 //      Stores the stream in a XML file. These files are meant to be portable
 //      to different architectures (e.g. little/big endian, 32/64 bit system).
@@ -151,6 +158,15 @@ public:
 	//   cannot know whether a byte-array should be serialized as a blob
 	//   or as a collection of bytes (IOW we cannot decide it based on the
 	//   type).
+	//
+	//
+	// void serialize_blob(const char* tag, std::span<const uint8_t> data,
+	//                     const DirtyPages& dirty)
+	//
+	//   Only for output archives. Like above, but 'dirty' indicates which
+	//   pages of 'data' were changed since the previous reverse-snapshot.
+	//   MemOutputArchive uses this to only compare the dirty pages, other
+	//   archives ignore it.
 
 	template<typename T>
 	void serialize_blob(const char* tag, std::span<T> data, bool diff = true)
@@ -233,6 +249,7 @@ public:
 
 	/** Does this archive store version information. */
 	static constexpr bool NEED_VERSION = true;
+	[[nodiscard]] bool needVersion() const { return Derived::NEED_VERSION; }
 
 	/** Is this a reverse-snapshot? */
 	[[nodiscard]] bool isReverseSnapshot() const { return false; }
@@ -241,6 +258,7 @@ public:
 	 * See also struct serialize_as_enum.
 	 */
 	static constexpr bool TRANSLATE_ENUM_TO_STRING = false;
+	[[nodiscard]] bool translateEnumToString() const { return Derived::TRANSLATE_ENUM_TO_STRING; }
 
 	/** Load/store an attribute from/in the archive.
 	 * Depending on the underlying concrete stream, attributes are either
@@ -653,18 +671,36 @@ public:
 	MemOutputArchive(LastDeltaBlocks& lastDeltaBlocks_,
 	                 std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks_,
 			 bool reverseSnapshot_)
-		: lastDeltaBlocks(lastDeltaBlocks_)
-		, deltaBlocks(deltaBlocks_)
+		: lastDeltaBlocks(&lastDeltaBlocks_)
+		, deltaBlocks(&deltaBlocks_)
 		, reverseSnapshot(reverseSnapshot_)
 	{
 	}
 
+	/** Create a stand-alone archive: blobs are not stored as DeltaBlocks
+	  * and class version information is included. Small blobs are stored
+	  * inline, large blobs are only referenced (see getLargeBlobs()).
+	  */
+	MemOutputArchive() = default;
+
+	/** Like a stand-alone archive, but only used to calculate a hash of
+	  * the machine state (see ReverseManager::calcStateHash()). Strings
+	  * are left out: these are mostly names and file paths (config files,
+	  * disk images, patches), which differ between installations that
+	  * emulate the exact same thing. Enums are stored as numbers.
+	  */
+	struct ForHash {};
+	explicit MemOutputArchive(ForHash) : forHash(true) {}
+
 	~MemOutputArchive()
 	{
 		assert(openSections.empty());
 	}
 
-	static constexpr bool NEED_VERSION = false;
+	[[nodiscard]] bool needVersion() const { return !deltaBlocks; }
+	// Stand-alone archives may be loaded by a newer openMSX version, in
+	// which the numeric value of an enum can be different.
+	[[nodiscard]] bool translateEnumToString() const { return !deltaBlocks && !forHash; }
 	[[nodiscard]] bool isReverseSnapshot() const { return reverseSnapshot; }
 
 	template<typename T> void save(const T& t)
@@ -680,6 +716,8 @@ public:
 	void save(std::string_view s);
 	void serialize_blob(const char* tag, std::span<const uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<const uint8_t> data,
+	                    const DirtyPages& dirty);
 
 	using OutputArchiveBase<MemOutputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -723,6 +761,18 @@ public:
 		return std::move(buffer).release();
 	}
 
+	/** For a stand-alone archive: the large blobs, in order. In the stream
+	  * these are referred to by their offset in the concatenation of all
+	  * these blobs, each padded to a multiple of BLOB_ALIGNMENT bytes.
+	  * Note: this refers to the serialized objects, so these must remain
+	  * unchanged until the archive is written (see BinarySaveState::save()).
+	  */
+	[[nodiscard]] std::span<const std::span<const uint8_t>> getLargeBlobs() const
+	{
+		return largeBlobs;
+	}
+	static constexpr size_t BLOB_ALIGNMENT = 4096;
+
 private:
 	ALWAYS_INLINE void serialize_group(const std::tuple<>& /*tuple*/) const
 	{
@@ -751,9 +801,12 @@ private:
 private:
 	OutputBuffer buffer;
 	std::vector<size_t> openSections;
-	LastDeltaBlocks& lastDeltaBlocks;
-	std::vector<std::shared_ptr<DeltaBlock>>& deltaBlocks;
-	const bool reverseSnapshot;
+	LastDeltaBlocks* lastDeltaBlocks = nullptr; // both nullptr for a
+	std::vector<std::shared_ptr<DeltaBlock>>* deltaBlocks = nullptr; // stand-alone archive
+	std::vector<std::span<const uint8_t>> largeBlobs; // only for stand-alone
+	size_t largeBlobsSize = 0; // including padding
+	const bool reverseSnapshot = false;
+	const bool forHash = false;
 };
 
 class MemInputArchive final : public InputArchiveBase<MemInputArchive>
@@ -763,21 +816,38 @@ public:
 	                std::span<const std::shared_ptr<DeltaBlock>> deltaBlocks_)
 		: buffer(buf_)
 		, deltaBlocks(deltaBlocks_)
+		, standAlone(false)
 	{
 	}
 
-	static constexpr bool NEED_VERSION = false;
-	[[nodiscard]] bool versionAtLeast(unsigned /*actual*/, unsigned /*required*/) const
+	/** Load from a stand-alone archive, see MemOutputArchive. The large
+	  * blobs are copied from 'largeBlobs_' (typically a memory mapped
+	  * file).
+	  */
+	MemInputArchive(std::span<const uint8_t> buf_,
+	                std::span<const uint8_t> largeBlobs_)
+		: buffer(buf_)
+		, largeBlobs(largeBlobs_)
+		, standAlone(true)
 	{
-		return true;
 	}
-	[[nodiscard]] bool versionBelow(unsigned /*actual*/, unsigned /*required*/) const
+
+	[[nodiscard]] bool needVersion() const { return standAlone; }
+	[[nodiscard]] bool translateEnumToString() const { return standAlone; }
+	// Note: for non-stand-alone archives 'actual' is always the latest
+	// version, so then these are respectively always true and false.
+	[[nodiscard]] bool versionAtLeast(unsigned actual, unsigned required) const
 	{
-		return false;
+		return actual >= required;
+	}
+	[[nodiscard]] bool versionBelow(unsigned actual, unsigned required) const
+	{
+		return actual < required;
 	}
 
 	template<typename T> void load(T& t)
 	{
+		checkAvailable(sizeof(t));
 		buffer.read(&t, sizeof(t));
 	}
 	void loadChar(char& c)
@@ -801,6 +871,7 @@ public:
 	ALWAYS_INLINE void serialize(const char* /*tag*/, std::array<T, N>& t)
 		requires(SerializeAsMemcpy<T>::value)
 	{
+		checkAvailable(N * sizeof(T));
 		buffer.read(t.data(), N * sizeof(T));
 	}
 
@@ -809,15 +880,30 @@ public:
 		size_t num;
 		load(num);
 		if (skip) {
+			checkAvailable(num);
 			buffer.skip(num);
 		}
 	}
 
 private:
+	/** Stand-alone archives are read from file, so they can be truncated
+	  * or corrupt. Check before each read, so that we never read past the
+	  * end of the buffer.
+	  * @throws MSXException
+	  */
+	ALWAYS_INLINE void checkAvailable(size_t len) const
+	{
+		if (len > buffer.remaining()) [[unlikely]] {
+			throwTruncated();
+		}
+	}
+	[[noreturn]] static void throwTruncated();
+
 	// See comments in MemOutputArchive
 	template<typename TUPLE>
 	ALWAYS_INLINE void serialize_group(const TUPLE& tuple)
 	{
+		std::apply([&](auto&&... args) { checkAvailable((sizeof(*args) + ... + 0)); }, tuple);
 		auto read = [&](auto* p) { buffer.read(p, sizeof(*p)); };
 		std::apply([&](auto&&... args) { (read(args), ...); }, tuple);
 	}
@@ -836,8 +922,49 @@ private:
 private:
 	InputBuffer buffer;
 	std::span<const std::shared_ptr<DeltaBlock>> deltaBlocks;
+	std::span<const uint8_t> largeBlobs; // only for stand-alone
+	const bool standAlone;
 };
 
+/** Binary savestate files.
+  * Such a file contains a small header followed by a zlib-compressed
+  * stand-alone MemOutputArchive stream. The large blobs (RAM, VRAM, sample
+  * RAM, ...) follow uncompressed, each starting at a page boundary. While
+  * loading the file is memory mapped, so those blobs are copied directly
+  * from the OS page cache into the emulated devices without any
+  * intermediate buffers or decompression.
+  * Compared to XML savestates these are much faster to load, though they
+  * can only be loaded on a platform with the same endianness and word size.
+  */
+namespace BinarySaveState {
+	/** Does the given file start with the binary savestate header? Returns
+	  * false (doesn't throw) if the file cannot be read.
+	  */
+	[[nodiscard]] bool isBinary(zstring_view filename);
+
+	/** Write the content of a stand-alone MemOutputArchive to file.
+	  * @throws MSXException
+	  */
+	void save(zstring_view filename, MemOutputArchive&& archive);
+
+	/** The content of a file written by save(). */
+	struct Contents {
+		MemBuffer<uint8_t> stream; // uncompressed
+		MappedFile<const uint8_t> file; // keeps 'largeBlobs' alive
+		std::span<const uint8_t> largeBlobs;
+
+		[[nodiscard]] MemInputArchive createArchive() const {
+			return MemInputArchive(stream, largeBlobs);
+		}
+	};
+
+	/** Read a file written by save(). Use the result to create a
+	  * stand-alone MemInputArchive.
+	  * @throws MSXException
+	  */
+	[[nodiscard]] Contents load(zstring_view filename);
+}
+
 ////
 
 class XmlOutputArchive final : public OutputArchiveBase<XmlOutputArchive>
@@ -883,6 +1010,11 @@ public:
 
 	void serialize_blob(const char* tag, std::span<const uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<const uint8_t> data,
+	                    const DirtyPages& /*dirty*/)
+	{
+		serialize_blob(tag, data);
+	}
 
 	auto& getXMLOutputStream() { return writer; }
 
@@ -27,10 +27,16 @@ void pointerError(unsigned id)
 		latestVersion, ").");
 }
 
-unsigned loadVersionHelper(MemInputArchive& /*ar*/, const char* /*className*/,
-                           unsigned /*latestVersion*/)
+unsigned loadVersionHelper(MemInputArchive& ar, const char* className,
+                           unsigned latestVersion)
 {
-	UNREACHABLE;
+	// only stand-alone archives store the version
+	unsigned version;
+	ar.attribute("version", version);
+	if (version > latestVersion) [[unlikely]] {
+		versionError(className, latestVersion, version);
+	}
+	return version;
 }
 
 unsigned loadVersionHelper(XmlInputArchive& ar, const char* className,
@@ -140,9 +140,9 @@ template<> struct serialize_as_enum<TYPE> : std::true_type { \
 };
 
 template<typename Archive, typename T, typename SaveAction>
-void saveEnum(std::span<const enum_string<T>> list, T t, SaveAction save)
+void saveEnum(const Archive& ar, std::span<const enum_string<T>> list, T t, SaveAction save)
 {
-	if constexpr (Archive::TRANSLATE_ENUM_TO_STRING) {
+	if (Archive::TRANSLATE_ENUM_TO_STRING || ar.translateEnumToString()) {
 		save(toString(list, t));
 	} else {
 		save(int(t));
@@ -150,9 +150,9 @@ void saveEnum(std::span<const enum_string<T>> list, T t, SaveAction save)
 }
 
 template<typename Archive, typename T, typename LoadAction>
-void loadEnum(std::span<const enum_string<T>> list, T& t, LoadAction load)
+void loadEnum(const Archive& ar, std::span<const enum_string<T>> list, T& t, LoadAction load)
 {
-	if constexpr (Archive::TRANSLATE_ENUM_TO_STRING) {
+	if (Archive::TRANSLATE_ENUM_TO_STRING || ar.translateEnumToString()) {
 		std::string str;
 		load(str);
 		t = fromString(list, str);
@@ -191,7 +191,7 @@ template<typename V> struct VariantSerializer : std::true_type
 	struct Saver {
 		template<typename Archive>
 		void operator()(Archive& ar, const V& v, bool saveId) const {
-			saveEnum<Archive>(Serializer<V>::info(), v.index(),
+			saveEnum(ar, Serializer<V>::info(), v.index(),
 				[&](const auto& t) { ar.attribute("type", t); });
 			std::visit([&]<typename T>(T& e) {
 				using TNC = std::remove_cvref_t<T>;
@@ -205,7 +205,7 @@ template<typename V> struct VariantSerializer : std::true_type
 		template<typename Archive, typename TUPLE>
 		void operator()(Archive& ar, V& v, TUPLE args, int id) const {
 			size_t idx;
-			loadEnum<Archive>(Serializer<V>::info(), idx,
+			loadEnum(ar, Serializer<V>::info(), idx,
 				[&](auto& l) { ar.attribute("type", l); });
 			v = defaultConstructVariant<V>(idx);
 			std::visit([&]<typename T>(T& e) {
@@ -349,7 +349,8 @@ template<typename T, size_t N> struct serialize_as_collection<std::array<T, N>>
 //      Primitive values cannot be versioned.
 //  - EnumSaver
 //      Depending on the archive type, enums are either saved as strings (XML
-//      archive) or as integers (memory archive).
+//      archive and stand-alone memory archive) or as integers (memory
+//      archive).
 //      This does not work automatically: it needs a specialization of
 //      serialize_as_enum, see above.
 //  - ClassSaver
@@ -394,7 +395,7 @@ template<typename T> struct EnumSaver
 	template<typename Archive> void operator()(Archive& ar, const T& t,
 	                                           bool /*saveId*/) const
 	{
-		saveEnum<Archive>(serialize_as_enum<T>::info(), t,
+		saveEnum(ar, serialize_as_enum<T>::info(), t,
 			[&](const auto& s) { ar.save(s); });
 	}
 };
@@ -426,7 +427,7 @@ template<typename T> struct ClassSaver
 		}
 
 		unsigned version = SerializeClassVersion<T>::value;
-		if ((version != 0) && ar.NEED_VERSION) {
+		if ((version != 0) && ar.needVersion()) {
 			if (!ar.CAN_HAVE_OPTIONAL_ATTRIBUTES ||
 			    (version != 1)) {
 				ar.attribute("version", version);
@@ -562,7 +563,7 @@ template<typename T> struct EnumLoader
 	{
 		static_assert(std::tuple_size_v<TUPLE> == 0,
 		              "can't have constructor arguments");
-		loadEnum<Archive>(serialize_as_enum<T>::info(), t,
+		loadEnum(ar, serialize_as_enum<T>::info(), t,
 			[&](auto& l) { ar.load(l); });
 	}
 };
@@ -574,7 +575,7 @@ unsigned loadVersionHelper(XmlInputArchive& ar, const char* className,
 template<typename T, typename Archive> unsigned loadVersion(Archive& ar)
 {
 	unsigned latestVersion = SerializeClassVersion<T>::value;
-	if ((latestVersion != 0) && ar.NEED_VERSION) {
+	if ((latestVersion != 0) && ar.needVersion()) {
 		return loadVersionHelper(ar, typeid(T).name(), latestVersion);
 	} else {
 		return latestVersion;
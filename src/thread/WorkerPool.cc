@@ -0,0 +1,61 @@
+#include "WorkerPool.hh"
+
+#include "xrange.hh"
+
+namespace openmsx {
+
+WorkerPool::WorkerPool(unsigned numHelpers)
+{
+	threads.reserve(numHelpers);
+	for (auto i : xrange(numHelpers)) {
+		threads.emplace_back([this, i] { helperLoop(i + 1); });
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::scoped_lock lock(mutex);
+		stop = true;
+	}
+	startCond.notify_all();
+	for (auto& t : threads) t.join();
+}
+
+void WorkerPool::run(size_t num, function_ref<void(size_t)> f)
+{
+	{
+		std::scoped_lock lock(mutex);
+		job = &f;
+		jobSize = num;
+		busy = num - 1;
+		++jobCount;
+	}
+	startCond.notify_all();
+
+	f(0);
+
+	std::unique_lock lock(mutex);
+	doneCond.wait(lock, [&] { return busy == 0; });
+	job = nullptr;
+}
+
+void WorkerPool::helperLoop(size_t index)
+{
+	uint64_t done = 0;
+	std::unique_lock lock(mutex);
+	while (true) {
+		startCond.wait(lock, [&] { return stop || (jobCount != done); });
+		if (stop) return;
+		done = jobCount;
+		if (index >= jobSize) continue; // not needed for this job
+
+		auto* f = job;
+		lock.unlock();
+		(*f)(index);
+		lock.lock();
+		if (--busy == 0) doneCond.notify_one();
+	}
+}
+
+} // namespace openmsx
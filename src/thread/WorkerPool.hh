@@ -0,0 +1,60 @@
+#ifndef WORKERPOOL_HH
+#define WORKERPOOL_HH
+
+#include "function_ref.hh"
+
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+/** A fixed set of helper threads, used to repeatedly (e.g. once per frame)
+  * run a job in parallel, without the cost of starting and joining new
+  * threads each time.
+  */
+class WorkerPool
+{
+public:
+	explicit WorkerPool(unsigned numHelpers);
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool(WorkerPool&&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	WorkerPool& operator=(WorkerPool&&) = delete;
+	~WorkerPool();
+
+	/** Run 'f' on all items: item 0 on the calling thread, the others on
+	  * the helper threads. Returns when all items are done.
+	  * There can't be more items than helpers + 1, and 'f' shouldn't
+	  * throw.
+	  */
+	template<typename T, typename F>
+	void forEach(std::span<T> items, F f)
+	{
+		assert(items.size() <= threads.size() + 1);
+		if (items.empty()) return;
+		run(items.size(), [&](size_t i) { f(items[i]); });
+	}
+
+private:
+	void run(size_t num, function_ref<void(size_t)> job);
+	void helperLoop(size_t index);
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable startCond; // a new job, or stop
+	std::condition_variable doneCond;  // all helpers finished the job
+	function_ref<void(size_t)>* job = nullptr;
+	size_t jobSize = 0;
+	uint64_t jobCount = 0; // incremented for each job
+	size_t busy = 0; // number of helpers still working on the current job
+	bool stop = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,223 @@
+#include "catch.hpp"
+
+#include "BitmapConverter.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace openmsx;
+using Pixel = BitmapConverter::Pixel;
+
+// Straightforward (slow) implementations of all bitmap modes, the optimized
+// (possibly SIMD) versions in BitmapConverter must give identical results.
+struct Reference
+{
+	std::span<const Pixel, 16 * 2> palette16;
+	std::span<const Pixel, 256>    palette256;
+	std::span<const Pixel, 32768>  palette32768;
+
+	[[nodiscard]] std::vector<Pixel> graphic4(std::span<const uint8_t, 128> v0) const {
+		std::vector<Pixel> result;
+		for (auto d : v0) {
+			result.push_back(palette16[d >> 4]);
+			result.push_back(palette16[d & 15]);
+		}
+		return result;
+	}
+	[[nodiscard]] std::vector<Pixel> graphic5(std::span<const uint8_t, 128> v0) const {
+		std::vector<Pixel> result;
+		for (auto d : v0) {
+			result.push_back(palette16[ 0 + ((d >> 6) & 3)]);
+			result.push_back(palette16[16 + ((d >> 4) & 3)]);
+			result.push_back(palette16[ 0 + ((d >> 2) & 3)]);
+			result.push_back(palette16[16 + ((d >> 0) & 3)]);
+		}
+		return result;
+	}
+	[[nodiscard]] std::vector<Pixel> graphic6(std::span<const uint8_t, 128> v0,
+	                                          std::span<const uint8_t, 128> v1) const {
+		std::vector<Pixel> result;
+		for (auto i : xrange(128)) {
+			result.push_back(palette16[v0[i] >> 4]);
+			result.push_back(palette16[v0[i] & 15]);
+			result.push_back(palette16[v1[i] >> 4]);
+			result.push_back(palette16[v1[i] & 15]);
+		}
+		return result;
+	}
+	[[nodiscard]] std::vector<Pixel> graphic7(std::span<const uint8_t, 128> v0,
+	                                          std::span<const uint8_t, 128> v1) const {
+		std::vector<Pixel> result;
+		for (auto i : xrange(128)) {
+			result.push_back(palette256[v0[i]]);
+			result.push_back(palette256[v1[i]]);
+		}
+		return result;
+	}
+	[[nodiscard]] std::vector<Pixel> yjk(std::span<const uint8_t, 128> v0,
+	                                     std::span<const uint8_t, 128> v1, bool yae) const {
+		auto signed6 = [](int lo, int hi) { // 3 low bits of 'lo', 3 low bits of 'hi'
+			int v = (lo & 7) | ((hi & 7) << 3);
+			return (v & 32) ? v - 64 : v;
+		};
+		std::vector<Pixel> result;
+		for (auto i : xrange(64)) {
+			std::array<int, 4> p = {v0[2 * i], v1[2 * i], v0[2 * i + 1], v1[2 * i + 1]};
+			int k = signed6(p[0], p[1]);
+			int j = signed6(p[2], p[3]);
+			for (auto n : xrange(4)) {
+				if (yae && (p[n] & 8)) {
+					result.push_back(palette16[p[n] >> 4]);
+				} else {
+					int y = p[n] >> 3;
+					int r = std::clamp(y + j, 0, 31);
+					int g = std::clamp(y + k, 0, 31);
+					int b = std::clamp((5 * y - 2 * j - k + 2) / 4, 0, 31);
+					result.push_back(palette32768[(r << 10) + (g << 5) + b]);
+				}
+			}
+		}
+		return result;
+	}
+};
+
+TEST_CASE("BitmapConverter")
+{
+	std::mt19937 gen(1234); // fixed seed: reproducible
+	std::uniform_int_distribution<uint32_t> dist;
+
+	std::vector<Pixel> palette16(16 * 2);
+	std::vector<Pixel> palette256(256);
+	std::vector<Pixel> palette32768(32768);
+	for (auto& p : palette16)    p = dist(gen);
+	for (auto& p : palette256)   p = dist(gen);
+	for (auto& p : palette32768) p = dist(gen);
+	std::span<const Pixel, 16 * 2> pal16(palette16.data(), 16 * 2);
+	std::span<const Pixel, 256>    pal256(palette256.data(), 256);
+	std::span<const Pixel, 32768>  pal32768(palette32768.data(), 32768);
+
+	BitmapConverter converter(pal16, pal256, pal32768);
+	Reference ref{pal16, pal256, pal32768};
+
+	std::array<uint8_t, 128> vram0;
+	std::array<uint8_t, 128> vram1;
+	std::vector<Pixel> buf(512 + 1);
+
+	auto check = [&](uint8_t mode, bool planar, const std::vector<Pixel>& expected) {
+		const Pixel sentinel = 0x12345678;
+		std::ranges::fill(buf, sentinel);
+		DisplayMode displayMode;
+		displayMode.setByte(mode);
+		converter.setDisplayMode(displayMode);
+		if (planar) {
+			converter.convertLinePlanar(buf, vram0, vram1);
+		} else {
+			converter.convertLine(buf, vram0);
+		}
+		CHECK(std::equal(expected.begin(), expected.end(), buf.begin()));
+		CHECK(buf[expected.size()] == sentinel); // no writes beyond the line
+	};
+
+	for (auto iter : xrange(100)) {
+		for (auto& v : vram0) v = uint8_t(dist(gen));
+		for (auto& v : vram1) v = uint8_t(dist(gen));
+		if (iter == 10) {
+			// change palette, make sure it's picked up
+			for (auto& p : palette16) p = dist(gen);
+			converter.palette16Changed();
+		}
+
+		check(DisplayMode::GRAPHIC4, false, ref.graphic4(vram0));
+		check(DisplayMode::GRAPHIC5, false, ref.graphic5(vram0));
+		check(DisplayMode::GRAPHIC6, true,  ref.graphic6(vram0, vram1));
+		check(DisplayMode::GRAPHIC7, true,  ref.graphic7(vram0, vram1));
+		check(DisplayMode::GRAPHIC7 | DisplayMode::YJK, true,
+		      ref.yjk(vram0, vram1, false));
+		check(DisplayMode::GRAPHIC7 | DisplayMode::YJK | DisplayMode::YAE, true,
+		      ref.yjk(vram0, vram1, true));
+	}
+}
+
+// The test above only exercises the kernels that are selected on this CPU,
+// test every kernel that can run here separately.
+TEST_CASE("BitmapKernels")
+{
+	using namespace BitmapKernels;
+	std::mt19937 gen(4321); // fixed seed: reproducible
+	std::uniform_int_distribution<uint32_t> dist;
+
+	std::vector<Pixel> palette16(16 * 2);
+	std::vector<Pixel> palette256(256);
+	std::vector<Pixel> palette32768(32768);
+	for (auto& p : palette16)    p = dist(gen);
+	for (auto& p : palette256)   p = dist(gen);
+	for (auto& p : palette32768) p = dist(gen);
+	std::span<const Pixel, 16 * 2> pal16(palette16.data(), 16 * 2);
+	std::span<const Pixel, 256>    pal256(palette256.data(), 256);
+	std::span<const Pixel, 32768>  pal32768(palette32768.data(), 32768);
+	Reference ref{pal16, pal256, pal32768};
+
+	std::array<DPixel, 16 * 16> dPalette;
+	calcDPalette(pal16, dPalette);
+
+	std::array<uint8_t, 128> vram0;
+	std::array<uint8_t, 128> vram1;
+	std::vector<Pixel> buf(512 + 1);
+
+	auto check = [&](const std::vector<Pixel>& expected, auto kernel) {
+		const Pixel sentinel = 0x12345678;
+		std::ranges::fill(buf, sentinel);
+		kernel(buf.data());
+		CHECK(std::equal(expected.begin(), expected.end(), buf.begin()));
+		CHECK(buf[expected.size()] == sentinel); // no writes beyond the line
+	};
+	auto out256 = [](Pixel* p) { return std::span<Pixel, 256>(p, 256); };
+	auto out512 = [](Pixel* p) { return std::span<Pixel, 512>(p, 512); };
+
+	for ([[maybe_unused]] auto iter : xrange(100)) {
+		for (auto& v : vram0) v = uint8_t(dist(gen));
+		for (auto& v : vram1) v = uint8_t(dist(gen));
+		auto g4  = ref.graphic4(vram0);
+		auto g5  = ref.graphic5(vram0);
+		auto g6  = ref.graphic6(vram0, vram1);
+		auto g7  = ref.graphic7(vram0, vram1);
+		auto yjk = ref.yjk(vram0, vram1, false);
+		auto yae = ref.yjk(vram0, vram1, true);
+
+		check(g4,  [&](Pixel* p) { renderGraphic4(dPalette, vram0, out256(p)); });
+		check(g5,  [&](Pixel* p) { renderGraphic5(pal16, vram0, out512(p)); });
+		check(g6,  [&](Pixel* p) { renderGraphic6(dPalette, vram0, vram1, out512(p)); });
+		check(g7,  [&](Pixel* p) { renderGraphic7(pal256, vram0, vram1, out256(p)); });
+		check(yjk, [&](Pixel* p) { renderYJK(pal32768, vram0, vram1, out256(p)); });
+		check(yae, [&](Pixel* p) { renderYAE(pal16, pal32768, vram0, vram1, out256(p)); });
+#ifdef __SSE2__
+		check(yjk, [&](Pixel* p) { renderYJKSSE2(pal32768, vram0, vram1, out256(p)); });
+		check(yae, [&](Pixel* p) { renderYAESSE2(pal16, pal32768, vram0, vram1, out256(p)); });
+#endif
+#ifdef SIMD_SSSE3
+		if (SIMD::hasSSSE3()) {
+			check(g4, [&](Pixel* p) { renderGraphic4SSSE3(pal16, vram0, out256(p)); });
+			check(g5, [&](Pixel* p) { renderGraphic5SSSE3(pal16, vram0, out512(p)); });
+			check(g6, [&](Pixel* p) { renderGraphic6SSSE3(pal16, vram0, vram1, out512(p)); });
+		}
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+		check(g4, [&](Pixel* p) { renderGraphic4NEON(pal16, vram0, out256(p)); });
+		check(g5, [&](Pixel* p) { renderGraphic5NEON(pal16, vram0, out512(p)); });
+		check(g6, [&](Pixel* p) { renderGraphic6NEON(pal16, vram0, vram1, out512(p)); });
+#endif
+#ifdef SIMD_AVX2
+		if (SIMD::hasAVX2()) {
+			check(g7,  [&](Pixel* p) { renderGraphic7AVX2(pal256, vram0, vram1, out256(p)); });
+			check(yjk, [&](Pixel* p) { renderYJKAVX2(pal32768, vram0, vram1, out256(p)); });
+			check(yae, [&](Pixel* p) { renderYAEAVX2(pal16, pal32768, vram0, vram1, out256(p)); });
+		}
+#endif
+	}
+}
@@ -0,0 +1,126 @@
+#include "catch.hpp"
+
+#include "DeltaBlock.hh"
+#include "DirtyPages.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <vector>
+
+using namespace openmsx;
+
+static void check(const DeltaBlock& block, const std::vector<uint8_t>& expected)
+{
+	std::vector<uint8_t> buf(expected.size(), 0x55);
+	block.apply(buf);
+	CHECK(buf == expected);
+}
+
+TEST_CASE("DirtyPages")
+{
+	DirtyPages dirty(1000); // last page is partial
+	CHECK(dirty.size() == 4);
+	CHECK(!dirty.any());
+
+	dirty.mark(300);
+	CHECK(dirty.any());
+	CHECK(!dirty.test(0));
+	CHECK( dirty.test(1));
+	CHECK(!dirty.test(2));
+
+	dirty.markRange(255, 2);
+	CHECK(dirty.test(0));
+	CHECK(dirty.test(1));
+	CHECK(!dirty.test(3));
+
+	DirtyPages other(1000);
+	other.mark(999);
+	dirty |= other;
+	CHECK(dirty.test(3));
+
+	dirty.clear();
+	CHECK(!dirty.any());
+	dirty.markAll();
+	for (auto i : xrange(dirty.size())) CHECK(dirty.test(i));
+}
+
+TEST_CASE("DeltaBlock: dirty pages")
+{
+	static constexpr size_t SIZE = 10 * DirtyPages::PAGE_SIZE + 123;
+	std::vector<uint8_t> data(SIZE);
+	for (auto i : xrange(SIZE)) data[i] = uint8_t(i * 7);
+	int id = 0; // only the address matters
+
+	LastDeltaBlocks lastBlocks;
+	DirtyPages dirty(SIZE);
+	auto b0 = lastBlocks.createNew(&id, data, &dirty);
+	check(*b0, data);
+
+	// single write
+	data[3 * DirtyPages::PAGE_SIZE + 5] ^= 0xff;
+	dirty.mark(3 * DirtyPages::PAGE_SIZE + 5);
+	auto b1 = lastBlocks.createNew(&id, data, &dirty);
+	check(*b1, data);
+	dirty.clear();
+
+	// writes in different pages, including the partial last page
+	data[0] ^= 1;
+	dirty.mark(0);
+	data[SIZE - 1] ^= 1;
+	dirty.mark(SIZE - 1);
+	std::ranges::fill(std::span{data}.subspan(4 * DirtyPages::PAGE_SIZE - 3, 10), 0x42);
+	dirty.markRange(4 * DirtyPages::PAGE_SIZE - 3, 10);
+	auto b2 = lastBlocks.createNew(&id, data, &dirty);
+	check(*b2, data);
+	auto data2 = data;
+	dirty.clear();
+
+	// no changes since the last snapshot, but still different from the
+	// reference block (changes must be accumulated)
+	auto b3 = lastBlocks.createNew(&id, data, &dirty);
+	check(*b3, data);
+
+	// mix with a diff without dirty information
+	data[7 * DirtyPages::PAGE_SIZE] ^= 3;
+	auto b4 = lastBlocks.createNew(&id, data);
+	check(*b4, data);
+
+	// earlier blocks are still valid
+	check(*b2, data2);
+	check(*b3, data2);
+}
+
+TEST_CASE("DeltaBlock: compression")
+{
+	static constexpr size_t SIZE = 20000;
+	std::vector<uint8_t> data(SIZE);
+	for (auto i : xrange(SIZE)) data[i] = uint8_t((i / 13) % 5);
+	int id = 0;
+
+	LastDeltaBlocks lastBlocks;
+	auto b0 = lastBlocks.createNew(&id, data);
+	auto data0 = data;
+	// still the reference block: can't be compressed
+	CHECK(b0->compress(DeltaBlock::Compression::FAST) == 0);
+	auto b1 = lastBlocks.createNew(&id, data);
+
+	// many changes, the next call creates a new reference block
+	for (auto& d : data) d ^= 0xff;
+	auto b2 = lastBlocks.createNew(&id, data);
+	auto b3 = lastBlocks.createNew(&id, data);
+	auto data2 = data;
+	check(*b0, data0);
+	check(*b2, data2);
+
+	CHECK(b0->compress(DeltaBlock::Compression::FAST) == SIZE);
+	CHECK(b0->compress(DeltaBlock::Compression::FAST) == 0); // already done
+	check(*b0, data0);
+	check(*b1, data0);
+	CHECK(b1->compress(DeltaBlock::Compression::HIGH) == SIZE); // recompresses b0
+	CHECK(b0->compress(DeltaBlock::Compression::HIGH) == 0);
+	check(*b0, data0);
+	check(*b1, data0);
+	check(*b2, data2);
+	check(*b3, data2);
+}
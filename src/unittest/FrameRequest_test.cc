@@ -0,0 +1,87 @@
+#include "catch.hpp"
+
+#include "FrameRequest.hh"
+
+#include "xrange.hh"
+
+using namespace openmsx;
+
+// Simplified model of how PixelRenderer, SDLRasterizer and PostProcessor
+// handle the frames with 'render_on_demand' enabled: a frame is only
+// rendered when it's wanted, at the start of a rendered frame the previous
+// work frame is published (PostProcessor::rotateFrames()).
+struct Renderer {
+	// Start the next MSX frame. 'paint' is false when frame skip
+	// decides not to render this frame.
+	void frameStart(bool paint = true) {
+		++frame;
+		if (!request.isPending()) return; // not wanted
+		if (!paint) return;
+		published = workFrame;
+		request.frameRotated();
+		workFrame = frame; // from now on rendered into the work frame
+	}
+
+	// Like HeadlessVideoSystem::takeScreenShot(): returns the MSX frame
+	// the screenshot shows.
+	int screenshot() {
+		request.request();
+		int start = frame;
+		while (request.isPending()) {
+			REQUIRE(frame < start + 10);
+			frameStart();
+		}
+		return published;
+	}
+
+	FrameRequest request;
+	int frame = 0;      // the current MSX frame
+	int workFrame = 0;  // MSX frame that's (being) rendered in the work frame
+	int published = 0;  // MSX frame that's shown, see PostProcessor::getPaintFrame()
+};
+
+TEST_CASE("FrameRequest")
+{
+	Renderer r;
+	CHECK(!r.request.isPending());
+
+	SECTION("frames are not rendered without request") {
+		repeat(100, [&] { r.frameStart(); });
+		CHECK(r.published == 0);
+		CHECK(r.workFrame == 0);
+	}
+	SECTION("screenshot after a long time without rendering") {
+		repeat(100, [&] { r.frameStart(); });
+		int requestFrame = r.frame;
+		int shown = r.screenshot();
+		// Frame 'requestFrame' itself was (partly) drawn before the
+		// request (and here it's not rendered at all).
+		CHECK(shown > requestFrame);
+		CHECK(shown == requestFrame + 1);
+		// rendering stops again
+		CHECK(!r.request.isPending());
+		repeat(10, [&] { r.frameStart(); });
+		CHECK(r.published == shown);
+	}
+	SECTION("frames stay requested while not rendered (paused, frame skip)") {
+		repeat(5, [&] { r.frameStart(); });
+		r.request.request();
+		int requestFrame = r.frame;
+		repeat(10, [&] { r.frameStart(false); });
+		CHECK(r.request.isPending());
+		r.frameStart(); // starts rendering a fresh frame
+		CHECK(r.request.isPending());
+		repeat(3, [&] { r.frameStart(false); });
+		CHECK(r.request.isPending());
+		r.frameStart(); // publishes it
+		CHECK(!r.request.isPending());
+		CHECK(r.published > requestFrame);
+	}
+	SECTION("second request while the first one is rendering") {
+		repeat(5, [&] { r.frameStart(); });
+		r.request.request();
+		r.frameStart(); // rendering frame 6, started after the first request
+		int requestFrame = r.frame;
+		CHECK(r.screenshot() > requestFrame);
+	}
+}
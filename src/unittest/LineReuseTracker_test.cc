@@ -0,0 +1,78 @@
+#include "catch.hpp"
+
+#include "LineReuseTracker.hh"
+
+#include "xrange.hh"
+
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+// Mimics how PixelRenderer uses LineReuseTracker: render a frame line by line
+// and record which lines were drawn (as opposed to copied).
+struct Renderer
+{
+	LineReuseTracker tracker{16};
+	int textModeCounter = 0;
+	bool haveLastFrame = true;
+
+	std::vector<int> renderFrame(int lineZero = 0, bool displayEnabled = true)
+	{
+		std::vector<int> drawn;
+		textModeCounter = 0;
+		for (auto y : xrange(16)) {
+			tracker.renderLine(y, textModeCounter, lineZero, displayEnabled,
+				[&] { return haveLastFrame; },
+				[&] { drawn.push_back(y); textModeCounter += 2; });
+		}
+		return drawn;
+	}
+};
+}
+
+TEST_CASE("LineReuseTracker")
+{
+	static const std::vector<int> all = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+	static const std::vector<int> none;
+	Renderer r;
+	CHECK(r.renderFrame() == all); // nothing drawn yet
+	CHECK(r.renderFrame() == none); // static screen
+	CHECK(r.textModeCounter == 32); // restored from the copied lines
+
+	SECTION("change halfway a frame") {
+		// E.g. the sprite attribute table base changes while line 8 is
+		// rendered (PixelRenderer::updateSpriteAttributeBase()). The
+		// lines before that were already rendered, so only the
+		// remaining lines are redrawn in this frame, the other lines
+		// in the next frame.
+		std::vector<int> drawn;
+		r.textModeCounter = 0;
+		for (auto y : xrange(16)) {
+			if (y == 8) r.tracker.invalidate();
+			r.tracker.renderLine(y, r.textModeCounter, 0, true,
+				[] { return true; },
+				[&] { drawn.push_back(y); r.textModeCounter += 2; });
+		}
+		CHECK(drawn == std::vector<int>{8, 9, 10, 11, 12, 13, 14, 15});
+		CHECK(r.renderFrame() == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7});
+		CHECK(r.renderFrame() == none);
+	}
+	SECTION("change between frames") {
+		r.tracker.invalidate();
+		CHECK(r.renderFrame() == all);
+		CHECK(r.renderFrame() == none);
+	}
+	SECTION("line zero or display enable changed") {
+		CHECK(r.renderFrame(1, true) == all);
+		CHECK(r.renderFrame(1, true) == none);
+		CHECK(r.renderFrame(1, false) == all);
+		CHECK(r.renderFrame(1, false) == none);
+	}
+	SECTION("previous frame not available") {
+		r.haveLastFrame = false;
+		CHECK(r.renderFrame() == all);
+		r.haveLastFrame = true;
+		CHECK(r.renderFrame() == none);
+	}
+}
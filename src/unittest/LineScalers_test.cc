@@ -0,0 +1,94 @@
+#include "catch.hpp"
+
+#include "LineScalers.hh"
+
+#include "xrange.hh"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// The (possibly SIMD) line routines must give identical results as the scalar
+// PixelOperations routines. Test with all widths up to 20, so that every
+// possible tail after the SIMD loop is covered.
+
+static std::vector<Pixel> randomLine(std::mt19937& gen, size_t width)
+{
+	std::uniform_int_distribution<uint32_t> dist;
+	std::vector<Pixel> result(width);
+	for (auto& p : result) p = dist(gen);
+	return result;
+}
+
+template<unsigned w1, unsigned w2>
+static void testBlend()
+{
+	PixelOperations pixelOps;
+	std::mt19937 gen(123);
+	for (auto width : xrange(21)) {
+		auto in1 = randomLine(gen, width);
+		auto in2 = randomLine(gen, width);
+		std::vector<Pixel> out(width);
+		blendLines<w1, w2>(in1, in2, out);
+		for (auto i : xrange(width)) {
+			CHECK(out[i] == pixelOps.blend<w1, w2>(in1[i], in2[i]));
+		}
+		// in-place
+		blendLines<w1, w2>(in1, in2, in1);
+		CHECK(in1 == out);
+	}
+}
+
+TEST_CASE("LineScalers: blendLines")
+{
+	testBlend<1, 1>();
+	testBlend<1, 3>();
+	testBlend<3, 1>();
+	testBlend<1, 7>();
+	testBlend<3, 5>();
+	testBlend<5, 3>();
+	testBlend<1, 2>();
+	testBlend<2, 1>();
+	testBlend<1, 15>();
+	testBlend<0, 1>();
+}
+
+TEST_CASE("LineScalers: alphaBlendLines")
+{
+	PixelOperations pixelOps;
+	std::mt19937 gen(456);
+	for (auto width : xrange(21)) {
+		auto in1 = randomLine(gen, width);
+		auto in2 = randomLine(gen, width);
+		if (width > 2) {
+			// also fully opaque and fully transparent pixels
+			in1[0] |= 0xFF000000;
+			in1[1] &= 0x00FFFFFF;
+		}
+		std::vector<Pixel> out(width);
+		alphaBlendLines(in1, in2, out);
+		for (auto i : xrange(width)) {
+			CHECK(out[i] == pixelOps.alphaBlend(in1[i], in2[i]));
+		}
+	}
+}
+
+TEST_CASE("LineScalers: alphaBlendLines with constant color")
+{
+	PixelOperations pixelOps;
+	std::mt19937 gen(789);
+	for (auto alpha : {1u, 2u, 127u, 128u, 200u, 254u}) {
+		Pixel in1 = (alpha << 24) | 0x123456;
+		Pixel in1M = pixelOps.multiply(in1, alpha);
+		for (auto width : xrange(21)) {
+			auto in2 = randomLine(gen, width);
+			std::vector<Pixel> out(width);
+			alphaBlendLines(in1, in2, out);
+			for (auto i : xrange(width)) {
+				CHECK(out[i] == in1M + pixelOps.multiply(in2[i], 256 - alpha));
+			}
+		}
+	}
+}
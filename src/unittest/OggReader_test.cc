@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "components.hh"
+
+#if COMPONENT_LASERDISC
+
+#include "OggReader.hh"
+
+#include "FileOperations.hh"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+static constexpr size_t FILE_SIZE = 123456789;
+static constexpr time_t FILE_TIME = 1700000000;
+
+static void createFile(const std::string& filename, const std::string& content)
+{
+	std::ofstream of(filename);
+	of << content;
+}
+
+// Keyframes 1, 50 and 120; the audio page before each keyframe page starts
+// at the given sample.
+static OggSeekIndex makeIndex()
+{
+	return {FILE_SIZE, FILE_TIME, 200, {
+		{.offset =    0, .frame =   1, .sample =     0},
+		{.offset = 1000, .frame =  50, .sample = 20000},
+		{.offset = 3000, .frame = 120, .sample = 60000},
+	}};
+}
+
+static void checkFind(const OggSeekIndex& index)
+{
+	auto offset = [&](size_t frame, size_t sample) {
+		return index.find(frame, sample).offset;
+	};
+	// before the first keyframe
+	CHECK(offset(0, 0) == 0);
+	// up to (not including) a keyframe the previous entry is needed
+	CHECK(offset(  1, 999999) ==    0);
+	CHECK(offset( 49, 999999) ==    0);
+	CHECK(offset( 50, 999999) == 1000);
+	CHECK(offset(119, 999999) == 1000);
+	CHECK(offset(120, 999999) == 3000);
+	CHECK(offset(199, 999999) == 3000);
+	// same for the audio sample
+	CHECK(offset(999, 19999) ==    0);
+	CHECK(offset(999, 20000) == 1000);
+	CHECK(offset(999, 59999) == 1000);
+	CHECK(offset(999, 60000) == 3000);
+	// the earliest of both wins
+	CHECK(offset( 49, 60000) ==    0);
+	CHECK(offset(120, 20000) == 1000);
+}
+
+TEST_CASE("OggSeekIndex: find")
+{
+	checkFind(makeIndex());
+}
+
+TEST_CASE("OggSeekIndex: save and load")
+{
+	auto filename = FileOperations::getTempDir() + "/oggseekindex_unittest.idx";
+	makeIndex().save(filename);
+
+	auto index = OggSeekIndex::load(filename, FILE_SIZE, FILE_TIME);
+	REQUIRE(index);
+	CHECK(index->getFileSize() == FILE_SIZE);
+	CHECK(index->getTotalFrames() == 200);
+	checkFind(*index);
+
+	// stale: the video file has changed
+	CHECK(!OggSeekIndex::load(filename, FILE_SIZE + 1, FILE_TIME));
+	CHECK(!OggSeekIndex::load(filename, FILE_SIZE, FILE_TIME + 1));
+
+	FileOperations::unlink(filename);
+	CHECK(!OggSeekIndex::load(filename, FILE_SIZE, FILE_TIME));
+}
+
+TEST_CASE("OggSeekIndex: corrupt")
+{
+	auto filename = FileOperations::getTempDir() + "/oggseekindex_unittest.idx";
+	std::string header = "openMSX ogg seek index 1\n";
+	std::string info = "123456789 1700000000 200\n";
+	std::string entries = "0 1 0\n1000 50 20000\n3000 120 60000\n";
+
+	createFile(filename, header + info + entries);
+	CHECK(OggSeekIndex::load(filename, FILE_SIZE, FILE_TIME));
+
+	std::vector<std::string> corrupt = {
+		"", // empty file
+		"openMSX ogg seek index 2\n" + info + entries, // other version
+		header, // no info
+		header + "123456789 1700000000\n" + entries, // incomplete info
+		header + info, // no entries
+		header + info + "0 1 0\n1000 50 20000\n3000 120", // truncated
+		header + info + "0 1 0\n1000 50 20000\n3000 120 60000", // truncated
+		header + info + "0 1 0\n1000 50 20000\n3000 x 60000\n", // garbage
+		header + info + "0 1 0\n1000 50 20000 7\n3000 120 60000\n", // extra field
+		header + info + "0 1 0\n3000 120 60000\n1000 50 20000\n", // unsorted offset
+		header + info + "0 1 0\n1000 120 20000\n3000 50 60000\n", // unsorted frame
+		header + info + "0 1 0\n1000 50 60000\n3000 120 20000\n", // unsorted sample
+	};
+	for (const auto& content : corrupt) {
+		CAPTURE(content);
+		createFile(filename, content);
+		CHECK(!OggSeekIndex::load(filename, FILE_SIZE, FILE_TIME));
+	}
+	FileOperations::unlink(filename);
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include "catch.hpp"
+
+#include "PNG.hh"
+
+#include "File.hh"
+#include "FileOperations.hh"
+
+#include "endian.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <zlib.h>
+
+using namespace openmsx;
+
+// Test image with a mix of smooth areas, noise and repeated rows, so that
+// all filter types get used and deflate finds matches across the stripe
+// boundaries (these must be resolved via the preset dictionary).
+static std::vector<uint8_t> makeImage(size_t rowBytes, size_t height)
+{
+	std::mt19937 gen(1234);
+	std::uniform_int_distribution<int> dist(0, 255);
+	std::vector<uint8_t> image(rowBytes * height);
+	for (auto y : xrange(height)) {
+		auto* row = &image[y * rowBytes];
+		switch (y % 4) {
+		case 0: // gradient
+			for (auto x : xrange(rowBytes)) row[x] = uint8_t(x + 3 * y);
+			break;
+		case 1: // noise
+			for (auto x : xrange(rowBytes)) row[x] = uint8_t(dist(gen));
+			break;
+		default: // repeat a row from somewhat higher up
+			if (y >= 11) {
+				std::memcpy(row, &image[(y - 11) * rowBytes], rowBytes);
+			} else {
+				std::memset(row, int(y), rowBytes);
+			}
+		}
+	}
+	return image;
+}
+
+struct ParsedPNG {
+	unsigned width = 0;
+	unsigned height = 0;
+	unsigned colorType = 0;
+	unsigned numIDAT = 0;
+	std::vector<uint8_t> zlibData; // concatenated content of the IDAT chunks
+};
+
+static ParsedPNG parsePNG(const std::string& filename)
+{
+	File file(filename);
+	std::vector<uint8_t> buf(file.getSize());
+	file.read(std::span{buf});
+
+	static constexpr std::array<uint8_t, 8> signature = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	REQUIRE(buf.size() >= 8);
+	REQUIRE(std::equal(signature.begin(), signature.end(), buf.begin()));
+
+	ParsedPNG result;
+	size_t pos = 8;
+	while (true) {
+		REQUIRE(pos + 12 <= buf.size());
+		auto len = Endian::read_UA_B32(&buf[pos]);
+		std::string type(reinterpret_cast<const char*>(&buf[pos + 4]), 4);
+		REQUIRE(pos + 12 + len <= buf.size());
+		const auto* data = &buf[pos + 8];
+		auto crc = crc32(crc32(0, nullptr, 0), &buf[pos + 4], uInt(len + 4));
+		CHECK(Endian::read_UA_B32(data + len) == crc);
+		if (type == "IHDR") {
+			result.width = Endian::read_UA_B32(data + 0);
+			result.height = Endian::read_UA_B32(data + 4);
+			result.colorType = data[9];
+		} else if (type == "IDAT") {
+			result.zlibData.insert(result.zlibData.end(), data, data + len);
+			++result.numIDAT;
+		} else if (type == "IEND") {
+			CHECK(pos + 12 == buf.size());
+			break;
+		}
+		pos += 12 + len;
+	}
+	return result;
+}
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+	int p = a + b - c;
+	int pa = std::abs(p - a);
+	int pb = std::abs(p - b);
+	int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc) return a;
+	if (pb <= pc) return b;
+	return c;
+}
+
+// Inflate (this checks the zlib header and the adler32 checksum) and undo
+// the filters.
+static std::vector<uint8_t> decodeImageData(
+	std::span<const uint8_t> zlibData, size_t rowBytes, size_t bpp, size_t height)
+{
+	std::vector<uint8_t> filtered(height * (rowBytes + 1) + 1); // +1: detect too much data
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	REQUIRE(inflateInit(&zs) == Z_OK);
+	zs.next_in = const_cast<uint8_t*>(zlibData.data());
+	zs.avail_in = uInt(zlibData.size());
+	zs.next_out = filtered.data();
+	zs.avail_out = uInt(filtered.size());
+	auto r = inflate(&zs, Z_FINISH);
+	auto totalOut = zs.total_out;
+	auto remaining = zs.avail_in;
+	inflateEnd(&zs);
+	REQUIRE(r == Z_STREAM_END);
+	REQUIRE(remaining == 0);
+	REQUIRE(totalOut == height * (rowBytes + 1));
+
+	std::vector<uint8_t> image(height * rowBytes);
+	std::vector<uint8_t> zeroRow(rowBytes, 0);
+	for (auto y : xrange(height)) {
+		const auto* in = &filtered[y * (rowBytes + 1)];
+		auto type = in[0];
+		REQUIRE(type <= 4);
+		++in;
+		auto* cur = &image[y * rowBytes];
+		const auto* prev = y ? &image[(y - 1) * rowBytes] : zeroRow.data();
+		for (auto i : xrange(rowBytes)) {
+			uint8_t a = (i >= bpp) ? cur[i - bpp] : 0;
+			uint8_t b = prev[i];
+			uint8_t c = (i >= bpp) ? prev[i - bpp] : 0;
+			uint8_t pred = (type == 0) ? 0
+			             : (type == 1) ? a
+			             : (type == 2) ? b
+			             : (type == 3) ? uint8_t((a + b) / 2)
+			             : paeth(a, b, c);
+			cur[i] = uint8_t(in[i] + pred);
+		}
+	}
+	return image;
+}
+
+// Also check that libpng (PNG::load) reads the same pixels.
+static void checkLoad(const std::string& filename, std::span<const uint8_t> image,
+                      size_t width, size_t height, bool color)
+{
+	auto surface = PNG::load(filename, false);
+	REQUIRE(size_t(surface->w) == width);
+	REQUIRE(size_t(surface->h) == height);
+	const auto* format = surface->format;
+	REQUIRE(format->BytesPerPixel == 3);
+	size_t firstDiff = width * height;
+	for (auto y : xrange(height)) {
+		const auto* line = static_cast<const uint8_t*>(surface.getLinePtr(unsigned(y)));
+		for (auto x : xrange(width)) {
+			uint32_t p = line[3 * x + 0] | (line[3 * x + 1] << 8) | (line[3 * x + 2] << 16);
+			auto r = uint8_t((p & format->Rmask) >> format->Rshift);
+			auto g = uint8_t((p & format->Gmask) >> format->Gshift);
+			auto b = uint8_t((p & format->Bmask) >> format->Bshift);
+			bool ok = color
+			        ? ((r == image[3 * (y * width + x) + 0]) &&
+			           (g == image[3 * (y * width + x) + 1]) &&
+			           (b == image[3 * (y * width + x) + 2]))
+			        : ((r == image[y * width + x]) && (g == r) && (b == r));
+			if (!ok) {
+				firstDiff = std::min(firstDiff, y * width + x);
+			}
+		}
+	}
+	CHECK(firstDiff == width * height);
+}
+
+TEST_CASE("PNG: save and load")
+{
+	auto filename = FileOperations::getTempDir() + "/png_unittest.png";
+
+	// The image is split in stripes of at least 32 rows (MIN_STRIPE_ROWS),
+	// so the smallest heights give a single stripe. With 2000 rows the
+	// stripes are larger than the deflate window (then only the end of the
+	// previous stripe is the dictionary), with 64-301 rows they're not.
+	for (size_t height : {1, 31, 32, 64, 100, 301, 2000}) {
+		for (bool color : {true, false}) {
+			size_t width = color ? 107 : 200;
+			size_t bpp = color ? 3 : 1;
+			size_t rowBytes = width * bpp;
+			auto image = makeImage(rowBytes, height);
+			std::vector<const uint8_t*> rows;
+			for (auto y : xrange(height)) rows.push_back(&image[y * rowBytes]);
+
+			for (int level : {0, 1, 6, 9}) {
+				CAPTURE(height, color, level);
+				if (color) {
+					PNG::saveRGB(width, rows, filename, level);
+				} else {
+					PNG::saveGrayscale(width, rows, filename, level);
+				}
+
+				auto png = parsePNG(filename);
+				CHECK(png.width == width);
+				CHECK(png.height == height);
+				CHECK(png.colorType == (color ? 2u : 0u));
+				// one IDAT chunk per stripe
+				CHECK(png.numIDAT == std::clamp<size_t>(height / 32, 1, 8));
+				auto decoded = decodeImageData(png.zlibData, rowBytes, bpp, height);
+				auto firstDiff = std::ranges::mismatch(decoded, image).in1 - decoded.begin();
+				CHECK(size_t(firstDiff) == image.size());
+
+				checkLoad(filename, image, width, height, color);
+			}
+		}
+	}
+	FileOperations::unlink(filename);
+}
@@ -0,0 +1,150 @@
+#include "catch.hpp"
+
+#include "PatternExpand.hh"
+
+#include "ranges.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+using PatternExpand::Pixel;
+
+// Plain scalar versions, the (possibly SIMD) PatternExpand routines must give
+// identical results. These are also the baseline for the benchmark.
+static void refDraw(Pixel*& out, Pixel fg, Pixel bg, uint8_t pattern, int width)
+{
+	for (auto i : xrange(width)) {
+		*out++ = (pattern & (0x80 >> i)) ? fg : bg;
+	}
+}
+
+namespace {
+struct LineData {
+	std::array<Pixel, 16> palette;
+	std::array<uint8_t, 80> patterns;
+	std::array<uint8_t, 80> colors;
+	std::array<uint8_t, 10> attributes;
+};
+}
+
+static LineData randomLine(std::mt19937& gen)
+{
+	std::uniform_int_distribution<uint32_t> dist;
+	LineData d;
+	for (auto& p : d.palette)    p = dist(gen);
+	for (auto& p : d.patterns)   p = uint8_t(dist(gen));
+	for (auto& c : d.colors)     c = uint8_t(dist(gen));
+	for (auto& a : d.attributes) a = uint8_t(dist(gen));
+	return d;
+}
+
+// Render a full line in the various character modes, with either the reference
+// or the optimized routines.
+enum class Impl { REF, OPT };
+
+template<Impl IMPL> static void text1Line(const LineData& d, Pixel* out)
+{
+	if constexpr (IMPL == Impl::REF) {
+		for (auto i : xrange(40)) {
+			refDraw(out, d.palette[15], d.palette[4], d.patterns[i], 6);
+		}
+	} else {
+		PatternExpand::drawText1(out, d.palette[15], d.palette[4], subspan<40>(d.patterns));
+	}
+}
+template<Impl IMPL> static void text2Line(const LineData& d, Pixel* out)
+{
+	if constexpr (IMPL == Impl::REF) {
+		for (auto i : xrange(80)) {
+			bool blink = d.attributes[i / 8] & (0x80 >> (i % 8));
+			refDraw(out, d.palette[blink ? 1 : 15], d.palette[blink ? 7 : 4], d.patterns[i], 6);
+		}
+	} else {
+		PatternExpand::drawText2(out, d.palette[15], d.palette[4], d.palette[1], d.palette[7],
+		                         d.attributes, d.patterns);
+	}
+}
+template<Impl IMPL> static void graphicLine(const LineData& d, Pixel* out)
+{
+	if constexpr (IMPL == Impl::REF) {
+		for (auto i : xrange(32)) {
+			Pixel fg = d.palette[d.colors[i] >> 4];
+			Pixel bg = d.palette[d.colors[i] & 15];
+			refDraw(out, fg, bg, d.patterns[i], 8);
+		}
+	} else {
+		PatternExpand::drawGraphic(out, d.palette, subspan<32>(d.patterns), subspan<32>(d.colors));
+	}
+}
+template<Impl IMPL> static void multiLine(const LineData& d, Pixel* out)
+{
+	if constexpr (IMPL == Impl::REF) {
+		for (auto i : xrange(32)) {
+			// a pattern with the left 4 pixels set
+			refDraw(out, d.palette[d.colors[i] >> 4], d.palette[d.colors[i] & 15], 0xF0, 8);
+		}
+	} else {
+		PatternExpand::drawMulti(out, d.palette, subspan<32>(d.colors));
+	}
+}
+
+template<typename Ref, typename Opt>
+static void compare(Ref ref, Opt opt, size_t width)
+{
+	std::mt19937 gen(42);
+	for ([[maybe_unused]] auto iter : xrange(100)) {
+		auto d = randomLine(gen);
+		std::vector<Pixel> expected(width + 1, 0);
+		std::vector<Pixel> actual  (width + 1, 0);
+		ref(d, expected.data());
+		opt(d, actual.data());
+		CHECK(expected == actual); // includes check for no writes beyond the line
+	}
+}
+
+TEST_CASE("PatternExpand")
+{
+	compare(text1Line  <Impl::REF>, text1Line  <Impl::OPT>, 240);
+	compare(text2Line  <Impl::REF>, text2Line  <Impl::OPT>, 480);
+	compare(graphicLine<Impl::REF>, graphicLine<Impl::OPT>, 256);
+	compare(multiLine  <Impl::REF>, multiLine  <Impl::OPT>, 256);
+}
+
+// Not run by default, use:  unittest "[benchmark]"
+template<typename Base, typename Opt>
+static void benchmark(std::string_view name, Base base, Opt opt)
+{
+	static constexpr int LINES = 200000;
+	std::mt19937 gen(42);
+	std::vector<LineData> data;
+	repeat(16, [&] { data.push_back(randomLine(gen)); });
+	std::vector<Pixel> buf(512);
+
+	auto measure = [&](auto f) {
+		auto start = std::chrono::steady_clock::now();
+		for (auto i : xrange(LINES)) {
+			f(data[i & 15], buf.data());
+		}
+		auto stop = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(stop - start).count() / LINES;
+	};
+	double tBase = measure(base);
+	double tOpt  = measure(opt);
+	auto speedup10 = int(10.0 * tBase / tOpt);
+	WARN(strCat(name, ": ", int(tBase), "ns/line -> ", int(tOpt), "ns/line, speedup x",
+	            speedup10 / 10, '.', speedup10 % 10));
+}
+
+TEST_CASE("PatternExpand benchmark", "[.benchmark]")
+{
+	benchmark("text1",    text1Line  <Impl::REF>, text1Line  <Impl::OPT>);
+	benchmark("text2",    text2Line  <Impl::REF>, text2Line  <Impl::OPT>);
+	benchmark("graphic",  graphicLine<Impl::REF>, graphicLine<Impl::OPT>);
+	benchmark("multi",    multiLine  <Impl::REF>, multiLine  <Impl::OPT>);
+}
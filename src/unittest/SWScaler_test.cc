@@ -0,0 +1,424 @@
+#include "catch.hpp"
+
+#include "SWHQScaler.hh"
+#include "SWRGBScaler.hh"
+#include "SWScaleNxScaler.hh"
+#include "SWScaler.hh"
+#include "SWSimpleScaler.hh"
+#include "SWTVScaler.hh"
+
+#include "RawFrame.hh"
+#include "SWOutputSurface.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <span>
+
+using namespace openmsx;
+
+// Frame with random pixels from a small palette, so that neighbouring pixels
+// are often equal.
+static RawFrame randomFrame(unsigned width, unsigned height)
+{
+	static constexpr std::array<uint32_t, 3> palette = {
+		0xFF000000, 0xFF20C0E0, 0xFFFFFFFF,
+	};
+	std::mt19937 gen(1234);
+	std::uniform_int_distribution<size_t> dist(0, palette.size() - 1);
+	RawFrame frame(width, height);
+	for (auto y : xrange(height)) {
+		frame.setLineWidth(y, width);
+		for (auto& p : frame.getLineDirect(y)) p = palette[dist(gen)];
+	}
+	return frame;
+}
+
+static RawFrame uniformFrame(unsigned width, unsigned height, uint32_t pixel)
+{
+	RawFrame frame(width, height);
+	for (auto y : xrange(height)) {
+		frame.setLineWidth(y, width);
+		std::ranges::fill(frame.getLineDirect(y), pixel);
+	}
+	return frame;
+}
+
+static uint32_t gray(unsigned g)
+{
+	return 0xFF000000 | (g * 0x010101);
+}
+
+// Check that all pixels on output line 'y' have the given value.
+static void checkLine(const SWOutputSurface& output, unsigned y, uint32_t expected)
+{
+	CAPTURE(y);
+	auto line = output.getLine(y);
+	auto wrong = std::ranges::find_if(line, [&](uint32_t p) { return p != expected; });
+	CHECK(wrong == line.end());
+}
+
+// HQ tables that, for all edge patterns, select the same two neighbours,
+// with weights depending only on the sub-pixel position.
+static SWHQScaler hqScaler(std::array<uint8_t, 4> offset,
+                           std::function<std::array<uint8_t, 3>(unsigned, unsigned, unsigned)> weight)
+{
+	SWHQScaler::Tables offsets;
+	SWHQScaler::Tables weights;
+	for (auto i : xrange(3u)) {
+		unsigned n = i + 2;
+		unsigned size = 64 * n * 64 * n;
+		offsets[i].resize(4 * size);
+		weights[i].resize(3 * size);
+		for (auto idx : xrange(size)) {
+			unsigned subX = (idx % (64 * n)) % n;
+			unsigned subY = (idx / (64 * n)) % n;
+			std::ranges::copy(offset, &offsets[i][4 * idx]);
+			std::ranges::copy(weight(n, subX, subY), &weights[i][3 * idx]);
+		}
+	}
+	return {std::move(offsets), std::move(weights)};
+}
+
+TEST_CASE("SWScaler: default (nearest neighbour)")
+{
+	auto frame = randomFrame(640, 8);
+	SWScaler scaler;
+
+	SECTION("zoom") {
+		SWOutputSurface output({640 * 2, 8 * 2});
+		scaler.scaleImage(frame, nullptr, 0, 8, 640, output, 0, 16, 8);
+		for (auto y : xrange(16u)) {
+			auto in = frame.getLineDirect(y / 2);
+			auto out = output.getLine(y);
+			for (auto x : xrange(640 * 2)) CHECK(out[x] == in[x / 2]);
+		}
+	}
+	SECTION("shrink: like on the GPU, the right pixel is picked") {
+		SWOutputSurface output({320, 4});
+		scaler.scaleImage(frame, nullptr, 0, 8, 640, output, 0, 4, 8);
+		for (auto y : xrange(4u)) {
+			auto in = frame.getLineDirect(2 * y + 1);
+			auto out = output.getLine(y);
+			for (auto x : xrange(320)) CHECK(out[x] == in[2 * x + 1]);
+		}
+	}
+}
+
+TEST_CASE("SWScaler: scale2x")
+{
+	auto frame = randomFrame(320, 6);
+	auto get = [&](int x, int y) {
+		return frame.getLineDirect(std::clamp(y, 0, 5))[std::clamp(x, 0, 319)];
+	};
+	SWScaleNxScaler scaler;
+
+	SECTION("2x: same as scale2x.frag") {
+		SWOutputSurface output({640, 12});
+		scaler.scaleImage(frame, nullptr, 0, 6, 320, output, 0, 12, 6);
+		for (auto y : xrange(12)) {
+			for (auto x : xrange(640)) {
+				// in scale2x.frag the direction to the 'left' and
+				// 'top' neighbour depends on the sub-pixel
+				int sx = x / 2, dx = (x & 1) ? 1 : -1;
+				int sy = y / 2, dy = (y & 1) ? 1 : -1;
+				auto l = get(sx + dx, sy);
+				auto r = get(sx - dx, sy);
+				auto t = get(sx, sy + dy);
+				auto b = get(sx, sy - dy);
+				int dot = 0;
+				for (int s = 0; s < 24; s += 8) {
+					dot += (int((l >> s) & 255) - int((r >> s) & 255)) *
+					       (int((t >> s) & 255) - int((b >> s) & 255));
+				}
+				auto expected = ((dot == 0) || (l != t)) ? get(sx, sy) : t;
+				CAPTURE(x, y);
+				CHECK(output.getLine(y)[x] == expected);
+			}
+		}
+	}
+	SECTION("3x: the middle sub-pixels are not changed") {
+		SWOutputSurface output({960, 18});
+		scaler.scaleImage(frame, nullptr, 0, 6, 320, output, 0, 18, 6);
+		for (auto y : xrange(18)) {
+			for (auto x : xrange(960)) {
+				if (((x % 3) != 1) && ((y % 3) != 1)) continue;
+				CAPTURE(x, y);
+				CHECK(output.getLine(y)[x] == get(x / 3, y / 3));
+			}
+		}
+	}
+}
+
+// The expected values in the tests below are calculated by hand from the
+// fragment shaders.
+
+TEST_CASE("SWScaler: hq")
+{
+	SECTION("neighbours") {
+		auto frame = randomFrame(320, 6);
+		SWOutputSurface output({640, 12});
+		auto get = [&](int x, int y) {
+			return frame.getLineDirect(std::clamp(y, 0, 5))[std::clamp(x, 0, 319)];
+		};
+		// offset 0 -> left/top, 128 -> middle
+		SECTION("left") {
+			auto scaler = hqScaler({0, 128, 128, 0}, [](auto...) { return std::array<uint8_t, 3>{255, 0, 0}; });
+			scaler.scaleImage(frame, nullptr, 0, 6, 320, output, 0, 12, 6);
+			for (auto y : xrange(12)) {
+				for (auto x : xrange(640)) {
+					CAPTURE(x, y);
+					CHECK(output.getLine(y)[x] == get(x / 2 - 1, y / 2));
+				}
+			}
+		}
+		SECTION("top") {
+			auto scaler = hqScaler({0, 128, 128, 0}, [](auto...) { return std::array<uint8_t, 3>{0, 255, 0}; });
+			scaler.scaleImage(frame, nullptr, 0, 6, 320, output, 0, 12, 6);
+			for (auto y : xrange(12)) {
+				for (auto x : xrange(640)) {
+					CAPTURE(x, y);
+					CHECK(output.getLine(y)[x] == get(x / 2, y / 2 - 1));
+				}
+			}
+		}
+	}
+	SECTION("sub-pixel position") {
+		auto frame = uniformFrame(320, 2, 0xFFFFFFFF);
+		auto scaler = hqScaler({128, 128, 128, 128}, [](unsigned n, unsigned subX, unsigned subY) {
+			return std::array<uint8_t, 3>{0, 0, uint8_t(255 - 15 * (subY * n + subX))};
+		});
+		for (unsigned n : {2, 3, 4}) {
+			CAPTURE(n);
+			SWOutputSurface output({int(320 * n), int(2 * n)});
+			scaler.scaleImage(frame, nullptr, 0, 2, 320, output, 0, 2 * n, 2);
+			for (auto y : xrange(2 * n)) {
+				for (auto x : xrange(320 * n)) {
+					CAPTURE(x, y);
+					CHECK(output.getLine(y)[x] == gray(255 - 15 * ((y % n) * n + (x % n))));
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("SWScaler: simple")
+{
+	SECTION("scanlines") {
+		auto frame = uniformFrame(320, 2, gray(0x80));
+		SWOutputSurface output({640, 4});
+		SWSimpleScaler::scale(0.0f, 0.5f, frame, nullptr, 0, 2, 320, 2, output, 0, 4, 2);
+		for (auto y : xrange(4u)) checkLine(output, y, gray((y & 1) ? 0x80 : 0x40));
+	}
+	SECTION("blur") {
+		RawFrame frame(320, 2);
+		for (auto y : xrange(2)) {
+			frame.setLineWidth(y, 320);
+			auto line = frame.getLineDirect(y);
+			std::ranges::fill(line.first(160), gray(0));
+			std::ranges::fill(line.subspan(160), gray(255));
+		}
+		SWOutputSurface output({640, 2});
+		SWSimpleScaler::scale(1.0f, 1.0f, frame, nullptr, 0, 2, 320, 2, output, 0, 2, 2);
+		static constexpr std::array<unsigned, 6> expected = {0, 32, 96, 160, 223, 255};
+		for (auto y : xrange(2)) {
+			auto line = output.getLine(y);
+			for (auto x : xrange(640)) {
+				CAPTURE(x, y);
+				auto g = (x < 317) ? 0 : (x > 322) ? 255 : expected[x - 317];
+				CHECK(line[x] == gray(g));
+			}
+		}
+	}
+}
+
+TEST_CASE("SWScaler: RGB triplet")
+{
+	// Each output pixel is one of the three sub-pixels.
+	auto frame = uniformFrame(320, 2, gray(0x60));
+	SWOutputSurface output({960, 2});
+	SWRGBScaler::scale(0.5f, 1.0f, frame, nullptr, 0, 2, 320, 2, output, 0, 2, 2);
+	static constexpr std::array<uint32_t, 3> expected = {0xFF3030C0, 0xFF30C030, 0xFFC03030};
+	for (auto y : xrange(2)) {
+		auto line = output.getLine(y);
+		for (auto x : xrange(960)) {
+			CAPTURE(x, y);
+			CHECK(line[x] == expected[x % 3]);
+		}
+	}
+}
+
+TEST_CASE("SWScaler: TV")
+{
+	SWOutputSurface output({320, 4});
+	SECTION("no gap") {
+		auto frame = uniformFrame(320, 2, 0xFF20C0E0);
+		SWTVScaler::scale(0.0f, frame, nullptr, 0, 2, 320, 2, output, 0, 4, 2);
+		for (auto y : xrange(4u)) checkLine(output, y, 0xFF20C0E0);
+	}
+	SECTION("bright pixels are larger") {
+		auto white = uniformFrame(320, 2, gray(255));
+		SWTVScaler::scale(1.0f, white, nullptr, 0, 2, 320, 2, output, 0, 4, 2);
+		for (auto y : xrange(4u)) checkLine(output, y, gray((y & 1) ? 255 : 101));
+
+		auto grey = uniformFrame(320, 2, gray(128));
+		SWTVScaler::scale(1.0f, grey, nullptr, 0, 2, 320, 2, output, 0, 4, 2);
+		for (auto y : xrange(4u)) checkLine(output, y, gray((y & 1) ? 128 : 0));
+	}
+}
+
+TEST_CASE("SWScaler: superimpose")
+{
+	// Like in the shaders, the video is blended with the scaled frame. So
+	// it's sampled (with linear filtering) at the output resolution.
+	RawFrame video(2, 1);
+	video.setLineWidth(0, 2);
+	video.getLineDirect(0)[0] = gray(0);
+	video.getLineDirect(0)[1] = gray(255);
+
+	// top half transparent, bottom half opaque
+	RawFrame frame(320, 2);
+	frame.setLineWidth(0, 320);
+	frame.setLineWidth(1, 320);
+	std::ranges::fill(frame.getLineDirect(0), 0x00000000);
+	std::ranges::fill(frame.getLineDirect(1), 0xFFFFFFFF);
+
+	SWOutputSurface output({640, 4});
+	auto check = [&] {
+		for (auto y : xrange(4)) {
+			auto line = output.getLine(y);
+			for (auto x : xrange(640)) {
+				// the GPU interpolates with a weight of 8 bits
+				int w = std::clamp(int(std::lrint((x + 0.501) / 640.0 * 512.0)) - 128, 0, 256);
+				auto g = (y < 2) ? unsigned((255 * w + 128) >> 8) : 255;
+				CAPTURE(x, y);
+				CHECK(line[x] == gray(g));
+			}
+		}
+	};
+	SECTION("default") {
+		SWScaler scaler;
+		scaler.scaleImage(frame, &video, 0, 2, 320, output, 0, 4, 2);
+		check();
+	}
+	SECTION("scale2x") {
+		SWScaleNxScaler scaler;
+		scaler.scaleImage(frame, &video, 0, 2, 320, output, 0, 4, 2);
+		check();
+	}
+	SECTION("hq") {
+		auto scaler = hqScaler({128, 128, 128, 128}, [](auto...) { return std::array<uint8_t, 3>{0, 0, 255}; });
+		scaler.scaleImage(frame, &video, 0, 2, 320, output, 0, 4, 2);
+		check();
+	}
+	SECTION("simple") {
+		SWSimpleScaler::scale(0.0f, 1.0f, frame, &video, 0, 2, 320, 2, output, 0, 4, 2);
+		check();
+	}
+	SECTION("scanlines are also applied to the video") {
+		auto transparent = uniformFrame(320, 2, 0x00000000);
+		auto grey = uniformFrame(1, 1, gray(0x80));
+		SWSimpleScaler::scale(0.0f, 0.5f, transparent, &grey, 0, 2, 320, 2, output, 0, 4, 2);
+		for (auto y : xrange(4u)) checkLine(output, y, gray((y & 1) ? 0x80 : 0x40));
+		SWTVScaler::scale(1.0f, transparent, &grey, 0, 2, 320, 2, output, 0, 4, 2);
+		for (auto y : xrange(4u)) checkLine(output, y, gray((y & 1) ? 128 : 0));
+	}
+}
+
+TEST_CASE("SWScaler: same output as the GPU")
+{
+	// The expected values are captured from the shaders, rendered with Mesa
+	// llvmpipe (other GPUs may differ in the lowest bits). All pixels are
+	// random, including the alpha channel of the frame (superimpose).
+	auto randomPixels = [](unsigned width, unsigned height, unsigned seed) {
+		std::mt19937 gen(seed);
+		RawFrame frame(width, height);
+		for (auto y : xrange(height)) {
+			frame.setLineWidth(y, width);
+			for (auto& p : frame.getLineDirect(y)) p = uint32_t(gen());
+		}
+		return frame;
+	};
+	auto frame = randomPixels(5, 2, 1);
+	auto video = randomPixels(3, 2, 2);
+	SWOutputSurface output({10, 4});
+	auto check = [&](std::span<const uint32_t, 40> expected) {
+		for (auto y : xrange(4)) {
+			auto line = output.getLine(y);
+			for (auto x : xrange(10)) {
+				CAPTURE(x, y);
+				CHECK(line[x] == expected[10 * y + x]);
+			}
+		}
+	};
+
+	SECTION("without video") {
+		SECTION("simple") {
+			SWSimpleScaler::scale(0.5f, 0.7f, frame, nullptr, 0, 2, 5, 2, output, 0, 4, 2);
+			static constexpr std::array<uint32_t, 40> expected = {
+				0xFF82A623, 0xFF779C34, 0xFF436686, 0xFF3B548F, 0xFF482A6C, 0xFF52215D, 0xFF701644, 0xFF681D4E, 0xFF1D4A9A, 0xFF0D54AB,
+				0xFFAFD445, 0xFFA3C954, 0xFF6A8E9D, 0xFF657FA8, 0xFF826196, 0xFF8E5A87, 0xFFA44B58, 0xFF964E66, 0xFF376BDA, 0xFF2371F2,
+				0xFF6D734C, 0xFF697049, 0xFF59603F, 0xFF5D6244, 0xFF827864, 0xFF887B60, 0xFF787333, 0xFF6B6B3A, 0xFF3A4C95, 0xFF3045A8,
+				0xFF918C7F, 0xFF8E8A71, 0xFF898637, 0xFF95913C, 0xFFD5CF8B, 0xFFDADA8B, 0xFFAFD040, 0xFF9BBE4A, 0xFF606CD2, 0xFF555CEF
+			};
+			check(expected);
+		}
+		SECTION("rgb") {
+			SWRGBScaler::scale(0.3f, 0.8f, frame, nullptr, 0, 2, 5, 2, output, 0, 4, 2);
+			static constexpr std::array<uint32_t, 40> expected = {
+				0xFF68A547, 0xFFFF8315, 0xFF183DFF, 0xFF981A7E, 0xFF1710FF, 0xFFEE0A1E, 0xFF4906AB, 0xFFFF0B1C, 0xFF0C18FF, 0xFF0D1EB3,
+				0xFF90C792, 0xFFFFA61C, 0xFF2561FF, 0xFFEB3385, 0xFF3A1EFF, 0xFFFF1A3F, 0xFF8216C5, 0xFFFF1822, 0xFF131FFF, 0xFF3C2EFF,
+				0xFF3E49D3, 0xFFFF3D18, 0xFF1E24A5, 0xFFFF2918, 0xFF5B4AFF, 0xFFFF5623, 0xFF5A4D81, 0xFFFF3215, 0xFF161BFF, 0xFF7717B1,
+				0xFF5B54FF, 0xFFFF4E21, 0xFF46427D, 0xFFFF6313, 0xFFBDAFFF, 0xFFFFD051, 0xFF96C690, 0xFFFF9018, 0xFF1F2EFF, 0xFFC019FD
+			};
+			check(expected);
+		}
+		SECTION("tv") {
+			SWTVScaler::scale(0.6f, frame, nullptr, 0, 2, 5, 2, output, 0, 4, 2);
+			static constexpr std::array<uint32_t, 40> expected = {
+				0xFF41593C, 0xFF243656, 0xFF474555, 0xFF6A5554, 0xFF684F2F, 0xFF66480A, 0xFF393868, 0xFF0C27C5, 0xFF0C27C5, 0xFF0C27C5,
+				0xFF88854F, 0xFF7F7D19, 0xFFB7B166, 0xFFEFE4B2, 0xFFCBDC63, 0xFFA7D514, 0xFF7B9489, 0xFF5054FE, 0xFF5054FE, 0xFF5054FE,
+				0xFF3E3B1F, 0xFF363403, 0xFF736B35, 0xFFB0A166, 0xFF859834, 0xFF5B8E02, 0xFF385363, 0xFF1619C4, 0xFF1619C4, 0xFF1619C4,
+				0xFF88854F, 0xFF7F7D19, 0xFFB7B166, 0xFFEFE4B2, 0xFFCBDC63, 0xFFA7D514, 0xFF7B9489, 0xFF5054FE, 0xFF5054FE, 0xFF5054FE
+			};
+			check(expected);
+		}
+	}
+	SECTION("with video") {
+		SECTION("simple") {
+			SWSimpleScaler::scale(0.5f, 0.7f, frame, &video, 0, 2, 5, 2, output, 0, 4, 2);
+			static constexpr std::array<uint32_t, 40> expected = {
+				0xFF776E50, 0xFF737053, 0xFF476281, 0xFF3E5488, 0xFF48355B, 0xFF502C50, 0xFF6D1C46, 0xFF681F5A, 0xFF631BA4, 0xFF6C15A6,
+				0xFFA98B6D, 0xFFA38F70, 0xFF708897, 0xFF677D9E, 0xFF7A697A, 0xFF826371, 0xFF9B515D, 0xFF915079, 0xFF784FE4, 0xFF7D4CEA,
+				0xFF754844, 0xFF724B44, 0xFF5C583D, 0xFF5B5D3F, 0xFF6A6C4C, 0xFF6A714D, 0xFF6A6F39, 0xFF606B4A, 0xFF416099, 0xFF3E60A0,
+				0xFFA6555A, 0xFFA25A58, 0xFF8C7937, 0xFF8E883A, 0xFFA1AD65, 0xFF9DBB6D, 0xFF94C44C, 0xFF86BC63, 0xFF579BD6, 0xFF5199E4
+			};
+			check(expected);
+		}
+		SECTION("rgb") {
+			SWRGBScaler::scale(0.3f, 0.8f, frame, &video, 0, 2, 5, 2, output, 0, 4, 2);
+			static constexpr std::array<uint32_t, 40> expected = {
+				0xFF4F3BDA, 0xFFFF421D, 0xFF1A34FF, 0xFF9E1A73, 0xFF1713FF, 0xFFE70E1A, 0xFF4308B1, 0xFFFF0C25, 0xFF250AFF, 0xFFFF069D,
+				0xFF804EFF, 0xFFFF592C, 0xFF2D54FF, 0xFFF03277, 0xFF3022FF, 0xFFFF1D21, 0xFF7518D0, 0xFFFF1941, 0xFF3218FF, 0xFFFF16E0,
+				0xFF4B18BB, 0xFFFF1A17, 0xFF1F1EA1, 0xFFFF2117, 0xFF3437D5, 0xFFFF431A, 0xFF414693, 0xFFFB331B, 0xFF1725FF, 0xFFA82698,
+				0xFF7C19DB, 0xFFFF1C1A, 0xFF4C2F7E, 0xFFFF5412, 0xFF717FF6, 0xFFFF9E23, 0xFF6CB2AF, 0xFFFF911F, 0xFF1B6CFF, 0xFFBD65DE
+			};
+			check(expected);
+		}
+		SECTION("tv") {
+			SWTVScaler::scale(0.6f, frame, &video, 0, 2, 5, 2, output, 0, 4, 2);
+			static constexpr std::array<uint32_t, 40> expected = {
+				0xFF41343D, 0xFF253457, 0xFF2E393F, 0xFF42372E, 0xFF4A411A, 0xFF5B430B, 0xFF49365C, 0xFF322795, 0xFF3628AA, 0xFF3628AA,
+				0xFF906E4C, 0xFF817A1E, 0xFF919943, 0xFFB0AE77, 0xFFA0BF49, 0xFF9BC81E, 0xFF82968B, 0xFF6566E3, 0xFF6865EF, 0xFF6865EF,
+				0xFF492510, 0xFF383103, 0xFF414D16, 0xFF5E5C2C, 0xFF4C7818, 0xFF4B8204, 0xFF316957, 0xFF15489A, 0xFF164CA8, 0xFF164CA8,
+				0xFF93663B, 0xFF82781B, 0xFF8C9744, 0xFFABA973, 0xFF98C14A, 0xFF97CB1E, 0xFF73B388, 0xFF4D94DE, 0xFF4F98E9, 0xFF4F98E9
+			};
+			check(expected);
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include "SpriteTableWrite.hh"
+
+#include "xrange.hh"
+
+#include <array>
+#include <cstdint>
+
+using namespace openmsx;
+using namespace openmsx::SpriteTableWrite;
+
+// Sprite mode 1, 8x8 sprites, no scrolling. The lines [10, 20) are not yet
+// checked.
+static constexpr State mode1State = {
+	.minLine = 10, .maxLine = 20, .displayDelta = 0,
+	.size = 8, .mag = false, .mode1 = true,
+};
+
+struct Attributes {
+	explicit Attributes(bool mode1) : base(mode1 ? 0 : 512) {
+		data.fill(0);
+		// all sprites far away from the pending lines
+		for (auto sprite : xrange(32)) setY(sprite, 100);
+	}
+	void setY(unsigned sprite, uint8_t y) { data[base + 4 * sprite + 0] = y; }
+	void setPattern(unsigned sprite, uint8_t p) { data[base + 4 * sprite + 2] = p; }
+	[[nodiscard]] auto reader() const { return [this](unsigned i) { return data[i]; }; }
+
+	std::array<uint8_t, 1024> data;
+	unsigned base;
+};
+
+TEST_CASE("SpriteTableWrite: attribute table, sprite mode 1")
+{
+	Attributes attr(true);
+	attr.setY(3, 12); // sprite 3 is visible on the pending lines
+	auto read = attr.reader();
+
+	// any byte of a visible sprite
+	for (auto i : xrange(4u)) {
+		CHECK(affectsLines(mode1State, Table::ATTRIBUTE, 4 * 3 + i, read));
+	}
+	// X, pattern and color of an invisible sprite
+	for (auto i : xrange(1u, 4u)) {
+		CHECK(!affectsLines(mode1State, Table::ATTRIBUTE, 4 * 5 + i, read));
+	}
+	// The Y write of an invisible sprite can move it onto the pending lines.
+	CHECK(affectsLines(mode1State, Table::ATTRIBUTE, 4 * 5, read));
+	// The Y write of an invisible sprite in front of a visible one can end
+	// the table (Y=208), that hides the visible sprite.
+	CHECK(affectsLines(mode1State, Table::ATTRIBUTE, 4 * 1, read));
+
+	// sprite 7 ends the table
+	attr.setY(7, 208);
+	CHECK( affectsLines(mode1State, Table::ATTRIBUTE, 4 * 7 + 0, read)); // Y of the end marker
+	CHECK(!affectsLines(mode1State, Table::ATTRIBUTE, 4 * 7 + 1, read));
+	CHECK(!affectsLines(mode1State, Table::ATTRIBUTE, 4 * 8 + 0, read)); // after the end
+	CHECK(!affectsLines(mode1State, Table::ATTRIBUTE, 4 * 8 + 2, read));
+}
+
+TEST_CASE("SpriteTableWrite: visibility")
+{
+	Attributes attr(true);
+	auto read = attr.reader();
+	auto visible = [&](const State& s, uint8_t y) {
+		attr.setY(0, y);
+		return affectsLines(s, Table::ATTRIBUTE, 2, read); // pattern byte
+	};
+	// Without scrolling, an 8 lines high sprite at 'y' is checked on the
+	// lines [y, y + 8).
+	CHECK(!visible(mode1State, 2));
+	CHECK( visible(mode1State, 3));
+	CHECK( visible(mode1State, 19));
+	CHECK(!visible(mode1State, 20));
+
+	auto mag = mode1State;
+	mag.mag = true; // 16 lines high
+	CHECK( visible(mag, 251)); // wraps around
+	CHECK(!visible(mag, 250));
+
+	auto scrolled = mode1State;
+	scrolled.displayDelta = 50;
+	CHECK(!visible(scrolled, 19));
+	CHECK( visible(scrolled, 69));
+	CHECK(!visible(scrolled, 70));
+}
+
+TEST_CASE("SpriteTableWrite: sprite mode 2")
+{
+	auto state = mode1State;
+	state.mode1 = false;
+	state.size = 16;
+	Attributes attr(false);
+	attr.setY(2, 15);
+	attr.setPattern(2, 0x24); // 16x16: pattern 0x24-0x27
+	attr.setPattern(4, 0x30); // invisible
+	auto read = attr.reader();
+
+	// color table: 16 bytes per sprite
+	CHECK( affectsLines(state, Table::ATTRIBUTE, 16 * 2 + 5, read));
+	CHECK(!affectsLines(state, Table::ATTRIBUTE, 16 * 4 + 5, read));
+	// attribute table
+	CHECK( affectsLines(state, Table::ATTRIBUTE, 512 + 4 * 4 + 0, read)); // Y
+	CHECK(!affectsLines(state, Table::ATTRIBUTE, 512 + 4 * 4 + 1, read));
+
+	// pattern table
+	CHECK( affectsLines(state, Table::PATTERN, 8 * 0x24 + 3, read));
+	CHECK( affectsLines(state, Table::PATTERN, 8 * 0x27 + 7, read));
+	CHECK(!affectsLines(state, Table::PATTERN, 8 * 0x28, read));
+	CHECK(!affectsLines(state, Table::PATTERN, 8 * 0x30, read)); // invisible sprite
+
+	// sprites after the end marker (216) are not used
+	attr.setY(1, 216);
+	CHECK(!affectsLines(state, Table::PATTERN, 8 * 0x24, read));
+	CHECK(!affectsLines(state, Table::ATTRIBUTE, 16 * 2, read));
+}
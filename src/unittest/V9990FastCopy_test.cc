@@ -0,0 +1,235 @@
+#include "catch.hpp"
+
+#include "V9990FastCopy.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace openmsx;
+using namespace openmsx::V9990FastCopy;
+
+static constexpr unsigned SIZE = V9990VRAM::VRAM_SIZE;
+
+// Has the same interface as the TrackedRam object in V9990VRAM.
+struct FakeRam
+{
+	explicit FakeRam(std::mt19937& gen)
+		: buf(SIZE)
+	{
+		std::uniform_int_distribution<int> dist(0, 255);
+		for (auto& b : buf) b = uint8_t(dist(gen));
+	}
+
+	[[nodiscard]] const uint8_t& operator[](size_t addr) const {
+		return buf[addr];
+	}
+	void write(size_t addr, uint8_t value) {
+		buf[addr] = value;
+	}
+	[[nodiscard]] std::span<uint8_t> getWriteBackdoor(size_t addr, size_t len) {
+		return std::span{buf}.subspan(addr, len);
+	}
+
+	std::vector<uint8_t> buf;
+};
+
+// The straightforward byte-by-byte / pixel-by-pixel versions, these
+// correspond to the generic code in V9990VRAM and V9990CmdEngine.
+static uint8_t readBx(const FakeRam& ram, unsigned addr)
+{
+	return ram[V9990VRAM::transformBx(addr)];
+}
+static void writeBx(FakeRam& ram, unsigned addr, uint8_t value)
+{
+	ram.write(V9990VRAM::transformBx(addr), value);
+}
+
+static void refCopyBx(FakeRam& ram, unsigned src, unsigned dst, unsigned num)
+{
+	repeat(num, [&] { writeBx(ram, dst++, readBx(ram, src++)); });
+}
+
+static void refCopyPlanes(FakeRam& ram, unsigned src, unsigned dst, unsigned num)
+{
+	repeat(num, [&] {
+		src &= SIZE / 2 - 1;
+		dst &= SIZE / 2 - 1;
+		ram.write(dst + 0x00000, ram[src + 0x00000]);
+		ram.write(dst + 0x40000, ram[src + 0x40000]);
+		++src;
+		++dst;
+	});
+}
+
+// V9990CmdEngine::V9990Bpp{8,16}::addressOf()
+static unsigned pixelAddr(bool bpp16, unsigned x, unsigned y, unsigned pitch)
+{
+	unsigned addr = (x & (pitch - 1)) + y * pitch;
+	return bpp16 ? (addr & 0x3FFFF) : (V9990VRAM::transformBx(addr) & 0x7FFFF);
+}
+
+template<Cmd CMD, bool BPP16>
+static void refStep(FakeRam& ram, Rect& r, unsigned pitch, uint16_t dy)
+{
+	if constexpr (CMD == Cmd::LMMM) {
+		auto src = pixelAddr(BPP16, r.SX, r.SY, pitch);
+		auto dst = pixelAddr(BPP16, r.DX, r.DY, pitch);
+		ram.write(dst, ram[src]);
+		if (BPP16) ram.write(dst + 0x40000, ram[src + 0x40000]);
+	} else if constexpr (CMD == Cmd::BMXL) {
+		auto dst = pixelAddr(BPP16, r.DX, r.DY, pitch);
+		ram.write(dst, readBx(ram, r.srcAddress++));
+		if (BPP16) ram.write(dst + 0x40000, readBx(ram, r.srcAddress++));
+	} else {
+		auto src = pixelAddr(BPP16, r.SX, r.SY, pitch);
+		writeBx(ram, r.dstAddress++, ram[src]);
+		if (BPP16) writeBx(ram, r.dstAddress++, ram[src + 0x40000]);
+	}
+	if (CMD != Cmd::BMXL) ++r.SX;
+	if (CMD != Cmd::BMLX) ++r.DX;
+	if (!--r.ANX) {
+		if (CMD != Cmd::BMXL) { r.SX -= r.NX; r.SY += dy; }
+		if (CMD != Cmd::BMLX) { r.DX -= r.NX; r.DY += dy; }
+		if (--r.ANY) r.ANX = r.NX ? r.NX : 2048;
+	}
+}
+
+static void checkEqual(const FakeRam& a, const FakeRam& b)
+{
+	// (on failure) report the first difference, not the full content
+	auto firstDiff = std::ranges::mismatch(a.buf, b.buf).in1 - a.buf.begin();
+	REQUIRE(size_t(firstDiff) == SIZE);
+}
+
+static void checkEqual(const Rect& a, const Rect& b)
+{
+	CHECK(a.SX == b.SX);
+	CHECK(a.SY == b.SY);
+	CHECK(a.DX == b.DX);
+	CHECK(a.DY == b.DY);
+	CHECK(a.ANX == b.ANX);
+	CHECK(a.ANY == b.ANY);
+	CHECK(a.srcAddress == b.srcAddress);
+	CHECK(a.dstAddress == b.dstAddress);
+}
+
+TEST_CASE("V9990FastCopy: copyBx, copyPlanes")
+{
+	std::mt19937 gen(1234); // fixed seed: reproducible
+	FakeRam ram(gen);
+	FakeRam ref = ram;
+	auto rnd = [&](unsigned lo, unsigned hi) {
+		return std::uniform_int_distribution<unsigned>(lo, hi)(gen);
+	};
+	for (auto iter : xrange(2000)) {
+		bool planes = iter & 1;
+		unsigned size = planes ? SIZE / 2 : SIZE;
+		unsigned num = rnd(0, 3) ? rnd(0, 300) : rnd(0, 3000);
+		unsigned src = rnd(0, 3) ? rnd(0, size - 1)
+		                         : rnd(size - 400, size + 400); // near the end
+		unsigned dst;
+		switch (rnd(0, 2)) {
+		case 0: // overlapping, either direction
+			dst = src + rnd(0, 2 * num + 4) - num - 2;
+			break;
+		case 1: // (possibly) wrapping around the end
+			dst = size - rnd(0, num + 2);
+			break;
+		default:
+			dst = rnd(0, size - 1);
+			break;
+		}
+		CAPTURE(planes, src, dst, num);
+		if (planes) {
+			copyPlanes(ram, src, dst, num);
+			refCopyPlanes(ref, src, dst, num);
+		} else {
+			copyBx(ram, src, dst, num);
+			refCopyBx(ref, src, dst, num);
+		}
+		checkEqual(ram, ref);
+	}
+}
+
+template<Cmd CMD, bool BPP16>
+static void checkCopyRect(std::mt19937& gen, int iterations)
+{
+	FakeRam ram(gen);
+	FakeRam ref = ram;
+	auto rnd = [&](unsigned lo, unsigned hi) {
+		return std::uniform_int_distribution<unsigned>(lo, hi)(gen);
+	};
+	for (auto iter : xrange(iterations)) {
+		unsigned pitch = 256 << rnd(0, 3);
+		auto dy = uint16_t(rnd(0, 1) ? 1 : -1);
+		auto nx = uint16_t(rnd(0, 15) ? rnd(1, 2047) : 0); // 0 -> 2048
+		auto ny = uint16_t(rnd(1, 12));
+		auto coord = [&] {
+			switch (rnd(0, 2)) {
+			case 0:  return uint16_t(rnd(0, 2047));
+			case 1:  return uint16_t(-rnd(0, 16)); // wraps around
+			default: return uint16_t(SIZE / pitch - rnd(0, 16)); // end of VRAM
+			}
+		};
+		Rect rect{.SX = coord(), .SY = coord(), .DX = 0, .DY = 0, .NX = nx,
+		          .ANX = uint16_t(nx ? nx : 2048), .ANY = ny,
+		          .srcAddress = rnd(0, SIZE + 1000), .dstAddress = 0};
+		if (rnd(0, 1)) {
+			// overlapping source and destination
+			rect.DX = uint16_t(rect.SX + rnd(0, 8) - 4);
+			rect.DY = uint16_t(rect.SY + rnd(0, 2) - 1);
+		} else {
+			rect.DX = coord();
+			rect.DY = coord();
+		}
+		rect.dstAddress = rnd(0, 1) ? rnd(0, SIZE + 1000)
+		                            : rect.SX + rect.SY * pitch + rnd(0, 8) - 4;
+		if (BPP16) {
+			// requirement for the fast paths
+			if (CMD == Cmd::BMXL) rect.srcAddress &= ~1;
+			if (CMD == Cmd::BMLX) rect.dstAddress &= ~1;
+		}
+		Rect refRect = rect;
+		CAPTURE(iter, pitch, dy, rect.SX, rect.SY, rect.DX, rect.DY, rect.NX, rect.ANY,
+		        rect.srcAddress, rect.dstAddress);
+
+		// Execute in random chunks, like the command engine does when
+		// it's synchronized at arbitrary moments.
+		while (refRect.ANY) {
+			unsigned steps = rnd(0, 3) ? rnd(1, 100) : rnd(1, 5000);
+			unsigned refDone = 0;
+			while (refRect.ANY && (refDone < steps)) {
+				refStep<CMD, BPP16>(ref, refRect, pitch, dy);
+				++refDone;
+			}
+			unsigned done = copyRect<CMD, BPP16>(
+				rect, steps, pitch, dy,
+				[&](unsigned src, unsigned dst, unsigned num) {
+					if (BPP16) {
+						copyPlanes(ram, src, dst, num);
+					} else {
+						copyBx(ram, src, dst, num);
+					}
+				});
+			CHECK(done == refDone);
+			checkEqual(rect, refRect);
+			checkEqual(ram, ref);
+		}
+	}
+}
+
+TEST_CASE("V9990FastCopy: copyRect")
+{
+	std::mt19937 gen(1234);
+	SECTION("LMMM 8bpp")  { checkCopyRect<Cmd::LMMM, false>(gen, 200); }
+	SECTION("LMMM 16bpp") { checkCopyRect<Cmd::LMMM, true >(gen, 200); }
+	SECTION("BMXL 8bpp")  { checkCopyRect<Cmd::BMXL, false>(gen, 200); }
+	SECTION("BMXL 16bpp") { checkCopyRect<Cmd::BMXL, true >(gen, 200); }
+	SECTION("BMLX 8bpp")  { checkCopyRect<Cmd::BMLX, false>(gen, 200); }
+	SECTION("BMLX 16bpp") { checkCopyRect<Cmd::BMLX, true >(gen, 200); }
+}
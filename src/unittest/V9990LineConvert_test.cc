@@ -0,0 +1,171 @@
+#include "catch.hpp"
+
+#include "V9990LineConvert.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace openmsx;
+using namespace openmsx::V9990LineConvert;
+
+// Straightforward (slow) versions of the routines in V9990LineConvert (based
+// on the V9990 application manual), the optimized (possibly SIMD) versions
+// must give identical results.
+static uint16_t refYUV(std::span<const uint8_t, 4> group, int i, bool yjk, bool pal)
+{
+	auto signed6 = [](int lo, int hi) { // 3 low bits of 'lo', 3 low bits of 'hi'
+		int v = (lo & 7) | ((hi & 7) << 3);
+		return (v & 32) ? v - 64 : v;
+	};
+	if (pal && (group[i] & 8)) return uint16_t(PALETTE | (group[i] >> 4));
+	int v = signed6(group[0], group[1]);
+	int u = signed6(group[2], group[3]);
+	int y = group[i] >> 3;
+	int r = std::clamp(y + u, 0, 31);
+	int b = std::clamp(y + v, 0, 31);
+	int g = 5 * y - 2 * u - v;
+	g = std::clamp((g < 0) ? 0 : (g / 4), 0, 31);
+	if (yjk) std::swap(g, b);
+	return uint16_t((g << 10) | (r << 5) | b);
+}
+
+template<bool YJK, bool PAL>
+static void checkYUV(std::span<const uint8_t> even, std::span<const uint8_t> odd)
+{
+	std::vector<uint16_t> out(2 * even.size());
+	yuvIndices<YJK, PAL>(even, odd, out);
+	for (auto g : xrange(even.size() / 2)) {
+		std::array<uint8_t, 4> group = {even[2 * g], odd[2 * g], even[2 * g + 1], odd[2 * g + 1]};
+		for (auto i : xrange(4)) {
+			CAPTURE(YJK, PAL, g, i);
+			CHECK(out[4 * g + i] == refYUV(group, i, YJK, PAL));
+		}
+	}
+}
+
+TEST_CASE("V9990LineConvert: YUV/YJK")
+{
+	SECTION("all combinations of 2 bytes, with random other bytes") {
+		std::mt19937 gen(1234); // fixed seed: reproducible
+		std::uniform_int_distribution<int> dist(0, 255);
+		std::vector<uint8_t> even(2 * 65536), odd(2 * 65536);
+		for (auto n : xrange(65536)) {
+			even[2 * n + 0] = uint8_t(n & 255);
+			odd [2 * n + 0] = uint8_t(dist(gen));
+			even[2 * n + 1] = uint8_t(dist(gen));
+			odd [2 * n + 1] = uint8_t(n >> 8);
+		}
+		checkYUV<false, false>(even, odd);
+		checkYUV<false, true >(even, odd);
+		checkYUV<true,  false>(even, odd);
+		checkYUV<true,  true >(even, odd);
+	}
+	SECTION("number of groups not a multiple of 4") {
+		std::mt19937 gen(4321);
+		std::uniform_int_distribution<int> dist(0, 255);
+		for (auto groups : {1, 3, 5, 7, 257}) {
+			std::vector<uint8_t> even(2 * groups), odd(2 * groups);
+			for (auto& e : even) e = uint8_t(dist(gen));
+			for (auto& o : odd)  o = uint8_t(dist(gen));
+			checkYUV<false, true>(even, odd);
+			checkYUV<true,  true>(even, odd);
+		}
+	}
+}
+
+TEST_CASE("V9990LineConvert: BD16")
+{
+	std::mt19937 gen(1234);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto size : {1, 15, 16, 17, 1024}) {
+		std::vector<uint8_t> even(size), odd(size);
+		for (auto& e : even) e = uint8_t(dist(gen));
+		for (auto& o : odd)  o = uint8_t(dist(gen));
+		std::vector<uint16_t> out(size);
+		bd16Indices(even, odd, out);
+		for (auto i : xrange(size)) {
+			CAPTURE(size, i);
+			CHECK(out[i] == ((even[i] + 256 * odd[i]) & 0x7FFF));
+		}
+	}
+}
+
+TEST_CASE("V9990LineConvert: lookupIndices")
+{
+	std::mt19937 gen(1234);
+	std::uniform_int_distribution<uint32_t> dist;
+	std::vector<Pixel> palette64(64), palette32768(32768);
+	for (auto& p : palette64)    p = dist(gen);
+	for (auto& p : palette32768) p = dist(gen);
+	std::span<const Pixel, 32768> pal32768(palette32768.data(), 32768);
+
+	for (auto size : {1, 7, 8, 9, 1024}) {
+		for (bool pal : {false, true}) {
+			std::vector<uint16_t> idx(size);
+			for (auto& i : idx) {
+				i = (pal && (dist(gen) & 1)) ? uint16_t(PALETTE | (dist(gen) & 63))
+				                             : uint16_t(dist(gen) & 0x7FFF);
+			}
+			std::vector<Pixel> out(size + 1, 0x12345678); // sentinel
+			lookupIndices(idx, palette64, pal32768, std::span{out}.first(size));
+			for (auto i : xrange(size)) {
+				CAPTURE(size, pal, i);
+				CHECK(out[i] == ((idx[i] & PALETTE) ? palette64[idx[i] & 63]
+				                                    : palette32768[idx[i]]));
+			}
+			CHECK(out[size] == 0x12345678); // no writes beyond the end
+		}
+	}
+}
+
+template<bool TRANSPARENT, bool FILL_INFO>
+static void checkPattern8(std::span<const Pixel, 64> palette64, size_t ofst0, size_t ofst1)
+{
+	auto palette0 = palette64.subspan(ofst0).first<16>();
+	auto palette1 = palette64.subspan(ofst1).first<16>();
+	std::mt19937 gen(1234);
+	std::uniform_int_distribution<uint32_t> dist;
+	for (auto iter : xrange(1000)) {
+		std::array<uint8_t, 4> data;
+		for (auto& d : data) d = uint8_t(dist(gen));
+		if (iter < 16) data = {uint8_t(iter * 0x11), 0, uint8_t(iter), uint8_t(iter << 4)};
+
+		std::array<Pixel, 8 + 1> out;
+		std::array<uint8_t, 8 + 1> info;
+		for (auto& o : out) o = dist(gen);
+		std::ranges::fill(info, 0xAA);
+		auto expected = out;
+		drawPattern8<TRANSPARENT, FILL_INFO>(data, palette0, palette1, out.data(), info.data());
+
+		for (auto i : xrange(8)) {
+			auto palette = ((i / 2) & 1) ? palette1 : palette0;
+			auto p = (i & 1) ? (data[i / 2] & 15) : (data[i / 2] >> 4);
+			if (!TRANSPARENT || p) expected[i] = palette[p];
+			CAPTURE(TRANSPARENT, FILL_INFO, ofst0, ofst1, iter, i);
+			CHECK(out[i] == expected[i]);
+			CHECK(info[i] == (FILL_INFO ? uint8_t(p != 0) : 0xAA));
+		}
+		CHECK(out[8] == expected[8]); // no writes beyond the end
+		CHECK(info[8] == 0xAA);
+	}
+}
+
+TEST_CASE("V9990LineConvert: drawPattern8")
+{
+	std::mt19937 gen(1234);
+	std::uniform_int_distribution<uint32_t> dist;
+	std::array<Pixel, 64> palette64;
+	for (auto& p : palette64) p = dist(gen);
+
+	for (auto [ofst0, ofst1] : {std::pair{0, 0}, {16, 48}, {32, 0}}) {
+		checkPattern8<false, false>(palette64, ofst0, ofst1); // P1 background
+		checkPattern8<true,  true >(palette64, ofst0, ofst1); // P1 foreground
+		checkPattern8<false, true >(palette64, ofst0, ofst1); // P2
+	}
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include "VRAMAccessStats.hh"
+
+#include "xrange.hh"
+
+using namespace openmsx;
+using Access = VRAMAccessStats::Access;
+
+TEST_CASE("VRAMAccessStats: frame counters")
+{
+	VRAMAccessStats stats(0x4000);
+	CHECK(stats.getHistory().empty());
+
+	stats.count(Access::CPU_WRITE, 0x0000);
+	stats.count(Access::CPU_WRITE, 0x0001);
+	stats.count(Access::CMD_READ,  0x3fff);
+	CHECK(stats.getCurrentFrame().get(Access::CPU_WRITE) == 2);
+	CHECK(stats.getCurrentFrame().get(Access::CMD_READ) == 1);
+	CHECK(stats.getCurrentFrame().total() == 3);
+
+	stats.frameEnd(12);
+	REQUIRE(stats.getHistory().size() == 1);
+	const auto& frame = stats.getHistory()[0];
+	CHECK(frame.get(Access::CPU_READ)  == 0);
+	CHECK(frame.get(Access::CPU_WRITE) == 2);
+	CHECK(frame.get(Access::CMD_READ)  == 1);
+	CHECK(frame.get(Access::CMD_WRITE) == 0);
+	CHECK(frame.slots == 12);
+	CHECK(frame.utilization() == 0.25f);
+	CHECK(stats.getCurrentFrame().total() == 0);
+
+	// the history is limited, the oldest frames are dropped
+	for (auto i : xrange(VRAMAccessStats::HISTORY + 10)) {
+		stats.count(Access::CMD_WRITE, 0x100);
+		stats.frameEnd(uint32_t(i));
+	}
+	CHECK(stats.getHistory().size() == VRAMAccessStats::HISTORY);
+	CHECK(stats.getHistory()[0].slots == 10);
+	CHECK(stats.getHistory()[VRAMAccessStats::HISTORY - 1].slots == VRAMAccessStats::HISTORY + 9);
+	CHECK(stats.getHistory()[0].utilization() == 0.1f);
+
+	// utilization is 0 for frames without slots (e.g. broken cmd timing)
+	CHECK(VRAMAccessStats::FrameCounts{}.utilization() == 0.0f);
+}
+
+TEST_CASE("VRAMAccessStats: heatmap")
+{
+	VRAMAccessStats stats(0x20000);
+	CHECK(stats.getHeatmap(Access::CPU_READ).size() == 0x20000);
+
+	stats.count(Access::CPU_READ,  0x1ffff);
+	stats.count(Access::CPU_READ,  0x1ffff);
+	stats.count(Access::CMD_WRITE, 0x12345);
+	stats.frameEnd(100);
+	stats.count(Access::CMD_WRITE, 0x12345);
+	stats.frameEnd(100);
+
+	// accumulated over frames
+	CHECK(stats.getHeatmapFrames() == 2);
+	CHECK(stats.getHeatmap(Access::CPU_READ )[0x1ffff] == 2);
+	CHECK(stats.getHeatmap(Access::CPU_WRITE)[0x1ffff] == 0);
+	CHECK(stats.getHeatmap(Access::CMD_WRITE)[0x12345] == 2);
+	CHECK(stats.getHeatmap(Access::CMD_READ )[0x12345] == 0);
+
+	stats.clearHeatmap();
+	CHECK(stats.getHeatmapFrames() == 0);
+	CHECK(stats.getHeatmap(Access::CPU_READ )[0x1ffff] == 0);
+	CHECK(stats.getHeatmap(Access::CMD_WRITE)[0x12345] == 0);
+	// frame counters are not affected
+	CHECK(stats.getHistory().size() == 2);
+}
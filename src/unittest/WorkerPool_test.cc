@@ -0,0 +1,43 @@
+#include "catch.hpp"
+
+#include "WorkerPool.hh"
+
+#include "xrange.hh"
+
+#include <array>
+#include <set>
+#include <span>
+#include <thread>
+
+using namespace openmsx;
+
+TEST_CASE("WorkerPool")
+{
+	WorkerPool pool(3);
+
+	struct Item {
+		int value = 0;
+		std::thread::id id;
+	};
+	std::array<Item, 4> items;
+	for (auto iter : xrange(1000)) {
+		// vary the number of items, possibly less than the number of helpers
+		auto n = 1 + (iter % items.size());
+		pool.forEach(std::span{items}.first(n), [](Item& item) {
+			++item.value;
+			item.id = std::this_thread::get_id();
+		});
+	}
+	CHECK(items[0].value == 250 + 250 + 250 + 250);
+	CHECK(items[1].value == 250 + 250 + 250);
+	CHECK(items[2].value == 250 + 250);
+	CHECK(items[3].value == 250);
+
+	// item 0 on the calling thread, each of the others on a different thread
+	CHECK(items[0].id == std::this_thread::get_id());
+	std::set<std::thread::id> ids;
+	for (const auto& item : items) ids.insert(item.id);
+	CHECK(ids.size() == items.size());
+
+	pool.forEach(std::span<Item>{}, [](Item&) { FAIL("no items"); });
+}
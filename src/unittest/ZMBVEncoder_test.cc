@@ -0,0 +1,175 @@
+#include "catch.hpp"
+
+#include "ZMBVEncoder.hh"
+
+#include "RawFrame.hh"
+
+#include "xrange.hh"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <zlib.h>
+
+using namespace openmsx;
+
+static void fillFrame(RawFrame& frame, uint32_t seed)
+{
+	for (auto y : xrange(frame.getHeight())) {
+		auto line = frame.getLineDirect(y).first(320);
+		for (auto x : xrange(320u)) {
+			line[x] = (seed + x * 0x010203 + y * 0x030201) | 0xff000000;
+		}
+		frame.setLineWidth(y, 320);
+	}
+}
+
+TEST_CASE("ZMBVEncoder: unchanged frames")
+{
+	ZMBVEncoder encoder(320, 240);
+	RawFrame frame(320, 240);
+
+	fillFrame(frame, 0);
+	CHECK(!encoder.compressFrame(true, &frame).empty());
+
+	// identical non-key frame -> nothing to encode
+	CHECK(encoder.compressFrame(false, &frame).empty());
+	CHECK(encoder.compressFrame(false, &frame).empty());
+
+	// identical key frame must still be fully encoded
+	CHECK(!encoder.compressFrame(true, &frame).empty());
+
+	// a single changed pixel is detected
+	frame.getLineDirect(239)[319] ^= 1;
+	CHECK(!encoder.compressFrame(false, &frame).empty());
+	CHECK(encoder.compressFrame(false, &frame).empty());
+
+	// and changing back as well
+	fillFrame(frame, 0);
+	CHECK(!encoder.compressFrame(false, &frame).empty());
+	CHECK(encoder.compressFrame(false, &frame).empty());
+}
+
+namespace {
+// Minimal ZMBV decoder (32bpp, 16x16 blocks only), to check that the
+// (concatenated, multi-stripe) zlib stream decodes to the original frames.
+class Decoder {
+public:
+	Decoder(unsigned width_, unsigned height_)
+		: width(width_), height(height_)
+		, pitch(width + 32)
+		, curr((height + 32) * pitch, 0), prev(curr)
+	{
+		inflateInit(&zs);
+	}
+	~Decoder() { inflateEnd(&zs); }
+
+	bool decode(std::span<const uint8_t> data) {
+		if (data.empty()) return true; // repeat previous frame
+		std::swap(curr, prev);
+		bool key = data[0] & 1;
+		data = data.subspan(key ? 7 : 1);
+		if (key) inflateReset(&zs);
+
+		std::vector<uint8_t> buf(width * height * 4 + 65536);
+		zs.next_in = const_cast<uint8_t*>(data.data());
+		zs.avail_in = unsigned(data.size());
+		zs.next_out = buf.data();
+		zs.avail_out = unsigned(buf.size());
+		if (inflate(&zs, Z_SYNC_FLUSH) != Z_OK) return false;
+		if (zs.avail_in != 0) return false;
+		auto size = buf.size() - zs.avail_out;
+		auto pixel = [&](size_t offset) {
+			return uint32_t(buf[offset + 0] <<  0) | uint32_t(buf[offset + 1] <<  8) |
+			       uint32_t(buf[offset + 2] << 16) | uint32_t(buf[offset + 3] << 24);
+		};
+
+		if (key) {
+			if (size != width * height * 4) return false;
+			for (auto y : xrange(height)) {
+				for (auto x : xrange(width)) {
+					at(curr, x, y) = pixel(4 * (y * width + x));
+				}
+			}
+			return true;
+		}
+		unsigned xBlocks = width / 16;
+		unsigned blocks = xBlocks * (height / 16);
+		size_t pos = (blocks * 2 + 3) & ~3;
+		for (auto b : xrange(blocks)) {
+			int vx = int8_t(buf[2 * b + 0]) >> 1;
+			int vy = int8_t(buf[2 * b + 1]) >> 1;
+			bool delta = buf[2 * b + 0] & 1;
+			int bx = int(16 * (b % xBlocks));
+			int by = int(16 * (b / xBlocks));
+			for (auto y : xrange(16)) {
+				for (auto x : xrange(16)) {
+					auto p = at(prev, bx + x + vx, by + y + vy);
+					if (delta) {
+						if (pos + 4 > size) return false;
+						p ^= pixel(pos);
+						pos += 4;
+					}
+					at(curr, bx + x, by + y) = p;
+				}
+			}
+		}
+		return pos == size;
+	}
+
+	// decoded frame in ZMBV 0RGB format
+	uint32_t get(unsigned x, unsigned y) const {
+		return curr[(y + 16) * pitch + x + 16];
+	}
+
+private:
+	uint32_t& at(std::vector<uint32_t>& frame, int x, int y) {
+		return frame[(y + 16) * pitch + x + 16];
+	}
+
+	unsigned width, height, pitch;
+	std::vector<uint32_t> curr, prev; // with 16 pixel black border
+	z_stream zs = {};
+};
+}
+
+static bool sameFrame(const RawFrame& frame, const Decoder& decoder)
+{
+	for (auto y : xrange(frame.getHeight())) {
+		auto line = frame.getLineDirect(y);
+		for (auto x : xrange(320u)) {
+			auto p = line[x];
+			uint32_t expected = ((p & 0xff) << 16) | (p & 0xff00) | ((p >> 16) & 0xff);
+			if (decoder.get(x, y) != expected) return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("ZMBVEncoder: round trip")
+{
+	ZMBVEncoder encoder(320, 240);
+	Decoder decoder(320, 240);
+	RawFrame frame(320, 240);
+	std::mt19937 gen(1234);
+	std::uniform_int_distribution<uint32_t> dist;
+
+	fillFrame(frame, 0);
+	for (auto i : xrange(24)) {
+		if (i % 3 == 1) {
+			// scroll everything by a few pixels (motion vectors)
+			fillFrame(frame, i * 0x010203);
+		} else {
+			// change a few random pixels
+			repeat(50, [&] {
+				auto x = dist(gen) % 320;
+				auto y = dist(gen) % frame.getHeight();
+				frame.getLineDirect(y)[x] = dist(gen);
+			});
+		}
+		bool keyFrame = (i % 10) == 0;
+		CHECK(decoder.decode(encoder.compressFrame(keyFrame, &frame)));
+		CHECK(sameFrame(frame, decoder));
+	}
+}
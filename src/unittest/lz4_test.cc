@@ -0,0 +1,56 @@
+#include "catch.hpp"
+
+#include "lz4.hh"
+
+#include "xrange.hh"
+
+#include <cstdint>
+#include <vector>
+
+static void roundTrip(const std::vector<uint8_t>& data)
+{
+	auto size = int(data.size());
+	std::vector<uint8_t> compressed(LZ4::compressBound(size));
+	std::vector<uint8_t> decompressed(data.size() + 32); // decompress may write a bit beyond the end
+
+	auto len = LZ4::compress(data.data(), compressed.data(), size);
+	REQUIRE(len <= LZ4::compressBound(size));
+	CHECK(LZ4::decompress(compressed.data(), decompressed.data(), len, size) == size);
+	CHECK(std::equal(data.begin(), data.end(), decompressed.begin()));
+
+	auto lenHC = LZ4::compressHC(data.data(), compressed.data(), size);
+	REQUIRE(lenHC <= LZ4::compressBound(size));
+	std::ranges::fill(decompressed, 0);
+	CHECK(LZ4::decompress(compressed.data(), decompressed.data(), lenHC, size) == size);
+	CHECK(std::equal(data.begin(), data.end(), decompressed.begin()));
+
+	if (size > 1000) CHECK(lenHC <= len);
+}
+
+TEST_CASE("lz4")
+{
+	SECTION("tiny") {
+		roundTrip({1});
+		roundTrip({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13});
+	}
+	SECTION("zeros") {
+		roundTrip(std::vector<uint8_t>(100000, 0));
+	}
+	SECTION("pseudo random") {
+		std::vector<uint8_t> data(70000);
+		uint32_t x = 12345;
+		for (auto& d : data) {
+			x = x * 1103515245 + 12345;
+			d = uint8_t(x >> 24);
+		}
+		roundTrip(data);
+	}
+	SECTION("structured") {
+		// repeated patterns at various distances, also beyond 64kB
+		std::vector<uint8_t> data(300000);
+		for (auto i : xrange(data.size())) {
+			data[i] = uint8_t((i % 251) ^ ((i / 1000) % 7) ^ ((i / 70000) * 3));
+		}
+		roundTrip(data);
+	}
+}
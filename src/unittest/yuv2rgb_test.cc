@@ -0,0 +1,137 @@
+#include "catch.hpp"
+
+#include "components.hh"
+
+#if COMPONENT_LASERDISC
+
+#include "yuv2rgb.hh"
+
+#include "RawFrame.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+// 4:2:0 image, with (possibly) padding at the end of each line.
+struct YUVImage
+{
+	YUVImage(int width, int height, int padding)
+		: yStride(width + padding), uvStride(width / 2 + padding)
+		, y(size_t(yStride) * height), u(size_t(uvStride) * height / 2), v(u.size())
+	{
+		buffer[0] = {.width = width,     .height = height,     .stride = yStride,  .data = y.data()};
+		buffer[1] = {.width = width / 2, .height = height / 2, .stride = uvStride, .data = u.data()};
+		buffer[2] = {.width = width / 2, .height = height / 2, .stride = uvStride, .data = v.data()};
+	}
+
+	[[nodiscard]] uint8_t& Y(int x, int line) { return y[line * yStride + x]; }
+	[[nodiscard]] uint8_t& U(int x, int line) { return u[line / 2 * uvStride + x / 2]; }
+	[[nodiscard]] uint8_t& V(int x, int line) { return v[line / 2 * uvStride + x / 2]; }
+
+	int yStride, uvStride;
+	std::vector<uint8_t> y, u, v;
+	th_ycbcr_buffer buffer;
+};
+}
+
+// Straightforward implementation of the fixed point calculation, all
+// (possibly SIMD) implementations in yuv2rgb must give identical results.
+static uint32_t reference(int y, int u, int v)
+{
+	static constexpr int PREC = 15;
+	auto coef = [](double c) { return int(c * (1 << PREC) + 0.5); };
+	auto clip = [](int x) { return uint32_t(std::clamp(x >> PREC, 0, 255)); };
+	int yy = coef(1.164) * (y - 16) + (PREC / 2);
+	uint32_t r = clip(yy + coef(1.596) * (v - 128));
+	uint32_t g = clip(yy - coef(0.391) * (u - 128) - coef(0.813) * (v - 128));
+	uint32_t b = clip(yy + coef(2.018) * (u - 128));
+	return r | (g << 8) | (b << 16) | 0xFF000000;
+}
+
+static void check(YUVImage& image, const RawFrame& frame)
+{
+	for (auto line : xrange(image.buffer[0].height)) {
+		CHECK(frame.getLineWidthDirect(line) == unsigned(image.buffer[0].width));
+		auto out = frame.getLineDirect(line);
+		for (auto x : xrange(image.buffer[0].width)) {
+			auto expected = reference(image.Y(x, line), image.U(x, line), image.V(x, line));
+			if (out[x] != expected) {
+				CAPTURE(x, line);
+				CHECK(out[x] == expected);
+				return;
+			}
+		}
+	}
+}
+
+TEST_CASE("yuv2rgb: golden values")
+{
+	// 16x2, so this also goes through the SIMD code (if any)
+	YUVImage image(16, 2, 0);
+	auto set = [&](int x, int y, int u, int v) {
+		image.Y(x, 0) = image.Y(x + 1, 0) = image.Y(x, 1) = image.Y(x + 1, 1) = uint8_t(y);
+		image.U(x, 0) = uint8_t(u);
+		image.V(x, 0) = uint8_t(v);
+	};
+	set( 0,  16, 128, 128); // black
+	set( 2, 235, 128, 128); // white (the rounding gives 254, not 255)
+	set( 4,  82,  90, 240); // red
+	set( 6, 145,  54,  34); // green
+	set( 8,  41, 240, 110); // blue
+	set(10,   0,   0,   0); // out of range
+	set(12, 255, 255, 255); // out of range
+	set(14, 128, 128, 128); // gray
+	RawFrame frame(16, 2);
+	yuv2rgb::convert(image.buffer, frame);
+
+	auto out = frame.getLineDirect(1);
+	CHECK(out[ 1] == 0xFF000000);
+	CHECK(out[ 3] == 0xFFFEFEFE);
+	CHECK(out[ 5] == 0xFF0000FF);
+	CHECK(out[ 7] == 0xFF00FF00);
+	CHECK(out[ 9] == 0xFFFF0000);
+	CHECK(out[11] == 0xFF008700);
+	CHECK(out[13] == 0xFFFF7DFF);
+	CHECK(out[15] == 0xFF828282);
+	check(image, frame);
+}
+
+TEST_CASE("yuv2rgb: all U/V combinations")
+{
+	// 512x512, so every (U, V) pair occurs once, with random Y values.
+	// Lines have some padding at the end, like in theora frames.
+	YUVImage image(512, 512, 8);
+	std::mt19937 gen(1234);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto line : xrange(512)) {
+		for (auto x : xrange(512)) {
+			image.Y(x, line) = uint8_t(dist(gen));
+			image.U(x, line) = uint8_t(x / 2);
+			image.V(x, line) = uint8_t(line / 2);
+		}
+	}
+	RawFrame frame(512, 512);
+	yuv2rgb::convert(image.buffer, frame);
+	check(image, frame);
+}
+
+TEST_CASE("yuv2rgb: width not a multiple of the SIMD width")
+{
+	YUVImage image(38, 4, 3);
+	std::mt19937 gen(5678);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& b : image.y) b = uint8_t(dist(gen));
+	for (auto& b : image.u) b = uint8_t(dist(gen));
+	for (auto& b : image.v) b = uint8_t(dist(gen));
+	RawFrame frame(38, 4);
+	yuv2rgb::convert(image.buffer, frame);
+	check(image, frame);
+}
+
+#endif
@@ -184,22 +184,24 @@ end:	return std::mismatch(p, p_end, q);
 //   n2 number of bytes are different, and here are the bytes
 //   n3 number of bytes are equal
 //   ...
-[[nodiscard]] static std::vector<uint8_t> calcDelta(
-	const uint8_t* oldBuf, std::span<const uint8_t> newBuf)
+//
+// The buffers are only compared in the pages marked in 'dirty', all other
+// pages are known to be equal. This helper handles one contiguous dirty
+// region. 'equal' is the number of equal bytes that were not yet stored in
+// 'result' (these can span multiple regions).
+static void calcDeltaRegion(
+	std::vector<uint8_t>& result, size_t& equal,
+	const uint8_t* p, std::span<const uint8_t> newRegion)
 {
-	std::vector<uint8_t> result;
-
-	const auto* p = oldBuf;
-	const auto* q = newBuf.data();
-	auto size = newBuf.size();
+	const auto* q = newRegion.data();
+	auto size = newRegion.size();
 	const auto* p_end = p + size;
 	const auto* q_end = q + size;
 
 	// scan equal bytes (possibly zero)
 	const auto* q1 = q;
 	std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
-	auto n1 = q - q1;
-	storeUleb(result, n1);
+	equal += q - q1;
 
 	while (q != q_end) {
 		assert(*p != *q);
@@ -214,11 +216,38 @@ end:	return std::mismatch(p, p_end, q);
 		auto n3 = q - q3;
 		if ((q != q_end) && (n3 <= 2)) goto different;
 
+		storeUleb(result, equal);
 		storeUleb(result, n2);
 		result.insert(result.end(), q2, q3);
+		equal = n3;
+	}
+}
 
-		if (n3 != 0) storeUleb(result, n3);
+[[nodiscard]] static std::vector<uint8_t> calcDelta(
+	const uint8_t* oldBuf, std::span<const uint8_t> newBuf,
+	const DirtyPages& dirty)
+{
+	std::vector<uint8_t> result;
+	size_t equal = 0;
+
+	auto size = newBuf.size();
+	auto numPages = dirty.size();
+	assert(numPages == ((size + DirtyPages::PAGE_SIZE - 1) >> DirtyPages::PAGE_BITS));
+	size_t page = 0;
+	while (page < numPages) {
+		// clean pages, these are known to be equal
+		auto cleanStart = page << DirtyPages::PAGE_BITS;
+		while ((page < numPages) && !dirty.test(page)) ++page;
+		auto dirtyStart = std::min(page << DirtyPages::PAGE_BITS, size);
+		equal += dirtyStart - cleanStart;
+
+		// dirty pages, these must be compared
+		while ((page < numPages) && dirty.test(page)) ++page;
+		auto dirtyEnd = std::min(page << DirtyPages::PAGE_BITS, size);
+		calcDeltaRegion(result, equal, oldBuf + dirtyStart,
+		                newBuf.subspan(dirtyStart, dirtyEnd - dirtyStart));
 	}
+	if (result.empty() || equal) storeUleb(result, equal);
 
 	result.shrink_to_fit();
 	return result;
@@ -256,6 +285,7 @@ DeltaBlock::~DeltaBlock()
 
 DeltaBlockCopy::DeltaBlockCopy(std::span<const uint8_t> data)
 	: block(data.size())
+	, size(data.size())
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc(data);
@@ -282,18 +312,36 @@ void DeltaBlockCopy::apply(std::span<uint8_t> dst) const
 #endif
 }
 
-void DeltaBlockCopy::compress(size_t size)
+size_t DeltaBlockCopy::compress(Compression newLevel)
 {
-	if (compressed()) return;
+	if (reference || (newLevel <= level)) return 0;
+	level = newLevel;
+
+	// Recompress from the original data.
+	MemBuffer<uint8_t> orig;
+	if (compressed()) {
+		orig.resize(size);
+		apply(orig);
+	}
+	const uint8_t* src = compressed() ? orig.data() : block.data();
 
 	size_t dstLen = LZ4::compressBound(int(size));
 	MemBuffer<uint8_t> buf2(dstLen);
-	dstLen = LZ4::compress(block.data(), buf2.data(), int(size));
+	dstLen = (newLevel == Compression::HIGH)
+	       ? LZ4::compressHC(src, buf2.data(), int(size))
+	       : LZ4::compress  (src, buf2.data(), int(size));
 
-	if (dstLen >= size) {
-		// compression isn't beneficial
-		return;
+	if (dstLen >= (compressed() ? compressedSize : size)) {
+		// (re)compression isn't beneficial
+		return size;
 	}
+#if STATISTICS
+	int delta = dstLen - allocSize;
+	allocSize = dstLen;
+	globalAllocSize += delta;
+	std::cout << "stat: compress " << globalAllocSize
+	          << " (" << delta << ")\n";
+#endif
 	compressedSize = dstLen;
 	std::swap(block, buf2);
 	block.resize(compressedSize); // shrink to fit
@@ -301,15 +349,9 @@ void DeltaBlockCopy::compress(size_t size)
 #ifdef DEBUG
 	MemBuffer<uint8_t> buf3(size);
 	apply({buf3.data(), size});
-	assert(std::ranges::equal(std::span{buf3.data(), size}, std::span{buf2.data(), size}));
-#endif
-#if STATISTICS
-	int delta = compressedSize - allocSize;
-	allocSize = compressedSize;
-	globalAllocSize += delta;
-	std::cout << "stat: compress " << globalAllocSize
-	          << " (" << delta << ")\n";
+	assert(SHA1::calc(std::span{buf3.data(), size}) == sha1);
 #endif
+	return size;
 }
 
 const uint8_t* DeltaBlockCopy::getData()
@@ -323,9 +365,10 @@ const uint8_t* DeltaBlockCopy::getData()
 
 DeltaBlockDiff::DeltaBlockDiff(
 		std::shared_ptr<DeltaBlockCopy> prev_,
-		std::span<const uint8_t> data)
+		std::span<const uint8_t> data,
+		const DirtyPages& dirty)
 	: prev(std::move(prev_))
-	, delta(calcDelta(prev->getData(), data))
+	, delta(calcDelta(prev->getData(), data, dirty))
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc(data);
@@ -351,6 +394,11 @@ void DeltaBlockDiff::apply(std::span<uint8_t> dst) const
 #endif
 }
 
+size_t DeltaBlockDiff::compress(Compression level)
+{
+	return prev->compress(level);
+}
+
 size_t DeltaBlockDiff::getDeltaSize() const
 {
 	return delta.size();
@@ -360,7 +408,8 @@ size_t DeltaBlockDiff::getDeltaSize() const
 // class LastDeltaBlocks
 
 std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
-		const void* id, std::span<const uint8_t> data)
+		const void* id, std::span<const uint8_t> data,
+		const DirtyPages* dirty)
 {
 	auto size = data.size();
 	auto it = std::ranges::lower_bound(infos, std::tuple(id, size), {},
@@ -375,21 +424,30 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 	auto ref = it->ref.lock();
 	if (it->accSize >= size || !ref) {
 		if (ref) {
-			// We will switch to a new DeltaBlockCopy object. So
-			// now is a good time to compress the old one.
-			ref->compress(size);
+			// We will switch to a new DeltaBlockCopy object. From
+			// now on the old one may be compressed (see
+			// DeltaBlock::compress()).
+			ref->releaseReference();
 		}
 		// Heuristic: create a new block when too many small
 		// differences have accumulated.
 		auto b = std::make_shared<DeltaBlockCopy>(data);
 		it->ref = b;
 		it->last = b;
+		it->dirtySinceRef = DirtyPages(size);
 		it->accSize = 0;
 		return b;
 	} else {
 		// Create diff based on earlier reference block.
-		// Reference remains unchanged.
-		auto b = std::make_shared<DeltaBlockDiff>(ref, data);
+		// Reference remains unchanged. Without dirty information
+		// the whole block must be compared (now and for all later
+		// diffs against the same reference).
+		if (dirty) {
+			it->dirtySinceRef |= *dirty;
+		} else {
+			it->dirtySinceRef.markAll();
+		}
+		auto b = std::make_shared<DeltaBlockDiff>(ref, data, it->dirtySinceRef);
 		it->last = b;
 		it->accSize += b->getDeltaSize();
 		return b;
@@ -412,6 +470,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 		auto b = std::make_shared<DeltaBlockCopy>(data);
 		it->ref = b;
 		it->last = b;
+		it->dirtySinceRef = DirtyPages(size);
 		it->accSize = 0;
 		return b;
 	} else {
@@ -426,7 +485,8 @@ void LastDeltaBlocks::clear()
 {
 	for (const Info& info : infos) {
 		if (auto ref = info.ref.lock()) {
-			ref->compress(info.size);
+			ref->releaseReference();
+			ref->compress(DeltaBlock::Compression::FAST);
 		}
 	}
 	infos.clear();
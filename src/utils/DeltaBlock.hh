@@ -3,6 +3,7 @@
 
 #define STATISTICS 0
 
+#include "DirtyPages.hh"
 #include "MemBuffer.hh"
 
 #include <cstdint>
@@ -18,6 +19,13 @@ namespace openmsx {
 class DeltaBlock
 {
 public:
+	/** Compression levels, used for progressively older reverse history. */
+	enum class Compression : uint8_t {
+		NONE, // fastest to apply
+		FAST, // LZ4
+		HIGH, // LZ4 high compression: slow to compress, but as fast to apply as FAST
+	};
+
 #if STATISTICS
 	virtual ~DeltaBlock();
 #else
@@ -25,6 +33,14 @@ public:
 #endif
 	virtual void apply(std::span<uint8_t> dst) const = 0;
 
+	/** Make sure the (uncompressed) data of this block is compressed with
+	  * at least the given level. This has no effect on blocks that are
+	  * still used as a reference for new diffs (see LastDeltaBlocks).
+	  * Returns the number of (uncompressed) bytes that were compressed,
+	  * this allows the caller to limit the amount of work.
+	  */
+	virtual size_t compress(Compression level) = 0;
+
 protected:
 	DeltaBlock() = default;
 
@@ -46,14 +62,23 @@ class DeltaBlockCopy final : public DeltaBlock
 public:
 	explicit DeltaBlockCopy(std::span<const uint8_t> data);
 	void apply(std::span<uint8_t> dst) const override;
-	void compress(size_t size);
+	size_t compress(Compression level) override;
 	[[nodiscard]] const uint8_t* getData();
+	[[nodiscard]] Compression getCompression() const { return level; }
+
+	/** Called by LastDeltaBlocks when this block is no longer used as the
+	  * reference for new diffs. Only from then on it can be compressed.
+	  */
+	void releaseReference() { reference = false; }
 
 private:
 	[[nodiscard]] bool compressed() const { return compressedSize != 0; }
 
 	MemBuffer<uint8_t> block;
+	size_t size;
 	size_t compressedSize = 0;
+	Compression level = Compression::NONE; // highest level tried so far
+	bool reference = true;
 };
 
 
@@ -61,8 +86,10 @@ class DeltaBlockDiff final : public DeltaBlock
 {
 public:
 	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
-	               std::span<const uint8_t> data);
+	               std::span<const uint8_t> data,
+	               const DirtyPages& dirty);
 	void apply(std::span<uint8_t> dst) const override;
+	size_t compress(Compression level) override;
 	[[nodiscard]] size_t getDeltaSize() const;
 
 private:
@@ -74,8 +101,13 @@ private:
 class LastDeltaBlocks
 {
 public:
+	/** Create a new block for 'data'. Optionally 'dirty' indicates which
+	  * pages changed since the previous call with the same 'id'. Pages that
+	  * are not marked are assumed to be unchanged and won't be compared.
+	  */
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNew(
-		const void* id, std::span<const uint8_t> data);
+		const void* id, std::span<const uint8_t> data,
+		const DirtyPages* dirty = nullptr);
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNullDiff(
 		const void* id, std::span<const uint8_t> data);
 	void clear();
@@ -89,6 +121,7 @@ private:
 		size_t size;
 		std::weak_ptr<DeltaBlockCopy> ref;
 		std::weak_ptr<DeltaBlock> last;
+		DirtyPages dirtySinceRef; // pages changed since 'ref' was created
 		size_t accSize = 0;
 	};
 
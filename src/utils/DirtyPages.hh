@@ -0,0 +1,107 @@
+#ifndef DIRTY_PAGES_HH
+#define DIRTY_PAGES_HH
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+/** DirtyPages. Tracks which (fixed size) pages of a memory block were written.
+  *
+  * A memory block of 'size' bytes is divided in pages of PAGE_SIZE bytes (the
+  * last page may be partial). Marking is cheap enough to be done on every
+  * emulated write. The main user is the reverse-snapshot code: when creating
+  * a delta (see DeltaBlock.hh) only the dirty pages need to be compared.
+  */
+class DirtyPages
+{
+	static constexpr size_t BITS_PER_WORD = 64;
+
+public:
+	static constexpr unsigned PAGE_BITS = 8;
+	static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+	DirtyPages() = default;
+
+	/** Create a (clean) bitmap for a memory block of the given size.
+	  */
+	explicit DirtyPages(size_t byteSize)
+		: numPages((byteSize + PAGE_SIZE - 1) >> PAGE_BITS)
+		, words((numPages + BITS_PER_WORD - 1) / BITS_PER_WORD)
+	{
+	}
+
+	/** Returns the number of pages (not bytes).
+	  */
+	[[nodiscard]] size_t size() const { return numPages; }
+
+	/** Mark the page containing the given byte address as dirty.
+	  */
+	void mark(size_t addr)
+	{
+		auto page = addr >> PAGE_BITS;
+		assert(page < numPages);
+		words[page / BITS_PER_WORD] |= uint64_t(1) << (page % BITS_PER_WORD);
+	}
+
+	/** Mark all pages overlapping the byte range [addr, addr + len).
+	  */
+	void markRange(size_t addr, size_t len)
+	{
+		if (len == 0) return;
+		auto last = (addr + len - 1) >> PAGE_BITS;
+		for (auto page = addr >> PAGE_BITS; page <= last; ++page) {
+			assert(page < numPages);
+			words[page / BITS_PER_WORD] |= uint64_t(1) << (page % BITS_PER_WORD);
+		}
+	}
+
+	/** Mark the whole memory block as dirty.
+	  */
+	void markAll()
+	{
+		std::ranges::fill(words, ~uint64_t(0));
+	}
+
+	/** Mark all pages as clean.
+	  */
+	void clear()
+	{
+		std::ranges::fill(words, uint64_t(0));
+	}
+
+	/** Is the page with the given index (not byte address) dirty?
+	  */
+	[[nodiscard]] bool test(size_t page) const
+	{
+		assert(page < numPages);
+		return words[page / BITS_PER_WORD] & (uint64_t(1) << (page % BITS_PER_WORD));
+	}
+
+	/** Returns true iff at least one page is dirty.
+	  */
+	[[nodiscard]] bool any() const
+	{
+		return std::ranges::any_of(words, [](auto w) { return w != 0; });
+	}
+
+	DirtyPages& operator|=(const DirtyPages& other)
+	{
+		assert(numPages == other.numPages);
+		for (size_t i = 0; i < words.size(); ++i) {
+			words[i] |= other.words[i];
+		}
+		return *this;
+	}
+
+private:
+	size_t numPages = 0;
+	std::vector<uint64_t> words;
+};
+
+} // namespace openmsx
+
+#endif
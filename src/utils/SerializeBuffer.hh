@@ -208,6 +208,9 @@ public:
 	  */
 	[[nodiscard]] const uint8_t* getCurrentPos() const { return buf.data(); }
 
+	/** The number of bytes that can still be read. */
+	[[nodiscard]] size_t remaining() const { return buf.size(); }
+
 private:
 	std::span<const uint8_t> buf;
 };
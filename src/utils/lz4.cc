@@ -4,9 +4,11 @@
 #include "endian.hh"
 #include "inline.hh"
 #include "unreachable.hh"
+#include <algorithm>
 #include <array>
 #include <bit>
 #include <cstring>
+#include <memory>
 
 #ifdef _MSC_VER
 #  include <intrin.h>
@@ -463,6 +465,153 @@ int compress(const uint8_t* src, uint8_t* dst, int srcSize)
 
 
 
+// --- high compression mode ---
+
+static constexpr int HC_HASHLOG = 15;
+static constexpr uint32_t HC_NONE = uint32_t(-1);
+static constexpr int HC_MAX_ATTEMPTS = 256;
+
+struct HCMatchFinder {
+	explicit HCMatchFinder(const uint8_t* src_) : src(src_) {
+		hashTable.fill(HC_NONE);
+	}
+
+	[[nodiscard]] static uint32_t hashPosition(const uint8_t* p) {
+		return (unalignedLoad32(p) * 2654435761U) >> ((MINMATCH * 8) - HC_HASHLOG);
+	}
+
+	// Insert all positions up to (not including) 'ip' in the hash chains.
+	void insert(const uint8_t* ip) {
+		auto target = uint32_t(ip - src);
+		for (/**/; nextToUpdate < target; ++nextToUpdate) {
+			auto h = hashPosition(src + nextToUpdate);
+			auto prev = hashTable[h];
+			auto delta = (prev == HC_NONE) ? DISTANCE_MAX : std::min<uint32_t>(nextToUpdate - prev, DISTANCE_MAX);
+			chainTable[nextToUpdate & 0xFFFF] = uint16_t(delta);
+			hashTable[h] = nextToUpdate;
+		}
+	}
+
+	// Returns the length of the longest match for 'ip' (or 0 if there's no
+	// match), 'matchPos' is set to the start of that match.
+	[[nodiscard]] unsigned find(const uint8_t* ip, const uint8_t* matchLimit, const uint8_t*& matchPos) {
+		insert(ip);
+		auto current = uint32_t(ip - src);
+		auto maxLen = unsigned(matchLimit - ip);
+		unsigned best = 0;
+		auto matchIndex = hashTable[hashPosition(ip)];
+		for (int attempts = HC_MAX_ATTEMPTS;
+		     (matchIndex != HC_NONE) && ((current - matchIndex) <= DISTANCE_MAX) && (attempts > 0);
+		     --attempts) {
+			const uint8_t* candidate = src + matchIndex;
+			if ((candidate[best] == ip[best]) &&
+			    (unalignedLoad32(candidate) == unalignedLoad32(ip))) {
+				auto len = MINMATCH + count(ip + MINMATCH, candidate + MINMATCH, matchLimit);
+				if (len > best) {
+					best = len;
+					matchPos = candidate;
+					if (best == maxLen) break; // can't do better
+				}
+			}
+			auto delta = chainTable[matchIndex & 0xFFFF];
+			if (delta > matchIndex) break;
+			matchIndex -= delta;
+		}
+		return best;
+	}
+
+	const uint8_t* src;
+	uint32_t nextToUpdate = 0;
+	std::array<uint32_t, 1 << HC_HASHLOG> hashTable;
+	std::array<uint16_t, DISTANCE_MAX + 1> chainTable;
+};
+
+static uint8_t* writeLength(uint8_t* op, size_t len)
+{
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = uint8_t(len);
+	return op;
+}
+
+static uint8_t* encodeSequence(uint8_t* op, const uint8_t* anchor, const uint8_t* ip,
+                               const uint8_t* match, unsigned matchLength)
+{
+	auto litLength = size_t(ip - anchor);
+	uint8_t* token = op++;
+	if (litLength >= RUN_MASK) {
+		*token = RUN_MASK << ML_BITS;
+		op = writeLength(op, litLength - RUN_MASK);
+	} else {
+		*token = uint8_t(litLength << ML_BITS);
+	}
+	memcpy(op, anchor, litLength);
+	op += litLength;
+
+	Endian::write_UA_L16(op, uint16_t(ip - match));
+	op += 2;
+
+	unsigned matchCode = matchLength - MINMATCH;
+	if (matchCode >= ML_MASK) {
+		*token += ML_MASK;
+		op = writeLength(op, matchCode - ML_MASK);
+	} else {
+		*token += uint8_t(matchCode);
+	}
+	return op;
+}
+
+int compressHC(const uint8_t* src, uint8_t* dst, int srcSize)
+{
+	auto finder = std::make_unique<HCMatchFinder>(src); // too big for the stack
+
+	const uint8_t* ip = src;
+	const uint8_t* anchor = src;
+	uint8_t* op = dst;
+	const uint8_t* const iend = src + srcSize;
+	const uint8_t* const mflimitPlusOne = iend - MFLIMIT + 1;
+	const uint8_t* const matchLimit = iend - LASTLITERALS;
+
+	if (srcSize >= MIN_LENGTH) {
+		while (ip < mflimitPlusOne) {
+			const uint8_t* match = nullptr;
+			auto len = finder->find(ip, matchLimit, match);
+			if (len < MINMATCH) {
+				++ip;
+				continue;
+			}
+			// Lazy matching: prefer a longer match starting one byte later.
+			while ((ip + 1) < mflimitPlusOne) {
+				const uint8_t* match2 = nullptr;
+				auto len2 = finder->find(ip + 1, matchLimit, match2);
+				if (len2 <= len) break;
+				++ip;
+				len = len2;
+				match = match2;
+			}
+			op = encodeSequence(op, anchor, ip, match, len);
+			ip += len;
+			anchor = ip;
+		}
+	}
+
+	// Encode Last Literals
+	auto lastRun = size_t(iend - anchor);
+	if (lastRun >= RUN_MASK) {
+		*op++ = RUN_MASK << ML_BITS;
+		op = writeLength(op, lastRun - RUN_MASK);
+	} else {
+		*op++ = uint8_t(lastRun << ML_BITS);
+	}
+	memcpy(op, anchor, lastRun);
+	op += lastRun;
+
+	return int(op - dst);
+}
+
+
 static ALWAYS_INLINE unsigned read_variable_length(const uint8_t** ip)
 {
 	unsigned length = 0;
@@ -41,6 +41,7 @@
 //   compress function, and that data is never stored/reloaded from disk.
 // - Rewrite in C++ style.
 // - Use existing openMSX helper functions.
+// - Added compressHC(), a simplified variant of the LZ4 HC algorithm.
 
 #ifndef LZ4_HH
 #define LZ4_HH
@@ -54,6 +55,12 @@ namespace LZ4 {
 	}
 
 	[[nodiscard]] int compress(const uint8_t* src, uint8_t* dst, int srcSize);
+
+	// Slower, but better compression (hash chains instead of a single hash
+	// table). The output uses the same format as compress(), so it can be
+	// decompressed with decompress() at the same (high) speed.
+	[[nodiscard]] int compressHC(const uint8_t* src, uint8_t* dst, int srcSize);
+
 	int decompress(const uint8_t* src, uint8_t* dst, int compressedSize, int dstCapacity);
 }
 
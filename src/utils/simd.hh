@@ -0,0 +1,135 @@
+#ifndef SIMD_HH
+#define SIMD_HH
+
+/** Helpers shared by the hand-written SIMD routines.
+  *
+  * Most of that code is selected at compile time (#ifdef __SSE2__, ...). On
+  * x86 the default build only enables SSE2, so routines that need a newer
+  * instruction set are put in separate functions marked with
+  * SIMD_TARGET("ssse3") or SIMD_TARGET("avx2"), and are called only when
+  * SIMD::hasSSSE3() or SIMD::hasAVX2() returns true. With gcc and clang this
+  * is a run-time check (SIMD_DISPATCH is defined), with other compilers those
+  * routines are only built when the compiler flags already enable the
+  * instruction set.
+  *
+  * Note: a function marked with SIMD_TARGET() can only be inlined in a
+  * function that supports (at least) the same instruction set. So helpers
+  * used by such routines must carry the same marking (or none at all, if they
+  * only use SSE2).
+  */
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#define SIMD_DISPATCH 1
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+#if defined(__SSSE3__) || defined(SIMD_DISPATCH)
+#define SIMD_SSSE3 1
+#endif
+#if defined(__AVX2__) || defined(SIMD_DISPATCH)
+#define SIMD_AVX2 1
+#endif
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#if defined(SIMD_SSSE3) || defined(SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace SIMD {
+
+[[nodiscard]] inline bool hasSSSE3()
+{
+#if defined(__SSSE3__)
+	return true;
+#elif defined(SIMD_DISPATCH)
+	static const bool result = __builtin_cpu_supports("ssse3");
+	return result;
+#else
+	return false;
+#endif
+}
+
+[[nodiscard]] inline bool hasAVX2()
+{
+#if defined(__AVX2__)
+	return true;
+#elif defined(SIMD_DISPATCH)
+	static const bool result = __builtin_cpu_supports("avx2");
+	return result;
+#else
+	return false;
+#endif
+}
+
+#ifdef __SSE2__
+/** Bitwise select: take the bits from 'a1' where 'mask' is set, otherwise
+  * from 'a0'.
+  */
+[[nodiscard]] inline __m128i select(__m128i a0, __m128i a1, __m128i mask)
+{
+	return _mm_xor_si128(_mm_and_si128(_mm_xor_si128(a0, a1), mask), a0);
+}
+#endif
+
+/** Split a palette of (at most) 16 colors in 4 byte-planes (in memory order),
+  * then the palette lookup for 16 pixels is one table lookup instruction per
+  * plane (pshufb on x86, tbl on ARM).
+  */
+[[nodiscard]] inline std::array<std::array<uint8_t, 16>, 4> splitPalette(std::span<const uint32_t> palette)
+{
+	assert(palette.size() <= 16);
+	std::array<std::array<uint8_t, 16>, 4> planes = {};
+	for (size_t i = 0; i < palette.size(); ++i) {
+		auto bytes = std::bit_cast<std::array<uint8_t, 4>>(palette[i]);
+		for (size_t b = 0; b < 4; ++b) planes[b][i] = bytes[b];
+	}
+	return planes;
+}
+
+#ifdef SIMD_SSSE3
+struct PalettePlanes {
+	__m128i b0, b1, b2, b3;
+};
+[[nodiscard]] inline SIMD_TARGET("ssse3") PalettePlanes loadPlanes(std::span<const uint32_t> palette)
+{
+	auto planes = splitPalette(palette);
+	return {_mm_loadu_si128(std::bit_cast<const __m128i*>(planes[0].data())),
+	        _mm_loadu_si128(std::bit_cast<const __m128i*>(planes[1].data())),
+	        _mm_loadu_si128(std::bit_cast<const __m128i*>(planes[2].data())),
+	        _mm_loadu_si128(std::bit_cast<const __m128i*>(planes[3].data()))};
+}
+
+/** Write the 16 pixels corresponding to the 16 (4-bit) palette indices in
+  * 'idx'.
+  */
+inline SIMD_TARGET("ssse3") void lookup16(const PalettePlanes& planes, __m128i idx, uint32_t* out)
+{
+	__m128i b0 = _mm_shuffle_epi8(planes.b0, idx);
+	__m128i b1 = _mm_shuffle_epi8(planes.b1, idx);
+	__m128i b2 = _mm_shuffle_epi8(planes.b2, idx);
+	__m128i b3 = _mm_shuffle_epi8(planes.b3, idx);
+	__m128i b01l = _mm_unpacklo_epi8(b0, b1);
+	__m128i b01h = _mm_unpackhi_epi8(b0, b1);
+	__m128i b23l = _mm_unpacklo_epi8(b2, b3);
+	__m128i b23h = _mm_unpackhi_epi8(b2, b3);
+	auto* o = std::bit_cast<__m128i*>(out);
+	_mm_storeu_si128(o + 0, _mm_unpacklo_epi16(b01l, b23l));
+	_mm_storeu_si128(o + 1, _mm_unpackhi_epi16(b01l, b23l));
+	_mm_storeu_si128(o + 2, _mm_unpacklo_epi16(b01h, b23h));
+	_mm_storeu_si128(o + 3, _mm_unpackhi_epi16(b01h, b23h));
+}
+#endif
+
+} // namespace SIMD
+
+#endif
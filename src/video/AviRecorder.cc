@@ -1,6 +1,7 @@
 #include "AviRecorder.hh"
 
 #include "AviWriter.hh"
+#include "PipeWriter.hh"
 #include "PostProcessor.hh"
 
 #include "CliComm.hh"
@@ -39,11 +40,12 @@ AviRecorder::AviRecorder(Reactor& reactor_)
 AviRecorder::~AviRecorder()
 {
 	assert(!aviWriter);
+	assert(!pipeWriter);
 	assert(!wavWriter);
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
-                        bool recordStereo, const std::string& filename)
+                        bool recordStereo, bool pipe, const std::string& filename)
 {
 	stop();
 	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
@@ -84,9 +86,19 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		prevTime = EmuTime::infinity();
 
 		try {
-			aviWriter = std::make_unique<AviWriter>(
-				filename, frameWidth, frameHeight,
-				(recordAudio && stereo) ? 2 : 1, sampleRate);
+			unsigned channels = (recordAudio && stereo) ? 2 : 1;
+			if (pipe) {
+				pipeWriter = std::make_unique<PipeWriter>(
+					filename,
+					recordAudio ? PipeWriter::Format::RAW
+					            : PipeWriter::Format::Y4M,
+					frameWidth, frameHeight, channels,
+					recordAudio ? sampleRate : 0);
+			} else {
+				aviWriter = std::make_unique<AviWriter>(
+					filename, frameWidth, frameHeight,
+					channels, sampleRate);
+			}
 		} catch (MSXException& e) {
 			throw CommandException("Can't start recording: ",
 			                       e.getMessage());
@@ -115,6 +127,7 @@ void AviRecorder::stop()
 	}
 	sampleRate = 0;
 	aviWriter.reset();
+	pipeWriter.reset();
 	wavWriter.reset();
 }
 
@@ -145,7 +158,7 @@ void AviRecorder::addWave(std::span<const StereoFloat> data)
 				buf[2 * i + 0] = float2int16(s.left);
 				buf[2 * i + 1] = float2int16(s.right);
 			}
-			assert(aviWriter);
+			assert(aviWriter || pipeWriter);
 			append(audioBuf, std::span{buf});
 		}
 	} else {
@@ -170,7 +183,7 @@ void AviRecorder::addWave(std::span<const StereoFloat> data)
 		if (wavWriter) {
 			wavWriter->write(buf);
 		} else {
-			assert(aviWriter);
+			assert(aviWriter || pipeWriter);
 			append(audioBuf, std::span{buf});
 		}
 	}
@@ -189,14 +202,21 @@ void AviRecorder::addImage(const FrameSource* frame, EmuTime time)
 		}
 	} else if (prevTime != EmuTime::infinity()) {
 		duration = time - prevTime;
-		aviWriter->setFps(narrow_cast<float>(1.0 / duration.toDouble()));
+		auto fps = narrow_cast<float>(1.0 / duration.toDouble());
+		if (aviWriter) aviWriter->setFps(fps);
+		if (pipeWriter) pipeWriter->setFps(fps);
 	}
 	prevTime = time;
 
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, audioBuf);
+	if (aviWriter) {
+		aviWriter->addFrame(frame, audioBuf);
+	} else {
+		assert(pipeWriter);
+		pipeWriter->addFrame(frame, audioBuf);
+	}
 	audioBuf.clear();
 }
 
@@ -215,6 +235,7 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	bool recordStereo = false;
 	bool doubleSize   = false;
 	bool tripleSize   = false;
+	bool pipe         = false;
 	std::array info = {
 		valueArg("-prefix", prefix),
 		flagArg("-audioonly", audioOnly),
@@ -223,6 +244,7 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 		flagArg("-stereo",    recordStereo),
 		flagArg("-doublesize", doubleSize),
 		flagArg("-triplesize", tripleSize),
+		flagArg("-pipe",      pipe),
 	};
 	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
 
@@ -238,6 +260,9 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	if (videoOnly && (recordStereo || recordMono)) {
 		throw CommandException("Can't have both -videoonly and -stereo or -mono.");
 	}
+	if (pipe && audioOnly) {
+		throw CommandException("Can't have both -pipe and -audioonly.");
+	}
 	std::string_view filenameArg;
 	switch (arguments.size()) {
 	case 0:
@@ -262,14 +287,17 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	bool recordAudio = !videoOnly;
 	bool recordVideo = !audioOnly;
 	std::string_view directory = recordVideo ? VIDEO_DIR : AUDIO_DIR;
-	std::string_view extension = recordVideo ? VIDEO_EXTENSION : AUDIO_EXTENSION;
+	std::string_view extension = !recordVideo ? AUDIO_EXTENSION
+	                           : !pipe        ? VIDEO_EXTENSION
+	                           : recordAudio  ? RAW_EXTENSION
+	                                          : Y4M_EXTENSION;
 	auto filename = FileOperations::parseCommandFileArgument(
 		filenameArg, directory, prefix, extension);
 
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		result = "Already recording.";
 	} else {
-		start(recordAudio, recordVideo, recordMono, recordStereo, filename);
+		start(recordAudio, recordVideo, recordMono, recordStereo, pipe, filename);
 		result = tmpStrCat("Recording to ", filename);
 	}
 }
@@ -281,7 +309,7 @@ void AviRecorder::processStop(std::span<const TclObject> /*tokens*/)
 
 void AviRecorder::processToggle(Interpreter& interp, std::span<const TclObject> tokens, TclObject& result)
 {
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		// drop extra tokens
 		processStop(tokens.first<2>());
 	} else {
@@ -291,7 +319,7 @@ void AviRecorder::processToggle(Interpreter& interp, std::span<const TclObject>
 
 bool AviRecorder::isRecording() const
 {
-	return aviWriter || wavWriter;
+	return aviWriter || pipeWriter || wavWriter;
 }
 
 void AviRecorder::status(std::span<const TclObject> /*tokens*/, TclObject& result) const
@@ -334,9 +362,13 @@ std::string AviRecorder::Cmd::help(std::span<const TclObject> /*tokens*/) const
 	       "record status             Query recording state\n"
 	       "\n"
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
-	       " -mono, -stereo, -doublesize, -triplesize flag.\n"
+	       " -mono, -stereo, -doublesize, -triplesize, -pipe flag.\n"
 	       "Videos are recorded in a 320x240 size by default, at 640x480 when the "
-	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.";
+	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.\n"
+	       "With -pipe, uncompressed frames are streamed to the given file, "
+	       "typically a named pipe read by an external encoder: YUV4MPEG2 (.y4m) "
+	       "together with -videoonly, otherwise raw RGBA frames interleaved "
+	       "with 16-bit PCM audio (.raw).";
 }
 
 void AviRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
@@ -351,7 +383,7 @@ void AviRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
 		static constexpr std::array options = {
 			"-prefix"sv, "-videoonly"sv, "-audioonly"sv,
 			"-doublesize"sv, "-triplesize"sv,
-			"-mono"sv, "-stereo"sv,
+			"-mono"sv, "-stereo"sv, "-pipe"sv,
 		};
 		completeFileName(tokens, userFileContext(), options);
 	}
@@ -18,6 +18,7 @@ class AviWriter;
 class FrameSource;
 class Interpreter;
 class MSXMixer;
+class PipeWriter;
 class PostProcessor;
 class Reactor;
 class TclObject;
@@ -30,6 +31,8 @@ public:
 	static constexpr std::string_view AUDIO_DIR = "soundlogs";
 	static constexpr std::string_view VIDEO_EXTENSION = ".avi";
 	static constexpr std::string_view AUDIO_EXTENSION = ".wav";
+	static constexpr std::string_view Y4M_EXTENSION = ".y4m";
+	static constexpr std::string_view RAW_EXTENSION = ".raw";
 
 public:
 	explicit AviRecorder(Reactor& reactor);
@@ -43,7 +46,7 @@ public:
 
 private:
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
-		   bool recordStereo, const std::string& filename);
+		   bool recordStereo, bool pipe, const std::string& filename);
 	void status(std::span<const TclObject> tokens, TclObject& result) const;
 
 	void processStart (Interpreter& interp, std::span<const TclObject> tokens, TclObject& result);
@@ -61,8 +64,9 @@ private:
 	} recordCommand;
 
 	std::vector<int16_t> audioBuf;
-	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
-	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
+	std::unique_ptr<AviWriter>   aviWriter;  // can be nullptr
+	std::unique_ptr<PipeWriter>  pipeWriter; // can be nullptr
+	std::unique_ptr<Wav16Writer> wavWriter;  // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
 	MSXMixer* mixer = nullptr;
 	EmuDuration duration = EmuDuration::infinity();
@@ -278,6 +278,9 @@ void AviWriter::addFrame(const FrameSource* video, std::span<const int16_t> audi
 {
 	bool keyFrame = (frames++ % 300 == 0);
 	auto buffer = codec.compressFrame(keyFrame, video);
+	// An unchanged frame gives an empty buffer. It's still written (as a
+	// zero-length chunk), players then repeat the previous frame. This
+	// keeps audio and video in sync.
 	addAviChunk(subspan<4>("00dc"), buffer, keyFrame ? 0x10 : 0x0);
 
 	if (!audio.empty()) {
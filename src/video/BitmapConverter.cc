@@ -3,13 +3,20 @@
 #include "endian.hh"
 #include "narrow.hh"
 #include "ranges.hh"
+#include "simd.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
 
 #include <algorithm>
+#include <array>
 #include <bit>
+#include <cassert>
 #include <tuple>
 
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
 namespace openmsx {
 
 BitmapConverter::BitmapConverter(
@@ -25,16 +32,7 @@ BitmapConverter::BitmapConverter(
 void BitmapConverter::calcDPalette()
 {
 	dPaletteValid = true;
-	unsigned bits = sizeof(Pixel) * 8;
-	for (auto i : xrange(16)) {
-		DPixel p0 = palette16[i];
-		for (auto j : xrange(16)) {
-			DPixel p1 = palette16[j];
-			DPixel dp = Endian::BIG ? (p0 << bits) | p1
-			                        : (p1 << bits) | p0;
-			dPalette[16 * i + j] = dp;
-		}
-	}
+	BitmapKernels::calcDPalette(palette16, dPalette);
 }
 
 void BitmapConverter::convertLine(std::span<Pixel> buf, std::span<const uint8_t, 128> vramPtr)
@@ -109,110 +107,390 @@ void BitmapConverter::renderGraphic4(
 	std::span<Pixel, 256> buf,
 	std::span<const uint8_t, 128> vramPtr0)
 {
-	/*for (unsigned i = 0; i < 128; i += 2) {
-		unsigned data0 = vramPtr0[i + 0];
-		unsigned data1 = vramPtr0[i + 1];
-		buf[2 * i + 0] = palette16[data0 >> 4];
-		buf[2 * i + 1] = palette16[data0 & 15];
-		buf[2 * i + 2] = palette16[data1 >> 4];
-		buf[2 * i + 3] = palette16[data1 & 15];
-	}*/
+#ifdef SIMD_SSSE3
+	if (SIMD::hasSSSE3()) {
+		BitmapKernels::renderGraphic4SSSE3(palette16, vramPtr0, buf);
+		return;
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	BitmapKernels::renderGraphic4NEON(palette16, vramPtr0, buf);
+	return;
+#endif
+	if (!dPaletteValid) [[unlikely]] {
+		calcDPalette();
+	}
+	BitmapKernels::renderGraphic4(dPalette, vramPtr0, buf);
+}
 
+void BitmapConverter::renderGraphic5(
+	std::span<Pixel, 512> buf,
+	std::span<const uint8_t, 128> vramPtr0) const
+{
+#ifdef SIMD_SSSE3
+	if (SIMD::hasSSSE3()) {
+		BitmapKernels::renderGraphic5SSSE3(palette16, vramPtr0, buf);
+		return;
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	BitmapKernels::renderGraphic5NEON(palette16, vramPtr0, buf);
+	return;
+#endif
+	BitmapKernels::renderGraphic5(palette16, vramPtr0, buf);
+}
+
+void BitmapConverter::renderGraphic6(
+	std::span<Pixel, 512> buf,
+	std::span<const uint8_t, 128> vramPtr0,
+	std::span<const uint8_t, 128> vramPtr1)
+{
+#ifdef SIMD_SSSE3
+	if (SIMD::hasSSSE3()) {
+		BitmapKernels::renderGraphic6SSSE3(palette16, vramPtr0, vramPtr1, buf);
+		return;
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	BitmapKernels::renderGraphic6NEON(palette16, vramPtr0, vramPtr1, buf);
+	return;
+#endif
 	if (!dPaletteValid) [[unlikely]] {
 		calcDPalette();
 	}
+	BitmapKernels::renderGraphic6(dPalette, vramPtr0, vramPtr1, buf);
+}
+
+void BitmapConverter::renderGraphic7(
+	std::span<Pixel, 256> buf,
+	std::span<const uint8_t, 128> vramPtr0,
+	std::span<const uint8_t, 128> vramPtr1) const
+{
+#ifdef SIMD_AVX2
+	if (SIMD::hasAVX2()) {
+		BitmapKernels::renderGraphic7AVX2(palette256, vramPtr0, vramPtr1, buf);
+		return;
+	}
+#endif
+	BitmapKernels::renderGraphic7(palette256, vramPtr0, vramPtr1, buf);
+}
+
+void BitmapConverter::renderYJK(
+	std::span<Pixel, 256> buf,
+	std::span<const uint8_t, 128> vramPtr0,
+	std::span<const uint8_t, 128> vramPtr1) const
+{
+#ifdef SIMD_AVX2
+	if (SIMD::hasAVX2()) {
+		BitmapKernels::renderYJKAVX2(palette32768, vramPtr0, vramPtr1, buf);
+		return;
+	}
+#endif
+#ifdef __SSE2__
+	BitmapKernels::renderYJKSSE2(palette32768, vramPtr0, vramPtr1, buf);
+#else
+	BitmapKernels::renderYJK(palette32768, vramPtr0, vramPtr1, buf);
+#endif
+}
+
+void BitmapConverter::renderYAE(
+	std::span<Pixel, 256> buf,
+	std::span<const uint8_t, 128> vramPtr0,
+	std::span<const uint8_t, 128> vramPtr1) const
+{
+#ifdef SIMD_AVX2
+	if (SIMD::hasAVX2()) {
+		BitmapKernels::renderYAEAVX2(palette16, palette32768, vramPtr0, vramPtr1, buf);
+		return;
+	}
+#endif
+#ifdef __SSE2__
+	BitmapKernels::renderYAESSE2(palette16, palette32768, vramPtr0, vramPtr1, buf);
+#else
+	BitmapKernels::renderYAE(palette16, palette32768, vramPtr0, vramPtr1, buf);
+#endif
+}
+
+void BitmapConverter::renderBogus(std::span<Pixel, 256> buf) const
+{
+	// Verified on real V9958: all bogus modes behave like this, always
+	// show palette color 15.
+	// When this is in effect, the VRAM is not refreshed anymore, but that
+	// is not emulated.
+	std::ranges::fill(buf, palette16[15]);
+}
 
-	Pixel* __restrict pixelPtr = buf.data();
-	      auto* out = std::bit_cast<DPixel*>(pixelPtr);
-	const auto* in  = std::bit_cast<const unsigned*>(vramPtr0.data());
+namespace BitmapKernels {
+
+void calcDPalette(std::span<const Pixel, 16 * 2> palette16, std::span<DPixel, 16 * 16> dPalette)
+{
+	unsigned bits = sizeof(Pixel) * 8;
+	for (auto i : xrange(16)) {
+		DPixel p0 = palette16[i];
+		for (auto j : xrange(16)) {
+			DPixel p1 = palette16[j];
+			DPixel dp = Endian::BIG ? (p0 << bits) | p1
+			                        : (p1 << bits) | p0;
+			dPalette[16 * i + j] = dp;
+		}
+	}
+}
+
+void renderGraphic4(std::span<const DPixel, 16 * 16> dPalette, VRAMLine vram0, std::span<Pixel, 256> out)
+{
+	/*for (unsigned i = 0; i < 128; i += 2) {
+		unsigned data0 = vram0[i + 0];
+		unsigned data1 = vram0[i + 1];
+		out[2 * i + 0] = palette16[data0 >> 4];
+		out[2 * i + 1] = palette16[data0 & 15];
+		out[2 * i + 2] = palette16[data1 >> 4];
+		out[2 * i + 3] = palette16[data1 & 15];
+	}*/
+	      auto* dOut = std::bit_cast<DPixel*>(out.data());
+	const auto* in   = std::bit_cast<const unsigned*>(vram0.data());
 	for (auto i : xrange(256 / 8)) {
 		// 8 pixels per iteration
 		unsigned data = in[i];
 		if constexpr (Endian::BIG) {
-			out[4 * i + 0] = dPalette[(data >> 24) & 0xFF];
-			out[4 * i + 1] = dPalette[(data >> 16) & 0xFF];
-			out[4 * i + 2] = dPalette[(data >>  8) & 0xFF];
-			out[4 * i + 3] = dPalette[(data >>  0) & 0xFF];
+			dOut[4 * i + 0] = dPalette[(data >> 24) & 0xFF];
+			dOut[4 * i + 1] = dPalette[(data >> 16) & 0xFF];
+			dOut[4 * i + 2] = dPalette[(data >>  8) & 0xFF];
+			dOut[4 * i + 3] = dPalette[(data >>  0) & 0xFF];
 		} else {
-			out[4 * i + 0] = dPalette[(data >>  0) & 0xFF];
-			out[4 * i + 1] = dPalette[(data >>  8) & 0xFF];
-			out[4 * i + 2] = dPalette[(data >> 16) & 0xFF];
-			out[4 * i + 3] = dPalette[(data >> 24) & 0xFF];
+			dOut[4 * i + 0] = dPalette[(data >>  0) & 0xFF];
+			dOut[4 * i + 1] = dPalette[(data >>  8) & 0xFF];
+			dOut[4 * i + 2] = dPalette[(data >> 16) & 0xFF];
+			dOut[4 * i + 3] = dPalette[(data >> 24) & 0xFF];
 		}
 	}
 }
 
-void BitmapConverter::renderGraphic5(
-	std::span<Pixel, 512> buf,
-	std::span<const uint8_t, 128> vramPtr0) const
+void renderGraphic5(std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 512> out)
 {
-	Pixel* __restrict pixelPtr = buf.data();
 	for (auto i : xrange(128)) {
-		unsigned data = vramPtr0[i];
-		pixelPtr[4 * i + 0] = palette16[ 0 +  (data >> 6)     ];
-		pixelPtr[4 * i + 1] = palette16[16 + ((data >> 4) & 3)];
-		pixelPtr[4 * i + 2] = palette16[ 0 + ((data >> 2) & 3)];
-		pixelPtr[4 * i + 3] = palette16[16 + ((data >> 0) & 3)];
+		unsigned data = vram0[i];
+		out[4 * i + 0] = palette16[ 0 +  (data >> 6)     ];
+		out[4 * i + 1] = palette16[16 + ((data >> 4) & 3)];
+		out[4 * i + 2] = palette16[ 0 + ((data >> 2) & 3)];
+		out[4 * i + 3] = palette16[16 + ((data >> 0) & 3)];
 	}
 }
 
-void BitmapConverter::renderGraphic6(
-	std::span<Pixel, 512> buf,
-	std::span<const uint8_t, 128> vramPtr0,
-	std::span<const uint8_t, 128> vramPtr1)
+void renderGraphic6(std::span<const DPixel, 16 * 16> dPalette, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 512> out)
 {
-	Pixel* __restrict pixelPtr = buf.data();
 	/*for (auto i : xrange(128)) {
-		unsigned data0 = vramPtr0[i];
-		unsigned data1 = vramPtr1[i];
-		pixelPtr[4 * i + 0] = palette16[data0 >> 4];
-		pixelPtr[4 * i + 1] = palette16[data0 & 15];
-		pixelPtr[4 * i + 2] = palette16[data1 >> 4];
-		pixelPtr[4 * i + 3] = palette16[data1 & 15];
+		unsigned data0 = vram0[i];
+		unsigned data1 = vram1[i];
+		out[4 * i + 0] = palette16[data0 >> 4];
+		out[4 * i + 1] = palette16[data0 & 15];
+		out[4 * i + 2] = palette16[data1 >> 4];
+		out[4 * i + 3] = palette16[data1 & 15];
 	}*/
-	if (!dPaletteValid) [[unlikely]] {
-		calcDPalette();
-	}
-	      auto* out = std::bit_cast<DPixel*>(pixelPtr);
-	const auto* in0 = std::bit_cast<const unsigned*>(vramPtr0.data());
-	const auto* in1 = std::bit_cast<const unsigned*>(vramPtr1.data());
+	      auto* dOut = std::bit_cast<DPixel*>(out.data());
+	const auto* in0  = std::bit_cast<const unsigned*>(vram0.data());
+	const auto* in1  = std::bit_cast<const unsigned*>(vram1.data());
 	for (auto i : xrange(512 / 16)) {
 		// 16 pixels per iteration
 		unsigned data0 = in0[i];
 		unsigned data1 = in1[i];
 		if constexpr (Endian::BIG) {
-			out[8 * i + 0] = dPalette[(data0 >> 24) & 0xFF];
-			out[8 * i + 1] = dPalette[(data1 >> 24) & 0xFF];
-			out[8 * i + 2] = dPalette[(data0 >> 16) & 0xFF];
-			out[8 * i + 3] = dPalette[(data1 >> 16) & 0xFF];
-			out[8 * i + 4] = dPalette[(data0 >>  8) & 0xFF];
-			out[8 * i + 5] = dPalette[(data1 >>  8) & 0xFF];
-			out[8 * i + 6] = dPalette[(data0 >>  0) & 0xFF];
-			out[8 * i + 7] = dPalette[(data1 >>  0) & 0xFF];
+			dOut[8 * i + 0] = dPalette[(data0 >> 24) & 0xFF];
+			dOut[8 * i + 1] = dPalette[(data1 >> 24) & 0xFF];
+			dOut[8 * i + 2] = dPalette[(data0 >> 16) & 0xFF];
+			dOut[8 * i + 3] = dPalette[(data1 >> 16) & 0xFF];
+			dOut[8 * i + 4] = dPalette[(data0 >>  8) & 0xFF];
+			dOut[8 * i + 5] = dPalette[(data1 >>  8) & 0xFF];
+			dOut[8 * i + 6] = dPalette[(data0 >>  0) & 0xFF];
+			dOut[8 * i + 7] = dPalette[(data1 >>  0) & 0xFF];
 		} else {
-			out[8 * i + 0] = dPalette[(data0 >>  0) & 0xFF];
-			out[8 * i + 1] = dPalette[(data1 >>  0) & 0xFF];
-			out[8 * i + 2] = dPalette[(data0 >>  8) & 0xFF];
-			out[8 * i + 3] = dPalette[(data1 >>  8) & 0xFF];
-			out[8 * i + 4] = dPalette[(data0 >> 16) & 0xFF];
-			out[8 * i + 5] = dPalette[(data1 >> 16) & 0xFF];
-			out[8 * i + 6] = dPalette[(data0 >> 24) & 0xFF];
-			out[8 * i + 7] = dPalette[(data1 >> 24) & 0xFF];
+			dOut[8 * i + 0] = dPalette[(data0 >>  0) & 0xFF];
+			dOut[8 * i + 1] = dPalette[(data1 >>  0) & 0xFF];
+			dOut[8 * i + 2] = dPalette[(data0 >>  8) & 0xFF];
+			dOut[8 * i + 3] = dPalette[(data1 >>  8) & 0xFF];
+			dOut[8 * i + 4] = dPalette[(data0 >> 16) & 0xFF];
+			dOut[8 * i + 5] = dPalette[(data1 >> 16) & 0xFF];
+			dOut[8 * i + 6] = dPalette[(data0 >> 24) & 0xFF];
+			dOut[8 * i + 7] = dPalette[(data1 >> 24) & 0xFF];
 		}
 	}
 }
 
-void BitmapConverter::renderGraphic7(
-	std::span<Pixel, 256> buf,
-	std::span<const uint8_t, 128> vramPtr0,
-	std::span<const uint8_t, 128> vramPtr1) const
+void renderGraphic7(std::span<const Pixel, 256> palette256, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out)
 {
-	Pixel* __restrict pixelPtr = buf.data();
 	for (auto i : xrange(128)) {
-		pixelPtr[2 * i + 0] = palette256[vramPtr0[i]];
-		pixelPtr[2 * i + 1] = palette256[vramPtr1[i]];
+		out[2 * i + 0] = palette256[vram0[i]];
+		out[2 * i + 1] = palette256[vram1[i]];
+	}
+}
+
+#if defined(SIMD_SSSE3) || (defined(__ARM_NEON) && defined(__aarch64__))
+// Even pixels in Graphic5 use palette entries 0-3, odd pixels use entries
+// 16-19, combine those in a single table: odd pixels get index 4-7.
+[[nodiscard]] static std::array<Pixel, 8> graphic5Palette(std::span<const Pixel, 16 * 2> palette16)
+{
+	return {palette16[ 0], palette16[ 1], palette16[ 2], palette16[ 3],
+	        palette16[16], palette16[17], palette16[18], palette16[19]};
+}
+#endif
+
+#ifdef SIMD_SSSE3
+using SIMD::PalettePlanes;
+using SIMD::loadPlanes;
+using SIMD::lookup16;
+
+// Write the 32 pixels corresponding to 16 bytes with each 2 4-bit palette
+// indices (high nibble is the left pixel).
+static inline SIMD_TARGET("ssse3") void lookupNibbles(const PalettePlanes& planes, __m128i in, Pixel* out)
+{
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+	__m128i lo = _mm_and_si128(in, mask);
+	lookup16(planes, _mm_unpacklo_epi8(hi, lo), out +  0);
+	lookup16(planes, _mm_unpackhi_epi8(hi, lo), out + 16);
+}
+
+// SSSE3 version, 32 pixels per iteration
+SIMD_TARGET("ssse3") void renderGraphic4SSSE3(
+	std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 256> out)
+{
+	auto planes = loadPlanes(palette16.first<16>());
+	const auto* vram = std::bit_cast<const __m128i*>(vram0.data());
+	for (auto i : xrange(128 / 16)) {
+		lookupNibbles(planes, _mm_loadu_si128(vram + i), out.data() + 32 * i);
+	}
+}
+
+// SSSE3 version, 64 pixels per iteration
+SIMD_TARGET("ssse3") void renderGraphic5SSSE3(
+	std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 512> out)
+{
+	auto planes = loadPlanes(graphic5Palette(palette16));
+	const __m128i mask = _mm_set1_epi8(3);
+	const __m128i odd  = _mm_set1_epi8(4);
+	const auto* vram = std::bit_cast<const __m128i*>(vram0.data());
+	for (auto i : xrange(128 / 16)) {
+		__m128i data = _mm_loadu_si128(vram + i);
+		__m128i p0 = _mm_and_si128(_mm_srli_epi16(data, 6), mask);
+		__m128i p1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(data, 4), mask), odd);
+		__m128i p2 = _mm_and_si128(_mm_srli_epi16(data, 2), mask);
+		__m128i p3 = _mm_or_si128(_mm_and_si128(data, mask), odd);
+		__m128i p01l = _mm_unpacklo_epi8(p0, p1);
+		__m128i p01h = _mm_unpackhi_epi8(p0, p1);
+		__m128i p23l = _mm_unpacklo_epi8(p2, p3);
+		__m128i p23h = _mm_unpackhi_epi8(p2, p3);
+		Pixel* o = out.data() + 64 * i;
+		lookup16(planes, _mm_unpacklo_epi16(p01l, p23l), o +  0);
+		lookup16(planes, _mm_unpackhi_epi16(p01l, p23l), o + 16);
+		lookup16(planes, _mm_unpacklo_epi16(p01h, p23h), o + 32);
+		lookup16(planes, _mm_unpackhi_epi16(p01h, p23h), o + 48);
+	}
+}
+
+// SSSE3 version, 64 pixels per iteration
+SIMD_TARGET("ssse3") void renderGraphic6SSSE3(
+	std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 512> out)
+{
+	auto planes = loadPlanes(palette16.first<16>());
+	const auto* in0 = std::bit_cast<const __m128i*>(vram0.data());
+	const auto* in1 = std::bit_cast<const __m128i*>(vram1.data());
+	for (auto i : xrange(128 / 16)) {
+		__m128i data0 = _mm_loadu_si128(in0 + i);
+		__m128i data1 = _mm_loadu_si128(in1 + i);
+		lookupNibbles(planes, _mm_unpacklo_epi8(data0, data1), out.data() + 64 * i +  0);
+		lookupNibbles(planes, _mm_unpackhi_epi8(data0, data1), out.data() + 64 * i + 32);
 	}
 }
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+[[nodiscard]] static uint8x16x4_t loadPlanes(std::span<const Pixel> palette)
+{
+	auto planes = SIMD::splitPalette(palette);
+	return {{vld1q_u8(planes[0].data()), vld1q_u8(planes[1].data()),
+	         vld1q_u8(planes[2].data()), vld1q_u8(planes[3].data())}};
+}
+
+// Write the 16 pixels corresponding to the 16 (4-bit) palette indices in 'idx'.
+static inline void lookup16(const uint8x16x4_t& planes, uint8x16_t idx, Pixel* out)
+{
+	uint8x16x4_t bytes = {{vqtbl1q_u8(planes.val[0], idx), vqtbl1q_u8(planes.val[1], idx),
+	                       vqtbl1q_u8(planes.val[2], idx), vqtbl1q_u8(planes.val[3], idx)}};
+	vst4q_u8(std::bit_cast<uint8_t*>(out), bytes); // interleaves the planes
+}
+
+// Write the 32 pixels corresponding to 16 bytes with each 2 4-bit palette
+// indices (high nibble is the left pixel).
+static inline void lookupNibbles(const uint8x16x4_t& planes, uint8x16_t in, Pixel* out)
+{
+	uint8x16x2_t idx = vzipq_u8(vshrq_n_u8(in, 4), vandq_u8(in, vdupq_n_u8(0x0F)));
+	lookup16(planes, idx.val[0], out +  0);
+	lookup16(planes, idx.val[1], out + 16);
+}
+
+// NEON version, 32 pixels per iteration
+void renderGraphic4NEON(
+	std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 256> out)
+{
+	auto planes = loadPlanes(palette16.first<16>());
+	for (auto i : xrange(128 / 16)) {
+		lookupNibbles(planes, vld1q_u8(vram0.data() + 16 * i), out.data() + 32 * i);
+	}
+}
+
+// NEON version, 64 pixels per iteration, see renderGraphic5SSSE3().
+void renderGraphic5NEON(
+	std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 512> out)
+{
+	auto planes = loadPlanes(graphic5Palette(palette16));
+	const uint8x16_t mask = vdupq_n_u8(3);
+	const uint8x16_t odd  = vdupq_n_u8(4);
+	for (auto i : xrange(128 / 16)) {
+		uint8x16_t data = vld1q_u8(vram0.data() + 16 * i);
+		uint8x16_t p0 = vshrq_n_u8(data, 6);
+		uint8x16_t p1 = vorrq_u8(vandq_u8(vshrq_n_u8(data, 4), mask), odd);
+		uint8x16_t p2 = vandq_u8(vshrq_n_u8(data, 2), mask);
+		uint8x16_t p3 = vorrq_u8(vandq_u8(data, mask), odd);
+		uint8x16x2_t p01 = vzipq_u8(p0, p1);
+		uint8x16x2_t p23 = vzipq_u8(p2, p3);
+		uint16x8x2_t lo = vzipq_u16(vreinterpretq_u16_u8(p01.val[0]), vreinterpretq_u16_u8(p23.val[0]));
+		uint16x8x2_t hi = vzipq_u16(vreinterpretq_u16_u8(p01.val[1]), vreinterpretq_u16_u8(p23.val[1]));
+		Pixel* o = out.data() + 64 * i;
+		lookup16(planes, vreinterpretq_u8_u16(lo.val[0]), o +  0);
+		lookup16(planes, vreinterpretq_u8_u16(lo.val[1]), o + 16);
+		lookup16(planes, vreinterpretq_u8_u16(hi.val[0]), o + 32);
+		lookup16(planes, vreinterpretq_u8_u16(hi.val[1]), o + 48);
+	}
+}
+
+// NEON version, 64 pixels per iteration
+void renderGraphic6NEON(
+	std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 512> out)
+{
+	auto planes = loadPlanes(palette16.first<16>());
+	for (auto i : xrange(128 / 16)) {
+		uint8x16x2_t data = vzipq_u8(vld1q_u8(vram0.data() + 16 * i),
+		                             vld1q_u8(vram1.data() + 16 * i));
+		lookupNibbles(planes, data.val[0], out.data() + 64 * i +  0);
+		lookupNibbles(planes, data.val[1], out.data() + 64 * i + 32);
+	}
+}
+#endif
+
+#ifdef SIMD_AVX2
+// AVX2 version, 16 pixels per iteration
+SIMD_TARGET("avx2") void renderGraphic7AVX2(
+	std::span<const Pixel, 256> palette256, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out)
+{
+	const auto* pal = std::bit_cast<const int*>(palette256.data());
+	auto* o = std::bit_cast<__m256i*>(out.data());
+	for (auto i : xrange(128 / 8)) {
+		__m128i data0 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(vram0.data() + 8 * i));
+		__m128i data1 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(vram1.data() + 8 * i));
+		__m128i idx = _mm_unpacklo_epi8(data0, data1);
+		__m256i idx0 = _mm256_cvtepu8_epi32(idx);
+		__m256i idx1 = _mm256_cvtepu8_epi32(_mm_srli_si128(idx, 8));
+		_mm256_storeu_si256(o + 2 * i + 0, _mm256_i32gather_epi32(pal, idx0, 4));
+		_mm256_storeu_si256(o + 2 * i + 1, _mm256_i32gather_epi32(pal, idx1, 4));
+	}
+}
+#endif
 
 static constexpr std::tuple<int, int, int> yjk2rgb(int y, int j, int k)
 {
@@ -227,18 +505,153 @@ static constexpr std::tuple<int, int, int> yjk2rgb(int y, int j, int k)
 	return {r, g, b};
 }
 
-void BitmapConverter::renderYJK(
-	std::span<Pixel, 256> buf,
-	std::span<const uint8_t, 128> vramPtr0,
-	std::span<const uint8_t, 128> vramPtr1) const
+#ifdef __SSE2__
+// Calculate the palette32768 index for 8 pixels (2 groups of 4) in YJK mode.
+// 'p' contains the VRAM bytes of those pixels, zero-extended to 16 bits.
+// This is the same calculation as yjk2rgb().
+[[nodiscard]] static inline __m128i yjkIndex(__m128i p)
+{
+	// k is calculated from the first two pixels of a group, j from the
+	// last two: (p0 & 7) + ((p1 & 3) << 3) - ((p1 & 4) << 3)
+	const __m128i oddLanes = _mm_set_epi16(-1, 0, -1, 0, -1, 0, -1, 0);
+	__m128i lowBits  = _mm_and_si128(p, _mm_set1_epi16(7));
+	__m128i highBits = _mm_sub_epi16(
+		_mm_slli_epi16(_mm_and_si128(p, _mm_set1_epi16(3)), 3),
+		_mm_slli_epi16(_mm_and_si128(p, _mm_set1_epi16(4)), 3));
+	__m128i sums = _mm_madd_epi16(SIMD::select(lowBits, highBits, oddLanes),
+	                              _mm_set1_epi16(1)); // k0 j0 k1 j1 (32-bit)
+	sums = _mm_packs_epi32(sums, sums);
+	__m128i dup = _mm_unpacklo_epi16(sums, sums); // k0 k0 j0 j0 k1 k1 j1 j1
+	__m128i k = _mm_shuffle_epi32(dup, 0xA0); // k0 (4x) k1 (4x)
+	__m128i j = _mm_shuffle_epi32(dup, 0xF5); // j0 (4x) j1 (4x)
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(31);
+	auto clamp = [&](__m128i x) { return _mm_min_epi16(_mm_max_epi16(x, zero), max); };
+	__m128i y = _mm_srli_epi16(p, 3);
+	__m128i r = clamp(_mm_add_epi16(y, j));
+	__m128i g = clamp(_mm_add_epi16(y, k));
+	// (5 * y - 2 * j - k + 2) / 4: the arithmetic shift rounds negative
+	// values differently than the division, but those get clamped to 0 anyway.
+	__m128i y5 = _mm_add_epi16(y, _mm_slli_epi16(y, 2));
+	__m128i b = clamp(_mm_srai_epi16(
+		_mm_add_epi16(_mm_sub_epi16(_mm_sub_epi16(y5, _mm_add_epi16(j, j)), k),
+		              _mm_set1_epi16(2)), 2));
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 10), _mm_slli_epi16(g, 5)), b);
+}
+
+// Load 16 YJK/YAE pixels: 8 bytes from each VRAM plane, interleaved and
+// zero-extended to 16 bits.
+struct YJKPixels {
+	__m128i lo, hi;
+};
+[[nodiscard]] static inline YJKPixels loadYJK(VRAMLine vram0, VRAMLine vram1, unsigned i)
+{
+	__m128i data0 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(vram0.data() + 8 * i));
+	__m128i data1 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(vram1.data() + 8 * i));
+	__m128i p = _mm_unpacklo_epi8(data0, data1);
+	const __m128i zero = _mm_setzero_si128();
+	return {_mm_unpacklo_epi8(p, zero), _mm_unpackhi_epi8(p, zero)};
+}
+
+// SSE2 version, 16 pixels per iteration. Only the index calculation is
+// vectorized, the palette lookups are scalar.
+void renderYJKSSE2(std::span<const Pixel, 32768> palette32768, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out)
+{
+	Pixel* pixelPtr = out.data();
+	auto convert8 = [&](__m128i p, Pixel* o) {
+		alignas(16) std::array<uint16_t, 8> idx;
+		_mm_store_si128(std::bit_cast<__m128i*>(idx.data()), yjkIndex(p));
+		for (auto n : xrange(8)) {
+			o[n] = palette32768[idx[n]];
+		}
+	};
+	for (auto i : xrange(128 / 8)) {
+		auto [p0, p1] = loadYJK(vram0, vram1, i);
+		convert8(p0, pixelPtr + 16 * i + 0);
+		convert8(p1, pixelPtr + 16 * i + 8);
+	}
+}
+
+void renderYAESSE2(std::span<const Pixel, 16 * 2> palette16, std::span<const Pixel, 32768> palette32768,
+                   VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out)
+{
+	Pixel* pixelPtr = out.data();
+	auto convert8 = [&](__m128i p, Pixel* o) {
+		alignas(16) std::array<uint16_t, 8> idx;
+		alignas(16) std::array<uint16_t, 8> data;
+		_mm_store_si128(std::bit_cast<__m128i*>(idx.data()), yjkIndex(p));
+		_mm_store_si128(std::bit_cast<__m128i*>(data.data()), p);
+		for (auto n : xrange(8)) {
+			o[n] = (data[n] & 0x08) ? palette16[data[n] >> 4] // YAE
+			                        : palette32768[idx[n]];   // YJK
+		}
+	};
+	for (auto i : xrange(128 / 8)) {
+		auto [p0, p1] = loadYJK(vram0, vram1, i);
+		convert8(p0, pixelPtr + 16 * i + 0);
+		convert8(p1, pixelPtr + 16 * i + 8);
+	}
+}
+#endif
+
+#ifdef SIMD_AVX2
+// AVX2 version, 8 pixels, the palette lookups use a gather.
+static inline SIMD_TARGET("avx2") void yjk8AVX2(
+	std::span<const Pixel, 32768> palette32768, __m128i p, Pixel* out)
+{
+	const auto* pal = std::bit_cast<const int*>(palette32768.data());
+	_mm256_storeu_si256(std::bit_cast<__m256i*>(out),
+		_mm256_i32gather_epi32(pal, _mm256_cvtepu16_epi32(yjkIndex(p)), 4));
+}
+
+SIMD_TARGET("avx2") void renderYJKAVX2(
+	std::span<const Pixel, 32768> palette32768, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out)
+{
+	Pixel* pixelPtr = out.data();
+	for (auto i : xrange(128 / 8)) {
+		auto [p0, p1] = loadYJK(vram0, vram1, i);
+		yjk8AVX2(palette32768, p0, pixelPtr + 16 * i + 0);
+		yjk8AVX2(palette32768, p1, pixelPtr + 16 * i + 8);
+	}
+}
+
+static inline SIMD_TARGET("avx2") void yae8AVX2(
+	std::span<const Pixel, 16 * 2> palette16, std::span<const Pixel, 32768> palette32768,
+	__m128i p, Pixel* out)
+{
+	const auto* pal = std::bit_cast<const int*>(palette32768.data());
+	const auto* pal16 = std::bit_cast<const int*>(palette16.data());
+	__m256i p32 = _mm256_cvtepu16_epi32(p);
+	__m256i yjk = _mm256_i32gather_epi32(pal, _mm256_cvtepu16_epi32(yjkIndex(p)), 4);
+	__m256i yae = _mm256_i32gather_epi32(pal16, _mm256_srli_epi32(p32, 4), 4);
+	__m256i isYae = _mm256_cmpeq_epi32(_mm256_and_si256(p32, _mm256_set1_epi32(8)),
+	                                   _mm256_set1_epi32(8));
+	_mm256_storeu_si256(std::bit_cast<__m256i*>(out),
+	                    _mm256_blendv_epi8(yjk, yae, isYae));
+}
+
+SIMD_TARGET("avx2") void renderYAEAVX2(
+	std::span<const Pixel, 16 * 2> palette16, std::span<const Pixel, 32768> palette32768,
+	VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out)
+{
+	Pixel* pixelPtr = out.data();
+	for (auto i : xrange(128 / 8)) {
+		auto [p0, p1] = loadYJK(vram0, vram1, i);
+		yae8AVX2(palette16, palette32768, p0, pixelPtr + 16 * i + 0);
+		yae8AVX2(palette16, palette32768, p1, pixelPtr + 16 * i + 8);
+	}
+}
+#endif
+
+void renderYJK(std::span<const Pixel, 32768> palette32768, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out)
 {
-	Pixel* __restrict pixelPtr = buf.data();
 	for (auto i : xrange(64)) {
 		std::array<unsigned, 4> p = {
-			vramPtr0[2 * i + 0],
-			vramPtr1[2 * i + 0],
-			vramPtr0[2 * i + 1],
-			vramPtr1[2 * i + 1],
+			vram0[2 * i + 0],
+			vram1[2 * i + 0],
+			vram0[2 * i + 1],
+			vram1[2 * i + 1],
 		};
 		int j = narrow<int>((p[2] & 7) + ((p[3] & 3) << 3)) - narrow<int>((p[3] & 4) << 3);
 		int k = narrow<int>((p[0] & 7) + ((p[1] & 3) << 3)) - narrow<int>((p[1] & 4) << 3);
@@ -247,23 +660,20 @@ void BitmapConverter::renderYJK(
 			int y = narrow<int>(p[n] >> 3);
 			auto [r, g, b] = yjk2rgb(y, j, k);
 			int col = (r << 10) + (g << 5) + b;
-			pixelPtr[4 * i + n] = palette32768[col];
+			out[4 * i + n] = palette32768[col];
 		}
 	}
 }
 
-void BitmapConverter::renderYAE(
-	std::span<Pixel, 256> buf,
-	std::span<const uint8_t, 128> vramPtr0,
-	std::span<const uint8_t, 128> vramPtr1) const
+void renderYAE(std::span<const Pixel, 16 * 2> palette16, std::span<const Pixel, 32768> palette32768,
+               VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out)
 {
-	Pixel* __restrict pixelPtr = buf.data();
 	for (auto i : xrange(64)) {
 		std::array<unsigned, 4> p = {
-			vramPtr0[2 * i + 0],
-			vramPtr1[2 * i + 0],
-			vramPtr0[2 * i + 1],
-			vramPtr1[2 * i + 1],
+			vram0[2 * i + 0],
+			vram1[2 * i + 0],
+			vram0[2 * i + 1],
+			vram1[2 * i + 1],
 		};
 		int j = narrow<int>((p[2] & 7) + ((p[3] & 3) << 3)) - narrow<int>((p[3] & 4) << 3);
 		int k = narrow<int>((p[0] & 7) + ((p[1] & 3) << 3)) - narrow<int>((p[1] & 4) << 3);
@@ -279,18 +689,11 @@ void BitmapConverter::renderYAE(
 				auto [r, g, b] = yjk2rgb(y, j, k);
 				pix = palette32768[(r << 10) + (g << 5) + b];
 			}
-			pixelPtr[4 * i + n] = pix;
+			out[4 * i + n] = pix;
 		}
 	}
 }
 
-void BitmapConverter::renderBogus(std::span<Pixel, 256> buf) const
-{
-	// Verified on real V9958: all bogus modes behave like this, always
-	// show palette color 15.
-	// When this is in effect, the VRAM is not refreshed anymore, but that
-	// is not emulated.
-	std::ranges::fill(buf, palette16[15]);
-}
+} // namespace BitmapKernels
 
 } // namespace openmsx
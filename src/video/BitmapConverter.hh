@@ -3,6 +3,8 @@
 
 #include "DisplayMode.hh"
 
+#include "simd.hh"
+
 #include <array>
 #include <cstdint>
 #include <span>
@@ -111,6 +113,56 @@ private:
 	bool dPaletteValid = false;
 };
 
+/** The individual implementations of the BitmapConverter routines.
+  * BitmapConverter picks the fastest one that the CPU supports. They're only
+  * exposed so that the unit test can check each of them.
+  */
+namespace BitmapKernels {
+
+using Pixel = BitmapConverter::Pixel;
+using DPixel = BitmapConverter::DPixel;
+using VRAMLine = std::span<const uint8_t, 128>;
+
+// C++ versions, these work on all CPUs. 'dPalette' maps a VRAM byte to two
+// pixels, see calcDPalette().
+void calcDPalette(std::span<const Pixel, 16 * 2> palette16, std::span<DPixel, 16 * 16> dPalette);
+void renderGraphic4(std::span<const DPixel, 16 * 16> dPalette, VRAMLine vram0, std::span<Pixel, 256> out);
+void renderGraphic5(std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 512> out);
+void renderGraphic6(std::span<const DPixel, 16 * 16> dPalette, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 512> out);
+void renderGraphic7(std::span<const Pixel, 256> palette256, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out);
+void renderYJK(std::span<const Pixel, 32768> palette32768, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out);
+void renderYAE(std::span<const Pixel, 16 * 2> palette16, std::span<const Pixel, 32768> palette32768,
+               VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out);
+
+#ifdef __SSE2__
+void renderYJKSSE2(std::span<const Pixel, 32768> palette32768, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out);
+void renderYAESSE2(std::span<const Pixel, 16 * 2> palette16, std::span<const Pixel, 32768> palette32768,
+                   VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out);
+#endif
+
+// Only call these when SIMD::hasSSSE3() returns true.
+#ifdef SIMD_SSSE3
+SIMD_TARGET("ssse3") void renderGraphic4SSSE3(std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 256> out);
+SIMD_TARGET("ssse3") void renderGraphic5SSSE3(std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 512> out);
+SIMD_TARGET("ssse3") void renderGraphic6SSSE3(std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 512> out);
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+void renderGraphic4NEON(std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 256> out);
+void renderGraphic5NEON(std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, std::span<Pixel, 512> out);
+void renderGraphic6NEON(std::span<const Pixel, 16 * 2> palette16, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 512> out);
+#endif
+
+// Only call these when SIMD::hasAVX2() returns true.
+#ifdef SIMD_AVX2
+SIMD_TARGET("avx2") void renderGraphic7AVX2(std::span<const Pixel, 256> palette256, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out);
+SIMD_TARGET("avx2") void renderYJKAVX2(std::span<const Pixel, 32768> palette32768, VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out);
+SIMD_TARGET("avx2") void renderYAEAVX2(std::span<const Pixel, 16 * 2> palette16, std::span<const Pixel, 32768> palette32768,
+                                       VRAMLine vram0, VRAMLine vram1, std::span<Pixel, 256> out);
+#endif
+
+} // namespace BitmapKernels
+
 } // namespace openmsx
 
 #endif
@@ -9,6 +9,7 @@ TODO:
 
 #include "CharacterConverter.hh"
 
+#include "PatternExpand.hh"
 #include "VDP.hh"
 #include "VDPVRAM.hh"
 
@@ -16,13 +17,9 @@ TODO:
 #include "xrange.hh"
 
 #include <algorithm>
-#include <bit>
+#include <array>
 #include <cstdint>
 
-#ifdef __SSE2__
-#include "emmintrin.h" // SSE2
-#endif
-
 namespace openmsx {
 
 using Pixel = CharacterConverter::Pixel;
@@ -84,61 +81,6 @@ void CharacterConverter::convertLine(std::span<Pixel> buf, int line) const
 	}
 }
 
-#ifdef __SSE2__
-// Copied from Scale2xScaler.cc, TODO move to common location?
-static inline __m128i select(__m128i a0, __m128i a1, __m128i mask)
-{
-	return _mm_xor_si128(_mm_and_si128(_mm_xor_si128(a0, a1), mask), a0);
-}
-#endif
-
-static inline void draw6(
-	Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, uint8_t pattern)
-{
-	pixelPtr[0] = (pattern & 0x80) ? fg : bg;
-	pixelPtr[1] = (pattern & 0x40) ? fg : bg;
-	pixelPtr[2] = (pattern & 0x20) ? fg : bg;
-	pixelPtr[3] = (pattern & 0x10) ? fg : bg;
-	pixelPtr[4] = (pattern & 0x08) ? fg : bg;
-	pixelPtr[5] = (pattern & 0x04) ? fg : bg;
-	pixelPtr += 6;
-}
-
-static inline void draw8(
-	Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, uint8_t pattern)
-{
-#ifdef __SSE2__
-	// SSE2 version, 32bpp
-	const __m128i m74 = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
-	const __m128i m30 = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
-	const __m128i zero = _mm_setzero_si128();
-
-	__m128i fg4 = _mm_set1_epi32(fg);
-	__m128i bg4 = _mm_set1_epi32(bg);
-	__m128i pat = _mm_set1_epi32(pattern);
-
-	__m128i b74 = _mm_cmpeq_epi32(_mm_and_si128(pat, m74), zero);
-	__m128i b30 = _mm_cmpeq_epi32(_mm_and_si128(pat, m30), zero);
-
-	auto* out = std::bit_cast<__m128i*>(pixelPtr);
-	_mm_storeu_si128(out + 0, select(fg4, bg4, b74));
-	_mm_storeu_si128(out + 1, select(fg4, bg4, b30));
-	pixelPtr += 8;
-	return;
-#endif
-
-	// C++ version
-	pixelPtr[0] = (pattern & 0x80) ? fg : bg;
-	pixelPtr[1] = (pattern & 0x40) ? fg : bg;
-	pixelPtr[2] = (pattern & 0x20) ? fg : bg;
-	pixelPtr[3] = (pattern & 0x10) ? fg : bg;
-	pixelPtr[4] = (pattern & 0x08) ? fg : bg;
-	pixelPtr[5] = (pattern & 0x04) ? fg : bg;
-	pixelPtr[6] = (pattern & 0x02) ? fg : bg;
-	pixelPtr[7] = (pattern & 0x01) ? fg : bg;
-	pixelPtr += 8;
-}
-
 void CharacterConverter::renderText1(std::span<Pixel, 256> buf, int line) const
 {
 	Pixel fg = palFg[vdp.getForegroundColor()];
@@ -152,13 +94,12 @@ void CharacterConverter::renderText1(std::span<Pixel, 256> buf, int line) const
 	//       from a VRAM pointer returned by readArea will not wrap the index
 	//       correctly. Therefore we read one character at a time.
 	unsigned nameStart = (line / 8) * 40;
-	unsigned nameEnd = nameStart + 40;
-	Pixel* __restrict pixelPtr = buf.data();
-	for (auto name : xrange(nameStart, nameEnd)) {
-		unsigned charCode = vram.nameTable.readNP((name + 0xC00) | (~0u << 12));
-		auto pattern = patternArea[l + charCode * 8];
-		draw6(pixelPtr, fg, bg, pattern);
+	std::array<uint8_t, 40> patterns;
+	for (auto i : xrange(40u)) {
+		unsigned charCode = vram.nameTable.readNP((nameStart + i + 0xC00) | (~0u << 12));
+		patterns[i] = patternArea[l + charCode * 8];
 	}
+	PatternExpand::drawText1(buf.data(), fg, bg, patterns);
 }
 
 void CharacterConverter::renderText1Q(std::span<Pixel, 256> buf, int line) const
@@ -172,16 +113,15 @@ void CharacterConverter::renderText1Q(std::span<Pixel, 256> buf, int line) const
 	//       from a VRAM pointer returned by readArea will not wrap the index
 	//       correctly. Therefore we read one character at a time.
 	unsigned nameStart = (line / 8) * 40;
-	unsigned nameEnd = nameStart + 40;
 	unsigned patternQuarter = (line & 0xC0) << 2;
-	Pixel* __restrict pixelPtr = buf.data();
-	for (auto name : xrange(nameStart, nameEnd)) {
-		unsigned charCode = vram.nameTable.readNP((name + 0xC00) | (~0u << 12));
+	std::array<uint8_t, 40> patterns;
+	for (auto i : xrange(40u)) {
+		unsigned charCode = vram.nameTable.readNP((nameStart + i + 0xC00) | (~0u << 12));
 		unsigned patternNr = patternQuarter | charCode;
-		auto pattern = vram.patternTable.readNP(
+		patterns[i] = vram.patternTable.readNP(
 			patternBaseLine | (patternNr * 8));
-		draw6(pixelPtr, fg, bg, pattern);
 	}
+	PatternExpand::drawText1(buf.data(), fg, bg, patterns);
 }
 
 void CharacterConverter::renderText2(std::span<Pixel, 512> buf, int line) const
@@ -204,45 +144,19 @@ void CharacterConverter::renderText2(std::span<Pixel, 512> buf, int line) const
 
 	unsigned colorStart = (line / 8) * (80 / 8);
 	unsigned nameStart  = (line / 8) * 80;
-	Pixel* __restrict pixelPtr = buf.data();
+	std::array<uint8_t, 80 / 8> attributes;
+	std::array<uint8_t, 80> patterns;
 	for (auto i : xrange(80 / 8)) {
-		unsigned colorPattern = vram.colorTable.readNP(
+		attributes[i] = vram.colorTable.readNP(
 			(colorStart + i) | (~0u << 9));
 		auto nameArea = vram.nameTable.getReadArea<8>(
 			(nameStart + 8 * i) | (~0u << 12));
-		draw6(pixelPtr,
-		      (colorPattern & 0x80) ? blinkFg : plainFg,
-		      (colorPattern & 0x80) ? blinkBg : plainBg,
-		      patternArea[l + nameArea[0] * 8]);
-		draw6(pixelPtr,
-		      (colorPattern & 0x40) ? blinkFg : plainFg,
-		      (colorPattern & 0x40) ? blinkBg : plainBg,
-		      patternArea[l + nameArea[1] * 8]);
-		draw6(pixelPtr,
-		      (colorPattern & 0x20) ? blinkFg : plainFg,
-		      (colorPattern & 0x20) ? blinkBg : plainBg,
-		      patternArea[l + nameArea[2] * 8]);
-		draw6(pixelPtr,
-		      (colorPattern & 0x10) ? blinkFg : plainFg,
-		      (colorPattern & 0x10) ? blinkBg : plainBg,
-		      patternArea[l + nameArea[3] * 8]);
-		draw6(pixelPtr,
-		      (colorPattern & 0x08) ? blinkFg : plainFg,
-		      (colorPattern & 0x08) ? blinkBg : plainBg,
-		      patternArea[l + nameArea[4] * 8]);
-		draw6(pixelPtr,
-		      (colorPattern & 0x04) ? blinkFg : plainFg,
-		      (colorPattern & 0x04) ? blinkBg : plainBg,
-		      patternArea[l + nameArea[5] * 8]);
-		draw6(pixelPtr,
-		      (colorPattern & 0x02) ? blinkFg : plainFg,
-		      (colorPattern & 0x02) ? blinkBg : plainBg,
-		      patternArea[l + nameArea[6] * 8]);
-		draw6(pixelPtr,
-		      (colorPattern & 0x01) ? blinkFg : plainFg,
-		      (colorPattern & 0x01) ? blinkBg : plainBg,
-		      patternArea[l + nameArea[7] * 8]);
+		for (auto n : xrange(8)) {
+			patterns[8 * i + n] = patternArea[l + nameArea[n] * 8];
+		}
 	}
+	PatternExpand::drawText2(buf.data(), plainFg, plainBg, blinkFg, blinkBg,
+	                         attributes, patterns);
 }
 
 std::span<const uint8_t, 32> CharacterConverter::getNamePtr(int line, int scroll) const
@@ -260,16 +174,14 @@ void CharacterConverter::renderGraphic1(std::span<Pixel, 256> buf, int line) con
 
 	int scroll = vdp.getHorizontalScrollHigh();
 	auto namePtr = getNamePtr(line, scroll);
-	Pixel* __restrict pixelPtr = buf.data();
-	repeat(32, [&] {
+	std::array<uint8_t, 32> patterns, colors;
+	for (auto n : xrange(32)) {
 		auto charCode = namePtr[scroll & 0x1F];
-		auto pattern = patternArea[l + charCode * 8];
-		auto color = colorArea[charCode / 8];
-		Pixel fg = palFg[color >> 4];
-		Pixel bg = palFg[color & 0x0F];
-		draw8(pixelPtr, fg, bg, pattern);
+		patterns[n] = patternArea[l + charCode * 8];
+		colors[n] = colorArea[charCode / 8];
 		if (!(++scroll & 0x1F)) namePtr = getNamePtr(line, scroll);
-	});
+	}
+	PatternExpand::drawGraphic(buf.data(), palFg, patterns, colors);
 }
 
 void CharacterConverter::renderGraphic2(std::span<Pixel, 256> buf, int line) const
@@ -279,7 +191,7 @@ void CharacterConverter::renderGraphic2(std::span<Pixel, 256> buf, int line) con
 	int scroll = vdp.getHorizontalScrollHigh();
 	auto namePtr = getNamePtr(line, scroll);
 
-	Pixel* __restrict pixelPtr = buf.data();
+	std::array<uint8_t, 32> patterns, colors;
 	if (vram.colorTable  .isContinuous((8 * 256) - 1) &&
 	    vram.patternTable.isContinuous((8 * 256) - 1) &&
 	    ((scroll & 0x1f) == 0)) {
@@ -290,11 +202,8 @@ void CharacterConverter::renderGraphic2(std::span<Pixel, 256> buf, int line) con
 		auto colorArea   = vram.colorTable  .getReadArea<256 * 8>(quarter8);
 		for (auto n : xrange(32)) {
 			auto charCode8 = namePtr[n] * 8;
-			auto pattern = patternArea[line7 + charCode8];
-			auto color   = colorArea  [line7 + charCode8];
-			Pixel fg = palFg[color >> 4];
-			Pixel bg = palFg[color & 0x0F];
-			draw8(pixelPtr, fg, bg, pattern);
+			patterns[n] = patternArea[line7 + charCode8];
+			colors[n]   = colorArea  [line7 + charCode8];
 		}
 	} else {
 		// Slower variant, also works when:
@@ -302,17 +211,15 @@ void CharacterConverter::renderGraphic2(std::span<Pixel, 256> buf, int line) con
 		// - there is mirroring in the pattern table (TMS9929)
 		// - V9958 horizontal scroll feature is used
 		unsigned baseLine = (~0u << 13) | quarter8 | line7;
-		repeat(32, [&] {
+		for (auto n : xrange(32)) {
 			unsigned charCode8 = namePtr[scroll & 0x1F] * 8;
 			unsigned index = charCode8 | baseLine;
-			auto pattern = vram.patternTable.readNP(index);
-			auto color   = vram.colorTable  .readNP(index);
-			Pixel fg = palFg[color >> 4];
-			Pixel bg = palFg[color & 0x0F];
-			draw8(pixelPtr, fg, bg, pattern);
+			patterns[n] = vram.patternTable.readNP(index);
+			colors[n]   = vram.colorTable  .readNP(index);
 			if (!(++scroll & 0x1F)) namePtr = getNamePtr(line, scroll);
-		});
+		}
 	}
+	PatternExpand::drawGraphic(buf.data(), palFg, patterns, colors);
 }
 
 void CharacterConverter::renderMultiHelper(
@@ -322,18 +229,13 @@ void CharacterConverter::renderMultiHelper(
 	unsigned baseLine = mask | ((line / 4) & 7);
 	unsigned scroll = vdp.getHorizontalScrollHigh();
 	auto namePtr = getNamePtr(line, scroll);
-	repeat(32, [&] {
+	std::array<uint8_t, 32> colors;
+	for (auto n : xrange(32)) {
 		unsigned patternNr = patternQuarter | namePtr[scroll & 0x1F];
-		unsigned color = vram.patternTable.readNP((patternNr * 8) | baseLine);
-		Pixel cl = palFg[color >> 4];
-		Pixel cr = palFg[color & 0x0F];
-		pixelPtr[0] = cl; pixelPtr[1] = cl;
-		pixelPtr[2] = cl; pixelPtr[3] = cl;
-		pixelPtr[4] = cr; pixelPtr[5] = cr;
-		pixelPtr[6] = cr; pixelPtr[7] = cr;
-		pixelPtr += 8;
+		colors[n] = vram.patternTable.readNP((patternNr * 8) | baseLine);
 		if (!(++scroll & 0x1F)) namePtr = getNamePtr(line, scroll);
-	});
+	}
+	PatternExpand::drawMulti(pixelPtr, palFg, colors);
 }
 void CharacterConverter::renderMulti(std::span<Pixel, 256> buf, int line) const
 {
@@ -3,6 +3,7 @@
 #include "ImGuiManager.hh"
 #include "Layer.hh"
 #include "OutputSurface.hh"
+#include "PNG.hh"
 #include "RendererFactory.hh"
 #include "VideoLayer.hh"
 #include "VideoSystem.hh"
@@ -425,12 +426,14 @@ void Display::ScreenShotCmd::execute(std::span<const TclObject> tokens, TclObjec
 	bool doubleSize = false;
 	bool withOsd = false;
 	std::string size;
+	int compressionLevel = PNG::DEFAULT_COMPRESSION_LEVEL;
 	std::array info = {
 		valueArg("-prefix", prefix),
 		flagArg("-raw", rawShot),
 		flagArg("-doublesize", doubleSize), // bwcompat, alias for -size 640
 		flagArg("-with-osd", withOsd),
-		valueArg("-size", size)
+		valueArg("-size", size),
+		valueArg("-compression", compressionLevel)
 	};
 	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
 
@@ -457,6 +460,10 @@ void Display::ScreenShotCmd::execute(std::span<const TclObject> tokens, TclObjec
 		}
 	}
 
+	if (compressionLevel < 0 || compressionLevel > 9) {
+		throw CommandException("-compression level must be in range 0-9");
+	}
+
 	// backwards compatiblity
 	if (doubleSize) {
 		size = "640";
@@ -483,7 +490,7 @@ void Display::ScreenShotCmd::execute(std::span<const TclObject> tokens, TclObjec
 	if (!rawShot) {
 		// take screenshot as displayed, possibly with other layers (OSD stuff, ImGUI)
 		try {
-			display.getVideoSystem().takeScreenShot(filename, withOsd);
+			display.getVideoSystem().takeScreenShot(filename, withOsd, compressionLevel);
 		} catch (MSXException& e) {
 			throw CommandException(
 				"Failed to take screenshot: ", e.getMessage());
@@ -497,7 +504,7 @@ void Display::ScreenShotCmd::execute(std::span<const TclObject> tokens, TclObjec
 		}
 		std::optional<unsigned> height = size == "auto" ? std::nullopt : size == "640" ? std::optional(480) : std::optional(240);
 		try {
-			videoLayer->takeRawScreenShot(height, filename);
+			videoLayer->takeRawScreenShot(height, filename, compressionLevel);
 		} catch (MSXException& e) {
 			throw CommandException(
 				"Failed to take screenshot: ", e.getMessage());
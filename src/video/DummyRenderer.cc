@@ -86,6 +86,19 @@ void DummyRenderer::updateColorBase(unsigned /*addr*/, EmuTime /*time*/) {
 void DummyRenderer::updateSpritesEnabled(bool /*enabled*/, EmuTime /*time*/) {
 }
 
+void DummyRenderer::updateSpriteAttributeBase(unsigned /*addr*/, EmuTime /*time*/) {
+}
+
+void DummyRenderer::updateSpritePatternBase(unsigned /*addr*/, EmuTime /*time*/) {
+}
+
+void DummyRenderer::updateSpriteSizeMag(uint8_t /*sizeMag*/, EmuTime /*time*/) {
+}
+
+bool DummyRenderer::isVRAMDisplayed(unsigned /*address*/, unsigned /*freeBits*/) const {
+	return false;
+}
+
 void DummyRenderer::updateVRAM(unsigned /*offset*/, EmuTime /*time*/) {
 }
 
@@ -40,6 +40,10 @@ public:
 	void updatePatternBase(unsigned addr, EmuTime time) override;
 	void updateColorBase(unsigned addr, EmuTime time) override;
 	void updateSpritesEnabled(bool enabled, EmuTime time) override;
+	void updateSpriteAttributeBase(unsigned addr, EmuTime time) override;
+	void updateSpritePatternBase(unsigned addr, EmuTime time) override;
+	void updateSpriteSizeMag(uint8_t sizeMag, EmuTime time) override;
+	[[nodiscard]] bool isVRAMDisplayed(unsigned address, unsigned freeBits) const override;
 	void updateVRAM(unsigned offset, EmuTime time) override;
 	void updateWindow(bool enabled, EmuTime time) override;
 
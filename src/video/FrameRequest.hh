@@ -0,0 +1,47 @@
+#ifndef FRAMEREQUEST_HH
+#define FRAMEREQUEST_HH
+
+#include <cstdint>
+
+namespace openmsx {
+
+/** Tracks a request for a fresh frame (see PostProcessor::requestFrame()).
+  *
+  * A request made in the middle of a frame is not satisfied by that frame:
+  * (part of) it was rendered before the request, or, when frames are not
+  * wanted, it's not rendered at all and the frame that gets published at
+  * the next frame start is an old one. So the request stays pending until
+  * a frame that was started after the request has been published, that's
+  * two frame starts (rotations) later.
+  */
+class FrameRequest
+{
+public:
+	/** Ask for a frame with content from after this moment. */
+	void request() { state = State::REQUESTED; }
+
+	/** Is there a request that is not yet satisfied? As long as there is,
+	  * frames must be rendered. */
+	[[nodiscard]] bool isPending() const { return state != State::NONE; }
+
+	/** A frame was published (and the next one starts rendering). */
+	void frameRotated() {
+		switch (state) {
+		case State::REQUESTED: state = State::RENDERING; break;
+		case State::RENDERING: state = State::NONE; break;
+		case State::NONE: break;
+		}
+	}
+
+private:
+	enum class State : uint8_t {
+		NONE,      // no request
+		REQUESTED, // the current frame started before the request
+		RENDERING, // the current frame started after the request
+	};
+	State state = State::NONE;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,218 @@
+#include "GLGlyphAtlas.hh"
+
+#include "SDLSurfacePtr.hh"
+
+#include "StringOp.hh"
+#include "endian.hh"
+#include "narrow.hh"
+#include "utf8_unchecked.hh"
+#include "xrange.hh"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <tuple>
+
+namespace openmsx {
+
+// The texture is filled with rows of glyphs, each row is as high as a line of
+// text. When it's full, the height is doubled (up to the maximum, then new
+// glyphs are no longer added, see Text::complete).
+static constexpr int TEXTURE_WIDTH = 512;
+static constexpr int MAX_TEXTURE_HEIGHT = 4096;
+
+// White, with the given alpha (GL_RGBA byte order).
+static constexpr uint32_t whitePixel(uint8_t alpha)
+{
+	return Endian::BIG ? (0xFFFFFF00 | alpha)
+	                   : (0x00FFFFFF | (uint32_t(alpha) << 24));
+}
+
+std::shared_ptr<GLGlyphAtlas> GLGlyphAtlas::get(
+	const std::string& filename, int ptSize, int faceIndex)
+{
+	struct Entry {
+		std::string filename;
+		int ptSize;
+		int faceIndex;
+		std::weak_ptr<GLGlyphAtlas> atlas;
+	};
+	static std::vector<Entry> pool;
+
+	std::erase_if(pool, [](const auto& e) { return e.atlas.expired(); });
+	if (auto it = std::ranges::find(pool, std::tuple(filename, ptSize, faceIndex),
+	        [](auto& e) { return std::tuple(e.filename, e.ptSize, e.faceIndex); });
+	    it != end(pool)) {
+		return it->atlas.lock();
+	}
+	auto result = std::make_shared<GLGlyphAtlas>(TTFFont(filename, ptSize, faceIndex));
+	pool.push_back(Entry{filename, ptSize, faceIndex, result});
+	return result;
+}
+
+GLGlyphAtlas::GLGlyphAtlas(TTFFont font_)
+	: font(std::move(font_))
+	, texture(false) // no interpolation, glyphs are drawn 1:1
+	, freePos(0, 0)
+	, lineHeight(font.getLineHeight())
+	, lineSkip(font.getHeight())
+{
+	texSize = gl::ivec2(TEXTURE_WIDTH, std::min(4 * lineHeight, MAX_TEXTURE_HEIGHT));
+	pixels.resize(size_t(texSize.x) * size_t(texSize.y));
+	std::ranges::fill(std::span{pixels.data(), pixels.size()}, whitePixel(0));
+	texture.bind();
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texSize.x, texSize.y, 0,
+	             GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+GLGlyphAtlas::Glyph GLGlyphAtlas::getGlyph(char32_t c)
+{
+	if (const auto* glyph = lookup(glyphs, c)) {
+		return *glyph;
+	}
+	auto glyph = addGlyph(c);
+	glyphs.emplace(c, glyph);
+	return glyph;
+}
+
+GLGlyphAtlas::Glyph GLGlyphAtlas::addGlyph(char32_t c)
+{
+	auto metrics = font.getGlyphMetrics(c);
+	Glyph glyph;
+	glyph.texPos = freePos;
+	glyph.width = 0;
+	// A single glyph is rendered starting from its left edge, or from the
+	// pen position if that's more to the left (see TTF_Size()).
+	glyph.offset = std::min(0, metrics.minX);
+	glyph.advance = metrics.advance;
+
+	SDLSurfacePtr surface = font.renderGlyph(c);
+	if (!surface) return glyph; // e.g. zero width, nothing to draw
+
+	int width = std::min(surface->w, TEXTURE_WIDTH);
+	int height = std::min(surface->h, lineHeight);
+	glyph.width = width;
+	auto pos = freePos;
+	if (pos.x + width > texSize.x) {
+		pos = gl::ivec2(0, pos.y + lineHeight);
+	}
+	if (pos.y + lineHeight > texSize.y && !grow()) {
+		// The texture is full. The metrics are still valid (for
+		// getWidth()), but texts with this glyph are rendered as a
+		// whole.
+		glyph.texPos = gl::ivec2(-1, -1);
+		return glyph;
+	}
+	glyph.texPos = pos;
+	freePos = gl::ivec2(pos.x + width, pos.y);
+
+	// Copy the coverage (alpha) of the rendered glyph.
+	const auto* format = surface->format;
+	MemBuffer<uint32_t> buf(size_t(width) * size_t(lineHeight));
+	std::ranges::fill(std::span{buf.data(), buf.size()}, whitePixel(0));
+	for (auto y : xrange(height)) {
+		const auto* in = static_cast<const uint32_t*>(surface.getLinePtr(y));
+		auto* out = &buf[size_t(y) * width];
+		for (auto x : xrange(width)) {
+			out[x] = whitePixel(narrow_cast<uint8_t>(
+				(in[x] & format->Amask) >> format->Ashift));
+		}
+	}
+	for (auto y : xrange(lineHeight)) {
+		std::ranges::copy(std::span{&buf[size_t(y) * width], size_t(width)},
+		                  &pixels[size_t(glyph.texPos.y + y) * texSize.x + glyph.texPos.x]);
+	}
+	texture.bind();
+	glTexSubImage2D(GL_TEXTURE_2D, 0, glyph.texPos.x, glyph.texPos.y, width, lineHeight,
+	                GL_RGBA, GL_UNSIGNED_BYTE, buf.data());
+	return glyph;
+}
+
+bool GLGlyphAtlas::grow()
+{
+	if (2 * texSize.y > MAX_TEXTURE_HEIGHT) {
+		return false;
+	}
+	// Texture coordinates are calculated while drawing, so existing glyphs
+	// can stay where they are.
+	auto oldSize = pixels.size();
+	texSize.y *= 2;
+	pixels.resize(size_t(texSize.x) * size_t(texSize.y));
+	std::ranges::fill(std::span{pixels.data() + oldSize, pixels.size() - oldSize},
+	                  whitePixel(0));
+	texture.bind();
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texSize.x, texSize.y, 0,
+	             GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	return true;
+}
+
+int GLGlyphAtlas::layoutLine(std::string_view line, int y, std::vector<Quad>* quads,
+                             bool* complete)
+{
+	// Like TTF_Size(): the line starts at the leftmost pixel (if that's
+	// left of the initial pen position), and ends at the rightmost pixel
+	// or the final pen position.
+	auto firstQuad = quads ? quads->size() : 0;
+	int x = 0;
+	int minX = 0;
+	int maxX = 0;
+	char32_t prev = 0;
+	auto it = line.begin();
+	while (it != line.end()) {
+		auto c = char32_t(utf8::unchecked::next(it));
+		if (prev) x += font.getKerning(prev, c);
+		prev = c;
+
+		auto glyph = getGlyph(c);
+		if (glyph.width) {
+			int left = x + glyph.offset;
+			minX = std::min(minX, left);
+			maxX = std::max(maxX, left + glyph.width);
+			if (glyph.texPos.x < 0) {
+				if (complete) *complete = false;
+			} else if (quads) {
+				quads->push_back(Quad{gl::ivec2(left, y), glyph.texPos,
+				                      gl::ivec2(glyph.width, lineHeight)});
+			}
+		}
+		x += glyph.advance;
+		maxX = std::max(maxX, x);
+	}
+	if (quads && (minX < 0)) {
+		for (auto& quad : std::span{*quads}.subspan(firstQuad)) {
+			quad.pos.x -= minX;
+		}
+	}
+	return maxX - minX;
+}
+
+GLGlyphAtlas::Text GLGlyphAtlas::layout(std::string_view text)
+{
+	Text result;
+	result.size = gl::ivec2(0, 0);
+
+	// Like TTFFont::render(): trailing empty lines are not included.
+	StringOp::trimRight(text, " \n");
+	if (text.empty()) return result;
+
+	int y = 0;
+	for (auto line : StringOp::split_view(text, '\n')) {
+		int width = layoutLine(line, y, &result.quads, &result.complete);
+		result.size.x = std::max(result.size.x, width);
+		result.size.y = y + lineHeight;
+		y += lineSkip;
+	}
+	return result;
+}
+
+int GLGlyphAtlas::getWidth(std::string_view line)
+{
+	return layoutLine(line, 0, nullptr, nullptr);
+}
+
+SDLSurfacePtr GLGlyphAtlas::render(std::string_view text, uint8_t r, uint8_t g, uint8_t b) const
+{
+	return font.render(std::string(text), r, g, b);
+}
+
+} // namespace openmsx
@@ -0,0 +1,104 @@
+#ifndef GLGLYPHATLAS_HH
+#define GLGLYPHATLAS_HH
+
+#include "GLUtil.hh"
+#include "TTFFont.hh"
+
+#include "MemBuffer.hh"
+#include "gl_vec.hh"
+#include "hash_map.hh"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openmsx {
+
+/** A texture containing all glyphs of a font (at one size) that have been
+  * used so far. Text can be drawn as one textured quad per character from
+  * this texture. Compared to rendering the whole text with SDL_ttf and
+  * uploading that as a new texture, this makes it much cheaper to show text
+  * that changes often (e.g. every frame).
+  *
+  * Glyphs are rendered (in white, the color is applied while drawing) and
+  * their metrics are queried only once, on first use.
+  */
+class GLGlyphAtlas
+{
+public:
+	/** A rectangle from the texture, drawn at some position. */
+	struct Quad {
+		gl::ivec2 pos;    // in the text
+		gl::ivec2 texPos; // in the texture
+		gl::ivec2 size;
+	};
+
+	/** Result of layout(). */
+	struct Text {
+		gl::ivec2 size;
+		std::vector<Quad> quads;
+		// False when (some of) the glyphs didn't fit in the texture
+		// anymore, then the text must be drawn with render() instead.
+		bool complete = true;
+	};
+
+	/** Return the atlas for the given font. It's shared with all other
+	  * users of the same font, and it's destroyed together with its last
+	  * user.
+	  * @throws MSXException when the font can't be opened.
+	  */
+	[[nodiscard]] static std::shared_ptr<GLGlyphAtlas> get(
+		const std::string& filename, int ptSize, int faceIndex);
+
+	explicit GLGlyphAtlas(TTFFont font);
+
+	/** Position the glyphs of the given text (UTF-8, possibly multi-line)
+	  * in the same way as TTFFont::render() would.
+	  */
+	[[nodiscard]] Text layout(std::string_view text);
+
+	/** The width (in pixels) of a single line of text, as positioned by
+	  * layout().
+	  */
+	[[nodiscard]] int getWidth(std::string_view line);
+
+	/** Render the whole text with the font, see TTFFont::render(). This is
+	  * the fallback for when layout() returns an incomplete text.
+	  */
+	[[nodiscard]] SDLSurfacePtr render(std::string_view text, uint8_t r, uint8_t g, uint8_t b) const;
+
+	/** The size of the texture (changes when it's full and new glyphs are
+	  * added), needed to calculate texture coordinates.
+	  */
+	[[nodiscard]] gl::ivec2 getTextureSize() const { return texSize; }
+
+	void bindTexture() const { texture.bind(); }
+
+private:
+	struct Glyph {
+		gl::ivec2 texPos; // negative when it didn't fit in the texture
+		int width;   // of the rendered glyph, can be zero
+		int offset;  // of the rendered glyph, relative to the pen position
+		int advance;
+	};
+	[[nodiscard]] Glyph getGlyph(char32_t c);
+	[[nodiscard]] Glyph addGlyph(char32_t c);
+	[[nodiscard]] int layoutLine(std::string_view line, int y, std::vector<Quad>* quads,
+	                             bool* complete);
+	[[nodiscard]] bool grow();
+
+private:
+	TTFFont font;
+	hash_map<char32_t, Glyph> glyphs;
+	MemBuffer<uint32_t> pixels; // copy of the texture content
+	gl::Texture texture;
+	gl::ivec2 texSize;
+	gl::ivec2 freePos; // start of the free space in the texture
+	int lineHeight;
+	int lineSkip;
+};
+
+} // namespace openmsx
+
+#endif
@@ -133,6 +133,25 @@ GLImage::GLImage(SDLSurfacePtr image)
 {
 }
 
+GLImage::GLImage(std::shared_ptr<GLGlyphAtlas> atlas_, std::string_view text,
+                 uint8_t r, uint8_t g, uint8_t b)
+	: atlas(std::move(atlas_))
+	, textR(r), textG(g), textB(b)
+{
+	auto layout = atlas->layout(text);
+	if (!layout.complete) {
+		// The texture of the atlas is full, render the whole text
+		// (in its color) instead.
+		if (auto surface = atlas->render(text, r, g, b)) {
+			texture = loadTexture(std::move(surface), size);
+			atlas.reset();
+			return;
+		}
+	}
+	size = layout.size;
+	quads = std::move(layout.quads);
+}
+
 void GLImage::initBuffers() const
 {
 	// border
@@ -144,6 +163,11 @@ void GLImage::initBuffers() const
 
 void GLImage::draw(ivec2 pos, uint8_t r, uint8_t g, uint8_t b, uint8_t alpha)
 {
+	if (atlas) {
+		drawText(pos, r, g, b, alpha);
+		return;
+	}
+
 	// 4-----------------7
 	// |                 |
 	// |   0---------3   |
@@ -247,4 +271,54 @@ void GLImage::draw(ivec2 pos, uint8_t r, uint8_t g, uint8_t b, uint8_t alpha)
 	glDisable(GL_BLEND);
 }
 
+void GLImage::drawText(ivec2 pos, uint8_t r, uint8_t g, uint8_t b, uint8_t alpha)
+{
+	if (quads.empty()) return;
+
+	// two triangles per glyph
+	std::vector<ivec2> positions;
+	std::vector<vec2> tex;
+	positions.reserve(6 * quads.size());
+	tex.reserve(6 * quads.size());
+	auto texScale = 1.0f / vec2(atlas->getTextureSize());
+	for (const auto& quad : quads) {
+		auto p0 = pos + quad.pos;
+		auto p1 = p0 + quad.size;
+		auto t0 = vec2(quad.texPos) * texScale;
+		auto t1 = vec2(quad.texPos + quad.size) * texScale;
+		positions.insert(positions.end(), {
+			p0, ivec2(p0.x, p1.y), p1,
+			p0, p1, ivec2(p1.x, p0.y)});
+		tex.insert(tex.end(), {
+			t0, vec2(t0.x, t1.y), t1,
+			t0, t1, vec2(t1.x, t0.y)});
+	}
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	auto& glContext = *gl::context;
+	glContext.progTex.activate();
+	glUniform4f(glContext.unifTexColor,
+	            narrow<float>(textR * r) * (1.0f / (255.0f * 255.0f)),
+	            narrow<float>(textG * g) * (1.0f / (255.0f * 255.0f)),
+	            narrow<float>(textB * b) * (1.0f / (255.0f * 255.0f)),
+	            narrow<float>(alpha)     * (1.0f / 255.0f));
+	glUniformMatrix4fv(glContext.unifTexMvp, 1, GL_FALSE,
+	                   glContext.pixelMvp.data());
+	glBindBuffer(GL_ARRAY_BUFFER, vbo[0].get());
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(ivec2), positions.data(), GL_STREAM_DRAW);
+	glVertexAttribPointer(0, 2, GL_INT, GL_FALSE, 0, nullptr);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo[1].get());
+	glBufferData(GL_ARRAY_BUFFER, tex.size() * sizeof(vec2), tex.data(), GL_STREAM_DRAW);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+	glEnableVertexAttribArray(1);
+	atlas->bindTexture();
+	glDrawArrays(GL_TRIANGLES, 0, narrow<GLsizei>(positions.size()));
+	glDisableVertexAttribArray(1);
+	glDisableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDisable(GL_BLEND);
+}
+
 } // namespace openmsx
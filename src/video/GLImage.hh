@@ -1,13 +1,17 @@
 #ifndef GLTEXTURE_HH
 #define GLTEXTURE_HH
 
+#include "GLGlyphAtlas.hh"
 #include "GLUtil.hh"
 #include "gl_vec.hh"
 
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 class SDLSurfacePtr;
 
@@ -26,6 +30,12 @@ public:
 	GLImage(gl::ivec2 size, uint32_t rgba);
 	GLImage(gl::ivec2 size, std::span<const uint32_t, 4> rgba,
 	        int borderSize, uint32_t borderRGBA);
+	/** Text (UTF-8, possibly multi-line) in the given color, drawn with
+	  * glyphs from the atlas. Or, when not all glyphs fit in the atlas,
+	  * from a texture with the whole text.
+	  */
+	GLImage(std::shared_ptr<GLGlyphAtlas> atlas, std::string_view text,
+	        uint8_t r, uint8_t g, uint8_t b);
 
 	void draw(gl::ivec2 pos, uint8_t alpha = 255) {
 		draw(pos, 255, 255, 255, alpha);
@@ -44,6 +54,7 @@ public:
 
 private:
 	void initBuffers() const;
+	void drawText(gl::ivec2 pos, uint8_t r, uint8_t g, uint8_t b, uint8_t alpha);
 
 private:
 	gl::ivec2 size;
@@ -55,6 +66,9 @@ private:
 	uint16_t borderA{0}; // 0..256
 	std::array<uint8_t, 4> bgR, bgG, bgB;
 	uint8_t borderR{0}, borderG{0}, borderB{0};
+	std::shared_ptr<GLGlyphAtlas> atlas; // only for text
+	std::vector<GLGlyphAtlas::Quad> quads;
+	uint8_t textR{0}, textG{0}, textB{0};
 };
 
 } // namespace openmsx
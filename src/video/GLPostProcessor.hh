@@ -0,0 +1,94 @@
+#ifndef GLPOSTPROCESSOR_HH
+#define GLPOSTPROCESSOR_HH
+
+#include "GLUtil.hh"
+#include "PostProcessor.hh"
+#include "RenderSettings.hh"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace openmsx {
+
+class GLScaler;
+
+/** PostProcessor that uses openGL to scale the MSX frame to the output
+  * surface and to apply the various effects (noise, glow, 3D deform).
+  */
+class GLPostProcessor final : public PostProcessor
+{
+public:
+	GLPostProcessor(
+		MSXMotherBoard& motherBoard, Display& display,
+		OutputSurface& screen, const std::string& videoSource,
+		unsigned maxWidth, unsigned height, bool canDoInterlace);
+	~GLPostProcessor() override;
+
+	// Layer interface:
+	void paint(OutputSurface& output) override;
+
+private:
+	// Observer<Setting> interface:
+	void update(const Setting& setting) noexcept override;
+
+	// PostProcessor
+	void uploadFrame() override;
+
+	void initBuffers();
+	void createRegions();
+	void uploadBlock(unsigned srcStartY, unsigned srcEndY,
+	                 unsigned lineWidth);
+
+	void preCalcNoise(float factor);
+	void drawNoise() const;
+	void drawGlow(int glow);
+
+	void preCalcMonitor3D(float width);
+	void drawMonitor3D() const;
+
+private:
+	/** The currently active scaler.
+	  */
+	std::unique_ptr<GLScaler> currScaler;
+
+	struct StoredFrame {
+		gl::ivec2 size; // (re)allocate when window size changes
+		gl::Texture tex;
+		gl::FrameBufferObject fbo;
+	};
+	std::array<StoredFrame, 2> renderedFrames;
+
+	// Noise effect:
+	gl::Texture noiseTextureA{true, true}; // interpolate + wrap
+	gl::Texture noiseTextureB{true, true};
+	float noiseX = 0.0f, noiseY = 0.0f;
+
+	struct TextureData {
+		gl::ColorTexture tex;
+		[[nodiscard]] unsigned width() const { return tex.getWidth(); }
+	};
+	std::vector<TextureData> textures;
+	gl::PixelBuffer<unsigned> pbo;
+
+	gl::ColorTexture superImposeTex;
+
+	std::vector<Region> regions;
+	unsigned regionsDstHeight = 0; // 'regions' were calculated for this output height (relevant when changing scale_factor when paused)
+
+	/** Currently active scale algorithm, used to detect scaler changes.
+	  */
+	RenderSettings::ScaleAlgorithm scaleAlgorithm = RenderSettings::ScaleAlgorithm::NO;
+
+	gl::ShaderProgram monitor3DProg;
+	gl::BufferObject arrayBuffer;
+	gl::BufferObject elementBuffer;
+	gl::BufferObject vbo;
+	gl::BufferObject stretchVBO;
+
+	bool storedFrame = false;
+};
+
+} // namespace openmsx
+
+#endif // GLPOSTPROCESSOR_HH
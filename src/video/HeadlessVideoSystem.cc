@@ -0,0 +1,194 @@
+#include "HeadlessVideoSystem.hh"
+
+#include "Display.hh"
+#include "SDLRasterizer.hh"
+#include "SWOutputSurface.hh"
+#include "SWPostProcessor.hh"
+#include "V9990.hh"
+#include "V9990SDLRasterizer.hh"
+#include "VDP.hh"
+
+#include "CliComm.hh"
+#include "MSXException.hh"
+#include "MSXMotherBoard.hh"
+#include "Reactor.hh"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "components.hh"
+#if COMPONENT_LASERDISC
+#include "LDSDLRasterizer.hh"
+#include "LaserdiscPlayer.hh"
+#endif
+
+namespace openmsx {
+
+HeadlessVideoSystem::HeadlessVideoSystem(Reactor& reactor_)
+	: reactor(reactor_)
+	, display(reactor.getDisplay())
+	, screen(std::make_unique<SWOutputSurface>(display.getWindowSize()))
+{
+}
+
+HeadlessVideoSystem::~HeadlessVideoSystem() = default;
+
+std::unique_ptr<Rasterizer> HeadlessVideoSystem::createRasterizer(VDP& vdp)
+{
+	assert(display.getRenderer() == RenderSettings::RendererID::HEADLESS);
+	std::string videoSource = (vdp.getName() == "VDP")
+	                        ? "MSX" // for backwards compatibility
+	                        : vdp.getName();
+	auto& motherBoard = vdp.getMotherBoard();
+	return std::make_unique<SDLRasterizer>(
+		vdp, display, *screen,
+		std::make_unique<SWPostProcessor>(
+			motherBoard, display, *screen,
+			videoSource, 640, 240, true));
+}
+
+std::unique_ptr<V9990Rasterizer> HeadlessVideoSystem::createV9990Rasterizer(
+	V9990& vdp)
+{
+	assert(display.getRenderer() == RenderSettings::RendererID::HEADLESS);
+	std::string videoSource = (vdp.getName() == "Sunrise GFX9000")
+	                        ? "GFX9000" // for backwards compatibility
+	                        : vdp.getName();
+	MSXMotherBoard& motherBoard = vdp.getMotherBoard();
+	return std::make_unique<V9990SDLRasterizer>(
+		vdp, display, *screen,
+		std::make_unique<SWPostProcessor>(
+			motherBoard, display, *screen,
+			videoSource, 1280, 240, true));
+}
+
+#if COMPONENT_LASERDISC
+std::unique_ptr<LDRasterizer> HeadlessVideoSystem::createLDRasterizer(
+	LaserdiscPlayer& ld)
+{
+	assert(display.getRenderer() == RenderSettings::RendererID::HEADLESS);
+	std::string videoSource = "Laserdisc"; // TODO handle multiple???
+	MSXMotherBoard& motherBoard = ld.getMotherBoard();
+	return std::make_unique<LDSDLRasterizer>(
+		std::make_unique<SWPostProcessor>(
+			motherBoard, display, *screen,
+			videoSource, 640, 480, false));
+}
+#endif
+
+void HeadlessVideoSystem::flush()
+{
+}
+
+void HeadlessVideoSystem::takeScreenShot(const std::string& filename, bool /*withOsd*/,
+                                         int compressionLevel)
+{
+	// There are no OSD layers, so 'withOsd' makes no difference.
+	// With 'render_on_demand' the most recently rendered frame can be much
+	// older than the current MSX screen. Then request a fresh frame and
+	// only save the screenshot once that's published (see repaint()). When
+	// frames are only rendered because of an earlier request, the frame
+	// that's currently rendered can also be (partly) older than this call.
+	bool stale = !pendingScreenShots.empty();
+	for (auto* pp : getRenderingPostProcessors()) {
+		if (!pp->isFrameWanted() || pp->isFrameRequested()) {
+			pp->requestFrame();
+			stale = true;
+		}
+	}
+	// No new frames are rendered while paused or fast-forwarding, then
+	// the last rendered frame is the best we have.
+	const auto* motherBoard = reactor.getMotherBoard();
+	if (stale && motherBoard && motherBoard->isActive() &&
+	    !motherBoard->isFastForwarding()) {
+		pendingScreenShots.emplace_back(filename, compressionLevel);
+		return;
+	}
+	saveScreenShot(filename, compressionLevel);
+}
+
+std::vector<PostProcessor*> HeadlessVideoSystem::getRenderingPostProcessors() const
+{
+	std::vector<PostProcessor*> result;
+	for (auto* l : display.getAllLayers()) {
+		if (auto* pp = dynamic_cast<PostProcessor*>(l); pp && pp->needRender()) {
+			result.push_back(pp);
+		}
+	}
+	return result;
+}
+
+void HeadlessVideoSystem::saveScreenShot(const std::string& filename, int compressionLevel)
+{
+	// Frames are only painted on demand, so do that now (possibly after
+	// adjusting to a changed scale_factor).
+	if (auto size = display.getWindowSize(); screen->getLogicalSize() != size) {
+		screen->resize(size);
+	}
+	display.repaintImpl(*screen);
+	screen->saveScreenshot(filename, compressionLevel);
+}
+
+std::optional<gl::ivec2> HeadlessVideoSystem::getMouseCoord()
+{
+	return {};
+}
+
+OutputSurface* HeadlessVideoSystem::getOutputSurface()
+{
+	// Our surface is not visible to the user. Returning it here would
+	// e.g. make the OSD widgets try to create openGL textures for it.
+	return nullptr;
+}
+
+void HeadlessVideoSystem::showCursor(bool /*show*/)
+{
+}
+
+bool HeadlessVideoSystem::getCursorEnabled()
+{
+	return false;
+}
+
+std::string HeadlessVideoSystem::getClipboardText()
+{
+	return "";
+}
+
+void HeadlessVideoSystem::setClipboardText(zstring_view /*text*/)
+{
+}
+
+std::optional<gl::ivec2> HeadlessVideoSystem::getWindowPosition()
+{
+	return {};
+}
+
+void HeadlessVideoSystem::setWindowPosition(gl::ivec2 /*pos*/)
+{
+}
+
+void HeadlessVideoSystem::repaint()
+{
+	// Nothing is painted (see getOutputSurface()), but this still keeps
+	// the frame rate statistics up to date.
+	display.repaintImpl();
+
+	// This is also called at other moments than right after a frame was
+	// rendered, so check whether the requested frames are there.
+	if (pendingScreenShots.empty() ||
+	    std::ranges::any_of(getRenderingPostProcessors(), &PostProcessor::isFrameRequested)) {
+		return;
+	}
+	for (const auto& [filename, compressionLevel] : std::exchange(pendingScreenShots, {})) {
+		try {
+			saveScreenShot(filename, compressionLevel);
+		} catch (MSXException& e) {
+			display.getCliComm().printWarning(
+				"Failed to take screenshot: ", e.getMessage());
+		}
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,66 @@
+#ifndef HEADLESSVIDEOSYSTEM_HH
+#define HEADLESSVIDEOSYSTEM_HH
+
+#include "VideoSystem.hh"
+
+#include "components.hh"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+class Display;
+class PostProcessor;
+class Reactor;
+class SWOutputSurface;
+
+/** Video system that renders the MSX screen completely in software, without
+  * opening a window and without an openGL context. The rendered frames are
+  * only used for screenshots and for video recording.
+  */
+class HeadlessVideoSystem final : public VideoSystem
+{
+public:
+	explicit HeadlessVideoSystem(Reactor& reactor);
+	~HeadlessVideoSystem() override;
+
+	// VideoSystem interface:
+	[[nodiscard]] std::unique_ptr<Rasterizer> createRasterizer(VDP& vdp) override;
+	[[nodiscard]] std::unique_ptr<V9990Rasterizer> createV9990Rasterizer(
+		V9990& vdp) override;
+#if COMPONENT_LASERDISC
+	[[nodiscard]] std::unique_ptr<LDRasterizer> createLDRasterizer(
+		LaserdiscPlayer& ld) override;
+#endif
+	void flush() override;
+	/** With 'render_on_demand' (and a running MSX) the screenshot is
+	  * saved after the next frame is rendered. */
+	void takeScreenShot(const std::string& filename, bool withOsd,
+	                    int compressionLevel) override;
+	[[nodiscard]] std::optional<gl::ivec2> getMouseCoord() override;
+	[[nodiscard]] OutputSurface* getOutputSurface() override;
+	void showCursor(bool show) override;
+	[[nodiscard]] bool getCursorEnabled() override;
+	[[nodiscard]] std::string getClipboardText() override;
+	void setClipboardText(zstring_view text) override;
+	[[nodiscard]] std::optional<gl::ivec2> getWindowPosition() override;
+	void setWindowPosition(gl::ivec2 pos) override;
+	void repaint() override;
+
+private:
+	[[nodiscard]] std::vector<PostProcessor*> getRenderingPostProcessors() const;
+	void saveScreenShot(const std::string& filename, int compressionLevel);
+
+private:
+	Reactor& reactor;
+	Display& display;
+	std::unique_ptr<SWOutputSurface> screen;
+	std::vector<std::pair<std::string, int>> pendingScreenShots; // filename, compression level
+};
+
+} // namespace openmsx
+
+#endif
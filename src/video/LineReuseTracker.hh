@@ -0,0 +1,79 @@
+#ifndef LINEREUSETRACKER_HH
+#define LINEREUSETRACKER_HH
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+/** Remembers the state in which each display line was drawn, so that
+  * PixelRenderer can copy unchanged lines from the previous frame instead
+  * of drawing them again.
+  */
+class LineReuseTracker
+{
+public:
+	explicit LineReuseTracker(size_t numLines)
+		: lineInfo(numLines) {}
+
+	/** Must be called on every change (VRAM, registers, palette, sprite
+	  * tables, ...) that can influence the rendered image. Lines drawn
+	  * before this call won't be reused anymore.
+	  */
+	void invalidate() { ++changeCount; }
+
+	/** Render line 'y' as a whole.
+	  * If the line was drawn in the same state before, 'copy()' is called
+	  * to reuse it. When that's not possible (returns false), 'draw()' is
+	  * called instead. 'draw()' advances 'textModeCounter', reusing a line
+	  * restores the value it had after drawing that line.
+	  */
+	template<typename Copy, typename Draw>
+	void renderLine(int y, int& textModeCounter, int lineZero, bool displayEnabled,
+	                Copy copy, Draw draw)
+	{
+		assert(size_t(y) < lineInfo.size());
+		auto& info = lineInfo[y];
+		LineState state{.changeCount = changeCount,
+		                .textModeCounter = textModeCounter,
+		                .lineZero = lineZero,
+		                .displayEnabled = displayEnabled};
+		if ((info.state == state) && copy()) {
+			textModeCounter = info.textModeCounterAfter;
+			return;
+		}
+		draw();
+		info.state = state;
+		info.textModeCounterAfter = textModeCounter;
+	}
+
+private:
+	/** Incremented on every change that can influence the rendered image.
+	  * Display enable/disable is the exception: that happens (at the same
+	  * position) in every frame, it is part of LineState instead.
+	  */
+	uint64_t changeCount = 0;
+
+	/** The state in which a line was drawn (as a whole) the last time.
+	  * If the current state is equal, the line is unchanged.
+	  */
+	struct LineState {
+		uint64_t changeCount = uint64_t(-1);
+		int textModeCounter = 0;
+		int lineZero = 0;
+		bool displayEnabled = false;
+
+		[[nodiscard]] bool operator==(const LineState&) const = default;
+	};
+	struct LineInfo {
+		LineState state;
+		int textModeCounterAfter = 0;
+	};
+	std::vector<LineInfo> lineInfo; // indexed by absolute line number
+};
+
+} // namespace openmsx
+
+#endif
@@ -24,9 +24,9 @@ OffScreenSurface::OffScreenSurface(const OutputSurface& output)
 	fbo.push();
 }
 
-void OffScreenSurface::saveScreenshot(const std::string& filename)
+void OffScreenSurface::saveScreenshot(const std::string& filename, int compressionLevel)
 {
-	VisibleSurface::saveScreenshotGL(*this, filename);
+	VisibleSurface::saveScreenshotGL(*this, filename, compressionLevel);
 }
 
 } // namespace openmsx
@@ -16,7 +16,7 @@ public:
 
 private:
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	void saveScreenshot(const std::string& filename, int compressionLevel) override;
 
 private:
 	gl::Texture fboTex;
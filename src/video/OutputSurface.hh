@@ -63,9 +63,10 @@ public:
 	}
 
 	/** Save the content of this OutputSurface to a PNG file.
+	  * @param compressionLevel See PNG::saveRGBA().
 	  * @throws MSXException If creating the PNG file fails.
 	  */
-	virtual void saveScreenshot(const std::string& filename) = 0;
+	virtual void saveScreenshot(const std::string& filename, int compressionLevel) = 0;
 
 protected:
 	OutputSurface() = default;
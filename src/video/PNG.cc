@@ -6,16 +6,21 @@
 #include "MSXException.hh"
 #include "Version.hh"
 
+#include "MemBuffer.hh"
 #include "cstdiop.hh"
 #include "endian.hh"
 #include "narrow.hh"
 #include "one_of.hh"
 #include "small_buffer.hh"
+#include "xrange.hh"
 
 #include <SDL.h>
 #include <png.h>
+#include <zlib.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <bit>
 #include <cassert>
 #include <cstdlib>
@@ -24,6 +29,8 @@
 #include <iostream>
 #include <limits>
 #include <ranges>
+#include <thread>
+#include <vector>
 
 namespace openmsx::PNG {
 
@@ -232,9 +239,216 @@ static void flushData(png_structp ctx)
 	file->flush();
 }
 
+// The image data is filtered and compressed in horizontal stripes, on
+// multiple threads. Every stripe is deflated separately, with the (filtered)
+// data of the preceding stripe as preset dictionary, and ends with a sync
+// flush, so that the concatenation of the stripes is a single valid zlib
+// stream. Each stripe is written as a separate IDAT chunk. The number of
+// stripes only depends on the image height, so the result is the same on
+// every machine.
+static constexpr unsigned MAX_STRIPES = 8;
+static constexpr size_t MIN_STRIPE_ROWS = 32; // smaller isn't worth a separate stripe
+static constexpr size_t WINDOW_SIZE = 32768; // deflate history
+static constexpr std::array<png_byte, 5> IDAT = {'I', 'D', 'A', 'T', 0};
+static constexpr std::array<png_byte, 5> IEND = {'I', 'E', 'N', 'D', 0};
+
+struct Stripe {
+	size_t firstRow;
+	size_t lastRow; // exclusive
+	size_t dictRows; // rows of the previous stripe needed for the dictionary
+	MemBuffer<uint8_t> filtered; // per row (from 'firstRow - dictRows'): filter type + filtered bytes
+	size_t inputSize = 0; // filtered size of the rows [firstRow, lastRow)
+	MemBuffer<uint8_t> output; // raw deflate data
+	size_t outputSize = 0;
+	uLong adler = 0; // of the filtered rows [firstRow, lastRow)
+	bool ok = false;
+};
+
+// Call 'f' for all items, on at most 'maxThreads' threads (including the
+// calling thread).
+template<typename T, typename F>
+static void parallelForEach(std::span<T> items, size_t maxThreads, F f)
+{
+	std::atomic<size_t> next = 0;
+	auto work = [&] {
+		for (auto i = next++; i < items.size(); i = next++) f(items[i]);
+	};
+	std::vector<std::thread> threads;
+	auto numThreads = std::clamp<size_t>(maxThreads, 1, std::max<size_t>(items.size(), 1));
+	threads.reserve(numThreads - 1);
+	repeat(numThreads - 1, [&] { threads.emplace_back(work); });
+	work();
+	for (auto& t : threads) t.join();
+}
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+	int p = a + b - c;
+	int pa = std::abs(p - a);
+	int pb = std::abs(p - b);
+	int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc) return a;
+	if (pb <= pc) return b;
+	return c;
+}
+
+// Apply PNG filter 'type' to row 'cur' ('prev' is the row above it).
+static void applyFilter(int type, std::span<const uint8_t> cur, std::span<const uint8_t> prev,
+                        size_t bpp, std::span<uint8_t> out)
+{
+	for (auto i : xrange(cur.size())) {
+		uint8_t a = (i >= bpp) ? cur[i - bpp] : 0; // left
+		uint8_t b = prev[i];                       // up
+		uint8_t c = (i >= bpp) ? prev[i - bpp] : 0; // up-left
+		uint8_t pred = [&]() -> uint8_t {
+			switch (type) {
+			case 0: return 0;
+			case 1: return a;
+			case 2: return b;
+			case 3: return uint8_t((a + b) / 2);
+			default: return paeth(a, b, c);
+			}
+		}();
+		out[i] = uint8_t(cur[i] - pred);
+	}
+}
+
+// Filter one row into 'out' (filter type byte followed by the filtered row).
+// Like libpng, pick the filter that gives the smallest sum of absolute values
+// (interpreted as signed bytes), that usually compresses best.
+static void filterRow(std::span<const uint8_t> cur, std::span<const uint8_t> prev,
+                      size_t bpp, bool tryAll, std::span<uint8_t> out,
+                      std::span<uint8_t> tmp)
+{
+	auto dst = out.subspan(1);
+	out[0] = 0;
+	applyFilter(0, cur, prev, bpp, dst);
+	if (!tryAll) return;
+
+	auto cost = [](std::span<const uint8_t> row) {
+		size_t sum = 0;
+		for (auto v : row) sum += size_t(std::abs(int(int8_t(v))));
+		return sum;
+	};
+	size_t best = cost(dst);
+	for (int type = 1; type <= 4; ++type) {
+		applyFilter(type, cur, prev, bpp, tmp);
+		if (auto c = cost(tmp); c < best) {
+			best = c;
+			out[0] = uint8_t(type);
+			std::ranges::copy(tmp, dst.begin());
+		}
+	}
+}
+
+static void compressStripe(Stripe& stripe, std::span<const uint8_t> dict,
+                           std::span<uint8_t> input,
+                           bool last, int compressionLevel)
+{
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if (deflateInit2(&zs, compressionLevel, Z_DEFLATED, -15, 8,
+	                 Z_DEFAULT_STRATEGY) != Z_OK) {
+		return;
+	}
+	stripe.output.resize(deflateBound(&zs, uLong(input.size())) + 16);
+	if (!dict.empty()) {
+		deflateSetDictionary(&zs, dict.data(), uInt(dict.size()));
+	}
+	zs.next_in   = input.data();
+	zs.avail_in  = uInt(input.size());
+	zs.next_out  = stripe.output.data();
+	zs.avail_out = uInt(stripe.output.size());
+	auto r = deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+	stripe.ok = (r == (last ? Z_STREAM_END : Z_OK)) && (zs.avail_in == 0);
+	stripe.outputSize = zs.total_out;
+	stripe.adler = adler32(adler32(0, nullptr, 0), input.data(), uInt(input.size()));
+	deflateEnd(&zs);
+}
+
+static void writeImageData(png_structp png, size_t rowBytes, size_t bpp,
+                           std::span<const void*> rowPointers, int compressionLevel)
+{
+	auto height = rowPointers.size();
+	auto numStripes = std::clamp<size_t>(height / MIN_STRIPE_ROWS, 1, MAX_STRIPES);
+	auto filteredRowSize = rowBytes + 1;
+	auto maxDictRows = (WINDOW_SIZE + filteredRowSize - 1) / filteredRowSize;
+	std::vector<Stripe> stripes(numStripes);
+	for (auto i : xrange(numStripes)) {
+		auto& stripe = stripes[i];
+		stripe.firstRow = (height * (i + 0)) / numStripes;
+		stripe.lastRow  = (height * (i + 1)) / numStripes;
+		stripe.dictRows = (i == 0) ? 0 : std::min(stripe.firstRow - stripes[i - 1].firstRow, maxDictRows);
+		stripe.inputSize = (stripe.lastRow - stripe.firstRow) * filteredRowSize;
+		stripe.filtered.resize(stripe.dictRows * filteredRowSize + stripe.inputSize);
+	}
+	auto row = [&](size_t y) {
+		return std::span{static_cast<const uint8_t*>(rowPointers[y]), rowBytes};
+	};
+
+	// Filtering is pointless when the data is stored uncompressed.
+	bool tryAll = compressionLevel != 0;
+	MemBuffer<uint8_t> zeroRow(rowBytes);
+	std::ranges::fill(std::span{zeroRow.data(), rowBytes}, 0);
+	parallelForEach(std::span{stripes}, std::thread::hardware_concurrency(), [&](Stripe& stripe) {
+		// Also filter the last rows of the previous stripe, that gives
+		// the same bytes as in that stripe (so it's the dictionary),
+		// without having to wait for the other thread.
+		MemBuffer<uint8_t> tmp(rowBytes);
+		auto* out = stripe.filtered.data();
+		for (auto y : xrange(stripe.firstRow - stripe.dictRows, stripe.lastRow)) {
+			auto prev = (y == 0) ? std::span<const uint8_t>{zeroRow.data(), rowBytes}
+			                     : row(y - 1);
+			filterRow(row(y), prev, bpp, tryAll,
+			          std::span{out, filteredRowSize}, std::span{tmp.data(), rowBytes});
+			out += filteredRowSize;
+		}
+
+		auto dictSize = std::min(stripe.dictRows * filteredRowSize, WINDOW_SIZE);
+		auto input = std::span{stripe.filtered.data() + stripe.dictRows * filteredRowSize,
+		                       stripe.inputSize};
+		compressStripe(stripe, std::span{input.data() - dictSize, dictSize}, input,
+		               &stripe == &stripes.back(), compressionLevel);
+	});
+	if (!std::ranges::all_of(stripes, &Stripe::ok)) {
+		throw MSXException("Failed to compress image data");
+	}
+
+	// zlib header: deflate with 32kB window, compression level hint, and
+	// a check value that makes the header a multiple of 31.
+	uint8_t cmf = 0x78;
+	uint8_t level = (compressionLevel < 2) ? 0
+	              : (compressionLevel < 6) ? 1
+	              : (compressionLevel == 6) ? 2 : 3;
+	uint8_t flg = uint8_t(level << 6);
+	flg = uint8_t(flg + 31 - ((cmf * 256 + flg) % 31));
+	std::array<uint8_t, 2> header = {cmf, flg};
+
+	uLong adler = adler32(0, nullptr, 0);
+	for (auto i : xrange(numStripes)) {
+		const auto& stripe = stripes[i];
+		adler = adler32_combine(adler, stripe.adler, z_off_t(stripe.inputSize));
+		bool first = i == 0;
+		bool last = i == (numStripes - 1);
+		auto size = stripe.outputSize + (first ? header.size() : 0) + (last ? sizeof(uint32_t) : 0);
+		png_write_chunk_start(png, IDAT.data(),
+		                      narrow<png_uint_32>(size));
+		if (first) png_write_chunk_data(png, header.data(), header.size());
+		png_write_chunk_data(png, stripe.output.data(), stripe.outputSize);
+		if (last) {
+			std::array<uint8_t, 4> trailer;
+			Endian::writeB32(trailer.data(), narrow<uint32_t>(adler));
+			png_write_chunk_data(png, trailer.data(), trailer.size());
+		}
+		png_write_chunk_end(png);
+	}
+}
+
 static void IMG_SavePNG_RW(size_t width, std::span<const void*> rowPointers,
-                           const std::string& filename, bool color)
+                           const std::string& filename, bool color,
+                           int compressionLevel)
 {
+	assert(0 <= compressionLevel && compressionLevel <= 9);
 	auto height = rowPointers.size();
 	assert(width  <= std::numeric_limits<png_uint_32>::max());
 	assert(height <= std::numeric_limits<png_uint_32>::max());
@@ -295,11 +509,13 @@ static void IMG_SavePNG_RW(size_t width, std::span<const void*> rowPointers,
 		// Write the file header information.  REQUIRED
 		png_write_info(png.ptr, png.info);
 
-		// Write out the entire image data in one call.
-		png_write_image(
-			png.ptr,
-			std::bit_cast<png_bytep*>(const_cast<void**>(rowPointers.data())));
-		png_write_end(png.ptr, png.info);
+		// Compress the image data ourselves (libpng can only do this on a
+		// single core), and write it as IDAT chunks. Because libpng never
+		// saw the image data, png_write_end() would complain, so also
+		// write the IEND chunk ourselves (there's nothing else to write).
+		writeImageData(png.ptr, width * (color ? 3 : 1), color ? 3 : 1,
+		               rowPointers, compressionLevel);
+		png_write_chunk(png.ptr, IEND.data(), nullptr, 0);
 	} catch (MSXException& e) {
 		throw MSXException(
 			"Error while writing PNG file \"", filename, "\": ",
@@ -307,7 +523,7 @@ static void IMG_SavePNG_RW(size_t width, std::span<const void*> rowPointers,
 	}
 }
 
-static void save(SDL_Surface* image, const std::string& filename)
+static void save(SDL_Surface* image, const std::string& filename, int compressionLevel)
 {
 	SDLAllocFormatPtr frmt24(SDL_AllocFormat(
 		Endian::BIG ? SDL_PIXELFORMAT_BGR24 : SDL_PIXELFORMAT_RGB24));
@@ -317,11 +533,11 @@ static void save(SDL_Surface* image, const std::string& filename)
 	small_buffer<const void*, 1080> rowPointers(std::views::transform(xrange(image->h),
 		[&](auto y) { return surf24.getLinePtr(y); }));
 
-	IMG_SavePNG_RW(image->w, rowPointers, filename, true);
+	IMG_SavePNG_RW(image->w, rowPointers, filename, true, compressionLevel);
 }
 
 void saveRGBA(size_t width, std::span<const uint32_t*> rowPointers,
-              const std::string& filename)
+              const std::string& filename, int compressionLevel)
 {
 	// this implementation creates 1 extra copy, can be optimized if required
 	auto height = narrow<unsigned>(rowPointers.size());
@@ -335,24 +551,24 @@ void saveRGBA(size_t width, std::span<const uint32_t*> rowPointers,
 		memcpy(surface.getLinePtr(y),
 		       rowPointers[y], width * sizeof(uint32_t));
 	}
-	save(surface.get(), filename);
+	save(surface.get(), filename, compressionLevel);
 }
 
 
 void saveRGB(size_t width, std::span<const uint8_t*> rowPointers,
-	     const std::string& filename)
+	     const std::string& filename, int compressionLevel)
 {
 	// Each row is width*3 bytes (packed RGB)
 	std::span rowPtrs{std::bit_cast<const void**>(rowPointers.data()), rowPointers.size()};
-	IMG_SavePNG_RW(width, rowPtrs, filename, true);
+	IMG_SavePNG_RW(width, rowPtrs, filename, true, compressionLevel);
 }
 
 void saveGrayscale(size_t width, std::span<const uint8_t*> rowPointers_,
-                   const std::string& filename)
+                   const std::string& filename, int compressionLevel)
 {
 	std::span rowPointers{std::bit_cast<const void**>(rowPointers_.data()),
 	                      rowPointers_.size()};
-	IMG_SavePNG_RW(width, rowPointers, filename, false);
+	IMG_SavePNG_RW(width, rowPointers, filename, false, compressionLevel);
 }
 
 } // namespace openmsx::PNG
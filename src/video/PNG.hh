@@ -18,13 +18,26 @@ namespace openmsx::PNG {
 	 */
 	[[nodiscard]] SDLSurfacePtr load(const std::string& filename, bool want32bpp);
 
+	/** Compression level (zlib, 0-9) used when none is given explicitly.
+	  * Lower levels are faster (e.g. for bulk captures), higher levels
+	  * give smaller files.
+	  */
+	inline constexpr int DEFAULT_COMPRESSION_LEVEL = 6;
+
+	/** Save an image as a PNG file. The image data is compressed on
+	  * multiple threads.
+	  * @param compressionLevel zlib compression level, in range [0, 9].
+	  */
 	void saveRGBA(size_t width, std::span<const uint32_t*> rowPointers,
-	              const std::string& filename);
+	              const std::string& filename,
+	              int compressionLevel = DEFAULT_COMPRESSION_LEVEL);
 	/** Save an RGB (24bpp) buffer as a PNG file. Each row is width*3 bytes. */
 	void saveRGB(size_t width, std::span<const uint8_t*> rowPointers,
-	       const std::string& filename);
+	       const std::string& filename,
+	       int compressionLevel = DEFAULT_COMPRESSION_LEVEL);
 	void saveGrayscale(size_t width, std::span<const uint8_t*> rowPointers,
-	                   const std::string& filename);
+	                   const std::string& filename,
+	                   int compressionLevel = DEFAULT_COMPRESSION_LEVEL);
 
 } // namespace openmsx::PNG
 
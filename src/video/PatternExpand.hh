@@ -0,0 +1,325 @@
+#ifndef PATTERNEXPAND_HH
+#define PATTERNEXPAND_HH
+
+#include "simd.hh"
+#include "xrange.hh"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+
+/** Routines to expand 1bpp VDP character patterns to host pixels, used by
+  * CharacterConverter for all character (text and pattern) modes. They're
+  * in a separate header so they can be tested and benchmarked without a VDP.
+  *
+  * The line routines take the VRAM bytes of a whole display line, gathered by
+  * CharacterConverter, so that the SIMD versions can work on several
+  * characters at once. Like in BitmapConverter, the SSSE3 and AVX2 versions
+  * are selected at run time.
+  */
+namespace openmsx::PatternExpand {
+
+using Pixel = uint32_t;
+
+#ifdef __SSE2__
+// Expand the bits of 'pattern' (msb first) to 8 pixels, stored in 2 vectors.
+struct Pixels8 { __m128i p74, p30; };
+[[nodiscard]] inline Pixels8 expand8(__m128i fg4, __m128i bg4, uint8_t pattern)
+{
+	const __m128i m74 = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+	const __m128i m30 = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i pat = _mm_set1_epi32(pattern);
+
+	__m128i b74 = _mm_cmpeq_epi32(_mm_and_si128(pat, m74), zero);
+	__m128i b30 = _mm_cmpeq_epi32(_mm_and_si128(pat, m30), zero);
+	return {SIMD::select(fg4, bg4, b74), SIMD::select(fg4, bg4, b30)};
+}
+
+// Store all 8 pixels. Also used to draw 6 pixels when the next character
+// overwrites the last 2.
+inline void store8(Pixel* pixelPtr, Pixels8 p)
+{
+	auto* out = std::bit_cast<__m128i*>(pixelPtr);
+	_mm_storeu_si128(out + 0, p.p74);
+	_mm_storeu_si128(out + 1, p.p30);
+}
+
+// Store only the 6 leftmost pixels.
+inline void store6(Pixel* pixelPtr, Pixels8 p)
+{
+	auto* out = std::bit_cast<__m128i*>(pixelPtr);
+	_mm_storeu_si128(out, p.p74);
+	_mm_storel_epi64(out + 1, p.p30);
+}
+#endif
+
+#ifdef SIMD_SSSE3
+// For the text modes: groups of 8 characters of 6 pixels, so 3 vectors of 16
+// pixels. Per pixel (byte) in vector 'i': the character within the group,
+// the mask of its bit in the pattern, and the mask of its bit in the
+// (Text2) attribute byte.
+struct TextMasks {
+	alignas(16) std::array<std::array<uint8_t, 16>, 3> character, patternBit, attributeBit;
+};
+inline constexpr TextMasks TEXT_MASKS = [] {
+	TextMasks result = {};
+	for (auto i : xrange(3u)) {
+		for (auto j : xrange(16u)) {
+			auto x = 16 * i + j;
+			result.character   [i][j] = uint8_t(x / 6);
+			result.patternBit  [i][j] = uint8_t(0x80 >> (x % 6));
+			result.attributeBit[i][j] = uint8_t(0x80 >> (x / 6));
+		}
+	}
+	return result;
+}();
+
+// For the 16 pixels in vector 'i' of a group: all bits set for the pixels of
+// which the pattern bit is set. The patterns of the group are in the lower 8
+// bytes of 'patterns'.
+[[nodiscard]] inline SIMD_TARGET("ssse3") __m128i textPixelMask(__m128i patterns, unsigned i)
+{
+	auto load = [](const std::array<uint8_t, 16>& a) {
+		return _mm_load_si128(std::bit_cast<const __m128i*>(a.data()));
+	};
+	auto bit = load(TEXT_MASKS.patternBit[i]);
+	auto p = _mm_shuffle_epi8(patterns, load(TEXT_MASKS.character[i]));
+	return _mm_cmpeq_epi8(_mm_and_si128(p, bit), bit);
+}
+
+// SSSE3 version of drawText1(): the pixel masks are expanded to 32 bits.
+inline SIMD_TARGET("ssse3") void drawText1SSSE3(
+	Pixel* __restrict pixelPtr, Pixel fg, Pixel bg, std::span<const uint8_t, 40> patterns)
+{
+	auto fg4 = _mm_set1_epi32(int(fg));
+	auto bg4 = _mm_set1_epi32(int(bg));
+	for (auto g : xrange(40u / 8)) {
+		auto pats = _mm_loadl_epi64(std::bit_cast<const __m128i*>(&patterns[8 * g]));
+		for (auto i : xrange(3u)) {
+			auto m = textPixelMask(pats, i);
+			auto m0 = _mm_unpacklo_epi8(m, m);
+			auto m1 = _mm_unpackhi_epi8(m, m);
+			auto* out = std::bit_cast<__m128i*>(pixelPtr);
+			_mm_storeu_si128(out + 0, SIMD::select(bg4, fg4, _mm_unpacklo_epi16(m0, m0)));
+			_mm_storeu_si128(out + 1, SIMD::select(bg4, fg4, _mm_unpackhi_epi16(m0, m0)));
+			_mm_storeu_si128(out + 2, SIMD::select(bg4, fg4, _mm_unpacklo_epi16(m1, m1)));
+			_mm_storeu_si128(out + 3, SIMD::select(bg4, fg4, _mm_unpackhi_epi16(m1, m1)));
+			pixelPtr += 16;
+		}
+	}
+}
+
+// SSSE3 version of drawText2(): the pattern bit and the attribute bit form a
+// palette index of 2 bits.
+inline SIMD_TARGET("ssse3") void drawText2SSSE3(
+	Pixel* __restrict pixelPtr,
+	Pixel plainFg, Pixel plainBg, Pixel blinkFg, Pixel blinkBg,
+	std::span<const uint8_t, 10> attributes, std::span<const uint8_t, 80> patterns)
+{
+	std::array<Pixel, 4> palette = {plainBg, plainFg, blinkBg, blinkFg};
+	auto planes = SIMD::loadPlanes(palette);
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i two = _mm_set1_epi8(2);
+	for (auto g : xrange(80u / 8)) {
+		auto pats = _mm_loadl_epi64(std::bit_cast<const __m128i*>(&patterns[8 * g]));
+		auto attr = _mm_set1_epi8(char(attributes[g]));
+		for (auto i : xrange(3u)) {
+			auto bit = _mm_load_si128(std::bit_cast<const __m128i*>(TEXT_MASKS.attributeBit[i].data()));
+			auto blink = _mm_cmpeq_epi8(_mm_and_si128(attr, bit), bit);
+			auto idx = _mm_or_si128(_mm_and_si128(textPixelMask(pats, i), one),
+			                        _mm_and_si128(blink, two));
+			SIMD::lookup16(planes, idx, pixelPtr);
+			pixelPtr += 16;
+		}
+	}
+}
+#endif
+
+#ifdef SIMD_AVX2
+// AVX2 version of drawGraphic(): one vector per character, the colors are
+// broadcast directly from memory.
+inline SIMD_TARGET("avx2") void drawGraphicAVX2(
+	Pixel* __restrict pixelPtr, std::span<const Pixel, 16> palette,
+	std::span<const uint8_t, 32> patterns, std::span<const uint8_t, 32> colors)
+{
+	const __m256i bits = _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+	for (auto i : xrange(32u)) {
+		auto fg = _mm256_set1_epi32(int(palette[colors[i] >> 4]));
+		auto bg = _mm256_set1_epi32(int(palette[colors[i] & 15]));
+		auto pat = _mm256_set1_epi32(patterns[i]);
+		auto mask = _mm256_cmpeq_epi32(_mm256_and_si256(pat, bits), bits);
+		_mm256_storeu_si256(std::bit_cast<__m256i*>(pixelPtr), _mm256_blendv_epi8(bg, fg, mask));
+		pixelPtr += 8;
+	}
+}
+#endif
+
+/** Draw the 6 leftmost bits of 'pattern' (text modes). */
+inline void draw6(Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, uint8_t pattern)
+{
+#ifdef __SSE2__
+	// SSE2 version, 32bpp
+	store6(pixelPtr, expand8(_mm_set1_epi32(int(fg)), _mm_set1_epi32(int(bg)), pattern));
+	pixelPtr += 6;
+	return;
+#endif
+
+	// C++ version
+	pixelPtr[0] = (pattern & 0x80) ? fg : bg;
+	pixelPtr[1] = (pattern & 0x40) ? fg : bg;
+	pixelPtr[2] = (pattern & 0x20) ? fg : bg;
+	pixelPtr[3] = (pattern & 0x10) ? fg : bg;
+	pixelPtr[4] = (pattern & 0x08) ? fg : bg;
+	pixelPtr[5] = (pattern & 0x04) ? fg : bg;
+	pixelPtr += 6;
+}
+
+/** Draw all 8 bits of 'pattern' (graphic modes). */
+inline void draw8(Pixel* __restrict & pixelPtr, Pixel fg, Pixel bg, uint8_t pattern)
+{
+#ifdef __SSE2__
+	// SSE2 version, 32bpp
+	store8(pixelPtr, expand8(_mm_set1_epi32(int(fg)), _mm_set1_epi32(int(bg)), pattern));
+	pixelPtr += 8;
+	return;
+#endif
+
+	// C++ version
+	pixelPtr[0] = (pattern & 0x80) ? fg : bg;
+	pixelPtr[1] = (pattern & 0x40) ? fg : bg;
+	pixelPtr[2] = (pattern & 0x20) ? fg : bg;
+	pixelPtr[3] = (pattern & 0x10) ? fg : bg;
+	pixelPtr[4] = (pattern & 0x08) ? fg : bg;
+	pixelPtr[5] = (pattern & 0x04) ? fg : bg;
+	pixelPtr[6] = (pattern & 0x02) ? fg : bg;
+	pixelPtr[7] = (pattern & 0x01) ? fg : bg;
+	pixelPtr += 8;
+}
+
+/** Draw a Text1 line: 40 characters of 6 pixels, all in the same colors. */
+inline void drawText1(Pixel* __restrict pixelPtr, Pixel fg, Pixel bg,
+                      std::span<const uint8_t, 40> patterns)
+{
+#ifdef SIMD_SSSE3
+	if (SIMD::hasSSSE3()) {
+		drawText1SSSE3(pixelPtr, fg, bg, patterns);
+		return;
+	}
+#endif
+#ifdef __SSE2__
+	// SSE2 version, 32bpp
+	auto fg4 = _mm_set1_epi32(int(fg));
+	auto bg4 = _mm_set1_epi32(int(bg));
+	for (auto i : xrange(39u)) {
+		store8(pixelPtr, expand8(fg4, bg4, patterns[i]));
+		pixelPtr += 6;
+	}
+	store6(pixelPtr, expand8(fg4, bg4, patterns[39]));
+	return;
+#endif
+
+	// C++ version
+	for (auto pattern : patterns) draw6(pixelPtr, fg, bg, pattern);
+}
+
+/** Draw a Text2 line: 80 characters of 6 pixels. A set bit in 'attributes'
+  * (msb is the leftmost character of a group of 8) selects the blink colors
+  * instead of the plain colors.
+  */
+inline void drawText2(Pixel* __restrict pixelPtr,
+                      Pixel plainFg, Pixel plainBg, Pixel blinkFg, Pixel blinkBg,
+                      std::span<const uint8_t, 10> attributes,
+                      std::span<const uint8_t, 80> patterns)
+{
+#ifdef SIMD_SSSE3
+	if (SIMD::hasSSSE3()) {
+		drawText2SSSE3(pixelPtr, plainFg, plainBg, blinkFg, blinkBg, attributes, patterns);
+		return;
+	}
+#endif
+#ifdef __SSE2__
+	// SSE2 version, 32bpp
+	// The attribute bit selects one of the two color pairs, so the colors
+	// are broadcast only once.
+	struct Colors4 { __m128i fg, bg; };
+	const Colors4 colors[2] = {
+		{_mm_set1_epi32(int(plainFg)), _mm_set1_epi32(int(plainBg))},
+		{_mm_set1_epi32(int(blinkFg)), _mm_set1_epi32(int(blinkBg))},
+	};
+	for (auto g : xrange(80u / 8)) {
+		unsigned attr = attributes[g];
+		for (auto n : xrange(8u)) {
+			const auto& c = colors[(attr >> (7 - n)) & 1];
+			auto p = expand8(c.fg, c.bg, patterns[8 * g + n]);
+			if ((8 * g + n) != 79) {
+				store8(pixelPtr, p);
+			} else {
+				store6(pixelPtr, p);
+			}
+			pixelPtr += 6;
+		}
+	}
+	return;
+#endif
+
+	// C++ version
+	for (auto i : xrange(80u)) {
+		bool blink = (attributes[i / 8] << (i % 8)) & 0x80;
+		draw6(pixelPtr, blink ? blinkFg : plainFg, blink ? blinkBg : plainBg, patterns[i]);
+	}
+}
+
+/** Draw a Graphic1-3 line: 32 characters of 8 pixels. The high (low) nibble
+  * of 'colors[i]' is the palette index for the 1-bits (0-bits) of
+  * 'patterns[i]'.
+  */
+inline void drawGraphic(Pixel* __restrict pixelPtr, std::span<const Pixel, 16> palette,
+                        std::span<const uint8_t, 32> patterns,
+                        std::span<const uint8_t, 32> colors)
+{
+#ifdef SIMD_AVX2
+	if (SIMD::hasAVX2()) {
+		drawGraphicAVX2(pixelPtr, palette, patterns, colors);
+		return;
+	}
+#endif
+	// SSE2 (in draw8()) or C++ version
+	for (auto i : xrange(32u)) {
+		draw8(pixelPtr, palette[colors[i] >> 4], palette[colors[i] & 15], patterns[i]);
+	}
+}
+
+/** Draw a Multicolor line: 32 blocks of 8 pixels, the left (right) 4 pixels
+  * have the color of the high (low) nibble of 'colors[i]'.
+  */
+inline void drawMulti(Pixel* __restrict pixelPtr, std::span<const Pixel, 16> palette,
+                      std::span<const uint8_t, 32> colors)
+{
+#ifdef __SSE2__
+	// SSE2 version, 32bpp
+	for (auto i : xrange(32u)) {
+		store8(pixelPtr, {_mm_set1_epi32(int(palette[colors[i] >> 4])),
+		                  _mm_set1_epi32(int(palette[colors[i] & 15]))});
+		pixelPtr += 8;
+	}
+	return;
+#endif
+
+	// C++ version
+	for (auto i : xrange(32u)) {
+		Pixel cl = palette[colors[i] >> 4];
+		Pixel cr = palette[colors[i] & 15];
+		pixelPtr[0] = cl; pixelPtr[1] = cl;
+		pixelPtr[2] = cl; pixelPtr[3] = cl;
+		pixelPtr[4] = cr; pixelPtr[5] = cr;
+		pixelPtr[6] = cr; pixelPtr[7] = cr;
+		pixelPtr += 8;
+	}
+}
+
+} // namespace openmsx::PatternExpand
+
+#endif
@@ -0,0 +1,202 @@
+#include "PipeWriter.hh"
+
+#include "FileException.hh"
+#include "FrameSource.hh"
+#include "PixelOperations.hh"
+
+#include "endian.hh"
+#include "narrow.hh"
+#include "ranges.hh"
+#include "small_buffer.hh"
+#include "strCat.hh"
+#include "unreachable.hh"
+#include "xrange.hh"
+
+#include <cassert>
+#include <cmath>
+
+#ifndef _WIN32
+#include <csignal>
+#endif
+
+namespace openmsx {
+
+PipeWriter::PipeWriter(const std::string& filename, Format format_,
+                       unsigned width_, unsigned height_,
+                       unsigned channels_, unsigned freq_)
+	: file(filename, "wb") // for a named pipe this blocks until the reader is there
+	, format(format_)
+	, width(width_)
+	, height(height_)
+	, channels(channels_)
+	, audioRate(freq_)
+{
+	if (format == Format::Y4M) {
+		planes.resize(3 * size_t(width) * height);
+	}
+	for (auto& frame : queue) {
+		frame.pixels.resize(size_t(width) * height);
+	}
+	thread = std::thread([this] { writerLoop(); });
+}
+
+PipeWriter::~PipeWriter()
+{
+	{
+		std::scoped_lock lock(mutex);
+		stop = true;
+	}
+	cond.notify_all();
+	thread.join();
+}
+
+void PipeWriter::addFrame(const FrameSource* video, std::span<const int16_t> audio)
+{
+	std::unique_lock lock(mutex);
+	if (!error.empty()) throw FileException(error);
+	if (!headerWritten && (fps == 0.0f)) return; // frame rate not yet known
+	cond.wait(lock, [&] { return queued < QUEUE_SIZE; });
+	// The writer thread doesn't touch this entry until it's queued.
+	auto& frame = queue[(first + queued) % QUEUE_SIZE];
+	lock.unlock();
+
+	frame.header.clear();
+	if (!headerWritten) {
+		auto rate = lrintf(fps * 1000.0f);
+		frame.header = (format == Format::Y4M)
+			? strCat("YUV4MPEG2 W", width, " H", height, " F", rate, ":1000 Ip A1:1 C444\n")
+			: strCat("OPENMSX-RAW W", width, " H", height, " F", rate, ":1000 A",
+			         audioRate, ':', channels, '\n');
+		headerWritten = true;
+	}
+	for (auto y : xrange(height)) {
+		auto dest = std::span{frame.pixels}.subspan(y * size_t(width), width);
+		auto line = getLine(video, y, dest);
+		if (line.data() != dest.data()) copy_to_range(line, dest);
+	}
+	if (format == Format::RAW) {
+		frame.audio.assign(audio.begin(), audio.end());
+	}
+
+	lock.lock();
+	++queued;
+	lock.unlock();
+	cond.notify_all();
+}
+
+void PipeWriter::writerLoop()
+{
+#ifndef _WIN32
+	// When the reader goes away, we want a write error (which stops the
+	// recording) instead of getting killed by SIGPIPE. Only block it for
+	// this thread: a (process-wide) SIG_IGN would also change the
+	// behavior of the rest of openMSX.
+	sigset_t sigPipe;
+	sigemptyset(&sigPipe);
+	sigaddset(&sigPipe, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &sigPipe, nullptr);
+#endif
+	std::unique_lock lock(mutex);
+	while (true) {
+		cond.wait(lock, [&] { return stop || queued; });
+		if (!queued) return; // stopped, and all frames are written
+		const auto& frame = queue[first];
+		bool ok = error.empty(); // after an error, drop the remaining frames
+		lock.unlock();
+		std::string newError;
+		if (ok) {
+			try {
+				writeFrame(frame);
+			} catch (MSXException& e) {
+				newError = e.getMessage();
+			}
+		}
+		lock.lock();
+		if (!newError.empty()) error = std::move(newError);
+		first = (first + 1) % QUEUE_SIZE;
+		--queued;
+		cond.notify_all();
+	}
+}
+
+void PipeWriter::writeFrame(const Frame& frame)
+{
+	if (!frame.header.empty()) {
+		file.write(std::span{frame.header});
+	}
+	if (format == Format::Y4M) {
+		writeY4MFrame(frame);
+	} else {
+		writeRawFrame(frame);
+		writeAudio(frame.audio);
+	}
+	file.flush();
+}
+
+std::span<const uint32_t> PipeWriter::getLine(
+	const FrameSource* video, unsigned y, std::span<uint32_t> buf) const
+{
+	switch (height) {
+	case 240:
+		return video->getLinePtr320_240(y, buf.first<320>());
+	case 480:
+		return video->getLinePtr640_480(y, buf.first<640>());
+	case 720:
+		return video->getLinePtr960_720(y, buf.first<960>());
+	default:
+		UNREACHABLE;
+	}
+}
+
+void PipeWriter::writeY4MFrame(const Frame& frame)
+{
+	// RGB -> YCbCr (BT.601, limited range), one full plane after the other.
+	PixelOperations pixelOps;
+	auto planeSize = size_t(width) * height;
+	uint8_t* yPlane = planes.data();
+	uint8_t* uPlane = yPlane + planeSize;
+	uint8_t* vPlane = uPlane + planeSize;
+	for (auto p : frame.pixels) {
+		int r = int(pixelOps.red  (p));
+		int g = int(pixelOps.green(p));
+		int b = int(pixelOps.blue (p));
+		*yPlane++ = uint8_t((( 66 * r + 129 * g +  25 * b + 128) >> 8) +  16);
+		*uPlane++ = uint8_t(((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128);
+		*vPlane++ = uint8_t(((112 * r -  94 * g -  18 * b + 128) >> 8) + 128);
+	}
+	static constexpr std::string_view FRAME = "FRAME\n";
+	file.write(std::span{FRAME});
+	file.write(std::span{planes});
+}
+
+void PipeWriter::writeRawFrame(const Frame& frame)
+{
+	static constexpr std::string_view FRAME = "FRAME\n";
+	file.write(std::span{FRAME});
+	// Pixels are stored with red in the lowest byte.
+	if constexpr (Endian::BIG) {
+		for (auto y : xrange(height)) {
+			auto line = std::span{frame.pixels}.subspan(y * size_t(width), width);
+			small_buffer<Endian::L32, 960> buf(line);
+			file.write(std::span{buf});
+		}
+	} else {
+		file.write(std::span{frame.pixels});
+	}
+}
+
+void PipeWriter::writeAudio(std::span<const int16_t> audio)
+{
+	if (audio.empty()) return;
+	assert((audio.size() % channels) == 0);
+	auto header = strCat("AUDIO ", audio.size_bytes(), '\n');
+	file.write(std::span{header});
+	if constexpr (Endian::BIG) {
+		small_buffer<Endian::L16, 4096> buf(audio);
+		file.write(std::span{buf});
+	} else {
+		file.write(audio);
+	}
+}
+
+} // namespace openmsx
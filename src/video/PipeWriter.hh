@@ -0,0 +1,97 @@
+#ifndef PIPEWRITER_HH
+#define PIPEWRITER_HH
+
+#include "File.hh"
+
+#include "MemBuffer.hh"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+class FrameSource;
+
+/** Writes uncompressed video (and audio) frames, typically to a named pipe
+  * (or e.g. /dev/fd/N) from which an external encoder reads. Nothing is
+  * compressed. The frames are captured in a small queue, converting and
+  * writing them is done on a separate thread. So a slow reader only stalls
+  * the emulation when that queue is full.
+  *
+  * Two formats are supported:
+  * - Y4M: YUV4MPEG2 (4:4:4 planes, BT.601), video only. This can directly
+  *   be read by e.g. ffmpeg or x264.
+  * - RAW: a header line
+  *     "OPENMSX-RAW W<width> H<height> F<num>:<den> A<rate>:<channels>\n"
+  *   followed by "FRAME\n" chunks, each with width x height RGBA pixels,
+  *   and "AUDIO <bytes>\n" chunks with 16-bit little endian PCM samples.
+  */
+class PipeWriter
+{
+public:
+	enum class Format : uint8_t { Y4M, RAW };
+
+	PipeWriter(const std::string& filename, Format format,
+	           unsigned width, unsigned height,
+	           unsigned channels, unsigned freq);
+	PipeWriter(const PipeWriter&) = delete;
+	PipeWriter(PipeWriter&&) = delete;
+	PipeWriter& operator=(const PipeWriter&) = delete;
+	PipeWriter& operator=(PipeWriter&&) = delete;
+	/** Waits till all queued frames are written. */
+	~PipeWriter();
+
+	/** The header contains the frame rate, so nothing is written (the
+	  * frame and audio is dropped) until the frame rate is known.
+	  * Throws FileException when writing an earlier frame failed.
+	  */
+	void addFrame(const FrameSource* video, std::span<const int16_t> audio);
+	void setFps(float fps_) { fps = fps_; }
+
+private:
+	struct Frame {
+		std::string header; // only for the first frame
+		std::vector<uint32_t> pixels;
+		std::vector<int16_t> audio;
+	};
+
+	void writerLoop();
+	void writeFrame(const Frame& frame);
+	void writeY4MFrame(const Frame& frame);
+	void writeRawFrame(const Frame& frame);
+	void writeAudio(std::span<const int16_t> audio);
+	[[nodiscard]] std::span<const uint32_t> getLine(
+		const FrameSource* video, unsigned y, std::span<uint32_t> buf) const;
+
+private:
+	File file; // only used by the writer thread (after construction)
+	MemBuffer<uint8_t> planes; // only for Y4M
+
+	static constexpr size_t QUEUE_SIZE = 4;
+	std::array<Frame, QUEUE_SIZE> queue;
+	size_t first = 0; // index in 'queue' of the oldest frame
+	size_t queued = 0; // number of frames in 'queue'
+	std::string error; // set when writing failed
+	bool stop = false;
+	std::mutex mutex; // protects the 5 members above
+	std::condition_variable cond; // signals changes in 'queued' or 'stop'
+	std::thread thread;
+
+	float fps = 0.0f;
+	const Format format;
+	const unsigned width;
+	const unsigned height;
+	const unsigned channels;
+	const unsigned audioRate;
+	bool headerWritten = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -29,6 +29,7 @@ TODO:
 #include "narrow.hh"
 #include "one_of.hh"
 #include "unreachable.hh"
+#include "xrange.hh"
 
 #include <algorithm>
 #include <cassert>
@@ -126,6 +127,7 @@ PixelRenderer::PixelRenderer(VDP& vdp_, Display& display)
 	, videoSourceSetting(vdp.getMotherBoard().getVideoSource())
 	, spriteChecker(vdp.getSpriteChecker())
 	, rasterizer(display.getVideoSystem().createRasterizer(vdp))
+	, lineReuse(VDP::NUM_LINES_MAX)
 {
 	// In case of loadstate we can't yet query any state from the VDP
 	// (because that object is not yet fully deserialized). But
@@ -166,6 +168,7 @@ void PixelRenderer::reInit()
 	// renderer in the middle of a frame.
 	renderFrame = false;
 	paintFrame = false;
+	lineReuse.invalidate(); // don't reuse lines from before
 
 	rasterizer->reset();
 	displayEnabled = vdp.isDisplayEnabled();
@@ -179,6 +182,17 @@ void PixelRenderer::updateDisplayEnabled(bool enabled, EmuTime time)
 
 void PixelRenderer::frameStart(EmuTime time)
 {
+	// Interlace, even/odd page alternation, fast blink and superimposed
+	// video make every frame different from the previous one.
+	FrameState frameState{.palTiming = vdp.isPalTiming(),
+	                      .disableSprites = renderSettings.getDisableSprites()};
+	if (frameState != lastFrameState ||
+	    vdp.isInterlaced() || vdp.isEvenOddEnabled() ||
+	    vdp.isFastBlinkEnabled() || vdp.isSuperimposing()) {
+		lineReuse.invalidate();
+	}
+	lastFrameState = frameState;
+
 	if (!rasterizer->isActive()) {
 		frameSkipCounter = 999.0f;
 		renderFrame = false;
@@ -269,6 +283,7 @@ void PixelRenderer::updateHorizontalScrollLow(
 	uint8_t scroll, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 	rasterizer->setHorizontalScrollLow(scroll);
 }
 
@@ -276,12 +291,14 @@ void PixelRenderer::updateHorizontalScrollHigh(
 	uint8_t /*scroll*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateBorderMask(
 	bool masked, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 	rasterizer->setBorderMask(masked);
 }
 
@@ -289,12 +306,14 @@ void PixelRenderer::updateMultiPage(
 	bool /*multiPage*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateTransparency(
 	bool enabled, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 	rasterizer->setTransparency(enabled);
 }
 
@@ -302,6 +321,7 @@ void PixelRenderer::updateSuperimposing(
 	const RawFrame* videoSource, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 	rasterizer->setSuperimposeVideoFrame(videoSource);
 }
 
@@ -309,12 +329,14 @@ void PixelRenderer::updateForegroundColor(
 	uint8_t /*color*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateBackgroundColor(
 	uint8_t color, EmuTime time)
 {
 	sync(time);
+	lineReuse.invalidate();
 	rasterizer->setBackgroundColor(color);
 }
 
@@ -322,12 +344,14 @@ void PixelRenderer::updateBlinkForegroundColor(
 	uint8_t /*color*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateBlinkBackgroundColor(
 	uint8_t /*color*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateBlinkState(
@@ -338,6 +362,7 @@ void PixelRenderer::updateBlinkState(
 	//       I don't know why exactly, but it's probably related to
 	//       being called at frame start.
 	//sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updatePalette(
@@ -359,6 +384,7 @@ void PixelRenderer::updatePalette(
 			}
 		}
 	}
+	lineReuse.invalidate();
 	rasterizer->setPalette(index, grb);
 }
 
@@ -366,12 +392,14 @@ void PixelRenderer::updateVerticalScroll(
 	int /*scroll*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateHorizontalAdjust(
 	int adjust, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 	rasterizer->setHorizontalAdjust(adjust);
 }
 
@@ -387,6 +415,7 @@ void PixelRenderer::updateDisplayMode(
 	|| mode.getByte() == DisplayMode::GRAPHIC7) {
 		sync(time, true);
 	}
+	lineReuse.invalidate();
 	rasterizer->setDisplayMode(mode);
 }
 
@@ -394,24 +423,49 @@ void PixelRenderer::updateNameBase(
 	unsigned /*addr*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updatePatternBase(
 	unsigned /*addr*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateColorBase(
 	unsigned /*addr*/, EmuTime time)
 {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateSpritesEnabled(
 	bool /*enabled*/, EmuTime time
 ) {
 	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
+}
+
+void PixelRenderer::updateSpriteAttributeBase(
+	unsigned /*addr*/, EmuTime time)
+{
+	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
+}
+
+void PixelRenderer::updateSpritePatternBase(
+	unsigned /*addr*/, EmuTime time)
+{
+	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
+}
+
+void PixelRenderer::updateSpriteSizeMag(
+	uint8_t /*sizeMag*/, EmuTime time)
+{
+	if (displayEnabled) sync(time);
+	lineReuse.invalidate();
 }
 
 static constexpr bool overlap(
@@ -522,6 +576,25 @@ bool PixelRenderer::checkSync(unsigned offset, EmuTime time) const
 	}
 }
 
+bool PixelRenderer::isVRAMDisplayed(unsigned address, unsigned freeBits) const
+{
+	// For now only the (common) case of drawing to an invisible page in
+	// Graphic 4/5 is detected, see also checkSync(). A later page flip
+	// goes through updateNameBase() or updateDisplayMode(), and at the
+	// start of each frame, the even/odd page can only change in modes
+	// where frameStart() already invalidates all lines.
+	auto base = vdp.getDisplayMode().getBase();
+	if (((base != DisplayMode::GRAPHIC4) && (base != DisplayMode::GRAPHIC5)) ||
+	    vdp.isFastBlinkEnabled() || (freeBits & 0x18000)) {
+		return true;
+	}
+	unsigned page = address & 0x18000;
+	unsigned visiblePage = vram.nameTable.getMask()
+		& (0x10000 | (vdp.getEvenOddMask() << 7));
+	return (page == visiblePage)
+	    || (vdp.isMultiPageScrolling() && (page == (visiblePage & 0x10000)));
+}
+
 void PixelRenderer::updateVRAM(unsigned offset, EmuTime time)
 {
 	// Note: No need to sync if display is disabled, because then the
@@ -529,6 +602,7 @@ void PixelRenderer::updateVRAM(unsigned offset, EmuTime time)
 	if (renderFrame && displayEnabled && checkSync(offset, time)) {
 		renderUntil(time);
 	}
+	lineReuse.invalidate();
 }
 
 void PixelRenderer::updateWindow(bool /*enabled*/, EmuTime /*time*/)
@@ -592,12 +666,32 @@ void PixelRenderer::renderUntil(EmuTime time)
 	// Also it is a small performance optimisation.
 	if (limitX == nextX && limitY == nextY) return;
 
-	if (displayEnabled) {
-		if (vdp.spritesEnabled()) {
-			// Update sprite checking, so that rasterizer can call getSprites.
-			spriteChecker.checkUntil(time);
+	if (displayEnabled && vdp.spritesEnabled()) {
+		// Update sprite checking, so that rasterizer can call getSprites.
+		spriteChecker.checkUntil(time);
+	}
+
+	// Lines that are completely rendered by this call are rendered one by
+	// one, so that lines which didn't change since the previous frame can
+	// be copied instead.
+	int fullStartY = (nextX == 0) ? nextY : nextY + 1;
+	if (fullStartY < limitY) {
+		if (nextX != 0) renderArea(nextX, nextY, 0, fullStartY);
+		for (auto y : xrange(fullStartY, limitY)) {
+			renderLine(y);
 		}
+		if (limitX != 0) renderArea(0, limitY, limitX, limitY);
+	} else {
+		renderArea(nextX, nextY, limitX, limitY);
+	}
 
+	nextX = limitX;
+	nextY = limitY;
+}
+
+void PixelRenderer::renderArea(int startX, int startY, int endX, int endY)
+{
+	if (displayEnabled) {
 		// Calculate start and end of borders in ticks since start of line.
 		// The 0..7 extra horizontal scroll low pixels should be drawn in
 		// border color. These will be drawn together with the border,
@@ -612,21 +706,25 @@ void PixelRenderer::renderUntil(EmuTime time)
 		// It's important that right border is drawn last (after left
 		// border and display area). See comment in SDLRasterizer::drawBorder().
 		// Left border.
-		subdivide(nextX, nextY, limitX, limitY,
+		subdivide(startX, startY, endX, endY,
 			0, displayL, DRAW_BORDER);
 		// Display area.
-		subdivide(nextX, nextY, limitX, limitY,
+		subdivide(startX, startY, endX, endY,
 			displayL, borderR, DRAW_DISPLAY);
 		// Right border.
-		subdivide(nextX, nextY, limitX, limitY,
+		subdivide(startX, startY, endX, endY,
 			borderR, VDP::TICKS_PER_LINE, DRAW_BORDER);
 	} else {
-		subdivide(nextX, nextY, limitX, limitY,
+		subdivide(startX, startY, endX, endY,
 			0, VDP::TICKS_PER_LINE, DRAW_BORDER);
 	}
+}
 
-	nextX = limitX;
-	nextY = limitY;
+void PixelRenderer::renderLine(int y)
+{
+	lineReuse.renderLine(y, textModeCounter, vdp.getLineZero(), displayEnabled,
+		[&] { return rasterizer->copyLineFromLastFrame(y); },
+		[&] { renderArea(0, y, 0, y + 1); });
 }
 
 void PixelRenderer::update(const Setting& setting) noexcept
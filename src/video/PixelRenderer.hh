@@ -1,6 +1,7 @@
 #ifndef PIXELRENDERER_HH
 #define PIXELRENDERER_HH
 
+#include "LineReuseTracker.hh"
 #include "RenderSettings.hh"
 #include "Renderer.hh"
 
@@ -60,6 +61,10 @@ public:
 	void updatePatternBase(unsigned addr, EmuTime time) override;
 	void updateColorBase(unsigned addr, EmuTime time) override;
 	void updateSpritesEnabled(bool enabled, EmuTime time) override;
+	void updateSpriteAttributeBase(unsigned addr, EmuTime time) override;
+	void updateSpritePatternBase(unsigned addr, EmuTime time) override;
+	void updateSpriteSizeMag(uint8_t sizeMag, EmuTime time) override;
+	[[nodiscard]] bool isVRAMDisplayed(unsigned address, unsigned freeBits) const override;
 	void updateVRAM(unsigned offset, EmuTime time) override;
 	void updateWindow(bool enabled, EmuTime time) override;
 
@@ -88,6 +93,17 @@ private:
 		int startX, int startY, int endX, int endY,
 		int clipL, int clipR, DrawType drawType);
 
+	/** Render the area between two scan positions: border and display
+	  * (when enabled).
+	  */
+	void renderArea(int startX, int startY, int endX, int endY);
+
+	/** Render one complete line. When nothing that influences this line
+	  * changed since it was drawn in the previous frame, it is copied from
+	  * that frame instead.
+	  */
+	void renderLine(int y);
+
 	[[nodiscard]] bool checkSync(unsigned offset, EmuTime time) const;
 
 	/** Update renderer state to specified moment in time.
@@ -169,6 +185,21 @@ private:
 	  * Used to force a minimal paint rate when throttle is off.
 	  */
 	uint64_t lastPaintTime = 0;
+
+	/** Decides which lines can be copied from the previous frame.
+	  */
+	LineReuseTracker lineReuse;
+
+	/** State that is not reported via the update methods, but that can
+	  * only change at the start of a frame.
+	  */
+	struct FrameState {
+		bool palTiming = false;
+		bool disableSprites = false;
+
+		[[nodiscard]] bool operator==(const FrameState&) const = default;
+	};
+	FrameState lastFrameState;
 };
 
 } // namespace openmsx
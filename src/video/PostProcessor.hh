@@ -1,15 +1,21 @@
-#ifndef GLPOSTPROCESSOR_HH
-#define GLPOSTPROCESSOR_HH
+#ifndef POSTPROCESSOR_HH
+#define POSTPROCESSOR_HH
 
-#include "GLUtil.hh"
+#include "FrameRequest.hh"
 #include "RenderSettings.hh"
 #include "VideoLayer.hh"
 
 #include "EmuTime.hh"
 #include "Schedulable.hh"
 
+#include "MemBuffer.hh"
+#include "aligned.hh"
+
 #include <array>
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace openmsx {
@@ -22,27 +28,22 @@ class Display;
 class DoubledFrame;
 class EventDistributor;
 class FrameSource;
-class GLScaler;
 class MSXMotherBoard;
+class OutputSurface;
 class RawFrame;
-class RenderSettings;
 class SuperImposedFrame;
 
 /** A post processor builds the frame that is displayed from the MSX frame,
   * while applying effects such as scalers, noise etc.
+  * This base class manages the stream of MSX frames (deinterlace, deflicker,
+  * superimpose, recording), subclasses bring the result to an actual
+  * output surface (see GLPostProcessor and SWPostProcessor).
   */
-class PostProcessor final : public VideoLayer, private Schedulable
+class PostProcessor : public VideoLayer, private Schedulable
 {
 public:
-	PostProcessor(
-		MSXMotherBoard& motherBoard, Display& display,
-		OutputSurface& screen, const std::string& videoSource,
-		unsigned maxWidth, unsigned height, bool canDoInterlace);
 	~PostProcessor() override;
 
-	// Layer interface:
-	void paint(OutputSurface& output) override;
-
 	/** Sets up the "abcdFrame" variables for a new frame.
 	  * TODO: The point of passing the finished frame in and the new workFrame
 	  *       out is to be able to split off the scaler application as a
@@ -99,36 +100,83 @@ public:
 		return lastFramesCount > 0 ? lastFrames[0].get() : nullptr;
 	}
 
+	/** Is anyone going to use the next frame? If not, the renderer can
+	  * skip rasterizing it (the VDP timing state is maintained anyway).
+	  * Frames are wanted when they are displayed, recorded or explicitly
+	  * requested, or when the 'render_on_demand' setting is disabled.
+	  */
+	[[nodiscard]] bool isFrameWanted() const;
+
+	/** Make sure a frame with content from after this call gets rendered
+	  * and published (see getPaintFrame()), see isFrameWanted().
+	  */
+	void requestFrame() { frameRequest.request(); }
+	/** Was a frame requested that's not yet published? */
+	[[nodiscard]] bool isFrameRequested() const { return frameRequest.isPending(); }
+
 	// VideoLayer
-	void takeRawScreenShot(std::optional<unsigned> height, const std::string& filename) override;
+	void takeRawScreenShot(std::optional<unsigned> height, const std::string& filename,
+	                       int compressionLevel) override;
 
 	[[nodiscard]] CliComm& getCliComm();
 
-private:
-	// Observer<Setting> interface:
-	void update(const Setting& setting) noexcept override;
+protected:
+	PostProcessor(
+		MSXMotherBoard& motherBoard, Display& display,
+		OutputSurface& screen, const std::string& videoSource,
+		unsigned maxWidth, unsigned height, bool canDoInterlace);
 
-	// Schedulable
-	void executeUntil(EmuTime time) override;
+	/** Called by rotateFrames() when 'paintFrame' has changed. Subclasses
+	  * make the new frame ready for painting here (e.g. upload it to a
+	  * texture).
+	  */
+	virtual void uploadFrame() = 0;
+
+	/** Is the output continuously shown to the user? */
+	[[nodiscard]] virtual bool isDisplayed() const { return true; }
 
 	/** Returns the maximum width for lines [y..y+step).
 	  */
-	[[nodiscard]] static unsigned getLineWidth(FrameSource* frame, unsigned y, unsigned step);
-
-	void initBuffers();
-	void createRegions();
-	void uploadFrame();
-	void uploadBlock(unsigned srcStartY, unsigned srcEndY,
-	                 unsigned lineWidth);
+	[[nodiscard]] static unsigned getLineWidth(const FrameSource* frame, unsigned y, unsigned step);
 
-	void preCalcNoise(float factor);
-	void drawNoise() const;
-	void drawGlow(int glow);
+	/** A block of source lines with equal width, and the output lines
+	  * they're scaled to.
+	  */
+	struct Region {
+		Region(unsigned srcStartY_, unsigned srcEndY_,
+		       unsigned dstStartY_, unsigned dstEndY_,
+		       unsigned lineWidth_)
+			: srcStartY(srcStartY_)
+			, srcEndY(srcEndY_)
+			, dstStartY(dstStartY_)
+			, dstEndY(dstEndY_)
+			, lineWidth(lineWidth_) {}
+		unsigned srcStartY;
+		unsigned srcEndY;
+		unsigned dstStartY;
+		unsigned dstEndY;
+		unsigned lineWidth;
+	};
+	/** Split 'frame' in regions that can each be handed to a scaler,
+	  * together they cover 'dstHeight' output lines.
+	  */
+	[[nodiscard]] static std::vector<Region> calcRegions(
+		const FrameSource* frame, unsigned dstHeight);
 
-	void preCalcMonitor3D(float width);
-	void drawMonitor3D() const;
+	/** Scale 'frame' to 320x240 or 640x480 (depending on the size of
+	  * 'lines'). The resulting line pointers point either inside 'frame'
+	  * or inside 'workBuffer'.
+	  */
+	using WorkBuffer = std::vector<MemBuffer<uint32_t, SSE_ALIGNMENT>>;
+	static void getScaledFrame(const FrameSource& frame,
+	                           std::span<const uint32_t*> lines,
+	                           WorkBuffer& workBuffer);
 
 private:
+	// Schedulable
+	void executeUntil(EmuTime time) override;
+
+protected:
 	Display& display;
 	RenderSettings& renderSettings;
 	EventDistributor& eventDistributor;
@@ -176,65 +224,14 @@ private:
 	  */
 	const bool canDoInterlace;
 
-	EmuTime lastRotate;
-	/** The currently active scaler.
-	  */
-	std::unique_ptr<GLScaler> currScaler;
+	/** Someone asked for a fresh frame, see requestFrame(). */
+	FrameRequest frameRequest;
 
-	struct StoredFrame {
-		gl::ivec2 size; // (re)allocate when window size changes
-		gl::Texture tex;
-		gl::FrameBufferObject fbo;
-	};
-	std::array<StoredFrame, 2> renderedFrames;
-
-	// Noise effect:
-	gl::Texture noiseTextureA{true, true}; // interpolate + wrap
-	gl::Texture noiseTextureB{true, true};
-	float noiseX = 0.0f, noiseY = 0.0f;
-
-	struct TextureData {
-		gl::ColorTexture tex;
-		[[nodiscard]] unsigned width() const { return tex.getWidth(); }
-	};
-	std::vector<TextureData> textures;
-	gl::PixelBuffer<unsigned> pbo;
-
-	gl::ColorTexture superImposeTex;
-
-	struct Region {
-		Region(unsigned srcStartY_, unsigned srcEndY_,
-		       unsigned dstStartY_, unsigned dstEndY_,
-		       unsigned lineWidth_)
-			: srcStartY(srcStartY_)
-			, srcEndY(srcEndY_)
-			, dstStartY(dstStartY_)
-			, dstEndY(dstEndY_)
-			, lineWidth(lineWidth_) {}
-		unsigned srcStartY;
-		unsigned srcEndY;
-		unsigned dstStartY;
-		unsigned dstEndY;
-		unsigned lineWidth;
-	};
-	std::vector<Region> regions;
-	unsigned regionsDstHeight = 0; // 'regions' were calculated for this output height (relevant when changing scale_factor when paused)
+	EmuTime lastRotate;
 
 	unsigned frameCounter = 0;
-
-	/** Currently active scale algorithm, used to detect scaler changes.
-	  */
-	RenderSettings::ScaleAlgorithm scaleAlgorithm = RenderSettings::ScaleAlgorithm::NO;
-
-	gl::ShaderProgram monitor3DProg;
-	gl::BufferObject arrayBuffer;
-	gl::BufferObject elementBuffer;
-	gl::BufferObject vbo;
-	gl::BufferObject stretchVBO;
-
-	bool storedFrame = false;
 };
 
 } // namespace openmsx
 
-#endif // GLPOSTPROCESSOR_HH
+#endif // POSTPROCESSOR_HH
@@ -105,6 +105,17 @@ public:
 		int displayX, int displayY,
 		int displayWidth, int displayHeight) = 0;
 
+	/** Copy a complete line (borders, display and sprites) from the
+	  * previous frame instead of drawing it again.
+	  * The caller guarantees that none of the VDP state that influences
+	  * this line changed since it was drawn in the previous frame.
+	  * @param line Y coordinate of the line in absolute lines.
+	  * @return False if the line could not be copied, for example because
+	  *         the rasterizer itself changed (e.g. palette settings). In
+	  *         that case the caller must draw the line normally.
+	  */
+	[[nodiscard]] virtual bool copyLineFromLastFrame(int line) = 0;
+
 	/** Is video recording active?
 	  */
 	[[nodiscard]] virtual bool isRecording() const = 0;
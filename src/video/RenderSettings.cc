@@ -36,7 +36,8 @@ EnumSetting<RenderSettings::RendererID>::Map RenderSettings::getRendererMap()
 	EnumSetting<RendererID>::Map rendererMap = {
 		{"uninitialized", UNINITIALIZED},
 		{"none",          DUMMY},
-		{"SDLGL-PP",      SDLGL_PP}
+		{"SDLGL-PP",      SDLGL_PP},
+		{"headless",      HEADLESS}
 	};
 	return rendererMap;
 }
@@ -178,6 +179,14 @@ RenderSettings::RenderSettings(CommandController& commandController)
 		"Useful on (100Hz+) lightboost enabled monitors to reduce "
 		"motion blur and double frame artifacts.",
 		false)
+	, renderOnDemandSetting(commandController,
+		"render_on_demand",
+		"Only render MSX frames when they are actually needed. Frames "
+		"that are shown on screen or recorded are always rendered, so "
+		"this only makes a difference for the headless renderer: there "
+		"frames are then only rendered while recording or after a "
+		"screenshot was taken.",
+		false)
 {
 	brightnessSetting.attach(*this);
 	contrastSetting  .attach(*this);
@@ -28,7 +28,7 @@ public:
 	/** Enumeration of Renderers known to openMSX.
 	  * This is the full list, the list of available renderers may be smaller.
 	  */
-	enum class RendererID : uint8_t { UNINITIALIZED, DUMMY, SDLGL_PP };
+	enum class RendererID : uint8_t { UNINITIALIZED, DUMMY, SDLGL_PP, HEADLESS };
 	using RendererSetting = EnumSetting<RendererID>;
 
 	/** Render accuracy: granularity of the rendered area.
@@ -163,6 +163,10 @@ public:
 	[[nodiscard]] BooleanSetting& getFullStretchSetting() { return fullStretchSetting; }
 	[[nodiscard]] bool getFullStretch() const { return fullStretchSetting.getBoolean(); }
 
+	/** Only render frames that are actually used (see
+	  * PostProcessor::isFrameWanted()). */
+	[[nodiscard]] bool getRenderOnDemand() const { return renderOnDemandSetting.getBoolean(); }
+
 	/** Amount of horizontal stretch.
 	  * This number represents the amount of MSX pixels (normal width) that
 	  * will be stretched to the complete width of the host window. */
@@ -246,6 +250,7 @@ private:
 	FloatSetting horizontalStretchSetting;
 	FloatSetting pointerHideDelaySetting;
 	BooleanSetting interleaveBlackFrameSetting;
+	BooleanSetting renderOnDemandSetting;
 
 	float brightness;
 	float contrast;
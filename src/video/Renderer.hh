@@ -182,6 +182,35 @@ public:
 	  */
 	virtual void updateSpritesEnabled(bool enabled, EmuTime time) = 0;
 
+	/** Informs the renderer of a sprite attribute table base address change.
+	  * @param addr The new base address.
+	  * @param time The moment in emulated time this change occurs.
+	  */
+	virtual void updateSpriteAttributeBase(unsigned addr, EmuTime time) = 0;
+
+	/** Informs the renderer of a sprite pattern table base address change.
+	  * @param addr The new base address.
+	  * @param time The moment in emulated time this change occurs.
+	  */
+	virtual void updateSpritePatternBase(unsigned addr, EmuTime time) = 0;
+
+	/** Informs the renderer of a sprite size or magnification change.
+	  * @param sizeMag The new value of VDP register 1 (only bits 0 and 1
+	  *                are relevant).
+	  * @param time The moment in emulated time this change occurs.
+	  */
+	virtual void updateSpriteSizeMag(uint8_t sizeMag, EmuTime time) = 0;
+
+	/** Can the output of the renderer depend on the given block of VRAM
+	  * (without first being informed through one of the other update
+	  * methods)? The block is specified like in VRAMWindow::isInsideAny().
+	  * When this returns false, VRAM writes in that block are not passed
+	  * to updateVRAM(). Returning true is always safe.
+	  * @param address Any address in the block.
+	  * @param freeBits Bits that vary within the block.
+	  */
+	[[nodiscard]] virtual bool isVRAMDisplayed(unsigned address, unsigned freeBits) const = 0;
+
 	/** Sprite palette in Graphic 7 mode.
           * See page 98 of the V9938 data book.
 	  * Each palette entry is a word in GRB format:
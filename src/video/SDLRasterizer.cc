@@ -146,6 +146,7 @@ const RawFrame* SDLRasterizer::getLastFrame() const
 bool SDLRasterizer::isActive()
 {
 	return postProcessor->needRender() &&
+	       postProcessor->isFrameWanted() &&
 	       vdp.getMotherBoard().isActive() &&
 	       !vdp.getMotherBoard().isFastForwarding();
 }
@@ -153,6 +154,8 @@ bool SDLRasterizer::isActive()
 void SDLRasterizer::reset()
 {
 	// Init renderer state.
+	lastFrameReusable = false;
+	workFrameReusable = false;
 	setDisplayMode(vdp.getDisplayMode());
 	spriteConverter.setTransparency(vdp.getTransparency());
 
@@ -179,6 +182,8 @@ void SDLRasterizer::setSuperimposeVideoFrame(const RawFrame* videoSource)
 void SDLRasterizer::frameStart(EmuTime time)
 {
 	workFrame = postProcessor->rotateFrames(std::move(workFrame), time);
+	lastFrameReusable = workFrameReusable;
+	workFrameReusable = true;
 	workFrame->init(
 	    vdp.isInterlaced() ? (vdp.getEvenOdd() ? FrameSource::FieldType::ODD
 	                                           : FrameSource::FieldType::EVEN)
@@ -630,6 +635,21 @@ void SDLRasterizer::drawSprites(
 	}
 }
 
+bool SDLRasterizer::copyLineFromLastFrame(int line)
+{
+	if (!lastFrameReusable) return false;
+	int y = line - lineRenderTop;
+	if ((y < 0) || (y >= 240)) return true; // not visible, nothing to copy
+	const RawFrame* lastFrame = postProcessor->getLastRawFrame();
+	if (!lastFrame) return false;
+
+	unsigned width = lastFrame->getLineWidthDirect(y);
+	std::ranges::copy(lastFrame->getLineDirect(y).first(width),
+	                  workFrame->getLineDirect(y).begin());
+	workFrame->setLineWidth(y, width);
+	return true;
+}
+
 bool SDLRasterizer::isRecording() const
 {
 	return postProcessor->isRecording();
@@ -643,6 +663,9 @@ void SDLRasterizer::update(const Setting& setting) noexcept
 	                       &renderSettings.getColorMatrixSetting())) {
 		precalcPalette();
 		resetPalette();
+		// Lines drawn with the old colors can't be reused anymore.
+		lastFrameReusable = false;
+		workFrameReusable = false;
 	}
 }
 
@@ -66,6 +66,7 @@ public:
 		int fromX, int fromY,
 		int displayX, int displayY,
 		int displayWidth, int displayHeight) override;
+	[[nodiscard]] bool copyLineFromLastFrame(int line) override;
 	[[nodiscard]] bool isRecording() const override;
 
 private:
@@ -137,6 +138,13 @@ private:
 	  */
 	int lineRenderTop;
 
+	/** Were the last (finished) frame, respectively the work frame, drawn
+	  * completely with the current palette settings? Only then lines can
+	  * be copied from the last frame, see copyLineFromLastFrame().
+	  */
+	bool lastFrameReusable = false;
+	bool workFrameReusable = false;
+
 	/** Host colors corresponding to each VDP palette entry.
 	  * palFg has entry 0 set to the current background color.
 	  *       The 16 first entries are for even pixels, the next 16 are for
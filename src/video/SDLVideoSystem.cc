@@ -2,7 +2,7 @@
 
 #include "Display.hh"
 #include "GlobalSettings.hh"
-#include "PostProcessor.hh"
+#include "GLPostProcessor.hh"
 #include "RenderSettings.hh"
 #include "SDLRasterizer.hh"
 #include "V9990.hh"
@@ -69,7 +69,7 @@ std::unique_ptr<Rasterizer> SDLVideoSystem::createRasterizer(VDP& vdp)
 	auto& motherBoard = vdp.getMotherBoard();
 	return std::make_unique<SDLRasterizer>(
 		vdp, display, *screen,
-		std::make_unique<PostProcessor>(
+		std::make_unique<GLPostProcessor>(
 			motherBoard, display, *screen,
 			videoSource, 640, 240, true));
 }
@@ -84,7 +84,7 @@ std::unique_ptr<V9990Rasterizer> SDLVideoSystem::createV9990Rasterizer(
 	MSXMotherBoard& motherBoard = vdp.getMotherBoard();
 	return std::make_unique<V9990SDLRasterizer>(
 		vdp, display, *screen,
-		std::make_unique<PostProcessor>(
+		std::make_unique<GLPostProcessor>(
 			motherBoard, display, *screen,
 			videoSource, 1280, 240, true));
 }
@@ -97,7 +97,7 @@ std::unique_ptr<LDRasterizer> SDLVideoSystem::createLDRasterizer(
 	std::string videoSource = "Laserdisc"; // TODO handle multiple???
 	MSXMotherBoard& motherBoard = ld.getMotherBoard();
 	return std::make_unique<LDSDLRasterizer>(
-		std::make_unique<PostProcessor>(
+		std::make_unique<GLPostProcessor>(
 			motherBoard, display, *screen,
 			videoSource, 640, 480, false));
 }
@@ -108,11 +108,12 @@ void SDLVideoSystem::flush()
 	screen->finish();
 }
 
-void SDLVideoSystem::takeScreenShot(const std::string& filename, bool withOsd)
+void SDLVideoSystem::takeScreenShot(const std::string& filename, bool withOsd,
+                                    int compressionLevel)
 {
 	if (withOsd) {
 		// we can directly save current content as screenshot
-		screen->saveScreenshot(filename);
+		screen->saveScreenshot(filename, compressionLevel);
 	} else {
 		// we first need to re-render to an off-screen surface
 		// with OSD layers disabled
@@ -120,7 +121,7 @@ void SDLVideoSystem::takeScreenShot(const std::string& filename, bool withOsd)
 		ScopedLayerHider hideImgui(*imGuiLayer);
 		std::unique_ptr<OutputSurface> surf = screen->createOffScreenSurface();
 		display.repaintImpl(*surf);
-		surf->saveScreenshot(filename);
+		surf->saveScreenshot(filename, compressionLevel);
 	}
 }
 
@@ -0,0 +1,55 @@
+#include "SWOutputSurface.hh"
+
+#include "PNG.hh"
+
+#include "narrow.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace openmsx {
+
+SWOutputSurface::SWOutputSurface(gl::ivec2 size)
+{
+	resize(size);
+}
+
+void SWOutputSurface::resize(gl::ivec2 size)
+{
+	calculateViewPort(size, size);
+	buffer.resize(size_t(size.x) * size.y);
+	fill(mapRGB255({0, 0, 0}));
+}
+
+std::span<OutputSurface::Pixel> SWOutputSurface::getLine(unsigned y)
+{
+	auto width = narrow<size_t>(getLogicalWidth());
+	assert(y < unsigned(getLogicalHeight()));
+	return buffer.subspan(y * width, width);
+}
+
+std::span<const OutputSurface::Pixel> SWOutputSurface::getLine(unsigned y) const
+{
+	auto width = narrow<size_t>(getLogicalWidth());
+	assert(y < unsigned(getLogicalHeight()));
+	return buffer.subspan(y * width, width);
+}
+
+void SWOutputSurface::fill(Pixel color)
+{
+	std::ranges::fill(std::span<Pixel>(buffer), color);
+}
+
+void SWOutputSurface::saveScreenshot(const std::string& filename, int compressionLevel)
+{
+	auto height = narrow<unsigned>(getLogicalHeight());
+	std::vector<const Pixel*> rowPointers(height);
+	for (auto y : xrange(height)) {
+		rowPointers[y] = getLine(y).data();
+	}
+	PNG::saveRGBA(getLogicalWidth(), rowPointers, filename, compressionLevel);
+}
+
+} // namespace openmsx
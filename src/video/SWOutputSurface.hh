@@ -0,0 +1,39 @@
+#ifndef SWOUTPUTSURFACE_HH
+#define SWOUTPUTSURFACE_HH
+
+#include "OutputSurface.hh"
+
+#include "MemBuffer.hh"
+#include "aligned.hh"
+
+#include <span>
+
+namespace openmsx {
+
+/** An OutputSurface that simply is a block of (host) memory. Used by the
+  * headless video system: no window nor openGL context is needed.
+  */
+class SWOutputSurface final : public OutputSurface
+{
+public:
+	explicit SWOutputSurface(gl::ivec2 size);
+
+	/** Change the size, the content is undefined afterwards. */
+	void resize(gl::ivec2 size);
+
+	[[nodiscard]] std::span<Pixel> getLine(unsigned y);
+	[[nodiscard]] std::span<const Pixel> getLine(unsigned y) const;
+
+	/** Fill the whole surface with the given color. */
+	void fill(Pixel color);
+
+	// OutputSurface
+	void saveScreenshot(const std::string& filename, int compressionLevel) override;
+
+private:
+	MemBuffer<Pixel, SSE_ALIGNMENT> buffer;
+};
+
+} // namespace openmsx
+
+#endif
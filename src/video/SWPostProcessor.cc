@@ -0,0 +1,65 @@
+#include "SWPostProcessor.hh"
+
+#include "RawFrame.hh"
+#include "RenderSettings.hh"
+#include "SWOutputSurface.hh"
+#include "SWScaler.hh"
+#include "SWScalerFactory.hh"
+
+#include "checked_cast.hh"
+
+namespace openmsx {
+
+SWPostProcessor::SWPostProcessor(
+	MSXMotherBoard& motherBoard_, Display& display_,
+	OutputSurface& screen_, const std::string& videoSource,
+	unsigned maxWidth_, unsigned height_, bool canDoInterlace_)
+	: PostProcessor(motherBoard_, display_, screen_,
+	                videoSource, maxWidth_, height_, canDoInterlace_)
+{
+}
+
+SWPostProcessor::~SWPostProcessor() = default;
+
+void SWPostProcessor::uploadFrame()
+{
+	// nothing to do, paint() reads directly from 'paintFrame'
+}
+
+void SWPostProcessor::paint(OutputSurface& output_)
+{
+	auto& output = checked_cast<SWOutputSurface&>(output_);
+	auto black = output.mapRGB255({0, 0, 0});
+
+	if (renderSettings.getInterleaveBlackFrame()) {
+		interleaveCount ^= 1;
+		if (interleaveCount) {
+			output.fill(black);
+			return;
+		}
+	}
+	if (!paintFrame) {
+		output.fill(black);
+		return;
+	}
+
+	// New scaler algorithm selected?
+	if (auto algo = renderSettings.getScaleAlgorithm();
+	    scaleAlgorithm != algo) {
+		scaleAlgorithm = algo;
+		currScaler = SWScalerFactory::createScaler(renderSettings, height * 2); // *2 for interlace, like the textures of GLPostProcessor
+	}
+
+	auto dstHeight = unsigned(output.getLogicalHeight());
+	for (const auto& r : calcRegions(paintFrame, dstHeight)) {
+		// Like in GLPostProcessor, the video is superimposed by the
+		// scaler (after scaling).
+		currScaler->scaleImage(
+			*paintFrame, superImposeVideoFrame,
+			r.srcStartY, r.srcEndY, r.lineWidth, // src
+			output, r.dstStartY, r.dstEndY,      // dst
+			paintFrame->getHeight());
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,45 @@
+#ifndef SWPOSTPROCESSOR_HH
+#define SWPOSTPROCESSOR_HH
+
+#include "PostProcessor.hh"
+#include "RenderSettings.hh"
+
+#include <memory>
+
+namespace openmsx {
+
+class SWScaler;
+
+/** PostProcessor that scales the MSX frame to the output surface in
+  * software, so without the need for an openGL context. Used by the
+  * headless video system. The selected scaler is applied (see SWScaler),
+  * effects like noise, glow or 3D deform are not implemented.
+  */
+class SWPostProcessor final : public PostProcessor
+{
+public:
+	SWPostProcessor(
+		MSXMotherBoard& motherBoard, Display& display,
+		OutputSurface& screen, const std::string& videoSource,
+		unsigned maxWidth, unsigned height, bool canDoInterlace);
+	~SWPostProcessor() override;
+
+	// Layer interface:
+	void paint(OutputSurface& output) override;
+
+private:
+	// PostProcessor
+	void uploadFrame() override;
+	[[nodiscard]] bool isDisplayed() const override { return false; }
+
+private:
+	/** The currently active scaler. */
+	std::unique_ptr<SWScaler> currScaler;
+
+	/** Currently active scale algorithm, used to detect scaler changes. */
+	RenderSettings::ScaleAlgorithm scaleAlgorithm = RenderSettings::ScaleAlgorithm::NO;
+};
+
+} // namespace openmsx
+
+#endif
@@ -14,6 +14,7 @@ TODO:
 
 #include "BooleanSetting.hh"
 #include "serialize.hh"
+#include "xrange.hh"
 
 #include <algorithm>
 #include <bit>
@@ -27,8 +28,8 @@ SpriteChecker::SpriteChecker(VDP& vdp_, RenderSettings& renderSettings,
 	, limitSpritesSetting(renderSettings.getLimitSpritesSetting())
 	, frameStartTime(time)
 {
-	vram.spriteAttribTable.setObserver(this);
-	vram.spritePatternTable.setObserver(this);
+	vram.spriteAttribTable.setObserver(&attribObserver);
+	vram.spritePatternTable.setObserver(&patternObserver);
 }
 
 void SpriteChecker::reset(EmuTime time)
@@ -67,6 +68,51 @@ inline SpriteChecker::SpritePattern SpriteChecker::calculatePatternPlanar(
 	return !vdp.isSpriteMag() ? pattern : doublePattern(pattern);
 }
 
+bool SpriteChecker::writeAffectsLines(Table table, unsigned offset, int limit) const
+{
+	// Determine the range of lines updateSprites1/2() will check.
+	if (!vdp.spritesEnabledFast()) return false;
+	int minLine = currentLine;
+	int maxLine = limit;
+	if (!vdp.isDisplayEnabled()) {
+		// in border, only the last line of top border is checked
+		int l0 = vdp.getLineZero() - 1;
+		if ((l0 < minLine) || (maxLine <= l0)) return false;
+		minLine = l0;
+		maxLine = l0 + 1;
+	}
+
+	// Translate the offset in the window to an index in the table. This is
+	// only unambiguous when all index bits are present in the table mask,
+	// in other words when the table is not mirrored.
+	bool mode1 = updateSpritesMethod == &SpriteChecker::updateSprites1;
+	unsigned tableSize = (table == Table::PATTERN) ? 256 * 8
+	                   : (mode1 ? 32 * 4 : 1024);
+	unsigned mask = (table == Table::PATTERN) ? vram.spritePatternTable.getMask()
+	                                          : vram.spriteAttribTable.getMask();
+	if (planar) {
+		offset = ((offset >> 16) & 1) | ((offset & 0xFFFF) << 1);
+		mask   = ((mask   >> 16) & 1) | ((mask   & 0xFFFF) << 1);
+	}
+	if ((mask & (tableSize - 1)) != (tableSize - 1)) return true;
+	unsigned index = offset & (tableSize - 1);
+
+	unsigned indexBits = mode1 ? (~0u << 7) : (~0u << 10);
+	SpriteTableWrite::State state{
+		.minLine = minLine,
+		.maxLine = maxLine,
+		.displayDelta = vdp.getVerticalScroll() - vdp.getLineZero(),
+		.size = vdp.getSpriteSize(),
+		.mag = vdp.isSpriteMag(),
+		.mode1 = mode1,
+	};
+	return SpriteTableWrite::affectsLines(state, table, index, [&](unsigned i) {
+		i |= indexBits;
+		return planar ? vram.spriteAttribTable.readPlanar(i)
+		              : vram.spriteAttribTable.readNP(i);
+	});
+}
+
 void SpriteChecker::updateSprites1(int limit)
 {
 	if (vdp.spritesEnabledFast()) {
@@ -2,6 +2,7 @@
 #define SPRITECHECKER_HH
 
 #include "DisplayMode.hh"
+#include "SpriteTableWrite.hh"
 #include "VDP.hh"
 #include "VDPVRAM.hh"
 #include "VRAMObserver.hh"
@@ -21,7 +22,7 @@ namespace openmsx {
 class RenderSettings;
 class BooleanSetting;
 
-class SpriteChecker final : public VRAMObserver
+class SpriteChecker
 {
 public:
 	/** Bitmap of length 32 describing a sprite pattern.
@@ -263,20 +264,57 @@ public:
 		return subspan(spriteBuffer[line], 0, spriteCount[line]);
 	}
 
-	// VRAMObserver implementation:
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
 
-	void updateVRAM(unsigned /*offset*/, EmuTime time) override {
-		checkUntil(time);
-	}
+private:
+	using Table = SpriteTableWrite::Table;
 
-	void updateWindow(bool /*enabled*/, EmuTime time) override {
-		sync(time);
+	/** Observes one of the two sprite tables. Both tables can be mapped
+	  * onto the same VRAM, so a separate observer per table is needed to
+	  * know which table a write belongs to.
+	  */
+	class TableObserver final : public VRAMObserver
+	{
+	public:
+		TableObserver(SpriteChecker& checker_, Table table_)
+			: checker(checker_), table(table_) {}
+
+		void updateVRAM(unsigned offset, EmuTime time) override {
+			checker.updateVRAM(table, offset, time);
+		}
+		void updateWindow(bool /*enabled*/, EmuTime time) override {
+			checker.sync(time);
+		}
+
+	private:
+		SpriteChecker& checker;
+		Table table;
+	};
+
+	/** A byte in one of the sprite tables is about to change.
+	  * Only the lines that are not yet checked (currentLine up to 'time')
+	  * still need the old value. So the sprite checking is only brought
+	  * up-to-date if the written byte is used by one of the sprites that
+	  * is visible on those lines, or if it's a Y coordinate (see
+	  * SpriteTableWrite::affectsLines()). Otherwise checking can be postponed,
+	  * which allows it to be done for a larger block of lines at once.
+	  */
+	void updateVRAM(Table table, unsigned offset, EmuTime time) {
+		int limit = narrow<int>(frameStartTime.getTicksTill_fast(time)
+		               / VDP::TICKS_PER_LINE);
+		if (currentLine >= limit) return; // nothing pending
+		if (writeAffectsLines(table, offset, limit)) {
+			(this->*updateSpritesMethod)(limit);
+		}
 	}
 
-	template<typename Archive>
-	void serialize(Archive& ar, unsigned version);
+	/** Does the byte at 'offset' in the given table influence the result
+	  * of checking the lines [currentLine, limit)? Returns true when in
+	  * doubt (e.g. when the table is mirrored in VRAM).
+	  */
+	[[nodiscard]] bool writeAffectsLines(Table table, unsigned offset, int limit) const;
 
-private:
 	/** Calculate 'updateSpritesMethod' and 'planar'.
 	  */
 	void setDisplayMode(DisplayMode mode) {
@@ -397,6 +435,9 @@ private:
 	  * TODO: Introduce separate update methods for planar/non-planar modes.
 	  */
 	bool planar;
+
+	TableObserver attribObserver{*this, Table::ATTRIBUTE};
+	TableObserver patternObserver{*this, Table::PATTERN};
 };
 SERIALIZE_CLASS_VERSION(SpriteChecker, 2);
 
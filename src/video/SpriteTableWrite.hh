@@ -0,0 +1,88 @@
+#ifndef SPRITETABLEWRITE_HH
+#define SPRITETABLEWRITE_HH
+
+#include "unreachable.hh"
+#include "xrange.hh"
+
+#include <cstdint>
+
+/** Decides whether a write into one of the sprite tables must bring the
+  * SpriteChecker up-to-date first (see SpriteChecker::updateVRAM()). This is
+  * separate from SpriteChecker, so that it can be unit tested without a VDP.
+  */
+namespace openmsx::SpriteTableWrite {
+
+enum class Table : uint8_t { ATTRIBUTE, PATTERN };
+
+/** The VDP state that's relevant for the decision. */
+struct State {
+	int minLine; // the lines [minLine, maxLine) are not yet checked
+	int maxLine;
+	int displayDelta; // vertical scroll minus line zero
+	int size; // 8 or 16
+	bool mag;
+	bool mode1; // sprite mode 1 or 2
+};
+
+/** Does writing the byte at 'index' in the given (not mirrored) table
+  * influence the result of checking the not yet checked lines?
+  * @param readAttrib Reads the (old) byte at the given index in the sprite
+  *                   attribute table (for sprite mode 2 the sprite color
+  *                   table occupies the first 512 bytes of that table).
+  */
+template<typename ReadAttrib>
+[[nodiscard]] bool affectsLines(const State& s, Table table, unsigned index, ReadAttrib readAttrib)
+{
+	// Find the sprites that are visible on at least one of the lines.
+	// Same logic as in SpriteChecker::checkSprites1/2(), but without
+	// looking at the individual lines.
+	int magSize = (s.mag + 1) * s.size;
+	unsigned attribBase = s.mode1 ? 0 : 512;
+	int endMarker = s.mode1 ? 208 : 216;
+	auto isVisible = [&](int y) {
+		int spriteLine = (s.minLine + s.displayDelta - y) & 0xFF;
+		return (spriteLine < magSize) || ((256 - spriteLine) < (s.maxLine - s.minLine));
+	};
+
+	if (table == Table::PATTERN) {
+		unsigned patternIndexMask = s.size == 16 ? 0xFC : 0xFF;
+		for (auto sprite : xrange(32u)) {
+			int y = readAttrib(attribBase + 4 * sprite + 0);
+			if (y == endMarker) return false;
+			if (!isVisible(y)) continue;
+			auto patternNr = readAttrib(attribBase + 4 * sprite + 2) & patternIndexMask;
+			if (((index / 8) & patternIndexMask) == patternNr) return true;
+		}
+		return false;
+	}
+
+	// Attribute table: which sprite and which byte of that sprite?
+	unsigned target;
+	bool isY = false;
+	if (index >= attribBase) {
+		target = (index - attribBase) / 4;
+		isY = ((index - attribBase) % 4) == 0;
+	} else {
+		target = index / 16; // sprite mode 2 color table
+	}
+	for (auto sprite : xrange(target + 1)) {
+		int y = readAttrib(attribBase + 4 * sprite + 0);
+		if (y == endMarker) {
+			// The sprite that terminates the table influences the
+			// status register, sprites after it are not used at all.
+			return (sprite == target) && isY;
+		}
+		if (sprite == target) {
+			// Only the old Y coordinate is known here. The new one
+			// can move the sprite onto the pending lines, or make
+			// it the end of the table (that hides all sprites after
+			// it), so Y writes always need the old value.
+			return isY || isVisible(y);
+		}
+	}
+	UNREACHABLE;
+}
+
+} // namespace openmsx::SpriteTableWrite
+
+#endif
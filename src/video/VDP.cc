@@ -19,6 +19,7 @@ TODO:
 
 #include "VDP.hh"
 
+#include "CommandException.hh"
 #include "Display.hh"
 #include "RenderSettings.hh"
 #include "Renderer.hh"
@@ -36,6 +37,8 @@ TODO:
 #include "TclObject.hh"
 #include "serialize_core.hh"
 
+#include "enumerate.hh"
+#include "join.hh"
 #include "narrow.hh"
 #include "one_of.hh"
 #include "unreachable.hh"
@@ -43,6 +46,8 @@ TODO:
 #include <algorithm>
 #include <cassert>
 #include <memory>
+#include <numeric>
+#include <optional>
 
 namespace openmsx {
 
@@ -92,6 +97,7 @@ VDP::VDP(const DeviceConfig& config)
 	, msxYPosInfo      (*this)
 	, msxX256PosInfo   (*this)
 	, msxX512PosInfo   (*this)
+	, vramStatsCmd(getCommandController())
 	, frameStartTime(getCurrentTime())
 	, irqVertical  (getMotherBoard(), getName() + ".IRQvertical",   config)
 	, irqHorizontal(getMotherBoard(), getName() + ".IRQhorizontal", config)
@@ -583,6 +589,9 @@ void VDP::scheduleHScan(EmuTime time)
 //       influences the frequency at which E/O toggles).
 void VDP::frameStart(EmuTime time)
 {
+	if (auto* stats = vram->getAccessStats()) [[unlikely]] {
+		stats->frameEnd(VDPAccessSlots::getSlotsPerFrame(*this, displayEnabled));
+	}
 	++frameCount;
 
 	// Toggle E/O.
@@ -1071,6 +1080,7 @@ void VDP::changeRegister(uint8_t reg, uint8_t val, EmuTime time)
 	case 1:
 		if (change & 0x03) {
 			// Update sprites on size and mag changes.
+			renderer->updateSpriteSizeMag(val, time);
 			spriteChecker->updateSpriteSizeMag(val, time);
 		}
 		// TODO: Reset vertical IRQ if IE0 is reset?
@@ -1356,12 +1366,13 @@ void VDP::updatePatternBase(EmuTime time)
 
 void VDP::updateSpriteAttributeBase(EmuTime time)
 {
+	unsigned baseMask = (controlRegs[11] << 15) | (controlRegs[5] << 7) | ~(~0u << 7);
+	renderer->updateSpriteAttributeBase(baseMask, time);
 	int mode = displayMode.getSpriteMode(isMSX1VDP());
 	if (mode == 0) {
 		vram->spriteAttribTable.disable(time);
 		return;
 	}
-	unsigned baseMask = (controlRegs[11] << 15) | (controlRegs[5] << 7) | ~(~0u << 7);
 	unsigned indexMask = mode == 1 ? ~0u << 7 : ~0u << 10;
 	if (displayMode.isPlanar()) {
 		baseMask = ((baseMask << 16) | (baseMask >> 1)) & 0x1FFFF;
@@ -1372,11 +1383,12 @@ void VDP::updateSpriteAttributeBase(EmuTime time)
 
 void VDP::updateSpritePatternBase(EmuTime time)
 {
+	unsigned baseMask = (controlRegs[6] << 11) | ~(~0u << 11);
+	renderer->updateSpritePatternBase(baseMask, time);
 	if (displayMode.getSpriteMode(isMSX1VDP()) == 0) {
 		vram->spritePatternTable.disable(time);
 		return;
 	}
-	unsigned baseMask = (controlRegs[6] << 11) | ~(~0u << 11);
 	unsigned indexMask = ~0u << 11;
 	if (displayMode.isPlanar()) {
 		baseMask = ((baseMask << 16) | (baseMask >> 1)) & 0x1FFFF;
@@ -1910,6 +1922,126 @@ int VDP::MsxX512PosInfo::calc(EmuTime time) const
 }
 
 
+// class VRAMStatsCmd
+
+VDP::VRAMStatsCmd::VRAMStatsCmd(CommandController& commandController_)
+	: Command(commandController_, "vram_stats")
+{
+}
+
+static std::optional<VRAMAccessStats::Access> parseAccess(std::string_view name)
+{
+	if (auto it = std::ranges::find(VRAMAccessStats::accessNames, name);
+	    it != VRAMAccessStats::accessNames.end()) {
+		return VRAMAccessStats::Access(std::distance(VRAMAccessStats::accessNames.begin(), it));
+	}
+	return {};
+}
+
+void VDP::VRAMStatsCmd::execute(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& vram = *OUTER(VDP, vramStatsCmd).vram;
+	auto getStats = [&]() -> VRAMAccessStats& {
+		auto* stats = vram.getAccessStats();
+		if (!stats) {
+			throw CommandException(
+				"VRAM access statistics are not enabled, "
+				"use 'vram_stats enable' first.");
+		}
+		return *stats;
+	};
+	executeSubCommand(tokens[1].getString(),
+		"enable", [&]{
+			checkNumArgs(tokens, 2, "");
+			vram.setAccessStatsEnabled(true);
+		},
+		"disable", [&]{
+			checkNumArgs(tokens, 2, "");
+			vram.setAccessStatsEnabled(false);
+		},
+		"enabled", [&]{
+			checkNumArgs(tokens, 2, "");
+			result = vram.getAccessStats() != nullptr;
+		},
+		"frame", [&]{
+			checkNumArgs(tokens, Between{2, 3}, "?age?");
+			const auto& history = getStats().getHistory();
+			auto age = (tokens.size() == 3) ? tokens[2].getInt(getInterpreter()) : 0;
+			if ((age < 0) || (size_t(age) >= history.size())) {
+				throw CommandException(
+					"Age must be in range [0, ", history.size(), ')');
+			}
+			const auto& frame = history[history.size() - 1 - age];
+			for (auto [i, name] : enumerate(VRAMAccessStats::accessNames)) {
+				result.addDictKeyValue(name, frame.counts[i]);
+			}
+			result.addDictKeyValues("slots", frame.slots,
+			                        "utilization", frame.utilization());
+		},
+		"heatmap", [&]{
+			checkNumArgs(tokens, Between{3, 4}, "type ?blocksize?");
+			auto type = tokens[2].getString();
+			auto access = parseAccess(type);
+			if (!access) {
+				throw CommandException(
+					"Unknown access type: ", type, ", must be one of ",
+					join(VRAMAccessStats::accessNames, ", "));
+			}
+			auto blockSize = (tokens.size() == 4) ? tokens[3].getInt(getInterpreter()) : 256;
+			if (blockSize <= 0) {
+				throw CommandException("Block size must be positive");
+			}
+			auto heatmap = getStats().getHeatmap(*access);
+			while (!heatmap.empty()) {
+				auto n = std::min(heatmap.size(), size_t(blockSize));
+				result.addListElement(std::accumulate(
+					heatmap.begin(), heatmap.begin() + n, uint64_t(0)));
+				heatmap = heatmap.subspan(n);
+			}
+		},
+		"clear", [&]{
+			checkNumArgs(tokens, 2, "");
+			getStats().clearHeatmap();
+		});
+}
+
+std::string VDP::VRAMStatsCmd::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Statistics about the accesses to the VDP VRAM by the CPU and by the "
+	       "command engine. Collecting them slows down emulation a bit, so "
+	       "they're disabled by default.\n"
+	       "  vram_stats enable                 start collecting statistics\n"
+	       "  vram_stats disable                stop and discard all statistics\n"
+	       "  vram_stats enabled                are statistics being collected?\n"
+	       "  vram_stats frame ?<age>?          a dict with the number of accesses\n"
+	       "                                    (cpu_read, cpu_write, cmd_read, cmd_write),\n"
+	       "                                    the number of access slots (slots) and\n"
+	       "                                    the fraction of those that was used\n"
+	       "                                    (utilization) in the last finished frame,\n"
+	       "                                    or <age> frames before that\n"
+	       "  vram_stats heatmap <type> ?<bs>?  the number of accesses of the given type\n"
+	       "                                    (one of cpu_read, cpu_write, cmd_read,\n"
+	       "                                    cmd_write), summed over each block of <bs>\n"
+	       "                                    bytes (default 256) of VRAM, since the\n"
+	       "                                    statistics were enabled or cleared\n"
+	       "  vram_stats clear                  reset the heatmap\n";
+}
+
+void VDP::VRAMStatsCmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	using namespace std::literals;
+	if (tokens.size() == 2) {
+		static constexpr std::array subCmds = {
+			"enable"sv, "disable"sv, "enabled"sv, "frame"sv, "heatmap"sv, "clear"sv,
+		};
+		completeString(tokens, subCmds);
+	} else if ((tokens.size() == 3) && (tokens[1] == "heatmap")) {
+		completeString(tokens, VRAMAccessStats::accessNames);
+	}
+}
+
+
 // version 1: initial version
 // version 2: added frameCount
 // version 3: removed verticalAdjust
@@ -6,6 +6,7 @@
 #include "gl_vec.hh"
 
 #include "Clock.hh"
+#include "Command.hh"
 #include "EnumSetting.hh"
 #include "IRQHelper.hh"
 #include "InfoTopic.hh"
@@ -1157,6 +1158,14 @@ private:
 		[[nodiscard]] int calc(EmuTime time) const override;
 	} msxX512PosInfo;
 
+	/** Tcl access to the (optional) VRAM access statistics. */
+	struct VRAMStatsCmd final : Command {
+		explicit VRAMStatsCmd(CommandController& commandController);
+		void execute(std::span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} vramStatsCmd;
+
 	/** Renderer that converts this VDP's state into an image.
 	  */
 	std::unique_ptr<Renderer> renderer;
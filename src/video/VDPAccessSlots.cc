@@ -1,5 +1,6 @@
 #include "VDPAccessSlots.hh"
 
+#include <algorithm>
 #include <array>
 #include <utility>
 
@@ -195,10 +196,10 @@ static constexpr CycleTable tabMsx1ScreenOff (true,  slotsMsx1ScreenOff);
 static constexpr ZeroTable  tabBroken;
 
 
-[[nodiscard]] static inline std::span<const uint8_t, NUM_DELTAS * TICKS> getTab(const VDP& vdp)
+[[nodiscard]] static inline std::span<const uint8_t, NUM_DELTAS * TICKS> getTab(
+	const VDP& vdp, bool enabled)
 {
 	if (vdp.getBrokenCmdTiming()) return tabBroken;
-	bool enabled = vdp.isDisplayEnabled();
 	bool sprites = vdp.spritesEnabledRegister();
 	auto mode    = vdp.getDisplayMode();
 	bool bitmap  = mode.isBitmapMode();
@@ -231,7 +232,7 @@ EmuTime getAccessSlot(
 {
 	VDP::VDPClock frame(frame_);
 	unsigned ticks = frame.getTicksTill_fast(time) % TICKS;
-	auto tab = getTab(vdp);
+	auto tab = getTab(vdp, vdp.isDisplayEnabled());
 	return time + VDP::VDPClock::duration(tab[std::to_underlying(delta) + ticks]);
 }
 
@@ -239,8 +240,23 @@ Calculator getCalculator(
 	EmuTime frame, EmuTime time, EmuTime limit,
 	const VDP& vdp)
 {
-	auto tab = getTab(vdp);
+	auto tab = getTab(vdp, vdp.isDisplayEnabled());
 	return {frame, time, limit, tab};
 }
 
+[[nodiscard]] static unsigned countSlots(std::span<const uint8_t, NUM_DELTAS * TICKS> tab)
+{
+	// The first part of the table is for Delta::D0, there an entry is zero
+	// iff there's an access slot at that cycle.
+	return narrow<unsigned>(std::ranges::count(tab.first<TICKS>(), 0));
+}
+
+unsigned getSlotsPerFrame(const VDP& vdp, bool displayEnabled)
+{
+	auto lines = narrow<unsigned>(vdp.getLinesPerFrame());
+	auto displayLines = narrow<unsigned>(vdp.getNumberOfLines());
+	return displayLines * countSlots(getTab(vdp, displayEnabled)) +
+	       (lines - displayLines) * countSlots(getTab(vdp, false)); // border
+}
+
 } // namespace openmsx::VDPAccessSlots
@@ -101,6 +101,12 @@ private:
 	EmuTime frame, EmuTime time, EmuTime limit,
 	const VDP& vdp);
 
+/** The number of access slots (for CPU and command engine) in one frame.
+  * This assumes that the display mode and the display and sprite enable
+  * status remain the same during the whole frame. The vertical borders are
+  * taken into account. */
+[[nodiscard]] unsigned getSlotsPerFrame(const VDP& vdp, bool displayEnabled);
+
 } // namespace openmsx::VDPAccessSlots
 
 #endif
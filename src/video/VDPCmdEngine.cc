@@ -41,6 +41,7 @@ TODO:
 #include "serialize.hh"
 
 #include "unreachable.hh"
+#include "xrange.hh"
 
 #include <algorithm>
 #include <array>
@@ -148,7 +149,7 @@ template<typename LogOp> static void psetFast(
 	EmuTime time, VDPVRAM& vram, unsigned addr,
 	uint8_t color, uint8_t mask, LogOp op)
 {
-	uint8_t src = vram.cmdWriteWindow.readNP(addr);
+	uint8_t src = vram.cmdRead(vram.cmdWriteWindow, addr);
 	op(time, vram, addr, src, color, mask);
 }
 
@@ -164,6 +165,8 @@ struct Graphic4Mode
 	static constexpr uint8_t PIXELS_PER_BYTE = 2;
 	static constexpr uint8_t PIXELS_PER_BYTE_SHIFT = 1;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr unsigned ROW_ADDRESS_BITS = 0x0007F; // vary within one line
+	static constexpr bool PLANAR = false; // is a line split over two VRAM planes?
 	static unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static uint8_t point(const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -185,7 +188,7 @@ inline unsigned Graphic4Mode::addressOf(
 inline uint8_t Graphic4Mode::point(
 	const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
 {
-	return (vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
+	return (vram.cmdRead(vram.cmdReadWindow, addressOf(x, y, extVRAM))
 		>> (((~x) & 1) << 2)) & 15;
 }
 
@@ -216,6 +219,8 @@ struct Graphic5Mode
 	static constexpr uint8_t PIXELS_PER_BYTE = 4;
 	static constexpr uint8_t PIXELS_PER_BYTE_SHIFT = 2;
 	static constexpr unsigned PIXELS_PER_LINE = 512;
+	static constexpr unsigned ROW_ADDRESS_BITS = 0x0007F; // vary within one line
+	static constexpr bool PLANAR = false; // is a line split over two VRAM planes?
 	static unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static uint8_t point(const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -237,7 +242,7 @@ inline unsigned Graphic5Mode::addressOf(
 inline uint8_t Graphic5Mode::point(
 	const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
 {
-	return (vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
+	return (vram.cmdRead(vram.cmdReadWindow, addressOf(x, y, extVRAM))
 		>> (((~x) & 3) << 1)) & 3;
 }
 
@@ -270,6 +275,8 @@ struct Graphic6Mode
 	static constexpr uint8_t PIXELS_PER_BYTE = 2;
 	static constexpr uint8_t PIXELS_PER_BYTE_SHIFT = 1;
 	static constexpr unsigned PIXELS_PER_LINE = 512;
+	static constexpr unsigned ROW_ADDRESS_BITS = 0x1007F; // vary within one line
+	static constexpr bool PLANAR = true;  // is a line split over two VRAM planes?
 	static unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static uint8_t point(const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -291,7 +298,7 @@ inline unsigned Graphic6Mode::addressOf(
 inline uint8_t Graphic6Mode::point(
 	const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
 {
-	return (vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM))
+	return (vram.cmdRead(vram.cmdReadWindow, addressOf(x, y, extVRAM))
 		>> (((~x) & 1) << 2)) & 15;
 }
 
@@ -322,6 +329,8 @@ struct Graphic7Mode
 	static constexpr uint8_t PIXELS_PER_BYTE = 1;
 	static constexpr uint8_t PIXELS_PER_BYTE_SHIFT = 0;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr unsigned ROW_ADDRESS_BITS = 0x1007F; // vary within one line
+	static constexpr bool PLANAR = true;  // is a line split over two VRAM planes?
 	static unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static uint8_t point(const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -343,7 +352,7 @@ inline unsigned Graphic7Mode::addressOf(
 inline uint8_t Graphic7Mode::point(
 	const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
 {
-	return vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM));
+	return vram.cmdRead(vram.cmdReadWindow, addressOf(x, y, extVRAM));
 }
 
 template<typename LogOp>
@@ -372,6 +381,8 @@ struct NonBitmapMode
 	static constexpr uint8_t PIXELS_PER_BYTE = 1;
 	static constexpr uint8_t PIXELS_PER_BYTE_SHIFT = 0;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr unsigned ROW_ADDRESS_BITS = 0x000FF; // vary within one line
+	static constexpr bool PLANAR = false; // is a line split over two VRAM planes?
 	static unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static uint8_t point(const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
 	template<typename LogOp>
@@ -393,7 +404,7 @@ inline unsigned NonBitmapMode::addressOf(
 inline uint8_t NonBitmapMode::point(
 	const VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM)
 {
-	return vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM));
+	return vram.cmdRead(vram.cmdReadWindow, addressOf(x, y, extVRAM));
 }
 
 template<typename LogOp>
@@ -655,6 +666,10 @@ struct IncrShift7
 // Logical operations:
 
 struct DummyOp {
+	[[nodiscard]] static uint8_t apply(uint8_t src, uint8_t /*color*/, uint8_t /*mask*/)
+	{
+		return src;
+	}
 	void operator()(EmuTime /*time*/, VDPVRAM& /*vram*/, unsigned /*addr*/,
 	                uint8_t /*src*/, uint8_t /*color*/, uint8_t /*mask*/) const
 	{
@@ -662,48 +677,59 @@ struct DummyOp {
 	}
 };
 
-struct ImpOp {
+// Writes the result of 'Op::apply()' to VRAM.
+template<typename Op>
+struct WriteOp {
 	void operator()(EmuTime time, VDPVRAM& vram, unsigned addr,
 	                uint8_t src, uint8_t color, uint8_t mask) const
 	{
-		vram.cmdWrite(addr, (src & mask) | color, time);
+		vram.cmdWrite(addr, Op::apply(src, color, mask), time);
 	}
 };
 
-struct AndOp {
-	void operator()(EmuTime time, VDPVRAM& vram, unsigned addr,
-	                uint8_t src, uint8_t color, uint8_t mask) const
+struct ImpOp : WriteOp<ImpOp> {
+	[[nodiscard]] static uint8_t apply(uint8_t src, uint8_t color, uint8_t mask)
 	{
-		vram.cmdWrite(addr, src & (color | mask), time);
+		return (src & mask) | color;
 	}
 };
 
-struct OrOp {
-	void operator()(EmuTime time, VDPVRAM& vram, unsigned addr,
-	                uint8_t src, uint8_t color, uint8_t /*mask*/) const
+struct AndOp : WriteOp<AndOp> {
+	[[nodiscard]] static uint8_t apply(uint8_t src, uint8_t color, uint8_t mask)
 	{
-		vram.cmdWrite(addr, src | color, time);
+		return src & (color | mask);
 	}
 };
 
-struct XorOp {
-	void operator()(EmuTime time, VDPVRAM& vram, unsigned addr,
-	                uint8_t src, uint8_t color, uint8_t /*mask*/) const
+struct OrOp : WriteOp<OrOp> {
+	[[nodiscard]] static uint8_t apply(uint8_t src, uint8_t color, uint8_t /*mask*/)
 	{
-		vram.cmdWrite(addr, src ^ color, time);
+		return src | color;
 	}
 };
 
-struct NotOp {
-	void operator()(EmuTime time, VDPVRAM& vram, unsigned addr,
-	                uint8_t src, uint8_t color, uint8_t mask) const
+struct XorOp : WriteOp<XorOp> {
+	[[nodiscard]] static uint8_t apply(uint8_t src, uint8_t color, uint8_t /*mask*/)
 	{
-		vram.cmdWrite(addr, (src & mask) | ~(color | mask), time);
+		return src ^ color;
+	}
+};
+
+struct NotOp : WriteOp<NotOp> {
+	[[nodiscard]] static uint8_t apply(uint8_t src, uint8_t color, uint8_t mask)
+	{
+		return (src & mask) | ~(color | mask);
 	}
 };
 
 template<typename Op>
 struct TransparentOp : Op {
+	// Only used when the write can't be observed, then writing back the
+	// original value is the same as skipping the write.
+	[[nodiscard]] static uint8_t apply(uint8_t src, uint8_t color, uint8_t mask)
+	{
+		return color ? Op::apply(src, color, mask) : src;
+	}
 	void operator()(EmuTime time, VDPVRAM& vram, unsigned addr,
 	                uint8_t src, uint8_t color, uint8_t mask) const
 	{
@@ -719,6 +745,78 @@ using TOrOp  = TransparentOp<OrOp>;
 using TXorOp = TransparentOp<XorOp>;
 using TNotOp = TransparentOp<NotOp>;
 
+// Same as 'Op', but for VRAM that no subsystem observes, see
+// VDPVRAM::cmdWriteDirect().
+template<typename Op>
+struct DirectOp {
+	void operator()(EmuTime time, VDPVRAM& vram, unsigned addr,
+	                uint8_t src, uint8_t color, uint8_t mask) const
+	{
+		vram.cmdWriteDirect(addr, Op::apply(src, color, mask), time);
+	}
+};
+
+
+/** Is any VDP subsystem (renderer, sprite checker) observing VRAM writes to
+  * (part of) destination line 'y'? The block commands (HMMV, LMMM, ...)
+  * write one line at a time, when this returns false, the writes for this
+  * line can skip all synchronization and can be done in bulk.
+  */
+template<typename Mode>
+static bool isLineObserved(const VDPVRAM& vram, unsigned y, bool extVRAM)
+{
+	return vram.isCmdWriteObserved(Mode::addressOf(0, y, extVRAM),
+	                               Mode::ROW_ADDRESS_BITS);
+}
+
+static void cmdWrite(VDPVRAM& vram, bool observed,
+                     unsigned addr, uint8_t value, EmuTime time)
+{
+	if (observed) {
+		vram.cmdWrite(addr, value, time);
+	} else {
+		vram.cmdWriteDirect(addr, value, time);
+	}
+}
+
+/** Advance the slot calculator over (at most 'num') repetitions of the
+  * access pattern of a command, without doing the accesses. A repetition
+  * does one access per delta, after each access the time advances by that
+  * delta. Stops in front of a repetition that doesn't entirely fit before
+  * the limit, so that the normal (per access) code can continue from there.
+  * @return The number of repetitions that were skipped.
+  */
+template<Delta... DELTAS>
+static unsigned skipSlots(VDPAccessSlots::Calculator& calculator, unsigned num)
+{
+	static constexpr std::array<Delta, sizeof...(DELTAS)> deltas = {DELTAS...};
+	unsigned n = 0;
+	while ((n < num) && !calculator.limitReached()) {
+		auto start = calculator;
+		for (auto i : xrange(deltas.size() - 1)) {
+			calculator.next(deltas[i]);
+			if (calculator.limitReached()) {
+				calculator = start;
+				return n;
+			}
+		}
+		calculator.next(deltas.back());
+		++n;
+	}
+	return n;
+}
+
+/** The lowest VRAM address of the 'num' bytes on line 'y' that a byte based
+  * command accesses when starting at 'x' and stepping 'tx' pixels. In the
+  * non-planar modes these bytes are 'num' consecutive addresses.
+  */
+template<typename Mode>
+static unsigned lowestAddressOf(unsigned x, int tx, unsigned num, unsigned y, bool extVRAM)
+{
+	static_assert(!Mode::PLANAR);
+	unsigned last = x + (num - 1) * tx;
+	return Mode::addressOf(std::min(x, last), y, extVRAM);
+}
 
 // Commands
 
@@ -799,7 +897,7 @@ void VDPCmdEngine::executePset(EmuTime limit)
 	case 0:
 		if (engineTime >= limit) [[unlikely]] { phase = 0; break; }
 		if (doPset) [[likely]] {
-			tmpDst = vram.cmdWriteWindow.readNP(addr);
+			tmpDst = vram.cmdRead(vram.cmdWriteWindow, addr);
 		}
 		nextAccessSlot(Delta::D24); // TODO
 		[[fallthrough]];
@@ -895,7 +993,7 @@ void VDPCmdEngine::executeLine(EmuTime limit)
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 		if (doPset) [[likely]] {
-			tmpDst = vram.cmdWriteWindow.readNP(addr);
+			tmpDst = vram.cmdRead(vram.cmdWriteWindow, addr);
 		}
 		calculator.next(Delta::D24);
 		[[fallthrough]];
@@ -993,14 +1091,31 @@ void VDPCmdEngine::executeLmmv(EmuTime limit)
 	uint8_t CL = COL & Mode::COLOR_MASK;
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset = !dstExt || hasExtendedVRAM;
+	bool observed = isLineObserved<Mode>(vram, DY, dstExt);
 	unsigned addr = Mode::addressOf(ADX, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
+		if (!observed && doPset && (ANX > 1)) {
+			// Same as in executeHmmv(), but the pixels of (the part
+			// before 'limit' of) this line still need to be combined
+			// one by one.
+			EmuTime time = calculator.getTime();
+			unsigned n = skipSlots<Delta::D24, Delta::D72>(calculator, ANX - 1);
+			repeat(n, [&] {
+				Mode::pset(time, vram, ADX, addr,
+				           vram.cmdRead(vram.cmdWriteWindow, addr),
+				           CL, DirectOp<LogOp>());
+				ADX += TX;
+				addr = Mode::addressOf(ADX, DY, dstExt);
+			});
+			ANX -= n;
+			if (calculator.limitReached()) { phase = 0; break; }
+		}
 		if (doPset) [[likely]] {
-			tmpDst = vram.cmdWriteWindow.readNP(addr);
+			tmpDst = vram.cmdRead(vram.cmdWriteWindow, addr);
 		}
 		calculator.next(Delta::D24);
 		[[fallthrough]];
@@ -1020,6 +1135,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 				commandDone(calculator.getTime());
 				break;
 			}
+			observed = isLineObserved<Mode>(vram, DY, dstExt);
 		}
 		addr = Mode::addressOf(ADX, DY, dstExt);
 		calculator.next(delta);
@@ -1119,12 +1235,28 @@ void VDPCmdEngine::executeLmmm(EmuTime limit)
 	bool dstExt  = (ARG & MXD) != 0;
 	bool doPoint = !srcExt || hasExtendedVRAM;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+	bool observed = isLineObserved<Mode>(vram, DY, dstExt);
 	unsigned dstAddr = Mode::addressOf(ADX, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
+		if (!observed && doPset && (ANX > 1)) {
+			// See executeLmmv().
+			EmuTime time = calculator.getTime();
+			unsigned n = skipSlots<Delta::D32, Delta::D24, Delta::D64>(calculator, ANX - 1);
+			repeat(n, [&] {
+				uint8_t src = doPoint ? Mode::point(vram, ASX, SY, srcExt) : 0xFF;
+				Mode::pset(time, vram, ADX, dstAddr,
+				           vram.cmdRead(vram.cmdWriteWindow, dstAddr),
+				           src, DirectOp<LogOp>());
+				ASX += TX; ADX += TX;
+				dstAddr = Mode::addressOf(ADX, DY, dstExt);
+			});
+			ANX -= n;
+			if (calculator.limitReached()) { phase = 0; break; }
+		}
 		if (doPoint) [[likely]] {
 		       tmpSrc = Mode::point(vram, ASX, SY, srcExt);
 		} else {
@@ -1135,7 +1267,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 	case 1:
 		if (calculator.limitReached()) [[unlikely]] { phase = 1; break; }
 		if (doPset) [[likely]] {
-			tmpDst = vram.cmdWriteWindow.readNP(dstAddr);
+			tmpDst = vram.cmdRead(vram.cmdWriteWindow, dstAddr);
 		}
 		calculator.next(Delta::D24);
 		[[fallthrough]];
@@ -1155,6 +1287,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 				commandDone(calculator.getTime());
 				break;
 			}
+			observed = isLineObserved<Mode>(vram, DY, dstExt);
 		}
 		dstAddr = Mode::addressOf(ADX, DY, dstExt);
 		calculator.next(delta);
@@ -1204,7 +1337,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 			             ? std::min(dur.divUp(delta), ANX)
 			             : ANX;
 			for (auto i : xrange(num)) {
-				uint8_t p = vram.cmdReadWindow.readNP(srcAddr.getAddr());
+				uint8_t p = vram.cmdRead(vram.cmdReadWindow, srcAddr.getAddr());
 				p = shift.doShift(p);
 				uint8_t mask = dstMask.getMask();
 				psetFast(engineTime, vram, dstAddr.getAddr(),
@@ -1327,7 +1460,7 @@ void VDPCmdEngine::executeLmmc(EmuTime limit)
 		//    - in next access slot write
 		if (doPset) [[likely]] {
 			unsigned addr = Mode::addressOf(ADX, DY, dstExt);
-			tmpDst = vram.cmdWriteWindow.readNP(addr);
+			tmpDst = vram.cmdRead(vram.cmdWriteWindow, addr);
 			Mode::pset(limit, vram, ADX, addr,
 			           tmpDst, col, LogOp());
 		}
@@ -1378,12 +1511,25 @@ void VDPCmdEngine::executeHmmv(EmuTime limit)
 		ADX, ANX << Mode::PIXELS_PER_BYTE_SHIFT, ARG);
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset = !dstExt || hasExtendedVRAM;
+	bool observed = isLineObserved<Mode>(vram, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
 	while (!calculator.limitReached()) {
+		if constexpr (!Mode::PLANAR) {
+			if (!observed && doPset && (ANX > 1)) {
+				// Nothing observes this line: first find how much
+				// of it gets written before 'limit', then fill that
+				// part at once. The last byte of the line is
+				// handled below.
+				unsigned n = skipSlots<Delta::D48>(calculator, ANX - 1);
+				vram.cmdFillDirect(lowestAddressOf<Mode>(ADX, TX, n, DY, dstExt), n, COL);
+				ADX += n * TX; ANX -= n;
+				if (calculator.limitReached()) break;
+			}
+		}
 		if (doPset) [[likely]] {
-			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
-			              COL, calculator.getTime());
+			cmdWrite(vram, observed, Mode::addressOf(ADX, DY, dstExt),
+			         COL, calculator.getTime());
 		}
 		ADX += TX;
 		Delta delta = Delta::D48;
@@ -1395,6 +1541,7 @@ void VDPCmdEngine::executeHmmv(EmuTime limit)
 				commandDone(calculator.getTime());
 				break;
 			}
+			observed = isLineObserved<Mode>(vram, DY, dstExt);
 		}
 		calculator.next(delta);
 	}
@@ -1486,13 +1633,30 @@ void VDPCmdEngine::executeHmmm(EmuTime limit)
 	bool dstExt  = (ARG & MXD) != 0;
 	bool doPoint = !srcExt || hasExtendedVRAM;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+	bool observed = isLineObserved<Mode>(vram, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
+		if constexpr (!Mode::PLANAR) {
+			if (!observed && doPset && (ANX > 1)) {
+				// Same as in executeHmmv(), copy (the part before
+				// 'limit' of) this line at once.
+				unsigned n = skipSlots<Delta::D24, Delta::D64>(calculator, ANX - 1);
+				unsigned dst = lowestAddressOf<Mode>(ADX, TX, n, DY, dstExt);
+				if (doPoint) [[likely]] {
+					unsigned src = lowestAddressOf<Mode>(ASX, TX, n, SY, srcExt);
+					vram.cmdCopyDirect(src, dst, n, TX < 0);
+				} else {
+					vram.cmdFillDirect(dst, n, 0xFF);
+				}
+				ASX += n * TX; ADX += n * TX; ANX -= n;
+				if (calculator.limitReached()) { phase = 0; break; }
+			}
+		}
 		if (doPoint) [[likely]] {
-			tmpSrc = vram.cmdReadWindow.readNP(Mode::addressOf(ASX, SY, srcExt));
+			tmpSrc = vram.cmdRead(vram.cmdReadWindow, Mode::addressOf(ASX, SY, srcExt));
 		} else {
 			tmpSrc = 0xFF;
 		}
@@ -1501,8 +1665,8 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 	case 1: {
 		if (calculator.limitReached()) [[unlikely]] { phase = 1; break; }
 		if (doPset) [[likely]] {
-			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
-			              tmpSrc, calculator.getTime());
+			cmdWrite(vram, observed, Mode::addressOf(ADX, DY, dstExt),
+			         tmpSrc, calculator.getTime());
 		}
 		ASX += TX; ADX += TX;
 		Delta delta = Delta::D64;
@@ -1514,6 +1678,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 				commandDone(calculator.getTime());
 				break;
 			}
+			observed = isLineObserved<Mode>(vram, DY, dstExt);
 		}
 		calculator.next(delta);
 		goto loop;
@@ -1531,7 +1696,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 			if (doPset) [[likely]] {
 				auto p = [&] -> uint8_t {
 					if (doPoint) [[likely]] {
-						return vram.cmdReadWindow.readNP(Mode::addressOf(ASX, SY, srcExt));
+						return vram.cmdRead(vram.cmdReadWindow, Mode::addressOf(ASX, SY, srcExt));
 					} else {
 						return 0xFF;
 					}
@@ -1560,7 +1725,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 			             ? std::min(dur.divUp(delta), ANX)
 			             : ANX;
 			for (auto i : xrange(num)) {
-				uint8_t p = vram.cmdReadWindow.readNP(srcAddr.getAddr());
+				uint8_t p = vram.cmdRead(vram.cmdReadWindow, srcAddr.getAddr());
 				vram.cmdWrite(dstAddr.getAddr(), p, engineTime);
 				engineTime += delta;
 				srcAddr.step(TX);
@@ -1624,13 +1789,26 @@ void VDPCmdEngine::executeYmmm(EmuTime limit)
 	//  OTOH YMMM also uses DX for both read and write
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+	bool observed = isLineObserved<Mode>(vram, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
+		if constexpr (!Mode::PLANAR) {
+			if (!observed && doPset && (ANX > 1)) {
+				// Same as in executeHmmv(), copy (the part before
+				// 'limit' of) this line at once.
+				unsigned n = skipSlots<Delta::D24, Delta::D40>(calculator, ANX - 1);
+				vram.cmdCopyDirect(lowestAddressOf<Mode>(ADX, TX, n, SY, dstExt),
+				                   lowestAddressOf<Mode>(ADX, TX, n, DY, dstExt),
+				                   n, TX < 0);
+				ADX += n * TX; ANX -= n;
+				if (calculator.limitReached()) { phase = 0; break; }
+			}
+		}
 		if (doPset) [[likely]] {
-			tmpSrc = vram.cmdReadWindow.readNP(
+			tmpSrc = vram.cmdRead(vram.cmdReadWindow, 
 			       Mode::addressOf(ADX, SY, dstExt));
 		}
 		calculator.next(Delta::D24);
@@ -1638,8 +1816,8 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 	case 1:
 		if (calculator.limitReached()) [[unlikely]] { phase = 1; break; }
 		if (doPset) [[likely]] {
-			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
-			              tmpSrc, calculator.getTime());
+			cmdWrite(vram, observed, Mode::addressOf(ADX, DY, dstExt),
+			         tmpSrc, calculator.getTime());
 		}
 		ADX += TX;
 		if (--ANX == 0) {
@@ -1650,6 +1828,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 				commandDone(calculator.getTime());
 				break;
 			}
+			observed = isLineObserved<Mode>(vram, DY, dstExt);
 		}
 		calculator.next(Delta::D40);
 		goto loop;
@@ -1664,7 +1843,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 		bool doPset  = !dstExt || hasExtendedVRAM;
 		while (engineTime < limit) {
 			if (doPset) [[likely]] {
-				uint8_t p = vram.cmdReadWindow.readNP(
+				uint8_t p = vram.cmdRead(vram.cmdReadWindow, 
 					      Mode::addressOf(ADX, SY, dstExt));
 				vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
 					      p, engineTime);
@@ -1690,7 +1869,7 @@ loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
 			             ? std::min(dur.divUp(delta), ANX)
 			             : ANX;
 			for (auto i : xrange(num)) {
-				uint8_t p = vram.cmdReadWindow.readNP(srcAddr.getAddr());
+				uint8_t p = vram.cmdRead(vram.cmdReadWindow, srcAddr.getAddr());
 				vram.cmdWrite(dstAddr.getAddr(), p, engineTime);
 				engineTime += delta;
 				srcAddr.step(TX);
@@ -106,6 +106,7 @@ static constexpr unsigned bufferSize(unsigned size)
 VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime time)
 	: vdp(vdp_)
 	, data(*vdp_.getDeviceConfig2().getXML(), bufferSize(size))
+	, dirtyPages(size)
 	, logicalVRAMDebug (vdp)
 	, physicalVRAMDebug(vdp, size)
 	, actualSize(size)
@@ -126,6 +127,8 @@ VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime time)
 	// Because this window has no observer, any EmuTime can be passed.
 	// TODO: Move this to cache registration.
 	bitmapCacheWindow.setMask(0x1FFFF, ~0u << 17, EmuTime::zero());
+
+	dirtyPages.markAll();
 }
 
 void VDPVRAM::clear()
@@ -139,6 +142,7 @@ void VDPVRAM::clear()
 		// give the same value.
 		std::ranges::fill(subspan(data, actualSize), 0xFF);
 	}
+	dirtyPages.markAll();
 }
 
 void VDPVRAM::updateDisplayMode(DisplayMode mode, bool cmdBit, EmuTime time)
@@ -216,6 +220,23 @@ void VDPVRAM::updateVRMode(bool newVRmode, EmuTime time)
 			std::swap(data[i], data[swapAddr(i)]);
 		}
 	}
+	dirtyPages.markAll();
+}
+
+bool VDPVRAM::isCmdWriteObserved(unsigned address, unsigned freeBits) const
+{
+	// The access statistics count every single write.
+	if (accessStats) return true;
+
+	address  &= sizeMask;
+	freeBits &= sizeMask;
+	if (spriteAttribTable .isInsideAny(address, freeBits) ||
+	    spritePatternTable.isInsideAny(address, freeBits)) {
+		return true;
+	}
+	// bitmapVisibleWindow covers all VRAM, so ask the renderer.
+	return bitmapVisibleWindow.isInsideAny(address, freeBits) &&
+	       renderer->isVRAMDisplayed(address, freeBits);
 }
 
 void VDPVRAM::setRenderer(Renderer* newRenderer, EmuTime time)
@@ -231,6 +252,17 @@ void VDPVRAM::setRenderer(Renderer* newRenderer, EmuTime time)
 	bitmapVisibleWindow.setObserver(renderer);
 }
 
+void VDPVRAM::setAccessStatsEnabled(bool enabled)
+{
+	if (enabled) {
+		if (!accessStats) {
+			accessStats = std::make_unique<VRAMAccessStats>(actualSize);
+		}
+	} else {
+		accessStats.reset();
+	}
+}
+
 void VDPVRAM::change4k8kMapping(bool mapping8k)
 {
 	/* Sources:
@@ -296,6 +328,7 @@ void VDPVRAM::change4k8kMapping(bool mapping8k)
 		}
 	}
 	copy_to_range(tmp, std::span{data});
+	dirtyPages.markAll();
 }
 
 
@@ -320,7 +353,16 @@ void VDPVRAM::serialize(Archive& ar, unsigned /*version*/)
 		setSizeMask(static_cast<MSXDevice&>(vdp).getCurrentTime());
 	}
 
-	ar.serialize_blob("data", std::span{data.data(), actualSize});
+	std::span blob{data.data(), actualSize};
+	if constexpr (Archive::IS_LOADER) {
+		ar.serialize_blob("data", blob);
+		dirtyPages.markAll();
+	} else if (ar.isReverseSnapshot()) {
+		ar.serialize_blob("data", blob, dirtyPages);
+		dirtyPages.clear();
+	} else {
+		ar.serialize_blob("data", blob);
+	}
 	ar.serialize("cmdReadWindow",       cmdReadWindow,
 	             "cmdWriteWindow",      cmdWriteWindow,
 	             "nameTable",           nameTable,
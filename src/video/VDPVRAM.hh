@@ -3,15 +3,22 @@
 
 #include "VDP.hh"
 #include "VDPCmdEngine.hh"
+#include "VRAMAccessStats.hh"
 #include "VRAMObserver.hh"
 
 #include "Ram.hh"
 #include "SimpleDebuggable.hh"
 
+#include "DirtyPages.hh"
 #include "Math.hh"
+#include "one_of.hh"
+#include "xrange.hh"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <memory>
+#include <span>
 
 namespace openmsx {
 
@@ -312,6 +319,17 @@ public:
 		return (address & combiMask) == baseAddr;
 	}
 
+	/** Test whether a block of addresses is (partly) inside this window.
+	  * The block contains all addresses that only differ from 'address'
+	  * in the bit positions that are set in 'freeBits'.
+	  * @param address Any address in the block.
+	  * @param freeBits Bits that vary within the block.
+	  * @return true iff at least one address in the block is inside.
+	  */
+	[[nodiscard]] bool isInsideAny(unsigned address, unsigned freeBits) const {
+		return (address & combiMask & ~freeBits) == (baseAddr & ~freeBits);
+	}
+
 	/** Notifies the observer of this window of a VRAM change,
 	  * if the changes address is inside this window.
 	  * @param address The address to test.
@@ -443,10 +461,88 @@ public:
 			// to range [0x4000,0x8000)
 			return;
 		}
+		countAccess(VRAMAccessStats::Access::CMD_WRITE, address);
 
 		writeCommon(address, value, time);
 	}
 
+	/** Is any subsystem observing writes to (part of) the given block of
+	  * VRAM (see VRAMWindow::isInsideAny())? If not, the command engine
+	  * can use cmdWriteDirect() for all addresses in that block.
+	  */
+	[[nodiscard]] bool isCmdWriteObserved(unsigned address, unsigned freeBits) const;
+
+	/** Like cmdWrite(), but skips notifying the observers. Only allowed
+	  * when isCmdWriteObserved() returned false for this address.
+	  */
+	void cmdWriteDirect(unsigned address, uint8_t value, EmuTime time) {
+		#ifdef DEBUG
+		assert(time >= vramTime);
+		vramTime = time;
+		#endif
+		(void)time;
+		assert(vdp.isInsideFrame(time));
+
+		address &= sizeMask;
+		if (address >= actualSize) [[unlikely]] return;
+		assert(!isCmdWriteObserved(address, 0));
+		countAccess(VRAMAccessStats::Access::CMD_WRITE, address);
+
+		if (data[address] == value) return;
+		data[address] = value;
+		dirtyPages.mark(address);
+	}
+
+	/** Bulk version of cmdWriteDirect(): write 'value' to the 'num'
+	  * addresses starting at 'address'. These addresses may not cross a
+	  * 128 byte boundary (they're all on the same line of a bitmap).
+	  */
+	void cmdFillDirect(unsigned address, unsigned num, uint8_t value) {
+		address &= sizeMask;
+		if (address >= actualSize) [[unlikely]] return;
+		assert((address & 127) + num <= 128);
+		assert(!isCmdWriteObserved(address, 127));
+
+		auto dst = std::span{&data[address], num};
+		if (std::ranges::all_of(dst, [&](auto b) { return b == value; })) return;
+		std::ranges::fill(dst, value);
+		dirtyPages.mark(address);
+	}
+
+	/** Bulk version of cmdWriteDirect() with values read through the
+	  * command read window (see cmdRead()): copy the 'num' bytes starting
+	  * at 'src' to the addresses starting at 'dst'. Like when copying byte
+	  * per byte, going up or 'down' in address, when both ranges overlap.
+	  * The destination addresses may not cross a 128 byte boundary.
+	  */
+	void cmdCopyDirect(unsigned src, unsigned dst, unsigned num, bool down) {
+		dst &= sizeMask;
+		if (dst >= actualSize) [[unlikely]] return;
+		assert((dst & 127) + num <= 128);
+		assert(!isCmdWriteObserved(dst, 127));
+
+		bool changed = false;
+		for (auto i : xrange(num)) {
+			unsigned j = down ? (num - 1 - i) : i;
+			uint8_t value = cmdReadWindow.readNP(src + j);
+			changed |= data[dst + j] != value;
+			data[dst + j] = value;
+		}
+		if (changed) dirtyPages.mark(dst);
+	}
+
+	/** Read a byte for the command engine, through the command read window
+	  * (or through the command write window, for the read part of a
+	  * read-modify-write). Same as VRAMWindow::readNP(), but the access is
+	  * counted in the access statistics (when enabled).
+	  */
+	[[nodiscard]] uint8_t cmdRead(const VRAMWindow& window, unsigned index) const {
+		assert(&window == one_of(&cmdReadWindow, &cmdWriteWindow));
+		countAccess(VRAMAccessStats::Access::CMD_READ,
+		            window.effectiveBaseMask & index);
+		return window.readNP(index);
+	}
+
 	/** Write a byte to VRAM through the CPU interface.
 	  * @param address The address to write.
 	  * @param value The value to write.
@@ -468,6 +564,7 @@ public:
 			// to range [0x4000,0x8000)
 			return;
 		}
+		countAccess(VRAMAccessStats::Access::CPU_WRITE, address);
 
 		// We should still sync with cmdEngine, even if the VRAM already
 		// contains the value we're about to write (e.g. it's possible
@@ -500,6 +597,7 @@ public:
 			cmdEngine->sync(time);
 		}
 		cmdEngine->stealAccessSlot(time);
+		countAccess(VRAMAccessStats::Access::CPU_READ, address);
 
 		#ifdef DEBUG
 		vramTime = time;
@@ -568,6 +666,17 @@ public:
 		return {data.data(), data.size()};
 	}
 
+	/** Start or stop collecting VRAM access statistics. Stopping
+	  * discards the collected data.
+	  */
+	void setAccessStatsEnabled(bool enabled);
+
+	/** The VRAM access statistics, or nullptr when not enabled.
+	  */
+	[[nodiscard]] VRAMAccessStats* getAccessStats() const {
+		return accessStats.get();
+	}
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -593,6 +702,7 @@ private:
 		spritePatternTable.notify(address, time);
 
 		data[address] = value;
+		dirtyPages.mark(address);
 
 		// Cache dirty marking should happen after the commit,
 		// otherwise the cache could be re-validated based on old state.
@@ -622,6 +732,13 @@ private:
 
 	void setSizeMask(EmuTime time);
 
+	void countAccess(VRAMAccessStats::Access access, unsigned address) const {
+		if (accessStats) [[unlikely]] {
+			// reads can go beyond 'actualSize' for 16kB VRAM
+			if (address < actualSize) accessStats->count(access, address);
+		}
+	}
+
 private:
 	/** VDP this VRAM belongs to.
 	  */
@@ -631,6 +748,10 @@ private:
 	  */
 	Ram data;
 
+	/** Pages of 'data' that changed since the last reverse snapshot.
+	  */
+	DirtyPages dirtyPages;
+
 	/** Debuggable with mode dependent view on the vram
 	  *   Screen7/8 are not interleaved in this mode.
 	  *   This debuggable is also at least 128kB in size (it possibly
@@ -663,6 +784,10 @@ private:
 	VDPCmdEngine* cmdEngine;
 	SpriteChecker* spriteChecker;
 
+	/** Only allocated while access statistics are enabled.
+	  */
+	std::unique_ptr<VRAMAccessStats> accessStats;
+
 	/** The last time a CmdEngine write or a CPU read/write occurred.
 	  * This is only used in a debug build to check if read/writes come
 	  * in the correct order.
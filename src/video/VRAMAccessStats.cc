@@ -0,0 +1,41 @@
+#include "VRAMAccessStats.hh"
+
+#include <algorithm>
+#include <numeric>
+
+namespace openmsx {
+
+uint32_t VRAMAccessStats::FrameCounts::total() const
+{
+	return std::accumulate(counts.begin(), counts.end(), uint32_t(0));
+}
+
+float VRAMAccessStats::FrameCounts::utilization() const
+{
+	if (slots == 0) return 0.0f;
+	return std::min(1.0f, float(total()) / float(slots));
+}
+
+VRAMAccessStats::VRAMAccessStats(unsigned vramSize_)
+	: heatmap(NUM_ACCESS * vramSize_)
+	, vramSize(vramSize_)
+{
+	clearHeatmap();
+}
+
+void VRAMAccessStats::frameEnd(uint32_t slots)
+{
+	current.slots = slots;
+	if (history.full()) history.pop_front();
+	history.push_back(current);
+	current = FrameCounts{};
+	++heatmapFrames;
+}
+
+void VRAMAccessStats::clearHeatmap()
+{
+	std::ranges::fill(heatmap, 0);
+	heatmapFrames = 0;
+}
+
+} // namespace openmsx
@@ -0,0 +1,92 @@
+#ifndef VRAMACCESSSTATS_HH
+#define VRAMACCESSSTATS_HH
+
+#include "CircularBuffer.hh"
+#include "MemBuffer.hh"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace openmsx {
+
+/** Optional instrumentation of the VRAM accesses of a VDP. It shows how much
+  * of the VRAM bandwidth is used by the CPU and by the command engine.
+  *
+  * Accesses are counted per frame and per VRAM address (a heatmap). The
+  * frame counters are kept for the last HISTORY frames, the heatmap
+  * accumulates until it's cleared. This object only exists while the
+  * instrumentation is enabled, see VDPVRAM::setAccessStatsEnabled().
+  */
+class VRAMAccessStats
+{
+public:
+	enum class Access : uint8_t { CPU_READ, CPU_WRITE, CMD_READ, CMD_WRITE, NUM };
+	static constexpr auto NUM_ACCESS = std::to_underlying(Access::NUM);
+	static constexpr std::array<std::string_view, NUM_ACCESS> accessNames = {
+		"cpu_read", "cpu_write", "cmd_read", "cmd_write"
+	};
+
+	struct FrameCounts {
+		std::array<uint32_t, NUM_ACCESS> counts = {};
+		/** The number of VRAM access slots (available for CPU and
+		  * command engine) in this frame. */
+		uint32_t slots = 0;
+
+		[[nodiscard]] uint32_t get(Access access) const {
+			return counts[std::to_underlying(access)];
+		}
+		[[nodiscard]] uint32_t total() const;
+		/** Fraction of the access slots that was used, in [0..1]. */
+		[[nodiscard]] float utilization() const;
+	};
+
+	static constexpr size_t HISTORY = 256;
+
+	explicit VRAMAccessStats(unsigned vramSize);
+
+	void count(Access access, unsigned address) {
+		assert(address < vramSize);
+		auto a = std::to_underlying(access);
+		++current.counts[a];
+		++heatmap[a * vramSize + address];
+	}
+
+	/** Close the current frame (and start a new one).
+	  * @param slots The number of access slots in the finished frame.
+	  */
+	void frameEnd(uint32_t slots);
+
+	/** The counters of the frame that is being emulated right now. */
+	[[nodiscard]] const FrameCounts& getCurrentFrame() const { return current; }
+
+	/** The counters of the last (up to HISTORY) finished frames, the
+	  * oldest one first. */
+	[[nodiscard]] const auto& getHistory() const { return history; }
+
+	/** Number of accesses of the given type, per VRAM address. */
+	[[nodiscard]] std::span<const uint32_t> getHeatmap(Access access) const {
+		return std::span<const uint32_t>(heatmap).subspan(
+			std::to_underlying(access) * vramSize, vramSize);
+	}
+
+	/** Number of frames that were accumulated in the heatmap. */
+	[[nodiscard]] unsigned getHeatmapFrames() const { return heatmapFrames; }
+
+	/** Reset the heatmap (the per frame counters are not affected). */
+	void clearHeatmap();
+
+private:
+	MemBuffer<uint32_t> heatmap; // NUM_ACCESS x vramSize
+	CircularBuffer<FrameCounts, HISTORY> history;
+	FrameCounts current;
+	const unsigned vramSize;
+	unsigned heatmapFrames = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -55,9 +55,11 @@ public:
 	  * The default implementation throws an exception.
 	  * @param filename Name of the file to save the screenshot to.
 	  * @param withOsd Should OSD elements be included in the screenshot.
+	  * @param compressionLevel PNG compression level, see PNG::saveRGBA().
 	  * @throws MSXException If taking the screen shot fails.
 	  */
-	virtual void takeScreenShot(const std::string& filename, bool withOsd);
+	virtual void takeScreenShot(const std::string& filename, bool withOsd,
+	                            int compressionLevel);
 
 	/** Called when the window title string has changed.
 	  */
@@ -354,13 +354,13 @@ std::optional<gl::ivec2> VisibleSurface::getMouseCoord() const
 }
 
 
-void VisibleSurface::saveScreenshot(const std::string& filename)
+void VisibleSurface::saveScreenshot(const std::string& filename, int compressionLevel)
 {
-	saveScreenshotGL(*this, filename);
+	saveScreenshotGL(*this, filename, compressionLevel);
 }
 
 void VisibleSurface::saveScreenshotGL(
-	const OutputSurface& output, const std::string& filename)
+	const OutputSurface& output, const std::string& filename, int compressionLevel)
 {
 	auto [x, y] = output.getViewOffset();
 	auto [w, h] = output.getViewSize();
@@ -372,7 +372,7 @@ void VisibleSurface::saveScreenshotGL(
 	small_buffer<const uint32_t*, 1080> rowPointers(std::views::transform(xrange(size_t(h)),
 		[&](auto i) { return &buffer[size_t(w) * (h - 1 - i)]; }));
 
-	PNG::saveRGBA(w, rowPointers, filename);
+	PNG::saveRGBA(w, rowPointers, filename, compressionLevel);
 }
 
 void VisibleSurface::finish()
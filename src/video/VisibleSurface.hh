@@ -45,7 +45,8 @@ public:
 	[[nodiscard]] Display& getDisplay() const { return display; }
 
 	static void saveScreenshotGL(const OutputSurface& output,
-	                             const std::string& filename);
+	                             const std::string& filename,
+	                             int compressionLevel);
 
 	[[nodiscard]] std::optional<gl::ivec2> getMouseCoord() const;
 	void updateWindowTitle();
@@ -76,7 +77,7 @@ public:
 	void setWindowPosition(gl::ivec2 pos);
 
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	void saveScreenshot(const std::string& filename, int compressionLevel) override;
 
 	// Observer
 	void update(const Setting& setting) noexcept override;
@@ -18,8 +18,13 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <thread>
 #include <tuple>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace openmsx {
 
 static constexpr uint8_t DBZV_VERSION_HIGH = 0;
@@ -29,6 +34,9 @@ static constexpr unsigned MAX_VECTOR = 16;
 static constexpr unsigned BLOCK_WIDTH  = MAX_VECTOR;
 static constexpr unsigned BLOCK_HEIGHT = MAX_VECTOR;
 static constexpr unsigned FLAG_KEYFRAME = 0x01;
+static constexpr unsigned MAX_STRIPES = 8;
+static constexpr unsigned WINDOW_SIZE = 32768; // deflate history
+static constexpr int COMPRESSION_LEVEL = 6;
 
 struct CodecVector {
 	int8_t x;
@@ -115,14 +123,37 @@ static inline void writePixel(
 	dest = (r << 16) | (g <<  8) |  b;
 }
 
+#ifdef __SSE2__
+// Same as writePixel(), but for 4 pixels at once.
+static inline void writePixels(__m128i pixels, Endian::L32* dest)
+{
+	__m128i mask = _mm_set1_epi32(0xFF);
+	__m128i r = _mm_slli_epi32(_mm_and_si128(pixels, mask), 16);
+	__m128i g = _mm_and_si128(pixels, _mm_set1_epi32(0xFF00));
+	__m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 16), mask);
+	_mm_storeu_si128(std::bit_cast<__m128i*>(dest),
+	                 _mm_or_si128(_mm_or_si128(r, g), b));
+}
+#endif
+
+ZMBVEncoder::Stripe::Stripe()
+{
+	memset(&zstream, 0, sizeof(zstream));
+	// Raw deflate (no zlib header/trailer): the stripes are concatenated
+	// into a single zlib stream.
+	deflateInit2(&zstream, COMPRESSION_LEVEL, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+}
+
+ZMBVEncoder::Stripe::~Stripe()
+{
+	deflateEnd(&zstream);
+}
 
 ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_)
 	: width(width_)
 	, height(height_)
 {
 	setupBuffers();
-	memset(&zstream, 0, sizeof(zstream));
-	deflateInit(&zstream, 6); // compression level
 
 	// I did a small test: compression level vs compression speed
 	//  (recorded Space Manbow intro, video only)
@@ -143,6 +174,8 @@ ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_)
 	// Level 6 seems a good compromise between size/speed for THIS test.
 }
 
+ZMBVEncoder::~ZMBVEncoder() = default;
+
 void ZMBVEncoder::setupBuffers()
 {
 	static constexpr size_t pixelSize = sizeof(Pixel);
@@ -154,15 +187,12 @@ void ZMBVEncoder::setupBuffers()
 	newFrame.resize(bufSize);
 	std::ranges::fill(std::span{oldFrame}, 0);
 	std::ranges::fill(std::span{newFrame}, 0);
-	work.resize(bufSize);
-	outputSize = neededSize();
-	output.resize(outputSize);
 
 	assert((width  % BLOCK_WIDTH ) == 0);
 	assert((height % BLOCK_HEIGHT) == 0);
-	size_t xBlocks = width / BLOCK_WIDTH;
-	size_t yBlocks = height / BLOCK_HEIGHT;
-	blockOffsets.resize(xBlocks * yBlocks);
+	unsigned xBlocks = width / BLOCK_WIDTH;
+	unsigned yBlocks = height / BLOCK_HEIGHT;
+	blockOffsets.resize(size_t(xBlocks) * yBlocks);
 	for (auto y : xrange(yBlocks)) {
 		for (auto x : xrange(xBlocks)) {
 			blockOffsets[y * xBlocks + x] =
@@ -170,13 +200,34 @@ void ZMBVEncoder::setupBuffers()
 				(x * BLOCK_WIDTH) + MAX_VECTOR;
 		}
 	}
-}
 
-unsigned ZMBVEncoder::neededSize() const
-{
-	static constexpr unsigned pixelSize = sizeof(Pixel);
-	unsigned f = pixelSize * width * height + 2 * (1 + (width / 8)) * (1 + (height / 8)) + 1024;
-	return f + f / 1000;
+	// Split the frame in (roughly) equal stripes of whole block rows, one
+	// per core (but not too many, each stripe restarts the motion vector
+	// search and has a small compression overhead).
+	unsigned numStripes = std::min(
+		std::clamp(std::thread::hardware_concurrency(), 1u, MAX_STRIPES),
+		yBlocks);
+	stripes = std::vector<Stripe>(numStripes);
+	workers.emplace(numStripes - 1);
+	unsigned blockCount = xBlocks * yBlocks;
+	unsigned vectorSize = (blockCount * 2 + 3) & ~3;
+	static constexpr auto blockSize = unsigned(BLOCK_WIDTH * BLOCK_HEIGHT * pixelSize);
+	unsigned outputSize = 1 + sizeof(KeyframeHeader) + 2; // + 2 for zlib header
+	for (auto i : xrange(numStripes)) {
+		auto& stripe = stripes[i];
+		stripe.firstBlock = xBlocks * ((yBlocks * (i + 0)) / numStripes);
+		stripe.lastBlock  = xBlocks * ((yBlocks * (i + 1)) / numStripes);
+		// the first stripe also contains the motion vectors
+		auto workSize = (stripe.lastBlock - stripe.firstBlock) * blockSize +
+		                ((i == 0) ? vectorSize : 0);
+		stripe.work.resize(workSize);
+		stripe.dict.resize(WINDOW_SIZE);
+		// + some extra for the sync flush marker
+		stripe.output.resize(deflateBound(&stripe.zstream, workSize) + 16);
+		outputSize += narrow<unsigned>(stripe.output.size());
+	}
+	output.resize(outputSize);
+	dictionary.resize(WINDOW_SIZE);
 }
 
 unsigned ZMBVEncoder::possibleBlock(int vx, int vy, size_t offset)
@@ -199,6 +250,25 @@ unsigned ZMBVEncoder::compareBlock(int vx, int vy, size_t offset)
 	int ret = 0;
 	const auto* pOld = &(std::bit_cast<const Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
 	const auto* pNew = &(std::bit_cast<const Pixel*>(newFrame.data()))[offset];
+#ifdef __SSE2__
+	// SSE2 version: compare a full row (16 pixels) at once
+	static_assert(BLOCK_WIDTH == 16);
+	repeat(BLOCK_HEIGHT, [&] {
+		unsigned equal = 0;
+		for (auto i : xrange(4)) {
+			__m128i o = _mm_loadu_si128(std::bit_cast<const __m128i*>(pOld + 4 * i));
+			__m128i n = _mm_loadu_si128(std::bit_cast<const __m128i*>(pNew + 4 * i));
+			auto mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(o, n)));
+			equal |= unsigned(mask) << (4 * i);
+		}
+		ret += BLOCK_WIDTH - std::popcount(equal);
+		pOld += pitch;
+		pNew += pitch;
+	});
+	return ret;
+#endif
+
+	// C++ version
 	repeat(BLOCK_HEIGHT, [&] {
 		for (auto x : xrange(BLOCK_WIDTH)) {
 			if (pOld[x] != pNew[x]) ++ret;
@@ -209,37 +279,47 @@ unsigned ZMBVEncoder::compareBlock(int vx, int vy, size_t offset)
 	return ret;
 }
 
-void ZMBVEncoder::addXorBlock(int vx, int vy, size_t offset, unsigned& workUsed)
+void ZMBVEncoder::addXorBlock(int vx, int vy, size_t offset, Stripe& stripe)
 {
 	using LE_P = typename Endian::Little<Pixel>::type;
 
 	const auto* pOld = &(std::bit_cast<const Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
 	const auto* pNew = &(std::bit_cast<const Pixel*>(newFrame.data()))[offset];
+#ifdef __SSE2__
+	// SSE2 version
+	repeat(BLOCK_HEIGHT, [&] {
+		auto* out = std::bit_cast<LE_P*>(&stripe.work[stripe.workUsed]);
+		for (unsigned x = 0; x < BLOCK_WIDTH; x += 4) {
+			__m128i o = _mm_loadu_si128(std::bit_cast<const __m128i*>(pOld + x));
+			__m128i n = _mm_loadu_si128(std::bit_cast<const __m128i*>(pNew + x));
+			writePixels(_mm_xor_si128(o, n), out + x);
+		}
+		stripe.workUsed += BLOCK_WIDTH * sizeof(Pixel);
+		pOld += pitch;
+		pNew += pitch;
+	});
+	return;
+#endif
+
+	// C++ version
 	repeat(BLOCK_HEIGHT, [&] {
 		for (auto x : xrange(BLOCK_WIDTH)) {
 			auto pXor = pNew[x] ^ pOld[x];
-			writePixel(pXor, *std::bit_cast<LE_P*>(&work[workUsed]));
-			workUsed += sizeof(Pixel);
+			writePixel(pXor, *std::bit_cast<LE_P*>(&stripe.work[stripe.workUsed]));
+			stripe.workUsed += sizeof(Pixel);
 		}
 		pOld += pitch;
 		pNew += pitch;
 	});
 }
 
-void ZMBVEncoder::addXorFrame(unsigned& workUsed)
+void ZMBVEncoder::addXorFrame(Stripe& stripe, int8_t* vectors)
 {
-	auto* vectors = std::bit_cast<int8_t*>(&work[workUsed]);
-
-	unsigned xBlocks = width / BLOCK_WIDTH;
-	unsigned yBlocks = height / BLOCK_HEIGHT;
-	unsigned blockCount = xBlocks * yBlocks;
-
-	// Align the following xor data on 4 byte boundary
-	workUsed = (workUsed + blockCount * 2 + 3) & ~3;
-
+	// Each stripe starts its search from the zero vector, so that stripes
+	// don't depend on each other.
 	int bestVx = 0;
 	int bestVy = 0;
-	for (auto b : xrange(blockCount)) {
+	for (auto b : xrange(stripe.firstBlock, stripe.lastBlock)) {
 		auto offset = blockOffsets[b];
 		// first try best vector of previous block
 		unsigned bestChange = compareBlock(bestVx, bestVy, offset);
@@ -263,29 +343,82 @@ void ZMBVEncoder::addXorFrame(unsigned& workUsed)
 		vectors[b * 2 + 1] = narrow<int8_t>(bestVy << 1);
 		if (bestChange) {
 			vectors[b * 2 + 0] |= 1;
-			addXorBlock(bestVx, bestVy, offset, workUsed);
+			addXorBlock(bestVx, bestVy, offset, stripe);
 		}
 	}
 }
 
-void ZMBVEncoder::addFullFrame(unsigned& workUsed)
+void ZMBVEncoder::addFullFrame(Stripe& stripe)
 {
 	using LE_P = typename Endian::Little<Pixel>::type;
 	static constexpr size_t pixelSize = sizeof(Pixel);
 
+	unsigned xBlocks = width / BLOCK_WIDTH;
+	unsigned firstLine = (stripe.firstBlock / xBlocks) * BLOCK_HEIGHT;
+	unsigned lastLine  = (stripe.lastBlock  / xBlocks) * BLOCK_HEIGHT;
 	auto* readFrame =
-		&newFrame[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
-	repeat(height, [&] {
+		&newFrame[pixelSize * (MAX_VECTOR + (MAX_VECTOR + firstLine) * pitch)];
+	repeat(lastLine - firstLine, [&] {
 		const auto* pixelsIn = std::bit_cast<const Pixel*>(readFrame);
-		auto* pixelsOut = std::bit_cast<LE_P*>(&work[workUsed]);
+		auto* pixelsOut = std::bit_cast<LE_P*>(&stripe.work[stripe.workUsed]);
+#ifdef __SSE2__
+		// SSE2 version (width is a multiple of BLOCK_WIDTH)
+		for (unsigned x = 0; x < width; x += 4) {
+			writePixels(_mm_loadu_si128(std::bit_cast<const __m128i*>(pixelsIn + x)),
+			            pixelsOut + x);
+		}
+#else
+		// C++ version
 		for (auto x : xrange(width)) {
 			writePixel(pixelsIn[x], pixelsOut[x]);
 		}
+#endif
 		readFrame += pitch * sizeof(Pixel);
-		workUsed += narrow<unsigned>(width * sizeof(Pixel));
+		stripe.workUsed += narrow<unsigned>(width * sizeof(Pixel));
 	});
 }
 
+void ZMBVEncoder::compressStripe(Stripe& stripe)
+{
+	stripe.outputUsed = 0;
+	if (stripe.workUsed == 0) return;
+
+	auto& zs = stripe.zstream;
+	deflateReset(&zs);
+	if (stripe.dictSize) {
+		// Continue where the previous stripe (or frame) stopped, so
+		// the concatenated result decodes as one stream.
+		deflateSetDictionary(&zs, stripe.dict.data(), stripe.dictSize);
+	}
+	zs.next_in = stripe.work.data();
+	zs.avail_in = stripe.workUsed;
+	zs.next_out = stripe.output.data();
+	zs.avail_out = narrow<uInt>(stripe.output.size());
+	// Sync flush: end on a byte boundary, without a final block.
+	auto r = deflate(&zs, Z_SYNC_FLUSH);
+	assert(r == Z_OK); (void)r;
+	assert(zs.avail_in == 0);
+	assert(zs.avail_out != 0);
+	stripe.outputUsed = narrow<unsigned>(stripe.output.size() - zs.avail_out);
+}
+
+void ZMBVEncoder::appendDictionary(std::span<const uint8_t> data)
+{
+	if (data.empty()) return;
+	if (data.size() >= WINDOW_SIZE) {
+		data = data.last(WINDOW_SIZE);
+		dictionarySize = 0;
+	}
+	auto size = narrow<unsigned>(data.size());
+	if (dictionarySize + size > WINDOW_SIZE) {
+		auto keep = WINDOW_SIZE - size;
+		memmove(dictionary.data(), &dictionary[dictionarySize - keep], keep);
+		dictionarySize = keep;
+	}
+	std::ranges::copy(data, &dictionary[dictionarySize]);
+	dictionarySize += size;
+}
+
 const ZMBVEncoder::Pixel* ZMBVEncoder::getScaledLine(const FrameSource* frame, unsigned y, Pixel* workBuf) const
 {
 	switch (height) {
@@ -304,8 +437,6 @@ std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, const FrameSo
 {
 	std::swap(newFrame, oldFrame); // replace oldFrame with newFrame
 
-	// Reset the work buffer
-	unsigned workUsed = 0;
 	unsigned writeDone = 1;
 	uint8_t* writeBuf = output.data();
 
@@ -323,42 +454,77 @@ std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, const FrameSo
 		header->blockWidth = BLOCK_WIDTH;
 		header->blockHeight = BLOCK_HEIGHT;
 		writeDone += sizeof(KeyframeHeader);
-		deflateReset(&zstream); // restart deflate
 	}
 
-	// copy lines (to add black border)
+	// copy lines (to add black border), meanwhile check whether anything
+	// changed compared to the previous frame
 	static constexpr size_t pixelSize = sizeof(Pixel);
 	auto linePitch = pitch * pixelSize;
 	auto lineWidth = size_t(width) * pixelSize;
-	uint8_t* dest =
-		&newFrame[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
+	auto startOffset = pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch);
+	uint8_t* dest = &newFrame[startOffset];
+	const uint8_t* prev = &oldFrame[startOffset];
+	bool changed = keyFrame;
 	for (auto i : xrange(height)) {
 		const auto* scaled = std::bit_cast<const uint8_t*>(
 			getScaledLine(frame, i, std::bit_cast<Pixel*>(dest)));
 		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+		if (!changed) changed = memcmp(dest, prev, lineWidth) != 0;
 		dest += linePitch;
+		prev += linePitch;
+	}
+	if (!changed) {
+		// Identical to the previous frame: return an empty buffer, the
+		// caller writes this as a zero-length (=repeat previous) frame.
+		// 'newFrame' and 'oldFrame' now have the same content, so the
+		// next delta frame is still correct.
+		return {};
 	}
 
-	// Add the frame data.
-	if (keyFrame) {
-		// Key frame: full frame data.
-		addFullFrame(workUsed);
-	} else {
-		// Non-key frame: delta frame data.
-		addXorFrame(workUsed);
+	// Add the frame data, all stripes in parallel.
+	// For a non-key frame the first stripe starts with the motion vectors
+	// of all blocks (aligned to a 4 byte boundary).
+	unsigned blockCount = narrow<unsigned>(blockOffsets.size());
+	auto* vectors = std::bit_cast<int8_t*>(stripes[0].work.data());
+	for (auto& stripe : stripes) stripe.workUsed = 0;
+	if (!keyFrame) {
+		auto vectorSize = (blockCount * 2 + 3) & ~3;
+		std::fill(&vectors[blockCount * 2], &vectors[vectorSize], 0);
+		stripes[0].workUsed = vectorSize;
 	}
-	// Compress the frame data with zlib.
-	zstream.next_in = work.data();
-	zstream.avail_in = workUsed;
-	zstream.total_in = 0;
-
-	zstream.next_out = std::bit_cast<Bytef*>(writeBuf + writeDone);
-	zstream.avail_out = outputSize - writeDone;
-	zstream.total_out = 0;
-	auto r = deflate(&zstream, Z_SYNC_FLUSH);
-	assert(r == Z_OK); (void)r;
+	workers->forEach(std::span{stripes}, [&](Stripe& stripe) {
+		if (keyFrame) {
+			// Key frame: full frame data.
+			addFullFrame(stripe);
+		} else {
+			// Non-key frame: delta frame data.
+			addXorFrame(stripe, vectors);
+		}
+	});
+
+	// Compress the stripes in parallel. Each stripe gets the preceding
+	// uncompressed data as dictionary. A key frame starts a new zlib
+	// stream, so then there's no history.
+	if (keyFrame) dictionarySize = 0;
+	for (auto& stripe : stripes) {
+		stripe.dictSize = dictionarySize;
+		std::ranges::copy(dictionary.first(dictionarySize), stripe.dict.data());
+		appendDictionary(stripe.work.first(stripe.workUsed));
+	}
+	workers->forEach(std::span{stripes}, [&](Stripe& stripe) {
+		compressStripe(stripe);
+	});
 
-	return {output.data(), writeDone + zstream.total_out};
+	if (keyFrame) {
+		// zlib header: deflate, 32kB window, default compression
+		writeBuf[writeDone++] = 0x78;
+		writeBuf[writeDone++] = 0x9C;
+	}
+	for (const auto& stripe : stripes) {
+		std::ranges::copy(stripe.output.first(stripe.outputUsed), writeBuf + writeDone);
+		writeDone += stripe.outputUsed;
+	}
+	return {output.data(), writeDone};
 }
 
 } // namespace openmsx
@@ -4,11 +4,14 @@
 #define ZMBVENCODER_HH
 
 #include "MemBuffer.hh"
+#include "WorkerPool.hh"
 #include "aligned.hh"
 
 #include <cstdint>
+#include <optional>
 #include <span>
 #include <string_view>
+#include <vector>
 
 #include <zlib.h>
 
@@ -27,29 +30,60 @@ public:
 	ZMBVEncoder(ZMBVEncoder&&) = delete;
 	ZMBVEncoder& operator=(const ZMBVEncoder&) = delete;
 	ZMBVEncoder& operator=(ZMBVEncoder&&) = delete;
-	~ZMBVEncoder() = default;
+	~ZMBVEncoder();
 
+	/** Compress the given frame.
+	  * For a non-key frame that is identical to the previous frame, the
+	  * (cheap) result is an empty buffer.
+	  * The frame is split in horizontal stripes which are encoded and
+	  * compressed in parallel. The result is still one zlib stream per
+	  * key frame interval, as required by the ZMBV format.
+	  */
 	[[nodiscard]] std::span<const uint8_t> compressFrame(bool keyFrame, const FrameSource* frame);
 
 private:
+	/** A horizontal band of whole block rows. Each stripe has its own
+	  * (raw) deflate stream, the compressed stripes are concatenated.
+	  */
+	struct Stripe {
+		Stripe();
+		Stripe(const Stripe&) = delete; // z_stream cannot be moved
+		Stripe& operator=(const Stripe&) = delete;
+		~Stripe();
+
+		unsigned firstBlock = 0; // [firstBlock, lastBlock)
+		unsigned lastBlock = 0;
+		MemBuffer<uint8_t, SSE_ALIGNMENT> work; // uncompressed data
+		unsigned workUsed = 0;
+		MemBuffer<uint8_t> dict; // preceding uncompressed data
+		unsigned dictSize = 0;
+		MemBuffer<uint8_t> output; // compressed data
+		unsigned outputUsed = 0;
+		z_stream zstream;
+	};
+
 	void setupBuffers();
-	[[nodiscard]] unsigned neededSize() const;
-	void addFullFrame(unsigned& workUsed);
-	void addXorFrame (unsigned& workUsed);
+	void addFullFrame(Stripe& stripe);
+	void addXorFrame (Stripe& stripe, int8_t* vectors);
+	void compressStripe(Stripe& stripe);
+	void appendDictionary(std::span<const uint8_t> data);
 	[[nodiscard]] unsigned possibleBlock(int vx, int vy, size_t offset);
 	[[nodiscard]] unsigned compareBlock(int vx, int vy, size_t offset);
-	void addXorBlock(int vx, int vy, size_t offset, unsigned& workUsed);
+	void addXorBlock(int vx, int vy, size_t offset, Stripe& stripe);
 	[[nodiscard]] const Pixel* getScaledLine(const FrameSource* frame, unsigned y, Pixel* workBuf) const;
 
 private:
 	MemBuffer<uint8_t, SSE_ALIGNMENT> oldFrame;
 	MemBuffer<uint8_t, SSE_ALIGNMENT> newFrame;
-	MemBuffer<uint8_t, SSE_ALIGNMENT> work;
 	MemBuffer<uint8_t> output;
 	MemBuffer<size_t> blockOffsets;
-	unsigned outputSize;
+	std::vector<Stripe> stripes;
+	std::optional<WorkerPool> workers; // one helper per stripe, except the first
 
-	z_stream zstream;
+	/** The last (up to 32kB) uncompressed bytes of the zlib stream, used
+	  * as deflate dictionary for the first stripe of the next frame. */
+	MemBuffer<uint8_t> dictionary;
+	unsigned dictionarySize = 0;
 
 	unsigned width;
 	unsigned height;
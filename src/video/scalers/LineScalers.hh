@@ -4,6 +4,7 @@
 #include "PixelOperations.hh"
 
 #include "ranges.hh"
+#include "simd.hh"
 #include "xrange.hh"
 
 #include <bit>
@@ -12,9 +13,6 @@
 #include <cstdint>
 #include <ranges>
 #include <span>
-#ifdef __SSE2__
-#include "emmintrin.h"
-#endif
 
 namespace openmsx {
 
@@ -457,17 +455,272 @@ inline void scale_8on9(std::span<const Pixel> in, std::span<Pixel> out)
 	if ((i + 7) < n) out[i + 7] = 0;
 }
 
+#ifdef __SSE2__
+// SSE2 versions of the PixelOperations routines, for 4 pixels at once. These
+// give bit-exact the same results as the scalar versions. Only meant for the
+// implementation of the routines below.
+namespace detail::sse {
+
+inline __m128i avgDown(__m128i x, __m128i y)
+{
+	// _mm_avg_epu8() rounds up, correct for that
+	__m128i odd = _mm_and_si128(_mm_xor_si128(x, y), _mm_set1_epi8(1));
+	return _mm_sub_epi8(_mm_avg_epu8(x, y), odd);
+}
+inline __m128i avgUp(__m128i x, __m128i y)
+{
+	return _mm_avg_epu8(x, y);
+}
+
+template<unsigned w1, unsigned w2>
+inline __m128i blend(__m128i x, __m128i y)
+{
+	// same special cases as PixelOperations::blend<w1, w2>()
+	constexpr unsigned total = w1 + w2;
+	if constexpr (w1 == 0) {
+		return y;
+	} else if constexpr (w1 > w2) {
+		return blend<w2, w1>(y, x);
+	} else if constexpr (w1 == w2) {
+		return avgDown(x, y);
+	} else if constexpr ((3 * w1) == w2) {
+		return avgUp(avgDown(x, y), y);
+	} else if constexpr ((7 * w1) == w2) {
+		__m128i p11 = avgDown(x, y);
+		__m128i p13 = avgDown(p11, y);
+		return avgUp(p13, y);
+	} else if constexpr ((5 * w1) == (3 * w2)) {
+		__m128i p11 = avgUp(x, y);
+		__m128i p13 = avgDown(p11, y);
+		return avgDown(p11, p13);
+	} else if constexpr (!std::has_single_bit(total)) {
+		constexpr unsigned newTotal = 256;
+		constexpr unsigned ww1 = (2 * w1 * newTotal + total) / (2 * total);
+		constexpr unsigned ww2 = 256 - ww1;
+		return blend<ww1, ww2>(x, y);
+	} else {
+		// (c1 * w1 + c2 * w2) / total, per component in 16 bit
+		constexpr int l2 = std::bit_width(total) - 1;
+		__m128i zero = _mm_setzero_si128();
+		__m128i m1 = _mm_set1_epi16(w1);
+		__m128i m2 = _mm_set1_epi16(w2);
+		auto half = [&](__m128i a, __m128i b) {
+			return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(a, m1),
+			                                    _mm_mullo_epi16(b, m2)), l2);
+		};
+		__m128i lo = half(_mm_unpacklo_epi8(x, zero), _mm_unpacklo_epi8(y, zero));
+		__m128i hi = half(_mm_unpackhi_epi8(x, zero), _mm_unpackhi_epi8(y, zero));
+		return _mm_packus_epi16(lo, hi);
+	}
+}
+
+// 32 bit (wrapping) multiplication of 'd' with 'x' (with 'x' in both 16-bit
+// halves of each 32 bit lane, and 'x' <= 256)
+inline __m128i mul32(__m128i d, __m128i x)
+{
+	__m128i lo = _mm_mullo_epi16(d, x);
+	__m128i hi = _mm_mulhi_epu16(d, x);
+	return _mm_add_epi32(_mm_and_si128(lo, _mm_set1_epi32(0xFFFF)),
+	                     _mm_slli_epi32(_mm_add_epi32(hi, _mm_srli_epi32(lo, 16)), 16));
+}
+
+// PixelOperations::alphaBlend(), so lerp(p2, p1, alpha(p1))
+inline __m128i alphaBlend(__m128i p1, __m128i p2)
+{
+	__m128i mask = _mm_set1_epi32(0x00FF00FF);
+	__m128i a = _mm_srli_epi32(p1, 24);
+	__m128i x = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+	__m128i rb1 = _mm_and_si128(p2, mask);
+	__m128i ag1 = _mm_and_si128(_mm_srli_epi32(p2, 8), mask);
+	__m128i rb2 = _mm_and_si128(p1, mask);
+	__m128i ag2 = _mm_and_si128(_mm_srli_epi32(p1, 8), mask);
+	__m128i trb = _mm_srli_epi32(mul32(_mm_sub_epi32(rb2, rb1), x), 8);
+	__m128i tag = mul32(_mm_sub_epi32(ag2, ag1), x);
+	__m128i rb = _mm_and_si128(_mm_add_epi32(trb, rb1), mask);
+	__m128i ag = _mm_andnot_si128(mask, _mm_add_epi32(tag, _mm_slli_epi32(ag1, 8)));
+	return _mm_or_si128(rb, ag);
+}
+
+// PixelOperations::multiply(), with 'x' (<= 256) in all 16-bit lanes
+inline __m128i multiply(__m128i p, __m128i x)
+{
+	__m128i mask = _mm_set1_epi32(0x00FF00FF);
+	__m128i rb = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(p, mask), x), 8);
+	__m128i ag = _mm_andnot_si128(mask, _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(p, 8), mask), x));
+	return _mm_or_si128(rb, ag);
+}
+
+inline __m128i load4(const Pixel* p)
+{
+	return _mm_loadu_si128(std::bit_cast<const __m128i*>(p));
+}
+inline void store4(Pixel* p, __m128i v)
+{
+	_mm_storeu_si128(std::bit_cast<__m128i*>(p), v);
+}
+
+} // namespace detail::sse
+#endif
+
+#ifdef SIMD_AVX2
+// AVX2 versions of the routines in detail::sse, for 8 pixels at once. Only
+// call the line routines (they return how many pixels they've processed, the
+// caller handles the rest) when SIMD::hasAVX2() returns true.
+namespace detail::avx2 {
+
+inline SIMD_TARGET("avx2") __m256i avgDown(__m256i x, __m256i y)
+{
+	__m256i odd = _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_set1_epi8(1));
+	return _mm256_sub_epi8(_mm256_avg_epu8(x, y), odd);
+}
+inline SIMD_TARGET("avx2") __m256i avgUp(__m256i x, __m256i y)
+{
+	return _mm256_avg_epu8(x, y);
+}
+
+template<int l2>
+inline SIMD_TARGET("avx2") __m256i weightedSum(__m256i a, __m256i b, __m256i m1, __m256i m2)
+{
+	return _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, m1),
+	                                          _mm256_mullo_epi16(b, m2)), l2);
+}
+
+template<unsigned w1, unsigned w2>
+inline SIMD_TARGET("avx2") __m256i blend(__m256i x, __m256i y)
+{
+	// same special cases as detail::sse::blend<w1, w2>()
+	constexpr unsigned total = w1 + w2;
+	if constexpr (w1 == 0) {
+		return y;
+	} else if constexpr (w1 > w2) {
+		return blend<w2, w1>(y, x);
+	} else if constexpr (w1 == w2) {
+		return avgDown(x, y);
+	} else if constexpr ((3 * w1) == w2) {
+		return avgUp(avgDown(x, y), y);
+	} else if constexpr ((7 * w1) == w2) {
+		__m256i p11 = avgDown(x, y);
+		__m256i p13 = avgDown(p11, y);
+		return avgUp(p13, y);
+	} else if constexpr ((5 * w1) == (3 * w2)) {
+		__m256i p11 = avgUp(x, y);
+		__m256i p13 = avgDown(p11, y);
+		return avgDown(p11, p13);
+	} else if constexpr (!std::has_single_bit(total)) {
+		constexpr unsigned newTotal = 256;
+		constexpr unsigned ww1 = (2 * w1 * newTotal + total) / (2 * total);
+		constexpr unsigned ww2 = 256 - ww1;
+		return blend<ww1, ww2>(x, y);
+	} else {
+		// unpack and pack work per 128-bit lane, so the pixel order is kept
+		constexpr int l2 = std::bit_width(total) - 1;
+		__m256i zero = _mm256_setzero_si256();
+		__m256i m1 = _mm256_set1_epi16(w1);
+		__m256i m2 = _mm256_set1_epi16(w2);
+		__m256i lo = weightedSum<l2>(_mm256_unpacklo_epi8(x, zero), _mm256_unpacklo_epi8(y, zero), m1, m2);
+		__m256i hi = weightedSum<l2>(_mm256_unpackhi_epi8(x, zero), _mm256_unpackhi_epi8(y, zero), m1, m2);
+		return _mm256_packus_epi16(lo, hi);
+	}
+}
+
+inline SIMD_TARGET("avx2") __m256i mul32(__m256i d, __m256i x)
+{
+	__m256i lo = _mm256_mullo_epi16(d, x);
+	__m256i hi = _mm256_mulhi_epu16(d, x);
+	return _mm256_add_epi32(_mm256_and_si256(lo, _mm256_set1_epi32(0xFFFF)),
+	                        _mm256_slli_epi32(_mm256_add_epi32(hi, _mm256_srli_epi32(lo, 16)), 16));
+}
+
+inline SIMD_TARGET("avx2") __m256i alphaBlend(__m256i p1, __m256i p2)
+{
+	__m256i mask = _mm256_set1_epi32(0x00FF00FF);
+	__m256i a = _mm256_srli_epi32(p1, 24);
+	__m256i x = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+	__m256i rb1 = _mm256_and_si256(p2, mask);
+	__m256i ag1 = _mm256_and_si256(_mm256_srli_epi32(p2, 8), mask);
+	__m256i rb2 = _mm256_and_si256(p1, mask);
+	__m256i ag2 = _mm256_and_si256(_mm256_srli_epi32(p1, 8), mask);
+	__m256i trb = _mm256_srli_epi32(mul32(_mm256_sub_epi32(rb2, rb1), x), 8);
+	__m256i tag = mul32(_mm256_sub_epi32(ag2, ag1), x);
+	__m256i rb = _mm256_and_si256(_mm256_add_epi32(trb, rb1), mask);
+	__m256i ag = _mm256_andnot_si256(mask, _mm256_add_epi32(tag, _mm256_slli_epi32(ag1, 8)));
+	return _mm256_or_si256(rb, ag);
+}
+
+inline SIMD_TARGET("avx2") __m256i multiply(__m256i p, __m256i x)
+{
+	__m256i mask = _mm256_set1_epi32(0x00FF00FF);
+	__m256i rb = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_and_si256(p, mask), x), 8);
+	__m256i ag = _mm256_andnot_si256(mask, _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask), x));
+	return _mm256_or_si256(rb, ag);
+}
+
+inline SIMD_TARGET("avx2") __m256i load8(const Pixel* p)
+{
+	return _mm256_loadu_si256(std::bit_cast<const __m256i*>(p));
+}
+inline SIMD_TARGET("avx2") void store8(Pixel* p, __m256i v)
+{
+	_mm256_storeu_si256(std::bit_cast<__m256i*>(p), v);
+}
+
+template<unsigned w1, unsigned w2>
+SIMD_TARGET("avx2") size_t blendLines(const Pixel* in1, const Pixel* in2, Pixel* out, size_t n)
+{
+	size_t i = 0;
+	for (/**/; (i + 8) <= n; i += 8) {
+		store8(&out[i], blend<w1, w2>(load8(&in1[i]), load8(&in2[i])));
+	}
+	return i;
+}
+
+inline SIMD_TARGET("avx2") size_t alphaBlendLines(const Pixel* in1, const Pixel* in2, Pixel* out, size_t n)
+{
+	size_t i = 0;
+	for (/**/; (i + 8) <= n; i += 8) {
+		store8(&out[i], alphaBlend(load8(&in1[i]), load8(&in2[i])));
+	}
+	return i;
+}
+
+inline SIMD_TARGET("avx2") size_t alphaBlendLines(Pixel in1M, unsigned alpha2, const Pixel* in2, Pixel* out, size_t n)
+{
+	__m256i in1M8 = _mm256_set1_epi32(int(in1M));
+	__m256i alpha28 = _mm256_set1_epi16(int16_t(alpha2));
+	size_t i = 0;
+	for (/**/; (i + 8) <= n; i += 8) {
+		store8(&out[i], _mm256_add_epi32(in1M8, multiply(load8(&in2[i]), alpha28)));
+	}
+	return i;
+}
+
+} // namespace detail::avx2
+#endif
+
 template<unsigned w1, unsigned w2>
 void blendLines(std::span<const Pixel> in1, std::span<const Pixel> in2, std::span<Pixel> out)
 {
 	// It _IS_ allowed that the output is the same as one of the inputs.
-	// TODO SSE optimizations
-	// pure C++ version
 	assert(in1.size() == in2.size());
 	assert(in1.size() == out.size());
+	size_t i = 0;
+#ifdef SIMD_AVX2
+	// AVX2 version, 8 pixels per iteration
+	if (SIMD::hasAVX2()) {
+		i = detail::avx2::blendLines<w1, w2>(in1.data(), in2.data(), out.data(), out.size());
+	}
+#endif
+#ifdef __SSE2__
+	// SSE2 version, 4 pixels per iteration (also for the remaining pixels)
+	using namespace detail::sse;
+	for (/**/; (i + 4) <= out.size(); i += 4) {
+		store4(&out[i], blend<w1, w2>(load4(&in1[i]), load4(&in2[i])));
+	}
+#endif
+	// C++ version (also for the remaining pixels)
 	PixelOperations pixelOps;
-	for (auto [i1, i2, o] : std::views::zip(in1, in2, out)) {
-		o = pixelOps.template blend<w1, w2>(i1, i2);
+	for (/**/; i < out.size(); ++i) {
+		out[i] = pixelOps.template blend<w1, w2>(in1[i], in2[i]);
 	}
 }
 
@@ -477,9 +730,24 @@ inline void alphaBlendLines(
 	// It _IS_ allowed that the output is the same as one of the inputs.
 	assert(in1.size() == in2.size());
 	assert(in1.size() == out.size());
+	size_t i = 0;
+#ifdef SIMD_AVX2
+	// AVX2 version, 8 pixels per iteration
+	if (SIMD::hasAVX2()) {
+		i = detail::avx2::alphaBlendLines(in1.data(), in2.data(), out.data(), out.size());
+	}
+#endif
+#ifdef __SSE2__
+	// SSE2 version, 4 pixels per iteration (also for the remaining pixels)
+	using namespace detail::sse;
+	for (/**/; (i + 4) <= out.size(); i += 4) {
+		store4(&out[i], alphaBlend(load4(&in1[i]), load4(&in2[i])));
+	}
+#endif
+	// C++ version (also for the remaining pixels)
 	PixelOperations pixelOps;
-	for (auto [i1, i2, o] : std::views::zip(in1, in2, out)) {
-		o = pixelOps.alphaBlend(i1, i2);
+	for (/**/; i < out.size(); ++i) {
+		out[i] = pixelOps.alphaBlend(in1[i], in2[i]);
 	}
 }
 
@@ -503,8 +771,25 @@ inline void alphaBlendLines(
 	//    }
 	Pixel in1M = pixelOps.multiply(in1, alpha);
 	unsigned alpha2 = 256 - alpha;
-	for (auto [i2, o] : std::views::zip(in2, out)) {
-		o = in1M + pixelOps.multiply(i2, alpha2);
+	size_t i = 0;
+#ifdef SIMD_AVX2
+	// AVX2 version, 8 pixels per iteration
+	if (SIMD::hasAVX2()) {
+		i = detail::avx2::alphaBlendLines(in1M, alpha2, in2.data(), out.data(), out.size());
+	}
+#endif
+#ifdef __SSE2__
+	// SSE2 version, 4 pixels per iteration (also for the remaining pixels)
+	using namespace detail::sse;
+	__m128i in1M4 = _mm_set1_epi32(int(in1M));
+	__m128i alpha24 = _mm_set1_epi16(int16_t(alpha2));
+	for (/**/; (i + 4) <= out.size(); i += 4) {
+		store4(&out[i], _mm_add_epi32(in1M4, multiply(load4(&in2[i]), alpha24)));
+	}
+#endif
+	// C++ version (also for the remaining pixels)
+	for (/**/; i < out.size(); ++i) {
+		out[i] = in1M + pixelOps.multiply(in2[i], alpha2);
 	}
 }
 
@@ -0,0 +1,171 @@
+#include "SWHQScaler.hh"
+
+#include "File.hh"
+#include "FileContext.hh"
+#include "FrameSource.hh"
+#include "HQCommon.hh"
+#include "SWOutputSurface.hh"
+
+#include "inplace_buffer.hh"
+#include "narrow.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+SWHQScaler::SWHQScaler()
+{
+	const auto& context = systemFileContext();
+	std::string offsetsName = "shaders/HQ_xOffsets.dat";
+	std::string weightsName = "shaders/HQ_xWeights.dat";
+	auto load = [&](const std::string& name, MemBuffer<uint8_t>& buf) {
+		File file(context.resolve(name));
+		buf.resize(file.getSize());
+		file.read(std::span{buf});
+	};
+	for (auto i : xrange(3)) {
+		int n = i + 2;
+		offsetsName[10] = narrow<char>('0' + n);
+		weightsName[10] = narrow<char>('0' + n);
+		load(offsetsName, offsets[i]);
+		load(weightsName, weights[i]);
+		assert(offsets[i].size() == size_t(4 * 64 * n * 64 * n));
+		assert(weights[i].size() == size_t(3 * 64 * n * 64 * n));
+	}
+}
+
+SWHQScaler::SWHQScaler(Tables offsets_, Tables weights_)
+	: offsets(std::move(offsets_))
+	, weights(std::move(weights_))
+{
+#ifndef NDEBUG
+	for (auto i : xrange(3)) {
+		int n = i + 2;
+		assert(offsets[i].size() == size_t(4 * 64 * n * 64 * n));
+		assert(weights[i].size() == size_t(3 * 64 * n * 64 * n));
+	}
+#endif
+}
+
+// hq.frag blends three pixels: 'cx * weights.x + cy * weights.y + c5 * weights.z'.
+// This is the same calculation in integers, the result is never exactly
+// halfway between two values, so it's rounded the same way.
+[[nodiscard]] static uint32_t blend(uint32_t cx, uint32_t cy, uint32_t c5, const uint8_t* w)
+{
+	uint32_t result = 0xFF000000;
+	for (int shift = 0; shift < 24; shift += 8) {
+		unsigned sum = ((cx >> shift) & 0xFF) * w[0]
+		             + ((cy >> shift) & 0xFF) * w[1]
+		             + ((c5 >> shift) & 0xFF) * w[2];
+		result |= std::min((sum + 127) / 255, 255u) << shift;
+	}
+	return result;
+}
+
+// Offsets 0, 128 and 255 select the left/top neighbour, the pixel itself or
+// the right/bottom neighbour (see 'leftTop + texStep2 * offsets' in hq.frag).
+[[nodiscard]] static int offsetToDelta(uint8_t offset)
+{
+	return (offset + 1) / 128 - 1;
+}
+
+void SWHQScaler::scaleImage(
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	unsigned factorY = (dstEndY - dstStartY) / (srcEndY - srcStartY); // 1 - 4
+	if ((factorY < 2) || ((srcWidth % 320) != 0)) {
+		scaleDefault(src, superImpose,
+		             srcStartY, srcEndY, srcWidth,
+		             dst, dstStartY, dstEndY, logSrcHeight);
+		return;
+	}
+	assert(factorY <= 4);
+	assert(factorY * (srcEndY - srcStartY) == (dstEndY - dstStartY));
+	unsigned n = factorY;
+	const uint8_t* offsetTab = offsets[n - 2].data();
+	const uint8_t* weightTab = weights[n - 2].data();
+
+	// The source pixel for each output column, and the column within the
+	// (64N x 64N) tables.
+	struct Column { unsigned x, sub; };
+	auto dstWidth = narrow<unsigned>(dst.getLogicalWidth());
+	std::vector<Column> columns;
+	columns.reserve(dstWidth);
+	for (auto x : xrange(dstWidth)) {
+		float tx = texCoord(x, dstWidth, srcWidth);
+		columns.push_back({texel(tx, srcWidth), unsigned(fract(tx) * float(n))});
+	}
+
+	assert(srcWidth <= 1280);
+	inplace_buffer<Endian::L32, 1280 / 2> edges(uninitialized_tag{}, srcWidth / 2); // 2 x uint16_t
+	#ifndef NDEBUG
+	// Avoid UMR. In optimized mode we don't care.
+	std::ranges::fill(edges, 0);
+	#endif
+	// Three buffers, used round-robin for lines y-1, y, y+1.
+	std::array<inplace_buffer<Pixel, 1280>, 3> bufs = {
+		inplace_buffer<Pixel, 1280>(uninitialized_tag{}, srcWidth),
+		inplace_buffer<Pixel, 1280>(uninitialized_tag{}, srcWidth),
+		inplace_buffer<Pixel, 1280>(uninitialized_tag{}, srcWidth),
+	};
+	auto prev = src.getLine(narrow<int>(srcStartY) - 1, bufs[(srcStartY + 2) % 3]);
+	auto curr = src.getLine(narrow<int>(srcStartY) + 0, bufs[(srcStartY + 0) % 3]);
+	EdgeHQ edgeOp;
+	calcEdgesGL(prev, curr, edges, edgeOp);
+
+	for (auto srcY : xrange(srcStartY, srcEndY)) {
+		auto next = src.getLine(narrow<int>(srcY) + 1, bufs[(srcY + 1) % 3]);
+		calcEdgesGL(curr, next, edges, edgeOp);
+		std::array<std::span<const Pixel>, 3> lines = {prev, curr, next};
+
+		for (auto k : xrange(n)) {
+			auto dstY = dstStartY + (srcY - srcStartY) * n + k;
+			float ty = texCoordY(dstY, srcStartY, srcEndY, dstStartY, dstEndY);
+			assert(unsigned(ty) == srcY);
+			auto subY = unsigned(fract(ty) * float(n));
+			auto out = dst.getLine(dstY);
+			std::optional<VideoLine> video;
+			if (superImpose) video.emplace(*superImpose, ty / float(logSrcHeight));
+			for (auto x : xrange(dstWidth)) {
+				auto [sx, subX] = columns[x];
+				uint32_t e = edges[sx / 2];
+				uint32_t e16 = (sx & 1) ? (e >> 16) : (e & 0xFFFF);
+				unsigned ex = (e16 & 0xFF) >> 2;
+				unsigned ey = e16 >> 10;
+				auto idx = (ey * n + subY) * 64 * n + (ex * n + subX);
+				const uint8_t* o = &offsetTab[4 * idx];
+				auto neighbour = [&](uint8_t ox, uint8_t oy) {
+					auto nx = std::clamp(narrow<int>(sx) + offsetToDelta(ox), 0, narrow<int>(srcWidth) - 1);
+					return lines[1 + offsetToDelta(oy)][nx];
+				};
+				auto cx = neighbour(o[0], o[1]);
+				auto cy = neighbour(o[2], o[3]);
+				const uint8_t* w = &weightTab[3 * idx];
+				if (video) {
+					// The same calculation in floats, including
+					// the alpha channel.
+					auto col = toVec4(cx) * (float(w[0]) / 255.0f)
+					         + toVec4(cy) * (float(w[1]) / 255.0f)
+					         + toVec4(curr[sx]) * (float(w[2]) / 255.0f);
+					out[x] = toPixel(blendVideo(col, video->sample(texCoord(x, dstWidth, 1))));
+				} else {
+					out[x] = blend(cx, cy, curr[sx], w);
+				}
+			}
+		}
+		prev = curr;
+		curr = next;
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,44 @@
+#ifndef SWHQSCALER_HH
+#define SWHQSCALER_HH
+
+#include "SWScaler.hh"
+
+#include "MemBuffer.hh"
+
+#include <array>
+#include <cstdint>
+
+namespace openmsx {
+
+/** Software version of GLHQScaler (hq.frag). It uses the same edge
+  * detection (see HQCommon.hh) and the same offset and weight tables.
+  */
+class SWHQScaler final : public SWScaler
+{
+public:
+	// for zoom factors 2, 3 and 4
+	using Tables = std::array<MemBuffer<uint8_t>, 3>;
+
+	/** Loads the tables from the 'shaders' directory, like GLHQScaler. */
+	SWHQScaler();
+
+	/** Uses the given tables instead, with the same layout as the files
+	  * HQ<N>xOffsets.dat (64N x 64N x RGBA) and HQ<N>xWeights.dat
+	  * (64N x 64N x RGB).
+	  */
+	SWHQScaler(Tables offsets, Tables weights);
+
+	void scaleImage(
+		const FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+		SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		unsigned logSrcHeight) override;
+
+private:
+	Tables offsets;
+	Tables weights;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,166 @@
+#include "SWRGBScaler.hh"
+
+#include "FrameSource.hh"
+#include "RenderSettings.hh"
+#include "SWOutputSurface.hh"
+
+#include "inplace_buffer.hh"
+#include "narrow.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+// The emulation of the GPU arithmetic (see SWScaler::Quad) relies on rounding
+// after every floating point operation.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace openmsx {
+
+SWRGBScaler::SWRGBScaler(const RenderSettings& renderSettings_, unsigned srcHeight_)
+	: renderSettings(renderSettings_)
+	, srcHeight(srcHeight_)
+{
+}
+
+void SWRGBScaler::scaleImage(
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	scale(narrow<float>(renderSettings.getBlurFactor()) * (1.0f / 256.0f),
+	      narrow<float>(renderSettings.getScanlineFactor()) * (1.0f / 255.0f),
+	      src, superImpose, srcStartY, srcEndY, srcWidth, srcHeight,
+	      dst, dstStartY, dstEndY, logSrcHeight);
+}
+
+void SWRGBScaler::scale(
+	float blur, float scanline,
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth, unsigned srcHeight,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	unsigned yScale = (dstEndY - dstStartY) / (srcEndY - srcStartY);
+	if (yScale == 0) {
+		// less lines in destination than in source
+		// (factor=1 / interlace) --> disable scanlines
+		scanline = 1.0f;
+		yScale = 1;
+	}
+	if ((blur == 0.0f) && (scanline == 1.0f) && !superImpose) {
+		scaleDefault(src, superImpose,
+		             srcStartY, srcEndY, srcWidth,
+		             dst, dstStartY, dstEndY, logSrcHeight);
+		return;
+	}
+
+	// GLRGBScaler enables linear interpolation, except for the border
+	// (which it treats as a 320-pixel wide display area).
+	bool interpolate = srcWidth != 1;
+	unsigned texWidth = interpolate ? srcWidth : 320;
+	auto sample = [&](float coord, unsigned size) {
+		return interpolate ? TexelPair::linear (coord, size)
+		                   : TexelPair::nearest(coord, size);
+	};
+
+	auto yScaleF = narrow<float>(yScale);
+	float scan_a = (yScale & 1) ? 0.5f : ((yScaleF + 1.0f) / (2.0f * yScaleF));
+	float c1 = blur;
+	float c2 = 3.0f - 2.0f * c1;
+	float scan_b_c2 = (1.0f - scanline) * 2.0f * c2;
+	float scan_c_c2 = scanline * c2;
+	float c1_2_2 = (c1 - c2) / c2;
+	static constexpr float BIG = 128.0f; // big number, actual value is not important
+
+	// rgb.vert
+	Quad quad(srcStartY, srcEndY, srcHeight, dst, dstStartY, dstEndY, logSrcHeight);
+	auto texWidthF = float(texWidth);
+	float tmpLeft  = quad.texLeft  * texWidthF;
+	float tmpRight = quad.texRight * texWidthF;
+	std::array scaled = {
+		Varying::horizontal(quad, tmpLeft + 0.0f,        tmpRight + 0.0f),
+		Varying::horizontal(quad, tmpLeft + 1.0f / 3.0f, tmpRight + 1.0f / 3.0f),
+		Varying::horizontal(quad, tmpLeft + 2.0f / 3.0f, tmpRight + 2.0f / 3.0f),
+		Varying::vertical(quad, quad.tex0Top    * float(srcHeight) + 0.5f,
+		                        quad.tex0Bottom * float(srcHeight) + 0.5f),
+	};
+	auto posX = Varying::horizontal(quad, quad.texLeft, quad.texRight);
+	auto posY = Varying::vertical(quad, quad.tex0Top, quad.tex0Bottom);
+	auto videoY = Varying::vertical(quad, quad.tex1Top, quad.tex1Bottom);
+
+	// The texture coordinate and the RGB mask only depend on the column.
+	struct Column { TexelPair s; gl::vec4 m; float videoX; };
+	auto dstWidth = narrow<unsigned>(dst.getLogicalWidth());
+	std::vector<Column> columns;
+	columns.reserve(dstWidth);
+	for (auto x : xrange(dstWidth)) {
+		auto m = [&](const Varying& v) {
+			return std::clamp(-BIG * fract(v(x, dstStartY)) + 2.0f * BIG / 3.0f, 0.0f, 1.0f);
+		};
+		float u = posX(x, dstStartY);
+		columns.push_back({sample(u, srcWidth), gl::vec4(m(scaled[2]), m(scaled[1]), m(scaled[0]), 0.0f), u});
+	}
+
+	auto pixel = [&](gl::vec4 p, float scan_c2, const gl::vec4& m) {
+		auto n = p * scan_c2;
+		auto s_n = n * c1_2_2 + saturate((n - gl::vec4(1.0f)) / 2.0f);
+		return toPixel(n + m * s_n);
+	};
+#ifdef __SSE2__
+	auto pixel4 = [&](__m128 p, __m128 scan_c2, const gl::vec4& m) {
+		auto n = _mm_mul_ps(p, scan_c2);
+		auto sat = _mm_mul_ps(_mm_sub_ps(n, _mm_set1_ps(1.0f)), _mm_set1_ps(0.5f));
+		sat = _mm_min_ps(_mm_max_ps(sat, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		auto s_n = _mm_add_ps(_mm_mul_ps(n, _mm_set1_ps(c1_2_2)), sat);
+		auto mm = _mm_setr_ps(m.x, m.y, m.z, m.w);
+		return toPixel4(_mm_add_ps(n, _mm_mul_ps(mm, s_n)));
+	};
+#endif
+
+	assert(srcWidth <= 1280);
+	inplace_buffer<Pixel, 1280> buf0(uninitialized_tag{}, srcWidth);
+	inplace_buffer<Pixel, 1280> buf1(uninitialized_tag{}, srcWidth);
+	for (auto dstY : xrange(dstStartY, dstEndY)) {
+		auto rows = sample(posY(0, dstY), srcHeight);
+		float scan_c2 = scan_c_c2 + scan_b_c2 * std::abs(fract(scaled[3](0, dstY)) - scan_a);
+		auto line0 = src.getLine(narrow<int>(rows.i0), buf0);
+		auto line1 = src.getLine(narrow<int>(rows.i1), buf1);
+		auto out = dst.getLine(dstY);
+		if (superImpose) {
+			VideoLine video(*superImpose, videoY(0, dstY));
+			for (auto x : xrange(dstWidth)) {
+				const auto& c = columns[x];
+				auto col = toVec4(sampleLinear(line0, line1, c.s, rows.w));
+				out[x] = pixel(blendVideo(col, video.sample(c.videoX)), scan_c2, c.m);
+			}
+			continue;
+		}
+		unsigned x = 0;
+#ifdef __SSE2__
+		// Two pixels at a time.
+		auto scan4 = _mm_set1_ps(scan_c2);
+		for (; (x + 2) <= dstWidth; x += 2) {
+			const auto& c0 = columns[x + 0];
+			const auto& c1_ = columns[x + 1];
+			auto p = sampleLinear2(line0, line1, c0.s, c1_.s, rows.w);
+			out[x + 0] = pixel4(toFloat4(p, false), scan4, c0.m);
+			out[x + 1] = pixel4(toFloat4(p, true ), scan4, c1_.m);
+		}
+#endif
+		for (; x < dstWidth; ++x) {
+			const auto& c = columns[x];
+			out[x] = pixel(toVec4(sampleLinear(line0, line1, c.s, rows.w)), scan_c2, c.m);
+		}
+	}
+}
+
+} // namespace openmsx
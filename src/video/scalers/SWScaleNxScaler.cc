@@ -0,0 +1,100 @@
+#include "SWScaleNxScaler.hh"
+
+#include "FrameSource.hh"
+#include "SWOutputSurface.hh"
+
+#include "Math.hh"
+#include "inplace_buffer.hh"
+#include "narrow.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace openmsx {
+
+static constexpr float PI2 = float(2.0 * Math::pi);
+
+namespace {
+// The texels that are sampled for one output coordinate: the middle one and
+// the two neighbours on either side. In the shader the distance to the
+// neighbours is sin(2*pi*coord), so which side is which (or whether it's the
+// middle texel again) depends on the position within the source pixel.
+struct Neighbours {
+	Neighbours(float coord, unsigned size)
+	{
+		float delta = std::sin(PI2 * (coord - std::floor(coord)));
+		mid  = unsigned(std::clamp(int(std::floor(coord        )), 0, int(size) - 1));
+		prev = unsigned(std::clamp(int(std::floor(coord - delta)), 0, int(size) - 1));
+		next = unsigned(std::clamp(int(std::floor(coord + delta)), 0, int(size) - 1));
+	}
+	unsigned mid, prev, next;
+};
+}
+
+// The shader compares the colors as floats, this gives the same result (the
+// dot product is exactly zero).
+[[nodiscard]] static int dotRGB(uint32_t l, uint32_t r, uint32_t t, uint32_t b)
+{
+	int result = 0;
+	for (int shift = 0; shift < 24; shift += 8) {
+		int dx = int((l >> shift) & 0xFF) - int((r >> shift) & 0xFF);
+		int dy = int((t >> shift) & 0xFF) - int((b >> shift) & 0xFF);
+		result += dx * dy;
+	}
+	return result;
+}
+
+void SWScaleNxScaler::scaleImage(
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	if ((srcWidth % 320) != 0) {
+		scaleDefault(src, superImpose,
+		             srcStartY, srcEndY, srcWidth,
+		             dst, dstStartY, dstEndY, logSrcHeight);
+		return;
+	}
+
+	auto dstWidth = narrow<unsigned>(dst.getLogicalWidth());
+	std::vector<Neighbours> columns;
+	columns.reserve(dstWidth);
+	for (auto x : xrange(dstWidth)) {
+		columns.emplace_back(texCoord(x, dstWidth, srcWidth), srcWidth);
+	}
+
+	assert(srcWidth <= 1280);
+	inplace_buffer<Pixel, 1280> buf0(uninitialized_tag{}, srcWidth);
+	inplace_buffer<Pixel, 1280> buf1(uninitialized_tag{}, srcWidth);
+	inplace_buffer<Pixel, 1280> buf2(uninitialized_tag{}, srcWidth);
+	for (auto dstY : xrange(dstStartY, dstEndY)) {
+		float y = texCoordY(dstY, srcStartY, srcEndY, dstStartY, dstEndY);
+		float delta = std::sin(PI2 * fract(y));
+		auto top = src.getLine(int(std::floor(y - delta)), buf0);
+		auto mid = src.getLine(int(std::floor(y        )), buf1);
+		auto bot = src.getLine(int(std::floor(y + delta)), buf2);
+		auto out = dst.getLine(dstY);
+		for (auto x : xrange(dstWidth)) {
+			const auto& c = columns[x];
+			auto l = mid[c.prev];
+			auto r = mid[c.next];
+			auto t = top[c.mid];
+			auto b = bot[c.mid];
+			out[x] = ((dotRGB(l, r, t, b) == 0) || ((l ^ t) & 0x00FFFFFF))
+			       ? mid[c.mid] : t;
+		}
+		if (superImpose) {
+			VideoLine video(*superImpose, y / float(logSrcHeight));
+			for (auto x : xrange(dstWidth)) {
+				out[x] = toPixel(blendVideo(toVec4(out[x]),
+				                            video.sample(texCoord(x, dstWidth, 1))));
+			}
+		}
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,21 @@
+#ifndef SWSCALENXSCALER_HH
+#define SWSCALENXSCALER_HH
+
+#include "SWScaler.hh"
+
+namespace openmsx {
+
+/** Software version of GLScaleNxScaler (scale2x.frag). */
+class SWScaleNxScaler final : public SWScaler
+{
+public:
+	void scaleImage(
+		const FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+		SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		unsigned logSrcHeight) override;
+};
+
+} // namespace openmsx
+
+#endif // SWSCALENXSCALER_HH
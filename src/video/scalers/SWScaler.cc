@@ -0,0 +1,146 @@
+#include "SWScaler.hh"
+
+#include "FrameSource.hh"
+#include "LineScalers.hh"
+#include "RawFrame.hh"
+#include "SWOutputSurface.hh"
+
+#include "inplace_buffer.hh"
+#include "narrow.hh"
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cassert>
+
+// The emulation of the GPU arithmetic (see SWScaler::Quad) relies on rounding
+// after every floating point operation.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace openmsx {
+
+void SWScaler::scaleImage(
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	scaleDefault(src, superImpose,
+	             srcStartY, srcEndY, srcWidth,
+	             dst, dstStartY, dstEndY, logSrcHeight);
+}
+
+void SWScaler::scaleDefault(
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	auto dstWidth = narrow<unsigned>(dst.getLogicalWidth());
+	assert(srcWidth <= 1280);
+	inplace_buffer<Pixel, 1280> buf(uninitialized_tag{}, srcWidth);
+
+	for (auto dstY : xrange(dstStartY, dstEndY)) {
+		float y = texCoordY(dstY, srcStartY, srcEndY, dstStartY, dstEndY);
+		auto in = src.getLine(int(y), buf);
+		auto out = dst.getLine(dstY);
+		if (superImpose) {
+			// default.frag
+			VideoLine video(*superImpose, y / float(logSrcHeight));
+			for (auto x : xrange(dstWidth)) {
+				auto col = toVec4(in[texel(texCoord(x, dstWidth, srcWidth), srcWidth)]);
+				out[x] = toPixel(blendVideo(col, video.sample(texCoord(x, dstWidth, 1))));
+			}
+			continue;
+		}
+		// Integer zoom factors pick the same pixels as the generic
+		// loop below, but faster.
+		switch ((dstWidth % srcWidth) ? 0 : (dstWidth / srcWidth)) {
+		case 1: copy_to_range(in, out); break;
+		case 2: scale_1on2(in, out); break;
+		case 3: scale_1on3(in, out); break;
+		case 4: scale_1on4(in, out); break;
+		default:
+			for (auto x : xrange(dstWidth)) {
+				out[x] = in[texel(texCoord(x, dstWidth, srcWidth), srcWidth)];
+			}
+		}
+	}
+}
+
+SWScaler::Quad::Quad(
+	unsigned srcStartY, unsigned srcEndY, unsigned srcHeight,
+	const SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight, bool textureFromZero)
+	: screenHeight(narrow<unsigned>(dst.getLogicalHeight()))
+{
+	// Same calculations as in GLScaler::execute().
+	auto srcStartYF = float(srcStartY);
+	auto srcEndYF = float(srcEndY);
+	auto dstStartYF = float(dstStartY);
+	auto dstEndYF = float(dstEndY);
+	auto dstWidthF = float(dst.getLogicalWidth());
+	auto srcHeightF = float(srcHeight);
+	auto logSrcHeightF = float(logSrcHeight);
+
+	float samplePos = (textureFromZero ? 0.5f : 0.0f) + BIAS;
+	float hShift = samplePos / dstWidthF;
+	float yRatio = (srcEndYF - srcStartYF) / (dstEndYF - dstStartYF);
+	float vShift = samplePos * yRatio;
+
+	// pixelMvp maps (x, y) to window coordinates (x, screenHeight - y)
+	top = float(screenHeight) - dstStartYF;
+	right = dstWidthF;
+	bottom = float(screenHeight) - dstEndYF;
+	texLeft = 0.0f + hShift;
+	texRight = 1.0f + hShift;
+	tex0Top    = (srcStartYF + vShift) / srcHeightF;
+	tex0Bottom = (srcEndYF   + vShift) / srcHeightF;
+	tex1Top    = (srcStartYF + vShift) / logSrcHeightF;
+	tex1Bottom = (srcEndYF   + vShift) / logSrcHeightF;
+}
+
+SWScaler::Varying::Varying(
+	const Quad& quad, float topLeft, float topRight, float bottomRight)
+	: screenHeight(quad.screenHeight)
+{
+	// (GCC ignores the pragma above for constructors that are declared
+	// before it, so the calculation is in a separate function.)
+	setup(quad, topLeft, topRight, bottomRight);
+}
+
+void SWScaler::Varying::setup(
+	const Quad& quad, float topLeft, float topRight, float bottomRight)
+{
+	// Corners 0, 1 and 2 are the top-left, top-right and bottom-right
+	// corner (the first triangle of the triangle fan). Pixel centers are
+	// at +0.5.
+	float x0 = 0.0f,       y0 = quad.top;
+	float x1 = quad.right, y1 = quad.top;
+	float x2 = quad.right, y2 = quad.bottom;
+	float dx01 = x0 - x1, dy01 = y0 - y1;
+	float dx20 = x2 - x0, dy20 = y2 - y0;
+	float oneOverArea = 1.0f / (dx01 * dy20 - dx20 * dy01);
+	float da01 = topLeft - topRight;
+	float da20 = bottomRight - topLeft;
+	dadx = da01 * (dy20 * oneOverArea) - da20 * (dy01 * oneOverArea);
+	dady = da20 * (dx01 * oneOverArea) - da01 * (dx20 * oneOverArea);
+	a0 = topLeft - (dadx * (x0 - 0.5f) + dady * (y0 - 0.5f));
+}
+
+SWScaler::VideoLine::VideoLine(const RawFrame& video, float v)
+{
+	// Like the texture of GLPostProcessor, all lines have the same width.
+	auto width = video.getWidth();
+	auto height = video.getHeight();
+	auto y = TexelPair::linear(v, height);
+	line0 = video.getLineDirect(y.i0).first(width);
+	line1 = video.getLineDirect(y.i1).first(width);
+	wy = y.w;
+}
+
+} // namespace openmsx
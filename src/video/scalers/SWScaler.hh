@@ -0,0 +1,370 @@
+#ifndef SWSCALER_HH
+#define SWSCALER_HH
+
+#include "gl_vec.hh"
+#include "narrow.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx {
+
+class FrameSource;
+class RawFrame;
+class SWOutputSurface;
+
+/** Base class for software scalers, these are used when there's no openGL
+  * context (headless mode, e.g. to take screenshots or to record on a
+  * server). Each subclass is the CPU version of the corresponding GLScaler
+  * subclass: for every output pixel it samples the source frame at the same
+  * texel positions as the fragment shader and it performs the same
+  * calculation, so that the result is the same as what is seen on screen.
+  *
+  * This base class itself implements the default algorithm (nearest
+  * neighbour, like GLDefaultScaler). The other scalers fall back to it in
+  * the same situations as their GL counterparts.
+  */
+class SWScaler
+{
+public:
+	using Pixel = uint32_t;
+
+	SWScaler() = default;
+	SWScaler(const SWScaler&) = delete;
+	SWScaler(SWScaler&&) = delete;
+	SWScaler& operator=(const SWScaler&) = delete;
+	SWScaler& operator=(SWScaler&&) = delete;
+	virtual ~SWScaler() = default;
+
+	/** Scales the image in the given area, which must consist of lines which
+	  * are all equally wide. See GLScaler::scaleImage() for the meaning of
+	  * the parameters.
+	  * @param src Source frame.
+	  * @param superImpose Video frame to superimpose the source on, or
+	  *        nullptr. Like in the shaders, this is blended with the
+	  *        source color in each output pixel (so after scaling), see
+	  *        VideoLine.
+	  * @param srcStartY Y-coordinate of the top source line (inclusive).
+	  * @param srcEndY Y-coordinate of the bottom source line (exclusive).
+	  * @param srcWidth The number of pixels per line for the given area.
+	  * @param dst Destination surface, its width is the output width.
+	  * @param dstStartY Y-coordinate of the top destination line (inclusive).
+	  * @param dstEndY Y-coordinate of the bottom destination line (exclusive).
+	  * @param logSrcHeight The height of the complete source frame.
+	  */
+	virtual void scaleImage(
+		const FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+		SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		unsigned logSrcHeight);
+
+protected:
+	/** The implementation of the default algorithm, for the fallbacks. */
+	static void scaleDefault(
+		const FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+		SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		unsigned logSrcHeight);
+
+	/** Offset added to the sample positions, see GLScaler::execute(). */
+	static constexpr float BIAS = 0.001f;
+
+	/** The position in the source (in pixels) that is sampled for output
+	  * pixel 'dst', when 'dstSize' output pixels correspond to 'srcSize'
+	  * source pixels. This is the texture coordinate as interpolated from
+	  * the vertex coordinates set up by GLScaler::execute().
+	  * @param textureFromZero See GLScaler::execute().
+	  */
+	[[nodiscard]] static float texCoord(
+		unsigned dst, unsigned dstSize, unsigned srcSize, bool textureFromZero = false)
+	{
+		float samplePos = (textureFromZero ? 0.5f : 0.0f) + BIAS;
+		return (float(dst) + 0.5f + samplePos) * float(srcSize) / float(dstSize);
+	}
+
+	/** Like texCoord(), but for output line 'dstY' of the given region. */
+	[[nodiscard]] static float texCoordY(
+		unsigned dstY, unsigned srcStartY, unsigned srcEndY,
+		unsigned dstStartY, unsigned dstEndY, bool textureFromZero = false)
+	{
+		return float(srcStartY) + texCoord(dstY - dstStartY, dstEndY - dstStartY,
+		                                   srcEndY - srcStartY, textureFromZero);
+	}
+
+	[[nodiscard]] static float fract(float x) { return x - std::floor(x); }
+
+	/** Index of the texel that contains position 'x', the edge texels are
+	  * repeated (GL_CLAMP_TO_EDGE).
+	  */
+	[[nodiscard]] static unsigned texel(float x, unsigned size)
+	{
+		auto i = int(std::floor(x));
+		return unsigned(std::clamp(i, 0, int(size) - 1));
+	}
+
+	/** The geometry of the rectangle that GLScaler::execute() draws, and
+	  * the values that it assigns to the vertex attributes.
+	  *
+	  * The GPU interpolates the vertex shader outputs ('varyings') over that
+	  * rectangle, see Varying. The output of the shaders depends on the
+	  * exact (rounded) result of that: they take the fract() of scaled
+	  * texture coordinates and the texture units round the coordinates to
+	  * 1/256 texel. So the emulation of these calculations in the software
+	  * scalers mimics the GPU down to the rounding of every operation. The
+	  * reference is Mesa's llvmpipe, the renderer of the GL output that is
+	  * compared to in the unit tests. Other GPUs may round differently, that
+	  * only changes the result in the lowest bit(s).
+	  */
+	struct Quad {
+		/** See scaleImage() for the parameters.
+		  * @param srcHeight The height of the texture that holds the source
+		  *        frame (in GLPostProcessor).
+		  * @param textureFromZero See GLScaler::execute().
+		  */
+		Quad(unsigned srcStartY, unsigned srcEndY, unsigned srcHeight,
+		     const SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		     unsigned logSrcHeight, bool textureFromZero = false);
+
+		// window coordinates of the top-left (x = 0) and bottom-right
+		// corners, the window y-axis points up
+		float top, right, bottom;
+		unsigned screenHeight;
+		// a_texCoord, X-coordinate shared, Y-coordinate for tex0 and tex1
+		float texLeft, texRight;
+		float tex0Top, tex0Bottom;
+		float tex1Top, tex1Bottom;
+	};
+
+	/** A vertex shader output as interpolated by the GPU: llvmpipe sets up
+	  * a plane equation from the values in three corners and evaluates that
+	  * relative to the top-left corner.
+	  */
+	class Varying {
+	public:
+		Varying(const Quad& quad, float topLeft, float topRight, float bottomRight);
+
+		/** A varying that only changes horizontally. */
+		[[nodiscard]] static Varying horizontal(const Quad& quad, float left, float right) {
+			return {quad, left, right, right};
+		}
+		/** A varying that only changes vertically. */
+		[[nodiscard]] static Varying vertical(const Quad& quad, float top, float bottom) {
+			return {quad, top, top, bottom};
+		}
+
+		/** The value in output pixel (x, dstY). */
+		[[nodiscard]] float operator()(unsigned x, unsigned dstY) const {
+			auto winY = float(screenHeight - 1 - dstY);
+			return std::fma(dady, winY, std::fma(dadx, float(x), a0));
+		}
+
+	private:
+		void setup(const Quad& quad, float topLeft, float topRight, float bottomRight);
+
+		float a0, dadx, dady;
+		unsigned screenHeight;
+	};
+	/** A pixel as returned by texture2D(): components in range [0, 1]. */
+	[[nodiscard]] static gl::vec4 toVec4(Pixel p)
+	{
+		return gl::vec4(float((p >>  0) & 0xFF),
+		                float((p >>  8) & 0xFF),
+		                float((p >> 16) & 0xFF),
+		                float((p >> 24) & 0xFF)) * (1.0f / 255.0f);
+	}
+
+	/** Conversion of one color component to 8 bits, like when written to
+	  * the frame buffer: clamped, and rounded to nearest (ties to even)
+	  * after scaling by 255/256 (llvmpipe).
+	  */
+	[[nodiscard]] static unsigned toUnorm8(float f)
+	{
+		// The magic number puts the result in the lowest mantissa bits.
+		// (Separate statements, so that the compiler doesn't fuse the
+		// multiply and add.)
+		float t = std::clamp(f, 0.0f, 1.0f) * (255.0f / 256.0f);
+		t += 32768.0f;
+		return std::bit_cast<uint32_t>(t) & 0xFF;
+	}
+
+	/** The inverse of toVec4(), like when written to the (RGB) frame
+	  * buffer, so alpha is always 255.
+	  */
+	[[nodiscard]] static Pixel toPixel(gl::vec4 c)
+	{
+		return (toUnorm8(c.x) << 0) | (toUnorm8(c.y) << 8) | (toUnorm8(c.z) << 16) | 0xFF000000;
+	}
+
+	/** The two texels that texture2D() interpolates between for
+	  * (normalized) texture coordinate 'coord', and the weight of the second
+	  * one. The edge texels are repeated (GL_CLAMP_TO_EDGE).
+	  */
+	struct TexelPair {
+		/** GL_LINEAR filtering: the position is rounded to 1/256 texel,
+		  * so the weight has 8 bits. */
+		[[nodiscard]] static TexelPair linear(float coord, unsigned size)
+		{
+			auto fixed = narrow_cast<int>(std::lrint(coord * float(size) * 256.0f)) - 128;
+			auto i = fixed >> 8;
+			auto last = narrow<int>(size) - 1;
+			return {unsigned(std::clamp(i + 0, 0, last)),
+			        unsigned(std::clamp(i + 1, 0, last)),
+			        unsigned(fixed & 0xFF)};
+		}
+		/** GL_NEAREST filtering, both texels are the same. */
+		[[nodiscard]] static TexelPair nearest(float coord, unsigned size)
+		{
+			auto i = texel(coord * float(size), size);
+			return {i, i, 0};
+		}
+
+		unsigned i0, i1;
+		unsigned w; // the weight of 'i1', in range [0, 256)
+	};
+
+	/** Linear interpolation between the components of two pixels with an
+	  * 8-bit weight, with the rounding of llvmpipe.
+	  */
+	[[nodiscard]] static Pixel lerp(Pixel p0, Pixel p1, unsigned w)
+	{
+		Pixel result = 0;
+		for (unsigned shift = 0; shift < 32; shift += 8) {
+			int c0 = (p0 >> shift) & 0xFF;
+			int c1 = (p1 >> shift) & 0xFF;
+			int c = c0 + ((int(w) * (c1 - c0) + 128) >> 8);
+			result |= Pixel(c) << shift;
+		}
+		return result;
+	}
+
+#ifdef __SSE2__
+	/** lerp() on 16-bit lanes that each hold one 8-bit component. The
+	  * calculation can wrap around, only the lowest 8 bits matter.
+	  */
+	[[nodiscard]] static __m128i lerp16(__m128i c0, __m128i c1, __m128i w)
+	{
+		auto d = _mm_mullo_epi16(_mm_sub_epi16(c1, c0), w);
+		d = _mm_srli_epi16(_mm_add_epi16(d, _mm_set1_epi16(128)), 8);
+		return _mm_and_si128(_mm_add_epi16(c0, d), _mm_set1_epi16(0xFF));
+	}
+
+	/** Two pixels, one component per 16-bit lane. */
+	[[nodiscard]] static __m128i unpack2(Pixel p0, Pixel p1)
+	{
+		auto p = _mm_unpacklo_epi32(_mm_cvtsi32_si128(int(p0)), _mm_cvtsi32_si128(int(p1)));
+		return _mm_unpacklo_epi8(p, _mm_setzero_si128());
+	}
+
+	/** sampleLinear() for two positions at once: the result holds two
+	  * pixels, like unpack2().
+	  */
+	[[nodiscard]] static __m128i sampleLinear2(
+		std::span<const Pixel> line0, std::span<const Pixel> line1,
+		TexelPair x0, TexelPair x1, unsigned wy)
+	{
+		auto wx = _mm_unpacklo_epi64(_mm_set1_epi16(narrow_cast<int16_t>(x0.w)),
+		                             _mm_set1_epi16(narrow_cast<int16_t>(x1.w)));
+		auto top = lerp16(unpack2(line0[x0.i0], line0[x1.i0]),
+		                  unpack2(line0[x0.i1], line0[x1.i1]), wx);
+		auto bot = lerp16(unpack2(line1[x0.i0], line1[x1.i0]),
+		                  unpack2(line1[x0.i1], line1[x1.i1]), wx);
+		return lerp16(top, bot, _mm_set1_epi16(narrow_cast<int16_t>(wy)));
+	}
+
+	/** toVec4() of the low (hi=false) or high pixel of unpack2(). */
+	[[nodiscard]] static __m128 toFloat4(__m128i p, bool hi)
+	{
+		auto c = hi ? _mm_unpackhi_epi16(p, _mm_setzero_si128())
+		            : _mm_unpacklo_epi16(p, _mm_setzero_si128());
+		return _mm_mul_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(1.0f / 255.0f));
+	}
+
+	/** toUnorm8() on 4 values, the results are in 32-bit lanes. */
+	[[nodiscard]] static __m128i toUnorm8(__m128 c)
+	{
+		c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		c = _mm_mul_ps(c, _mm_set1_ps(255.0f / 256.0f));
+		c = _mm_add_ps(c, _mm_set1_ps(32768.0f));
+		return _mm_and_si128(_mm_castps_si128(c), _mm_set1_epi32(0xFF));
+	}
+
+	/** toPixel() on the 4 components of 'c'. */
+	[[nodiscard]] static Pixel toPixel4(__m128 c)
+	{
+		auto i = toUnorm8(c);
+		i = _mm_packs_epi32(i, i);
+		i = _mm_packus_epi16(i, i);
+		return Pixel(_mm_cvtsi128_si32(i)) | 0xFF000000;
+	}
+
+	/** toPixel() for 4 pixels, with one color component per vector. */
+	[[nodiscard]] static __m128i toPixels4(__m128 r, __m128 g, __m128 b)
+	{
+		auto p = _mm_or_si128(toUnorm8(r), _mm_slli_epi32(toUnorm8(g), 8));
+		p = _mm_or_si128(p, _mm_slli_epi32(toUnorm8(b), 16));
+		return _mm_or_si128(p, _mm_set1_epi32(narrow_cast<int>(0xFF000000)));
+	}
+#endif
+
+	/** texture2D() with GL_LINEAR filtering: first horizontally on both
+	  * lines, then vertically.
+	  * @param line0 The upper line.
+	  * @param line1 The lower line.
+	  * @param x The horizontal position.
+	  * @param wy The weight of the lower line.
+	  */
+	[[nodiscard]] static Pixel sampleLinear(
+		std::span<const Pixel> line0, std::span<const Pixel> line1,
+		TexelPair x, unsigned wy)
+	{
+		return lerp(lerp(line0[x.i0], line0[x.i1], x.w),
+		            lerp(line1[x.i0], line1[x.i1], x.w), wy);
+	}
+
+	/** The superimposed video as sampled by the shaders ('videoCoord'):
+	  * it's stretched over the whole output and it's linearly filtered.
+	  * Construct one of these per output line, for (normalized) vertical
+	  * texture coordinate 'v' (a_texCoord.z).
+	  */
+	class VideoLine {
+	public:
+		VideoLine(const RawFrame& video, float v);
+
+		/** Sample at (normalized) horizontal position 'u'. */
+		[[nodiscard]] gl::vec4 sample(float u) const {
+			auto x = TexelPair::linear(u, unsigned(line0.size()));
+			return toVec4(sampleLinear(line0, line1, x, wy));
+		}
+
+	private:
+		std::span<const Pixel> line0;
+		std::span<const Pixel> line1;
+		unsigned wy;
+	};
+
+	/** 'mix(vid, col, col.a)' in the shaders. */
+	[[nodiscard]] static gl::vec4 blendVideo(gl::vec4 col, gl::vec4 vid)
+	{
+		return mix(vid, col, col.w);
+	}
+
+	[[nodiscard]] static gl::vec4 mix(gl::vec4 x, gl::vec4 y, float a)
+	{
+		return x + (y - x) * a;
+	}
+	[[nodiscard]] static gl::vec4 saturate(gl::vec4 x)
+	{
+		return clamp(x, 0.0f, 1.0f);
+	}
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,35 @@
+#include "SWScalerFactory.hh"
+
+#include "RenderSettings.hh"
+#include "SWHQScaler.hh"
+#include "SWRGBScaler.hh"
+#include "SWScaleNxScaler.hh"
+#include "SWSimpleScaler.hh"
+#include "SWTVScaler.hh"
+
+#include "unreachable.hh"
+
+#include <memory>
+
+namespace openmsx::SWScalerFactory {
+
+std::unique_ptr<SWScaler> createScaler(const RenderSettings& renderSettings, unsigned srcHeight)
+{
+	switch (renderSettings.getScaleAlgorithm()) {
+	using enum RenderSettings::ScaleAlgorithm;
+	case SIMPLE:
+		return std::make_unique<SWSimpleScaler>(renderSettings, srcHeight);
+	case RGBTRIPLET:
+		return std::make_unique<SWRGBScaler>(renderSettings, srcHeight);
+	case SCALE:
+		return std::make_unique<SWScaleNxScaler>();
+	case TV:
+		return std::make_unique<SWTVScaler>(renderSettings, srcHeight);
+	case HQ:
+		return std::make_unique<SWHQScaler>();
+	default:
+		UNREACHABLE;
+	}
+}
+
+} // namespace openmsx::SWScalerFactory
@@ -0,0 +1,25 @@
+#ifndef SWSCALERFACTORY_HH
+#define SWSCALERFACTORY_HH
+
+#include <memory>
+
+namespace openmsx {
+
+class RenderSettings;
+class SWScaler;
+
+namespace SWScalerFactory
+{
+	/** Instantiates the software version of the currently selected
+	  * scaler (see GLScalerFactory).
+	  * @param srcHeight The height of the texture that holds the source
+	  *        frame in GLPostProcessor, see SWScaler::Quad.
+	  * @return A Scaler object, owned by the caller.
+	  */
+	[[nodiscard]] std::unique_ptr<SWScaler> createScaler(
+		const RenderSettings& renderSettings, unsigned srcHeight);
+}
+
+} // namespace openmsx
+
+#endif // SWSCALERFACTORY_HH
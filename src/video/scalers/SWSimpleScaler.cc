@@ -0,0 +1,150 @@
+#include "SWSimpleScaler.hh"
+
+#include "FrameSource.hh"
+#include "RenderSettings.hh"
+#include "SWOutputSurface.hh"
+
+#include "inplace_buffer.hh"
+#include "narrow.hh"
+#include "xrange.hh"
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+// The emulation of the GPU arithmetic (see SWScaler::Quad) relies on rounding
+// after every floating point operation.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace openmsx {
+
+SWSimpleScaler::SWSimpleScaler(const RenderSettings& renderSettings_, unsigned srcHeight_)
+	: renderSettings(renderSettings_)
+	, srcHeight(srcHeight_)
+{
+}
+
+void SWSimpleScaler::scaleImage(
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	scale(narrow<float>(renderSettings.getBlurFactor()) * (1.0f / 256.0f),
+	      narrow<float>(renderSettings.getScanlineFactor()) * (1.0f / 255.0f),
+	      src, superImpose, srcStartY, srcEndY, srcWidth, srcHeight,
+	      dst, dstStartY, dstEndY, logSrcHeight);
+}
+
+void SWSimpleScaler::scale(
+	float blur, float scanline,
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth, unsigned srcHeight,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	unsigned yScale = (dstEndY - dstStartY) / (srcEndY - srcStartY);
+	if (yScale == 0) {
+		// less lines in destination than in source
+		// (factor=1 / interlace) --> disable scanlines
+		scanline = 1.0f;
+		yScale = 1;
+	}
+	if ((blur == 0.0f) && (scanline == 1.0f) && !superImpose) {
+		scaleDefault(src, superImpose,
+		             srcStartY, srcEndY, srcWidth,
+		             dst, dstStartY, dstEndY, logSrcHeight);
+		return;
+	}
+
+	bool interpolate = (blur != 0.0f) && (srcWidth != 1);
+	auto yScaleF = narrow<float>(yScale);
+	float scan_a = (yScale & 1) ? 0.5f : ((yScaleF + 1.0f) / (2.0f * yScaleF));
+	float scan_b = 2.0f - 2.0f * scanline;
+	float scan_c = scanline;
+	if (!superImpose) {
+		// Divide by 2 here, instead of for the average of the two
+		// samples below.
+		scan_b *= 0.5f;
+		scan_c *= 0.5f;
+	}
+	float texStepX = 1.0f / narrow<float>(srcWidth);
+	auto sample = [&](float coord, unsigned size) {
+		return interpolate ? TexelPair::linear (coord, size)
+		                   : TexelPair::nearest(coord, size);
+	};
+
+	// simple.vert
+	Quad quad(srcStartY, srcEndY, srcHeight, dst, dstStartY, dstEndY, logSrcHeight);
+	auto srcWidthF = float(srcWidth);
+	auto srcHeightF = float(srcHeight);
+	auto scaledX = Varying::horizontal(quad, quad.texLeft * srcWidthF, quad.texRight * srcWidthF);
+	auto scaledY = Varying::vertical(quad, quad.tex0Top * srcHeightF + 0.5f,
+	                                       quad.tex0Bottom * srcHeightF + 0.5f);
+	auto miscZ = Varying::vertical(quad, quad.tex0Top, quad.tex0Bottom);
+	auto videoX = Varying::horizontal(quad, quad.texLeft, quad.texRight);
+	auto videoY = Varying::vertical(quad, quad.tex1Top, quad.tex1Bottom);
+	float miscX = (0.5f - blur) * texStepX;
+	float miscY = 0.5f * texStepX;
+
+	// The horizontal texture coordinates of the two samples ('t.x' and
+	// 't.y' in simple.frag) only depend on the column.
+	struct Column { TexelPair s0, s1; float videoX; };
+	auto dstWidth = narrow<unsigned>(dst.getLogicalWidth());
+	std::vector<Column> columns;
+	columns.reserve(dstWidth);
+	for (auto x : xrange(dstWidth)) {
+		float s = scaledX(x, dstStartY);
+		float t = (std::floor(s) + blur * fract(s)) * texStepX;
+		columns.push_back({sample(t + miscX, srcWidth), sample(t + miscY, srcWidth),
+		                   videoX(x, dstStartY)});
+	}
+
+	assert(srcWidth <= 1280);
+	inplace_buffer<Pixel, 1280> buf0(uninitialized_tag{}, srcWidth);
+	inplace_buffer<Pixel, 1280> buf1(uninitialized_tag{}, srcWidth);
+	for (auto dstY : xrange(dstStartY, dstEndY)) {
+		auto rows = sample(miscZ(0, dstY), srcHeight);
+		float scan = scan_c + scan_b * std::abs(fract(scaledY(0, dstY)) - scan_a);
+		auto line0 = src.getLine(narrow<int>(rows.i0), buf0);
+		auto line1 = src.getLine(narrow<int>(rows.i1), buf1);
+		auto out = dst.getLine(dstY);
+		if (superImpose) {
+			VideoLine video(*superImpose, videoY(0, dstY));
+			for (auto x : xrange(dstWidth)) {
+				const auto& c = columns[x];
+				auto col = (toVec4(sampleLinear(line0, line1, c.s0, rows.w)) +
+				            toVec4(sampleLinear(line0, line1, c.s1, rows.w))) / 2.0f;
+				out[x] = toPixel(blendVideo(col, video.sample(c.videoX)) * scan);
+			}
+			continue;
+		}
+		unsigned x = 0;
+#ifdef __SSE2__
+		// Two pixels at a time.
+		auto scan4 = _mm_set1_ps(scan);
+		for (; (x + 2) <= dstWidth; x += 2) {
+			const auto& c0 = columns[x + 0];
+			const auto& c1 = columns[x + 1];
+			auto p0 = sampleLinear2(line0, line1, c0.s0, c1.s0, rows.w);
+			auto p1 = sampleLinear2(line0, line1, c0.s1, c1.s1, rows.w);
+			auto sum0 = _mm_add_ps(toFloat4(p0, false), toFloat4(p1, false));
+			auto sum1 = _mm_add_ps(toFloat4(p0, true ), toFloat4(p1, true ));
+			out[x + 0] = toPixel4(_mm_mul_ps(sum0, scan4));
+			out[x + 1] = toPixel4(_mm_mul_ps(sum1, scan4));
+		}
+#endif
+		for (; x < dstWidth; ++x) {
+			const auto& c = columns[x];
+			auto sum = toVec4(sampleLinear(line0, line1, c.s0, rows.w)) +
+			           toVec4(sampleLinear(line0, line1, c.s1, rows.w));
+			out[x] = toPixel(sum * scan);
+		}
+	}
+}
+
+} // namespace openmsx
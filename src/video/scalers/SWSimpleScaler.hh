@@ -0,0 +1,45 @@
+#ifndef SWSIMPLESCALER_HH
+#define SWSIMPLESCALER_HH
+
+#include "SWScaler.hh"
+
+namespace openmsx {
+
+class RenderSettings;
+
+/** Software version of GLSimpleScaler (simple.frag). */
+class SWSimpleScaler final : public SWScaler
+{
+public:
+	/** @param srcHeight See scale(). */
+	SWSimpleScaler(const RenderSettings& renderSettings, unsigned srcHeight);
+
+	void scaleImage(
+		const FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+		SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		unsigned logSrcHeight) override;
+
+	/** The implementation of scaleImage(), with the settings as
+	  * parameters instead of read from RenderSettings.
+	  * @param blur The blur factor, in range [0, 1].
+	  * @param scanline The scanline factor, in range [0, 1] (1 means no
+	  *        scanlines).
+	  * @param srcHeight The height of the texture that holds the source
+	  *        frame in GLPostProcessor, see Quad.
+	  */
+	static void scale(
+		float blur, float scanline,
+		const FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth, unsigned srcHeight,
+		SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		unsigned logSrcHeight);
+
+private:
+	const RenderSettings& renderSettings;
+	const unsigned srcHeight;
+};
+
+} // namespace openmsx
+
+#endif // SWSIMPLESCALER_HH
@@ -0,0 +1,188 @@
+#include "SWTVScaler.hh"
+
+#include "FrameSource.hh"
+#include "RenderSettings.hh"
+#include "SWOutputSurface.hh"
+
+#include "inplace_buffer.hh"
+#include "narrow.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <span>
+#include <vector>
+
+// The emulation of the GPU arithmetic (see SWScaler::Quad) relies on rounding
+// after every floating point operation.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace openmsx {
+
+SWTVScaler::SWTVScaler(const RenderSettings& renderSettings_, unsigned srcHeight_)
+	: renderSettings(renderSettings_)
+	, srcHeight(srcHeight_)
+{
+}
+
+/** smoothstep(edge0, 1, x), in the order of operations of the GPU. */
+[[nodiscard]] static float smoothstep(float edge0, float x)
+{
+	float t = std::clamp((x - edge0) / (1.0f - edge0), 0.0f, 1.0f);
+	float u = 2.0f * t;
+	u = 3.0f - u;
+	return t * (t * u);
+}
+
+/** mix(a0 + a1, b0 + b1, weight) in tv.frag. The shader compiler rewrites
+  * 'b - a' in that to '(b0 - a) + b1'.
+  */
+[[nodiscard]] static gl::vec4 mixCorners(
+	gl::vec4 a0, gl::vec4 a1, gl::vec4 b0, gl::vec4 b1, float weight)
+{
+	auto a = a0 + a1;
+	auto d = (b0 - a) + b1;
+	return a + d * weight;
+}
+
+void SWTVScaler::scaleImage(
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	scale(renderSettings.getScanlineGap(),
+	      src, superImpose, srcStartY, srcEndY, srcWidth, srcHeight,
+	      dst, dstStartY, dstEndY, logSrcHeight);
+}
+
+void SWTVScaler::scale(
+	float gap,
+	const FrameSource& src, const RawFrame* superImpose,
+	unsigned srcStartY, unsigned srcEndY, unsigned srcWidth, unsigned srcHeight,
+	SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+	unsigned logSrcHeight)
+{
+	// Same (experimentally established) functions as in GLTVScaler.
+	float minScanline  = 0.1f * gap + 0.2f * gap * gap;
+	float sizeVariance = 0.7f * gap - 0.3f * gap * gap;
+	// col * smoothstep(minScanline + sizeVariance * (1 - col), 1, dist)
+	auto calcCorner = [&](float col, float dist) {
+		return col * smoothstep(minScanline + sizeVariance * (1.0f - col), dist);
+	};
+
+	// tv.vert
+	Quad quad(srcStartY, srcEndY, srcHeight, dst, dstStartY, dstEndY, logSrcHeight, true);
+	auto srcWidthF = float(srcWidth);
+	auto srcHeightF = float(srcHeight);
+	float stepX = 1.0f / srcWidthF;
+	float stepY0 = 1.0f / srcHeightF;
+	float stepY1 = 1.0f / float(logSrcHeight);
+	auto intX = Varying::horizontal(quad, quad.texLeft * srcWidthF, quad.texRight * srcWidthF);
+	auto intY = Varying::vertical(quad, quad.tex0Top * srcHeightF, quad.tex0Bottom * srcHeightF);
+	auto negIntY = Varying::vertical(quad, -(quad.tex0Top * srcHeightF), -(quad.tex0Bottom * srcHeightF));
+	auto corner0X = Varying::horizontal(quad, quad.texLeft,         quad.texRight);
+	auto corner0Z = Varying::horizontal(quad, quad.texLeft + stepX, quad.texRight + stepX);
+	auto corner0Y = Varying::vertical(quad, quad.tex0Top,          quad.tex0Bottom);
+	auto corner0W = Varying::vertical(quad, quad.tex0Top + stepY0, quad.tex0Bottom + stepY0);
+	auto corner1Y = Varying::vertical(quad, quad.tex1Top,          quad.tex1Bottom);
+	auto corner1W = Varying::vertical(quad, quad.tex1Top + stepY1, quad.tex1Bottom + stepY1);
+
+	// The texels and the horizontal weight only depend on the column.
+	struct Column { unsigned x0, x1; float weight, u0, u1; };
+	auto dstWidth = narrow<unsigned>(dst.getLogicalWidth());
+	std::vector<Column> columns;
+	columns.reserve(dstWidth);
+	for (auto x : xrange(dstWidth)) {
+		float u0 = corner0X(x, dstStartY);
+		float u1 = corner0Z(x, dstStartY);
+		columns.push_back({texel(u0 * srcWidthF, srcWidth), texel(u1 * srcWidthF, srcWidth),
+		                   smoothstep(0.0f, fract(intX(x, dstStartY))), u0, u1});
+	}
+
+	assert(srcWidth <= 1280);
+	inplace_buffer<Pixel, 1280> buf0(uninitialized_tag{}, srcWidth);
+	inplace_buffer<Pixel, 1280> buf1(uninitialized_tag{}, srcWidth);
+	for (auto dstY : xrange(dstStartY, dstEndY)) {
+		// This scaler samples the texture starting from zero, so the
+		// pixel in between two texels gets a contribution from both.
+		float dist1 = fract(intY(0, dstY));
+		float dist0 = fract(negIntY(0, dstY));
+		auto line0 = src.getLine(narrow<int>(texel(corner0Y(0, dstY) * srcHeightF, srcHeight)), buf0);
+		auto line1 = src.getLine(narrow<int>(texel(corner0W(0, dstY) * srcHeightF, srcHeight)), buf1);
+		auto out = dst.getLine(dstY);
+		if (superImpose) {
+			// Blended per corner, before the scanline effect. The
+			// corners on the next line are one source line lower,
+			// also in the video.
+			VideoLine video0(*superImpose, corner1Y(0, dstY));
+			VideoLine video1(*superImpose, corner1W(0, dstY));
+			auto corner = [&](Pixel p, const VideoLine& video, float u, float dist) {
+				auto col = blendVideo(toVec4(p), video.sample(u));
+				return gl::vec4(calcCorner(col.x, dist),
+				                calcCorner(col.y, dist),
+				                calcCorner(col.z, dist),
+				                0.0f);
+			};
+			for (auto x : xrange(dstWidth)) {
+				const auto& c = columns[x];
+				out[x] = toPixel(mixCorners(
+					corner(line0[c.x0], video0, c.u0, dist0),
+					corner(line1[c.x0], video1, c.u0, dist1),
+					corner(line0[c.x1], video0, c.u1, dist0),
+					corner(line1[c.x1], video1, c.u1, dist1),
+					c.weight));
+			}
+			continue;
+		}
+
+		// Without video the colors of the corners have 8 bits, so the
+		// result of calcCorner() can be looked up.
+		std::array<float, 256> lut0, lut1;
+		for (auto i : xrange(256)) {
+			float col = float(i) * (1.0f / 255.0f);
+			lut0[i] = calcCorner(col, dist0);
+			lut1[i] = calcCorner(col, dist1);
+		}
+		unsigned x = 0;
+#ifdef __SSE2__
+		// Four pixels at a time, one color component of those pixels
+		// per vector.
+		for (; (x + 4) <= dstWidth; x += 4) {
+			const auto* c = &columns[x];
+			auto gather = [&](const std::array<float, 256>& lut, std::span<const Pixel> line,
+			                  unsigned Column::*texelX, unsigned shift) {
+				auto get = [&](const Column& col) { return lut[(line[col.*texelX] >> shift) & 0xFF]; };
+				return _mm_setr_ps(get(c[0]), get(c[1]), get(c[2]), get(c[3]));
+			};
+			auto weight = _mm_setr_ps(c[0].weight, c[1].weight, c[2].weight, c[3].weight);
+			auto component = [&](unsigned shift) {
+				auto a = _mm_add_ps(gather(lut0, line0, &Column::x0, shift),
+				                    gather(lut1, line1, &Column::x0, shift));
+				auto d = _mm_add_ps(_mm_sub_ps(gather(lut0, line0, &Column::x1, shift), a),
+				                    gather(lut1, line1, &Column::x1, shift));
+				return _mm_add_ps(a, _mm_mul_ps(d, weight));
+			};
+			_mm_storeu_si128(std::bit_cast<__m128i*>(&out[x]), toPixels4(component(0), component(8), component(16)));
+		}
+#endif
+		auto lookup = [](const std::array<float, 256>& lut, Pixel p) {
+			return gl::vec4(lut[(p >> 0) & 0xFF], lut[(p >> 8) & 0xFF], lut[(p >> 16) & 0xFF], 0.0f);
+		};
+		for (; x < dstWidth; ++x) {
+			const auto& c = columns[x];
+			out[x] = toPixel(mixCorners(
+				lookup(lut0, line0[c.x0]), lookup(lut1, line1[c.x0]),
+				lookup(lut0, line0[c.x1]), lookup(lut1, line1[c.x1]),
+				c.weight));
+		}
+	}
+}
+
+} // namespace openmsx
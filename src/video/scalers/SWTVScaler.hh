@@ -0,0 +1,43 @@
+#ifndef SWTVSCALER_HH
+#define SWTVSCALER_HH
+
+#include "SWScaler.hh"
+
+namespace openmsx {
+
+class RenderSettings;
+
+/** Software version of GLTVScaler (tv.frag). */
+class SWTVScaler final : public SWScaler
+{
+public:
+	/** @param srcHeight See scale(). */
+	SWTVScaler(const RenderSettings& renderSettings, unsigned srcHeight);
+
+	void scaleImage(
+		const FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth,
+		SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		unsigned logSrcHeight) override;
+
+	/** The implementation of scaleImage(), with the setting as parameter
+	  * instead of read from RenderSettings.
+	  * @param gap The scanline gap, in range [0, 1].
+	  * @param srcHeight The height of the texture that holds the source
+	  *        frame in GLPostProcessor, see Quad.
+	  */
+	static void scale(
+		float gap,
+		const FrameSource& src, const RawFrame* superImpose,
+		unsigned srcStartY, unsigned srcEndY, unsigned srcWidth, unsigned srcHeight,
+		SWOutputSurface& dst, unsigned dstStartY, unsigned dstEndY,
+		unsigned logSrcHeight);
+
+private:
+	const RenderSettings& renderSettings;
+	const unsigned srcHeight;
+};
+
+} // namespace openmsx
+
+#endif // SWTVSCALER_HH
@@ -1,10 +1,13 @@
 #include "V9990BitmapConverter.hh"
 
 #include "V9990.hh"
+#include "V9990LineConvert.hh"
 #include "V9990VRAM.hh"
 
 #include "narrow.hh"
+#include "ranges.hh"
 #include "unreachable.hh"
+#include "xrange.hh"
 
 #include <array>
 #include <cassert>
@@ -26,117 +29,30 @@ V9990BitmapConverter::V9990BitmapConverter(
 	setColorMode(V9990ColorMode::PP, V9990DisplayMode::B0); // initialize with dummy values
 }
 
-template<bool YJK, bool PAL, bool SKIP, std::unsigned_integral Pixel, typename ColorLookup>
-static inline void draw_YJK_YUV_PAL(
-	ColorLookup color, const V9990VRAM& vram,
-	Pixel* __restrict& out, unsigned& address, int firstX = 0)
-{
-	std::array<uint8_t, 4> data;
-	for (auto& d : data) {
-		d = vram.readVRAMBx(address++);
-	}
-
-	int u = (data[2] & 7) + ((data[3] & 3) << 3) - ((data[3] & 4) << 3);
-	int v = (data[0] & 7) + ((data[1] & 3) << 3) - ((data[1] & 4) << 3);
-
-	for (auto i : xrange(SKIP ? firstX : 0, 4)) {
-		if (PAL && (data[i] & 0x08)) {
-			*out++ = color.lookup64(data[i] >> 4);
-		} else {
-			int y = (data[i] & 0xF8) >> 3;
-			int r = std::clamp(y + u,                   0, 31);
-			int g = std::clamp((5 * y - 2 * u - v) / 4, 0, 31);
-			int b = std::clamp(y + v,                   0, 31);
-			// The only difference between YUV and YJK is that
-			// green and blue are swapped.
-			if constexpr (YJK) std::swap(g, b);
-			*out++ = color.lookup32768((g << 10) + (r << 5) + b);
-		}
-	}
-}
-
-template<std::unsigned_integral Pixel, typename ColorLookup>
-static void rasterBYUV(
-	ColorLookup color, const V9990& vdp, const V9990VRAM& vram,
-	std::span<Pixel> buf, unsigned x, unsigned y)
-{
-	Pixel* __restrict out = buf.data();
-	int nrPixels = narrow<int>(buf.size());
-	unsigned address = (x & ~3) + y * vdp.getImageWidth();
-	if (x & 3) {
-		draw_YJK_YUV_PAL<false, false, true>(
-			color, vram, out, address, x & 3);
-		nrPixels -= narrow<int>(4 - (x & 3));
-	}
-	for (/**/; nrPixels > 0; nrPixels -= 4) {
-		draw_YJK_YUV_PAL<false, false, false>(
-			color, vram, out, address);
-	}
-	// Note: this can draw up to 3 pixels too many, but that's ok.
-}
+// Maximum number of pixels per line, see convertLine().
+static constexpr size_t MAX_WIDTH = 1024;
 
-template<std::unsigned_integral Pixel, typename ColorLookup>
-static void rasterBYUVP(
+template<bool YJK, bool PAL, std::unsigned_integral Pixel, typename ColorLookup>
+static void rasterYUV(
 	ColorLookup color, const V9990& vdp, const V9990VRAM& vram,
 	std::span<Pixel> buf, unsigned x, unsigned y)
 {
-	// TODO this mode cannot be shown in B4 and higher resolution modes
+	// TODO the PAL modes cannot be shown in B4 and higher resolution modes
 	//      (So the dual palette for B4 modes is not an issue here.)
-	Pixel* __restrict out = buf.data();
-	int nrPixels = narrow<int>(buf.size());
+	// Groups of 4 pixels share their color information: convert all
+	// (partially) visible groups, then drop the first 'x & 3' pixels.
+	static constexpr size_t MAX_GROUPS = (3 + MAX_WIDTH + 3) / 4;
+	size_t skip = x & 3;
+	size_t groups = (skip + buf.size() + 3) / 4;
+	assert(groups <= MAX_GROUPS);
+	std::array<uint8_t, 2 * MAX_GROUPS> even, odd;
+	std::array<uint16_t, 4 * MAX_GROUPS> indices;
 	unsigned address = (x & ~3) + y * vdp.getImageWidth();
-	if (x & 3) {
-		draw_YJK_YUV_PAL<false, true, true>(
-			color, vram, out, address, x & 3);
-		nrPixels -= narrow<int>(4 - (x & 3));
-	}
-	for (/**/; nrPixels > 0; nrPixels -= 4) {
-		draw_YJK_YUV_PAL<false, true, false>(
-			color, vram, out, address);
-	}
-	// Note: this can draw up to 3 pixels too many, but that's ok.
-}
-
-template<std::unsigned_integral Pixel, typename ColorLookup>
-static void rasterBYJK(
-	ColorLookup color, const V9990& vdp, const V9990VRAM& vram,
-	std::span<Pixel> buf, unsigned x, unsigned y)
-{
-	Pixel* __restrict out = buf.data();
-	int nrPixels = narrow<int>(buf.size());
-	unsigned address = (x & ~3) + y * vdp.getImageWidth();
-	if (x & 3) {
-		draw_YJK_YUV_PAL<true, false, true>(
-			color, vram, out, address, x & 3);
-		nrPixels -= narrow<int>(4 - (x & 3));
-	}
-	for (/**/; nrPixels > 0; nrPixels -= 4) {
-		draw_YJK_YUV_PAL<true, false, false>(
-			color, vram, out, address);
-	}
-	// Note: this can draw up to 3 pixels too many, but that's ok.
-}
-
-template<std::unsigned_integral Pixel, typename ColorLookup>
-static void rasterBYJKP(
-	ColorLookup color, const V9990& vdp, const V9990VRAM& vram,
-	std::span<Pixel> buf, unsigned x, unsigned y)
-{
-	// TODO this mode cannot be shown in B4 and higher resolution modes
-	//      (So the dual palette for B4 modes is not an issue here.)
-	Pixel* __restrict out = buf.data();
-	int nrPixels = narrow<int>(buf.size());
-	unsigned address = (x & ~3) + y * vdp.getImageWidth();
-	if (x & 3) {
-		draw_YJK_YUV_PAL<true, true, true>(
-			color, vram, out, address, x & 3);
-		nrPixels -= narrow<int>(4 - (x & 3));
-	}
-	for (/**/; nrPixels > 0; nrPixels -= 4) {
-		draw_YJK_YUV_PAL<true, true, false>(
-			color, vram, out, address);
-	}
-	// Note: this can draw up to 3 pixels too many, but that's ok.
+	auto e = subspan(even, 0, 2 * groups);
+	auto o = subspan(odd,  0, 2 * groups);
+	vram.readBxPlanes(address, e, o);
+	V9990LineConvert::yuvIndices<YJK, PAL>(e, o, subspan(indices, 0, 4 * groups));
+	color.lookup(subspan(indices, skip, buf.size()), buf);
 }
 
 template<std::unsigned_integral Pixel, typename ColorLookup>
@@ -144,27 +60,19 @@ static void rasterBD16(
 	ColorLookup color, const V9990& vdp, const V9990VRAM& vram,
 	std::span<Pixel> buf, unsigned x, unsigned y)
 {
-	Pixel* __restrict out = buf.data();
-	int nrPixels = narrow<int>(buf.size());
-	unsigned address = 2 * (x + y * vdp.getImageWidth());
+	assert(buf.size() <= MAX_WIDTH);
+	std::array<uint8_t, MAX_WIDTH> low, high;
+	std::array<uint16_t, MAX_WIDTH> indices;
+	auto l = subspan(low,  0, buf.size());
+	auto h = subspan(high, 0, buf.size());
+	vram.readBxPlanes(2 * (x + y * vdp.getImageWidth()), l, h);
+	auto idx = subspan(indices, 0, buf.size());
+	V9990LineConvert::bd16Indices(l, h, idx);
+	color.lookup(idx, buf);
 	if (vdp.isSuperimposing()) {
 		auto transparent = color.lookup256(0);
-		for (/**/; nrPixels > 0; --nrPixels) {
-			uint8_t high = vram.readVRAMBx(address + 1);
-			if (high & 0x80) {
-				*out = transparent;
-			} else {
-				uint8_t low  = vram.readVRAMBx(address + 0);
-				*out = color.lookup32768(low + 256 * high);
-			}
-			address += 2;
-			out += 1;
-		}
-	} else {
-		for (/**/; nrPixels > 0; --nrPixels) {
-			uint8_t low  = vram.readVRAMBx(address++);
-			uint8_t high = vram.readVRAMBx(address++);
-			*out++ = color.lookup32768((low + 256 * high) & 0x7FFF);
+		for (auto i : xrange(buf.size())) {
+			if (h[i] & 0x80) buf[i] = transparent;
 		}
 	}
 }
@@ -314,6 +222,9 @@ public:
 	}
 
 	void set64Offset(size_t offset) { palette64 = palette64Base.subspan(offset); }
+	void lookup(std::span<const uint16_t> indices, std::span<Pixel> out) const {
+		V9990LineConvert::lookupIndices(indices, palette64, palette32768, out);
+	}
 	[[nodiscard]] Pixel lookup64   (size_t idx) const { return palette64   [idx]; }
 	[[nodiscard]] Pixel lookup256  (size_t idx) const { return palette256  [idx]; }
 	[[nodiscard]] Pixel lookup32768(size_t idx) const { return palette32768[idx]; }
@@ -338,6 +249,12 @@ public:
 	}
 
 	void set64Offset(size_t offset) { palette64_32768 = palette64_32768Base.subspan(offset); }
+	void lookup(std::span<const uint16_t> indices, std::span<uint16_t> out) const {
+		for (auto i : xrange(indices.size())) {
+			auto idx = indices[i];
+			out[i] = (idx & V9990LineConvert::PALETTE) ? uint16_t(lookup64(idx & 63)) : idx;
+		}
+	}
 	[[nodiscard]] int16_t lookup64   (size_t idx) const { return palette64_32768 [idx]; }
 	[[nodiscard]] int16_t lookup256  (size_t idx) const { return palette256_32768[idx]; }
 	[[nodiscard]] int16_t lookup32768(size_t idx) const { return int16_t(idx); }
@@ -355,10 +272,10 @@ static void raster(V9990ColorMode colorMode, bool highRes,
 {
 	switch (colorMode) {
 	using enum V9990ColorMode;
-	case BYUV:  return rasterBYUV <Pixel>(color, vdp, vram, out, x, y);
-	case BYUVP: return rasterBYUVP<Pixel>(color, vdp, vram, out, x, y);
-	case BYJK:  return rasterBYJK <Pixel>(color, vdp, vram, out, x, y);
-	case BYJKP: return rasterBYJKP<Pixel>(color, vdp, vram, out, x, y);
+	case BYUV:  return rasterYUV<false, false, Pixel>(color, vdp, vram, out, x, y);
+	case BYUVP: return rasterYUV<false, true,  Pixel>(color, vdp, vram, out, x, y);
+	case BYJK:  return rasterYUV<true,  false, Pixel>(color, vdp, vram, out, x, y);
+	case BYJKP: return rasterYUV<true,  true,  Pixel>(color, vdp, vram, out, x, y);
 	case BD16:  return rasterBD16 <Pixel>(color, vdp, vram, out, x, y);
 	case BD8:   return rasterBD8  <Pixel>(color, vdp, vram, out, x, y);
 	case BP6:   return rasterBP6  <Pixel>(color, vdp, vram, out, x, y);
@@ -464,14 +381,14 @@ void V9990BitmapConverter::convertLine(
 	std::span<Pixel> dst, unsigned x, unsigned y,
 	int cursorY, bool drawCursors) const
 {
-	assert(dst.size() <= 1024);
+	assert(dst.size() <= MAX_WIDTH);
 
 	CursorInfo cursor0(vdp, vram, palette64_32768, 0x7fe00, 0x7ff00, cursorY, drawCursors);
 	CursorInfo cursor1(vdp, vram, palette64_32768, 0x7fe08, 0x7ff80, cursorY, drawCursors);
 
 	if (cursor0.isVisible() || cursor1.isVisible()) {
 		// raster background into a temporary buffer
-		std::array<uint16_t, 1024 + 3> buf; // allow to draw upto 3 pixels too many, e.g. see rasterBP2()
+		std::array<uint16_t, MAX_WIDTH + 3> buf; // allow to draw upto 3 pixels too many, e.g. see rasterBP2()
 		raster(colorMode, highRes,
 		       IndexLookup(palette64_32768, palette256_32768),
 		       vdp, vram,
@@ -2,6 +2,7 @@
 
 #include "V9990.hh"
 #include "V9990DisplayTiming.hh"
+#include "V9990FastCopy.hh"
 #include "V9990VRAM.hh"
 
 #include "BooleanSetting.hh"
@@ -18,10 +19,12 @@
 #include "unreachable.hh"
 #include "xrange.hh"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <iostream>
 #include <string_view>
+#include <type_traits>
 
 namespace openmsx {
 
@@ -105,6 +108,16 @@ static constexpr std::array SRCH_TIMING = {
 	return EmuDuration(table[idx1][idx2][idx3]);
 }
 
+// Number of iterations a 'while (time < limit) { time += delta; ... }' loop
+// would make (for a command that doesn't end earlier).
+[[nodiscard]] static unsigned stepsUntil(EmuTime time, EmuTime limit, EmuDuration delta)
+{
+	if (time >= limit) return 0;
+	if (delta == EmuDuration::zero()) return unsigned(-1); // broken timing
+	uint64_t steps = ((limit - time).toUint64() + delta.toUint64() - 1) / delta.toUint64();
+	return narrow_cast<unsigned>(std::min<uint64_t>(steps, unsigned(-1)));
+}
+
 
 
 // Lazily initialized LUT to speed up logical operations:
@@ -701,6 +714,35 @@ inline void V9990CmdEngine::V9990Bpp16::psetColor(
 	vram.writeVRAMDirect(addr + 0x40000, narrow_cast<uint8_t>(result >> 8));
 }
 
+template<typename Mode>
+void V9990CmdEngine::copyPixels(unsigned src, unsigned dst, unsigned num)
+{
+	if constexpr (std::is_same_v<Mode, V9990Bpp16>) {
+		vram.copyPlanes(src, dst, num);
+	} else {
+		static_assert(std::is_same_v<Mode, V9990Bpp8>);
+		vram.copyBx(src, dst, num);
+	}
+}
+
+template<V9990FastCopy::Cmd CMD, typename Mode>
+void V9990CmdEngine::executeFastCopy(EmuTime limit, EmuDuration delta, unsigned pitch, uint16_t dy)
+{
+	V9990FastCopy::Rect rect{.SX = SX, .SY = SY, .DX = DX, .DY = DY, .NX = NX,
+	                         .ANX = ANX, .ANY = ANY,
+	                         .srcAddress = srcAddress, .dstAddress = dstAddress};
+	unsigned steps = V9990FastCopy::copyRect<CMD, std::is_same_v<Mode, V9990Bpp16>>(
+		rect, stepsUntil(engineTime, limit, delta), pitch, dy,
+		[&](unsigned src, unsigned dst, unsigned num) { copyPixels<Mode>(src, dst, num); });
+	engineTime += delta * steps;
+	SX = rect.SX; SY = rect.SY;
+	DX = rect.DX; DY = rect.DY;
+	ANX = rect.ANX; ANY = rect.ANY;
+	srcAddress = rect.srcAddress;
+	dstAddress = rect.dstAddress;
+	if (!ANY) cmdReady(engineTime);
+}
+
 // ====================================================================
 /** Constructor
   */
@@ -1145,6 +1187,15 @@ void V9990CmdEngine::executeLMMM(EmuTime limit)
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	uint16_t dx = (ARG & DIX) ? uint16_t(-1) : 1;
 	uint16_t dy = (ARG & DIY) ? uint16_t(-1) : 1;
+	if constexpr (std::is_same_v<Mode, V9990Bpp8> || std::is_same_v<Mode, V9990Bpp16>) {
+		if (isPlainCopy() && (dx == 1)) {
+			// Fast path: copy runs of pixels at once. Same result
+			// and timing as the pixel-by-pixel loop below.
+			executeFastCopy<V9990FastCopy::Cmd::LMMM, Mode>(limit, delta, pitch, dy);
+			return;
+		}
+	}
+
 	auto lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
 		engineTime += delta;
@@ -1286,6 +1337,15 @@ void V9990CmdEngine::executeBMXL<V9990CmdEngine::V9990Bpp16>(EmuTime limit)
 	unsigned pitch = V9990Bpp16::getPitch(vdp.getImageWidth());
 	uint16_t dx = (ARG & DIX) ? uint16_t(-1) : 1;
 	uint16_t dy = (ARG & DIY) ? uint16_t(-1) : 1;
+
+	if (isPlainCopy() && (dx == 1) && !(srcAddress & 1)) {
+		// Fast path: for an even start address the low and high bytes
+		// are at the same offset in both halves of VRAM, so runs of
+		// pixels can be copied at once. See also executeLMMM().
+		executeFastCopy<V9990FastCopy::Cmd::BMXL, V9990Bpp16>(limit, delta, pitch, dy);
+		return;
+	}
+
 	auto lut = V9990Bpp16::getLogOpLUT(LOG);
 
 	while (engineTime < limit) {
@@ -1315,6 +1375,15 @@ void V9990CmdEngine::executeBMXL(EmuTime limit)
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	uint16_t dx = (ARG & DIX) ? uint16_t(-1) : 1;
 	uint16_t dy = (ARG & DIY) ? uint16_t(-1) : 1;
+
+	if constexpr (std::is_same_v<Mode, V9990Bpp8>) {
+		if (isPlainCopy() && (dx == 1)) {
+			// Fast path, see executeLMMM().
+			executeFastCopy<V9990FastCopy::Cmd::BMXL, Mode>(limit, delta, pitch, dy);
+			return;
+		}
+	}
+
 	auto lut = Mode::getLogOpLUT(LOG);
 
 	while (engineTime < limit) {
@@ -1356,6 +1425,12 @@ void V9990CmdEngine::executeBMLX<V9990CmdEngine::V9990Bpp16>(EmuTime limit)
 	uint16_t dx = (ARG & DIX) ? uint16_t(-1) : 1;
 	uint16_t dy = (ARG & DIY) ? uint16_t(-1) : 1;
 
+	if ((dx == 1) && !(dstAddress & 1)) {
+		// Fast path, see executeBMXL<V9990Bpp16>().
+		executeFastCopy<V9990FastCopy::Cmd::BMLX, V9990Bpp16>(limit, delta, pitch, dy);
+		return;
+	}
+
 	while (engineTime < limit) {
 		engineTime += delta;
 		auto src = V9990Bpp16::point(vram, SX, SY, pitch);
@@ -1383,6 +1458,14 @@ void V9990CmdEngine::executeBMLX(EmuTime limit)
 	uint16_t dx = (ARG & DIX) ? uint16_t(-1) : 1;
 	uint16_t dy = (ARG & DIY) ? uint16_t(-1) : 1;
 
+	if constexpr (std::is_same_v<Mode, V9990Bpp8>) {
+		if (dx == 1) {
+			// Fast path, see executeLMMM().
+			executeFastCopy<V9990FastCopy::Cmd::BMLX, Mode>(limit, delta, pitch, dy);
+			return;
+		}
+	}
+
 	while (engineTime < limit) {
 		engineTime += delta;
 		uint8_t d = 0;
@@ -1433,6 +1516,17 @@ void V9990CmdEngine::executeBMLL<V9990CmdEngine::V9990Bpp16>(EmuTime limit)
 	// TODO DIX DIY?
 	// timing value is times 2, because it does 2 bytes per iteration:
 	auto delta = getTiming(*this, BMLL_TIMING) * 2;
+	if (isPlainCopy() && nbBytes) {
+		// Fast path: copy as many bytes as possible at once.
+		unsigned n = std::min(nbBytes, stepsUntil(engineTime, limit, delta));
+		vram.copyPlanes(srcAddress, dstAddress, n);
+		engineTime += delta * n;
+		srcAddress = (srcAddress + n) & 0x3FFFF;
+		dstAddress = (dstAddress + n) & 0x3FFFF;
+		nbBytes -= n;
+		if (!nbBytes) cmdReady(engineTime);
+		return;
+	}
 	auto lut = V9990Bpp16::getLogOpLUT(LOG);
 	bool transp = (LOG & 0x10) != 0;
 	while (engineTime < limit) {
@@ -1460,6 +1554,17 @@ void V9990CmdEngine::executeBMLL(EmuTime limit)
 {
 	// TODO DIX DIY?
 	auto delta = getTiming(*this, BMLL_TIMING);
+	if (isPlainCopy()) {
+		// Fast path, see executeBMLL<V9990Bpp16>().
+		unsigned n = std::min(nbBytes, stepsUntil(engineTime, limit, delta));
+		vram.copyBx(srcAddress, dstAddress, n);
+		engineTime += delta * n;
+		srcAddress = (srcAddress + n) & 0x7FFFF;
+		dstAddress = (dstAddress + n) & 0x7FFFF;
+		nbBytes -= n;
+		if (!nbBytes) cmdReady(engineTime);
+		return;
+	}
 	auto lut = Mode::getLogOpLUT(LOG);
 	while (engineTime < limit) {
 		engineTime += delta;
@@ -15,6 +15,7 @@ class V9990VRAM;
 class Setting;
 class RenderSettings;
 class BooleanSetting;
+namespace V9990FastCopy { enum class Cmd : uint8_t; }
 
 /** Command engine.
   */
@@ -337,6 +338,22 @@ private:
 	[[nodiscard]] uint16_t getWrappedNY() const {
 		return NY ? NY : 4096;
 	}
+
+	/** Does the current command simply copy its source (LOG=IMP without
+	  * transparency, no write mask)? */
+	[[nodiscard]] bool isPlainCopy() const {
+		return ((LOG & 0x1F) == 0x0C) && (WM == 0xFFFF);
+	}
+
+	/** For the modes where a horizontal run of pixels is a run of
+	  * consecutive bytes (8bpp: Bx addresses, 16bpp: offsets in both VRAM
+	  * halves), copy 'num' pixels at once. */
+	template<typename Mode> void copyPixels(unsigned src, unsigned dst, unsigned num);
+
+	/** Execute the current command (up to 'limit') via
+	  * V9990FastCopy::copyRect(). */
+	template<V9990FastCopy::Cmd CMD, typename Mode>
+	void executeFastCopy(EmuTime limit, EmuDuration delta, unsigned pitch, uint16_t dy);
 };
 SERIALIZE_CLASS_VERSION(V9990CmdEngine, 2);
 
@@ -0,0 +1,176 @@
+#ifndef V9990FASTCOPY_HH
+#define V9990FASTCOPY_HH
+
+#include "V9990VRAM.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+/** The bulk-copy fast paths of the V9990 command engine (see
+  * V9990CmdEngine::executeLMMM() and friends). These are templates, separate
+  * from V9990CmdEngine and V9990VRAM, so that they can be unit tested.
+  */
+namespace openmsx::V9990FastCopy {
+
+// Do the address ranges [a, a + num) and [b, b + num) (modulo 'size') overlap?
+[[nodiscard]] inline bool overlaps(unsigned a, unsigned b, unsigned num, unsigned size)
+{
+	return (((b - a) & (size - 1)) < num) || (((a - b) & (size - 1)) < num);
+}
+
+/** Copy 'num' bytes from one range of Bx (linear) addresses to another, both
+  * ranges wrap at the end of VRAM. Gives the same result as copying byte by
+  * byte in increasing address order (also for overlapping ranges).
+  */
+template<typename Ram>
+void copyBx(Ram& data, unsigned srcAddress, unsigned dstAddress, unsigned num)
+{
+	static constexpr unsigned SIZE = V9990VRAM::VRAM_SIZE;
+	srcAddress &= SIZE - 1;
+	dstAddress &= SIZE - 1;
+	if (overlaps(srcAddress, dstAddress, num, SIZE)) {
+		// Rare, byte-by-byte copy gives the required semantics.
+		repeat(num, [&] {
+			data.write(V9990VRAM::transformBx(dstAddress),
+			           data[V9990VRAM::transformBx(srcAddress)]);
+			srcAddress = (srcAddress + 1) & (SIZE - 1);
+			dstAddress = (dstAddress + 1) & (SIZE - 1);
+		});
+		return;
+	}
+	while (num) {
+		// Consecutive Bx addresses alternate between both halves of
+		// VRAM. So (as long as neither range wraps) the bytes at even
+		// and at odd positions in the range are each a contiguous block.
+		unsigned n = std::min({num, SIZE - srcAddress, SIZE - dstAddress});
+		for (auto i : xrange(std::min(n, 2u))) {
+			unsigned len = (n - i + 1) / 2;
+			auto src = V9990VRAM::transformBx(srcAddress + i);
+			auto dst = V9990VRAM::transformBx(dstAddress + i);
+			std::ranges::copy(std::span{&data[src], len},
+			                  data.getWriteBackdoor(dst, len).begin());
+		}
+		srcAddress = (srcAddress + n) & (SIZE - 1);
+		dstAddress = (dstAddress + n) & (SIZE - 1);
+		num -= n;
+	}
+}
+
+/** Similar to copyBx(), but copies 'num' bytes in both halves of VRAM (the
+  * low and high byte of a 16bpp pixel). The offsets are relative to the
+  * start of each half and wrap at the end of it.
+  */
+template<typename Ram>
+void copyPlanes(Ram& data, unsigned srcOffset, unsigned dstOffset, unsigned num)
+{
+	static constexpr unsigned HALF = V9990VRAM::VRAM_SIZE / 2;
+	srcOffset &= HALF - 1;
+	dstOffset &= HALF - 1;
+	if ((srcOffset != dstOffset) && (((dstOffset - srcOffset) & (HALF - 1)) < num)) {
+		// Destination starts inside the not yet copied source: the
+		// copied data repeats itself, byte-by-byte copy is required.
+		// (Both halves are independent, so the other overlap case is
+		// handled fine by the block copy below.)
+		repeat(num, [&] {
+			for (unsigned half : {0u, HALF}) {
+				data.write(dstOffset + half, data[srcOffset + half]);
+			}
+			srcOffset = (srcOffset + 1) & (HALF - 1);
+			dstOffset = (dstOffset + 1) & (HALF - 1);
+		});
+		return;
+	}
+	while (num) {
+		unsigned n = std::min({num, HALF - srcOffset, HALF - dstOffset});
+		for (unsigned half : {0u, HALF}) {
+			auto dst = data.getWriteBackdoor(dstOffset + half, n);
+			std::memmove(dst.data(), &data[srcOffset + half], n);
+		}
+		srcOffset = (srcOffset + n) & (HALF - 1);
+		dstOffset = (dstOffset + n) & (HALF - 1);
+		num -= n;
+	}
+}
+
+enum class Cmd : uint8_t { LMMM, BMXL, BMLX };
+
+/** The state of a LMMM, BMXL or BMLX command, these are the corresponding
+  * V9990CmdEngine members.
+  */
+struct Rect {
+	uint16_t SX, SY, DX, DY, NX;
+	uint16_t ANX, ANY;
+	unsigned srcAddress, dstAddress;
+};
+
+/** Execute (at most 'steps' pixels of) a LMMM, BMXL or BMLX command that
+  * copies from left to right (DIX=0) without logical operation or write mask.
+  * Instead of pixel by pixel, runs of pixels (up to the end of the current
+  * line or the wrap-around point in source or destination) are passed to
+  * 'copy(src, dst, num)'. That must copy 'num' pixels, given as Bx addresses
+  * (8bpp, see copyBx()) or offsets in both VRAM halves (16bpp, see
+  * copyPlanes()). For 16bpp BMXL resp. BMLX the (linear) source resp.
+  * destination address must be even.
+  * @return The number of pixels that were processed, equal to 'steps' unless
+  *         the command finished (then 'rect.ANY' is zero).
+  */
+template<Cmd CMD, bool BPP16, typename Copy>
+unsigned copyRect(Rect& rect, unsigned steps, unsigned pitch, uint16_t dy, Copy copy)
+{
+	auto wrappedNX = uint16_t(rect.NX ? rect.NX : 2048);
+	unsigned done = 0;
+	while (steps) {
+		unsigned n = std::min(steps, unsigned(rect.ANX));
+		unsigned src, dst;
+		if constexpr (CMD == Cmd::BMXL) {
+			src = BPP16 ? (rect.srcAddress & 0x7FFFF) / 2 : rect.srcAddress;
+		} else {
+			unsigned sx = rect.SX & (pitch - 1);
+			n = std::min(n, pitch - sx);
+			src = sx + rect.SY * pitch;
+		}
+		if constexpr (CMD == Cmd::BMLX) {
+			dst = BPP16 ? (rect.dstAddress & 0x7FFFF) / 2 : rect.dstAddress;
+		} else {
+			unsigned tx = rect.DX & (pitch - 1);
+			n = std::min(n, pitch - tx);
+			dst = tx + rect.DY * pitch;
+		}
+		copy(src, dst, n);
+		steps -= n;
+		done += n;
+
+		if constexpr (CMD == Cmd::BMXL) {
+			rect.srcAddress += (BPP16 ? 2 : 1) * n;
+		} else {
+			rect.SX = uint16_t(rect.SX + n);
+		}
+		if constexpr (CMD == Cmd::BMLX) {
+			rect.dstAddress += (BPP16 ? 2 : 1) * n;
+		} else {
+			rect.DX = uint16_t(rect.DX + n);
+		}
+		rect.ANX = uint16_t(rect.ANX - n);
+		if (!rect.ANX) {
+			if constexpr (CMD != Cmd::BMXL) {
+				rect.SX -= rect.NX;
+				rect.SY += dy;
+			}
+			if constexpr (CMD != Cmd::BMLX) {
+				rect.DX -= rect.NX;
+				rect.DY += dy;
+			}
+			if (!--rect.ANY) break;
+			rect.ANX = wrappedNX;
+		}
+	}
+	return done;
+}
+
+} // namespace openmsx::V9990FastCopy
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef V9990LINECONVERT_HH
+#define V9990LINECONVERT_HH
+
+#include "simd.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+
+/** Routines for the per-pixel work of V9990BitmapConverter and
+  * V9990PxConverter. They're in a separate header so they can be tested and
+  * benchmarked without a V9990.
+  *
+  * The bitmap routines work in two steps: first the VRAM bytes are converted
+  * to V9990 color indices, then those are looked up in the palette. The input
+  * is split in the bytes at even and at odd Bx addresses, because that's how
+  * they are stored in VRAM (see V9990VRAM::readBxPlanes()).
+  */
+namespace openmsx::V9990LineConvert {
+
+using Pixel = uint32_t;
+
+/** When this bit is set in a color index, the pixel uses the 64-entry
+  * palette with index 'idx & 63', otherwise 'idx' is an index in the
+  * 32768-entry palette.
+  */
+inline constexpr uint16_t PALETTE = 0x8000;
+
+/** Color indices for one group of 4 pixels in YUV or YJK mode. With 'PAL'
+  * set (YUVP or YJKP mode) pixels can also use the palette.
+  */
+template<bool YJK, bool PAL>
+inline void yuvGroup(std::array<uint8_t, 4> data, uint16_t* out)
+{
+	int u = (data[2] & 7) + ((data[3] & 3) << 3) - ((data[3] & 4) << 3);
+	int v = (data[0] & 7) + ((data[1] & 3) << 3) - ((data[1] & 4) << 3);
+
+	for (auto i : xrange(4)) {
+		if (PAL && (data[i] & 0x08)) {
+			out[i] = uint16_t(PALETTE | (data[i] >> 4));
+		} else {
+			int y = (data[i] & 0xF8) >> 3;
+			int r = std::clamp(y + u,                   0, 31);
+			int g = std::clamp((5 * y - 2 * u - v) / 4, 0, 31);
+			int b = std::clamp(y + v,                   0, 31);
+			// The only difference between YUV and YJK is that
+			// green and blue are swapped.
+			if constexpr (YJK) std::swap(g, b);
+			out[i] = uint16_t((g << 10) + (r << 5) + b);
+		}
+	}
+}
+
+#ifdef __SSE2__
+// Same as yuvGroup(), but for 8 pixels (2 groups). 'p' contains the VRAM
+// bytes of those pixels, zero-extended to 16 bits.
+template<bool YJK, bool PAL>
+[[nodiscard]] inline __m128i yuvIndex8(__m128i p)
+{
+	// v is calculated from the first two pixels of a group, u from the
+	// last two: (p0 & 7) + ((p1 & 3) << 3) - ((p1 & 4) << 3)
+	const __m128i oddLanes = _mm_set_epi16(-1, 0, -1, 0, -1, 0, -1, 0);
+	__m128i lowBits  = _mm_and_si128(p, _mm_set1_epi16(7));
+	__m128i highBits = _mm_sub_epi16(
+		_mm_slli_epi16(_mm_and_si128(p, _mm_set1_epi16(3)), 3),
+		_mm_slli_epi16(_mm_and_si128(p, _mm_set1_epi16(4)), 3));
+	__m128i sums = _mm_madd_epi16(SIMD::select(lowBits, highBits, oddLanes),
+	                              _mm_set1_epi16(1)); // v0 u0 v1 u1 (32-bit)
+	sums = _mm_packs_epi32(sums, sums);
+	__m128i dup = _mm_unpacklo_epi16(sums, sums); // v0 v0 u0 u0 v1 v1 u1 u1
+	__m128i v = _mm_shuffle_epi32(dup, 0xA0); // v0 (4x) v1 (4x)
+	__m128i u = _mm_shuffle_epi32(dup, 0xF5); // u0 (4x) u1 (4x)
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(31);
+	auto clamp = [&](__m128i x) { return _mm_min_epi16(_mm_max_epi16(x, zero), max); };
+	__m128i y = _mm_srli_epi16(p, 3);
+	__m128i r = clamp(_mm_add_epi16(y, u));
+	__m128i b = clamp(_mm_add_epi16(y, v));
+	// (5 * y - 2 * u - v) / 4: the arithmetic shift rounds negative values
+	// differently than the division, but those get clamped to 0 anyway.
+	__m128i y5 = _mm_add_epi16(y, _mm_slli_epi16(y, 2));
+	__m128i g = clamp(_mm_srai_epi16(
+		_mm_sub_epi16(_mm_sub_epi16(y5, _mm_add_epi16(u, u)), v), 2));
+	if constexpr (YJK) std::swap(g, b);
+	__m128i idx = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(g, 10), _mm_slli_epi16(r, 5)), b);
+	if constexpr (PAL) {
+		__m128i pal = _mm_or_si128(_mm_srli_epi16(p, 4), _mm_set1_epi16(short(PALETTE)));
+		__m128i isPal = _mm_cmpeq_epi16(_mm_and_si128(p, _mm_set1_epi16(8)),
+		                                _mm_set1_epi16(8));
+		idx = SIMD::select(idx, pal, isPal);
+	}
+	return idx;
+}
+#endif
+
+/** Color indices for YUV, YUVP, YJK or YJKP mode. Each group of 4 pixels
+  * takes 2 bytes from 'even' and 2 from 'odd'.
+  */
+template<bool YJK, bool PAL>
+inline void yuvIndices(std::span<const uint8_t> even, std::span<const uint8_t> odd,
+                       std::span<uint16_t> out)
+{
+	assert(even.size() == odd.size());
+	assert((even.size() % 2) == 0);
+	assert(out.size() == 2 * even.size());
+	size_t groups = even.size() / 2;
+	size_t g = 0;
+#ifdef __SSE2__
+	// SSE2 version, 16 pixels (4 groups) per iteration
+	const __m128i zero = _mm_setzero_si128();
+	auto* o = std::bit_cast<__m128i*>(out.data());
+	for (/**/; (g + 4) <= groups; g += 4) {
+		__m128i data0 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(even.data() + 2 * g));
+		__m128i data1 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(odd .data() + 2 * g));
+		__m128i p = _mm_unpacklo_epi8(data0, data1);
+		_mm_storeu_si128(o + g / 2 + 0, yuvIndex8<YJK, PAL>(_mm_unpacklo_epi8(p, zero)));
+		_mm_storeu_si128(o + g / 2 + 1, yuvIndex8<YJK, PAL>(_mm_unpackhi_epi8(p, zero)));
+	}
+#endif
+	// C++ version (and remaining groups)
+	for (/**/; g < groups; ++g) {
+		yuvGroup<YJK, PAL>({even[2 * g + 0], odd[2 * g + 0], even[2 * g + 1], odd[2 * g + 1]},
+		                   &out[4 * g]);
+	}
+}
+
+/** Color indices for BD16 mode: the low byte of each pixel comes from 'even',
+  * the high byte from 'odd'. The upper bit (used for transparency) is
+  * dropped.
+  */
+inline void bd16Indices(std::span<const uint8_t> even, std::span<const uint8_t> odd,
+                        std::span<uint16_t> out)
+{
+	assert(even.size() == odd.size());
+	assert(out.size() == even.size());
+	size_t i = 0;
+#ifdef __SSE2__
+	// SSE2 version, 16 pixels per iteration
+	const __m128i mask = _mm_set1_epi8(0x7F);
+	auto* o = std::bit_cast<__m128i*>(out.data());
+	for (/**/; (i + 16) <= out.size(); i += 16) {
+		__m128i low  = _mm_loadu_si128(std::bit_cast<const __m128i*>(even.data() + i));
+		__m128i high = _mm_and_si128(
+			_mm_loadu_si128(std::bit_cast<const __m128i*>(odd.data() + i)), mask);
+		_mm_storeu_si128(o + i / 8 + 0, _mm_unpacklo_epi8(low, high));
+		_mm_storeu_si128(o + i / 8 + 1, _mm_unpackhi_epi8(low, high));
+	}
+#endif
+	// C++ version (and remaining pixels)
+	for (/**/; i < out.size(); ++i) {
+		out[i] = uint16_t(even[i] | ((odd[i] & 0x7F) << 8));
+	}
+}
+
+#ifdef SIMD_AVX2
+namespace detail {
+
+// AVX2 version of lookupIndices(), 8 pixels per iteration. Returns the number
+// of pixels that were done.
+SIMD_TARGET("avx2") inline size_t lookupIndicesAVX2(
+	std::span<const uint16_t> idx,
+	std::span<const Pixel> palette64, std::span<const Pixel, 32768> palette32768,
+	std::span<Pixel> out)
+{
+	const auto* pal   = std::bit_cast<const int*>(palette32768.data());
+	const auto* pal64 = std::bit_cast<const int*>(palette64.data());
+	const __m256i flag = _mm256_set1_epi32(PALETTE);
+	size_t i = 0;
+	for (/**/; (i + 8) <= out.size(); i += 8) {
+		__m256i i32 = _mm256_cvtepu16_epi32(
+			_mm_loadu_si128(std::bit_cast<const __m128i*>(idx.data() + i)));
+		__m256i col = _mm256_i32gather_epi32(
+			pal, _mm256_andnot_si256(flag, i32), 4);
+		__m256i isPal = _mm256_cmpeq_epi32(_mm256_and_si256(i32, flag), flag);
+		if (!_mm256_testz_si256(isPal, isPal)) {
+			col = _mm256_mask_i32gather_epi32(
+				col, pal64, _mm256_and_si256(i32, _mm256_set1_epi32(63)), isPal, 4);
+		}
+		_mm256_storeu_si256(std::bit_cast<__m256i*>(out.data() + i), col);
+	}
+	return i;
+}
+
+} // namespace detail
+#endif
+
+/** Translate color indices (as produced by the routines above) to host
+  * pixels.
+  */
+inline void lookupIndices(std::span<const uint16_t> idx,
+                          std::span<const Pixel> palette64, std::span<const Pixel, 32768> palette32768,
+                          std::span<Pixel> out)
+{
+	assert(idx.size() == out.size());
+	size_t i = 0;
+#ifdef SIMD_AVX2
+	if (SIMD::hasAVX2()) {
+		i = detail::lookupIndicesAVX2(idx, palette64, palette32768, out);
+	}
+#endif
+	// C++ version (and remaining pixels)
+	for (/**/; i < out.size(); ++i) {
+		out[i] = (idx[i] & PALETTE) ? palette64[idx[i] & 63] : palette32768[idx[i]];
+	}
+}
+
+/** Draw the 8 pixels of 4 bytes from the pattern table (P1 and P2 modes),
+  * the even bytes use 'palette0', the odd bytes 'palette1'.
+  * @param TRANSPARENT Color 0 is transparent, don't draw those pixels.
+  * @param FILL_INFO Write '1' to 'info' for non-zero pixels, '0' otherwise.
+  */
+template<bool TRANSPARENT, bool FILL_INFO>
+inline void drawPattern8(std::array<uint8_t, 4> data,
+                         std::span<const Pixel, 16> palette0, std::span<const Pixel, 16> palette1,
+                         Pixel* __restrict out, uint8_t* __restrict info)
+{
+#if defined(__AVX2__)
+	// AVX2 version, both palettes are part of the same 64-entry palette,
+	// so both can be addressed from one base pointer. This is only used
+	// when the whole build targets AVX2: this routine is called per 8
+	// pixels, a run-time check (and call) would cost more than the
+	// gathers gain over the SSE2 version below.
+	uint32_t word = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+	auto ofst1 = int(palette1.data() - palette0.data());
+	__m256i nibbles = _mm256_and_si256(
+		_mm256_srlv_epi32(_mm256_set1_epi32(int(word)),
+		                  _mm256_setr_epi32(4, 0, 12, 8, 20, 16, 28, 24)),
+		_mm256_set1_epi32(15));
+	__m256i idx = _mm256_add_epi32(nibbles, _mm256_setr_epi32(0, 0, ofst1, ofst1, 0, 0, ofst1, ofst1));
+	const auto* pal = std::bit_cast<const int*>(palette0.data());
+	auto* o = std::bit_cast<__m256i*>(out);
+	if constexpr (TRANSPARENT) {
+		__m256i visible = _mm256_xor_si256(
+			_mm256_cmpeq_epi32(nibbles, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+		_mm256_storeu_si256(o, _mm256_mask_i32gather_epi32(
+			_mm256_loadu_si256(o), pal, idx, visible, 4));
+	} else {
+		_mm256_storeu_si256(o, _mm256_i32gather_epi32(pal, idx, 4));
+	}
+	if constexpr (FILL_INFO) {
+		// lowest byte of each 32-bit lane, 4 per 128-bit half
+		__m256i bits = _mm256_shuffle_epi8(
+			_mm256_min_epu32(nibbles, _mm256_set1_epi32(1)),
+			_mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			                 0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+		auto lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(bits));
+		auto hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(bits, 1));
+		memcpy(info + 0, &lo, 4);
+		memcpy(info + 4, &hi, 4);
+	}
+#elif defined(__SSE2__)
+	// SSE2 version: the palette lookups are scalar, but splitting the
+	// nibbles, the transparency and the 'info' bytes are done without
+	// branches.
+	__m128i bytes = _mm_cvtsi32_si128(int(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24)));
+	const __m128i mask = _mm_set1_epi8(15);
+	__m128i nibbles = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask),
+	                                    _mm_and_si128(bytes, mask)); // 8 pixels, in order
+	alignas(16) std::array<uint8_t, 16> n;
+	_mm_store_si128(std::bit_cast<__m128i*>(n.data()), nibbles);
+	__m128i col0 = _mm_setr_epi32(int(palette0[n[0]]), int(palette0[n[1]]),
+	                              int(palette1[n[2]]), int(palette1[n[3]]));
+	__m128i col1 = _mm_setr_epi32(int(palette0[n[4]]), int(palette0[n[5]]),
+	                              int(palette1[n[6]]), int(palette1[n[7]]));
+	auto* o = std::bit_cast<__m128i*>(out);
+	if constexpr (TRANSPARENT) {
+		const __m128i zero = _mm_setzero_si128();
+		__m128i n16 = _mm_unpacklo_epi8(nibbles, zero);
+		__m128i transp0 = _mm_cmpeq_epi32(_mm_unpacklo_epi16(n16, zero), zero);
+		__m128i transp1 = _mm_cmpeq_epi32(_mm_unpackhi_epi16(n16, zero), zero);
+		col0 = SIMD::select(col0, _mm_loadu_si128(o + 0), transp0);
+		col1 = SIMD::select(col1, _mm_loadu_si128(o + 1), transp1);
+	}
+	_mm_storeu_si128(o + 0, col0);
+	_mm_storeu_si128(o + 1, col1);
+	if constexpr (FILL_INFO) {
+		_mm_storel_epi64(std::bit_cast<__m128i*>(info),
+		                 _mm_min_epu8(nibbles, _mm_set1_epi8(1)));
+	}
+#else
+	// C++ version
+	for (auto i : xrange(8)) {
+		auto palette = (i & 2) ? palette1 : palette0;
+		size_t p = (data[i / 2] >> ((i & 1) ? 0 : 4)) & 15;
+		if constexpr (FILL_INFO) info[i] = bool(p);
+		if (!TRANSPARENT || p) out[i] = palette[p];
+	}
+#endif
+}
+
+} // namespace openmsx::V9990LineConvert
+
+#endif
@@ -1,6 +1,7 @@
 #include "V9990PxConverter.hh"
 
 #include "V9990.hh"
+#include "V9990LineConvert.hh"
 #include "V9990VRAM.hh"
 
 #include "ScopedAssign.hh"
@@ -54,6 +55,13 @@ struct P1BackgroundPolicy : P1Policy {
 	{
 		*buffer = palette[p];
 	}
+	static void draw8(
+		std::array<uint8_t, 4> data,
+		std::span<const Pixel, 16> palette0, std::span<const Pixel, 16> palette1,
+		Pixel* __restrict buffer, uint8_t* __restrict info)
+	{
+		V9990LineConvert::drawPattern8<false, false>(data, palette0, palette1, buffer, info);
+	}
 	static constexpr bool DRAW_BACKDROP = true;
 };
 struct P1ForegroundPolicy : P1Policy {
@@ -64,6 +72,13 @@ struct P1ForegroundPolicy : P1Policy {
 		*info = bool(p);
 		if (p) *buffer = palette[p];
 	}
+	static void draw8(
+		std::array<uint8_t, 4> data,
+		std::span<const Pixel, 16> palette0, std::span<const Pixel, 16> palette1,
+		Pixel* __restrict buffer, uint8_t* __restrict info)
+	{
+		V9990LineConvert::drawPattern8<true, true>(data, palette0, palette1, buffer, info);
+	}
 	static constexpr bool DRAW_BACKDROP = false;
 };
 struct P2Policy {
@@ -87,6 +102,13 @@ struct P2Policy {
 		*info = bool(p);
 		*buffer = palette[p];
 	}
+	static void draw8(
+		std::array<uint8_t, 4> data,
+		std::span<const Pixel, 16> palette0, std::span<const Pixel, 16> palette1,
+		Pixel* __restrict buffer, uint8_t* __restrict info)
+	{
+		V9990LineConvert::drawPattern8<false, true>(data, palette0, palette1, buffer, info);
+	}
 	static constexpr bool DRAW_BACKDROP = true;
 	static constexpr unsigned SCREEN_WIDTH = 512;
 	static constexpr unsigned IMAGE_WIDTH = 2 * SCREEN_WIDTH;
@@ -174,10 +196,12 @@ static void renderPattern(
 	assert((x & 7) == 0 || (width <= 0));
 	while ((width & ~7) > 0) {
 		unsigned address = getPatternAddress<Policy, true>(vram, nameAddr, patternBase, x, y);
-		draw2<Policy, false>(vram, palette0, buffer, info, address, width);
-		draw2<Policy, false>(vram, palette1, buffer, info, address, width);
-		draw2<Policy, false>(vram, palette0, buffer, info, address, width);
-		draw2<Policy, false>(vram, palette1, buffer, info, address, width);
+		std::array<uint8_t, 4> data;
+		for (auto& d : data) d = Policy::readPatternTable(vram, address++);
+		Policy::draw8(data, palette0, palette1, buffer, info);
+		buffer += 8;
+		info   += 8;
+		width  -= 8;
 		nameAddr = nextNameAddr<Policy>(nameAddr);
 	}
 	assert(width < 8);
@@ -57,6 +57,7 @@ PostProcessor* V9990SDLRasterizer::getPostProcessor() const
 bool V9990SDLRasterizer::isActive()
 {
 	return postProcessor->needRender() &&
+	       postProcessor->isFrameWanted() &&
 	       vdp.getMotherBoard().isActive() &&
 	       !vdp.getMotherBoard().isFastForwarding();
 }
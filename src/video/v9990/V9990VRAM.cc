@@ -2,9 +2,13 @@
 
 #include "V9990VRAM.hh"
 
+#include "V9990FastCopy.hh"
+
 #include "serialize.hh"
 
 #include <algorithm>
+#include <cassert>
+#include <span>
 
 namespace openmsx {
 
@@ -27,6 +31,32 @@ void V9990VRAM::clear()
 	}
 }
 
+void V9990VRAM::copyBx(unsigned srcAddress, unsigned dstAddress, unsigned num)
+{
+	V9990FastCopy::copyBx(data, srcAddress, dstAddress, num);
+}
+
+void V9990VRAM::copyPlanes(unsigned srcOffset, unsigned dstOffset, unsigned num)
+{
+	V9990FastCopy::copyPlanes(data, srcOffset, dstOffset, num);
+}
+
+void V9990VRAM::readBxPlanes(unsigned address, std::span<uint8_t> even, std::span<uint8_t> odd) const
+{
+	static constexpr unsigned HALF = VRAM_SIZE / 2;
+	assert((address & 1) == 0);
+	assert(even.size() == odd.size());
+	unsigned offset = (address & (VRAM_SIZE - 1)) / 2;
+	while (!even.empty()) {
+		auto n = std::min(even.size(), size_t(HALF - offset));
+		std::ranges::copy(std::span{&data[offset +    0], n}, even.begin());
+		std::ranges::copy(std::span{&data[offset + HALF], n}, odd .begin());
+		even = even.subspan(n);
+		odd  = odd .subspan(n);
+		offset = 0;
+	}
+}
+
 unsigned V9990VRAM::mapAddress(unsigned address) const
 {
 	address &= 0x7FFFF; // change to assert?
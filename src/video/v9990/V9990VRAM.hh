@@ -7,6 +7,7 @@
 #include "TrackedRam.hh"
 
 #include <cstdint>
+#include <span>
 
 namespace openmsx {
 
@@ -80,6 +81,26 @@ public:
 		data.write(address, value);
 	}
 
+	/** Copy 'num' bytes from one range of Bx (linear) addresses to
+	  * another, both ranges wrap at the end of VRAM. Gives the same result
+	  * as copying byte by byte in increasing address order (also for
+	  * overlapping ranges), but is a lot faster for non-overlapping ones.
+	  */
+	void copyBx(unsigned srcAddress, unsigned dstAddress, unsigned num);
+
+	/** Similar to copyBx(), but copies 'num' bytes in both halves of VRAM
+	  * (the low and high byte of a 16bpp pixel). The offsets are relative
+	  * to the start of each half and wrap at the end of it.
+	  */
+	void copyPlanes(unsigned srcOffset, unsigned dstOffset, unsigned num);
+
+	/** Read the bytes at consecutive Bx (linear) addresses, starting at
+	  * the (even) 'address', the bytes at even addresses go to 'even',
+	  * the others to 'odd'. Both are stored in a different half of VRAM,
+	  * so this is a block copy of each half. Wraps at the end of VRAM.
+	  */
+	void readBxPlanes(unsigned address, std::span<uint8_t> even, std::span<uint8_t> odd) const;
+
 	[[nodiscard]] uint8_t readVRAMCPU(unsigned address, EmuTime time);
 	void writeVRAMCPU(unsigned address, uint8_t val, EmuTime time);
 
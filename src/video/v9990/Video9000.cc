@@ -119,13 +119,14 @@ void Video9000::paint(OutputSurface& output)
 	activeLayer->paint(output);
 }
 
-void Video9000::takeRawScreenShot(std::optional<unsigned> height, const std::string& filename)
+void Video9000::takeRawScreenShot(std::optional<unsigned> height, const std::string& filename,
+                                  int compressionLevel)
 {
 	auto* layer = dynamic_cast<VideoLayer*>(activeLayer);
 	if (!layer) {
 		throw CommandException("TODO");
 	}
-	layer->takeRawScreenShot(height, filename);
+	layer->takeRawScreenShot(height, filename, compressionLevel);
 }
 
 bool Video9000::signalEvent(const Event& event)